@@ -0,0 +1,121 @@
+#include "Bench.h"
+#include <stdio.h>
+#include <thread>
+#include <filesystem>
+#include <system_error>
+#include "Luft/Core/AssetStreamer.h"
+#include "Luft/Core/KeyValueFile.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/VirtualFileSystem.h"
+
+// getting a set of assets into memory: opened together on the calling thread, against asked for
+// from the AssetStreamer and delivered by Update. The streamer's time is what the main thread waits
+// for it here, in a frame it would be spent on other work. The files are generated under
+// cache/bench_assets on first use
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr uint32_t FileCount = 256;
+		constexpr uint32_t FileSize = 16 * 1024;
+		const char* const Root = "cache/bench_assets";
+
+		lstr GetName(uint32_t i)
+		{
+			char name[48];
+			snprintf(name, sizeof(name), "assets/%03u.bin", i);
+			return name;
+		}
+
+		bool Setup()
+		{
+			const spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+			Log::GetCoreLogger()->set_level(spdlog::level::warn);
+			std::error_code ec;
+			std::filesystem::create_directories((lstr(Root) + "/assets").c_str(), ec);
+			larray<uint8_t> bytes;
+			bytes.resize(FileSize);
+			bool ok = true;
+			for (uint32_t i = 0; i < FileCount && ok; i++)
+			{
+				for (uint32_t b = 0; b < FileSize; b++)
+					bytes[b] = (uint8_t)(b * 131 + i);
+				ok = KeyValueFile::WriteReplacing(lstr(Root) + "/" + GetName(i), bytes.data(), bytes.size());
+			}
+			ok = ok && VirtualFileSystem::Mount("bench_assets", Root);
+			Log::GetCoreLogger()->set_level(level);
+			return ok;
+		}
+
+		bool Prepare(larray<lstr>& paths)
+		{
+			static const bool s_Ready = Setup();
+			for (uint32_t i = 0; i < FileCount; i++)
+				paths.push_back(lstr("bench_assets/") + GetName(i));
+			return s_Ready;
+		}
+
+		void OpenTogether(BenchState& state)
+		{
+			state.PauseTiming();
+			larray<lstr> paths;
+			const bool ready = Prepare(paths);
+			VirtualFile files[FileCount];
+			state.ResumeTiming();
+			if (!ready)
+				return;
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				VirtualFileSystem::OpenAll(paths.data(), paths.size(), files);
+				uint32_t sum = 0;
+				for (const VirtualFile& file : files)
+					sum += file.Data()[file.Size() - 1];
+				DoNotOptimize(sum);
+			}
+		}
+
+		void Stream(BenchState& state)
+		{
+			state.PauseTiming();
+			larray<lstr> paths;
+			const bool ready = Prepare(paths);
+			// Init reports its threads every time the benchmark runs
+			const spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+			Log::GetCoreLogger()->set_level(spdlog::level::warn);
+			AssetStreamer::Init();
+			larray<AssetHandle> handles;
+			state.ResumeTiming();
+			if (ready)
+			{
+				for (uint64_t it = 0; it < state.Iterations; it++)
+				{
+					for (const lstr& path : paths)
+						handles.push_back(AssetStreamer::Load(path, AssetPriority::Normal));
+					while (AssetStreamer::GetStats().Pending > 0)
+					{
+						if (AssetStreamer::Update() == 0)
+							std::this_thread::yield();
+					}
+					uint32_t sum = 0;
+					for (AssetHandle handle : handles)
+					{
+						Ref<larray<uint8_t>> bytes = AssetStreamer::Get<larray<uint8_t>>(handle);
+						sum += bytes->back();
+						AssetStreamer::Release(handle);
+					}
+					DoNotOptimize(sum);
+					handles.clear();
+				}
+			}
+			state.PauseTiming();
+			AssetStreamer::Shutdown();
+			Log::GetCoreLogger()->set_level(level);
+			state.ResumeTiming();
+		}
+	}
+
+	LUFT_BENCH("assets/load/256_files", "open_all", OpenTogether);
+	LUFT_BENCH("assets/load/256_files", "streamer", Stream);
+
+}
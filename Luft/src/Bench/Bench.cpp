@@ -0,0 +1,259 @@
+#include "Bench.h"
+
+#include <stdio.h>
+#include <time.h>
+#include "BenchStats.h"
+#include "BenchBaseline.h"
+#include "Version.h"
+
+namespace Luft {
+
+	namespace
+	{
+		larray<BenchCase>& GetRegistry()
+		{
+			// function local so registration order across translation units doesn't matter
+			static larray<BenchCase> s_Cases;
+			return s_Cases;
+		}
+
+		// one repetition, nanoseconds per iteration
+		double RunOnce(const BenchCase& bench, uint64_t iterations)
+		{
+			BenchState state(iterations);
+			const BenchState::Clock::time_point start = BenchState::Clock::now();
+			bench.Fn(state);
+			const BenchState::Clock::duration elapsed = BenchState::Clock::now() - start - state.GetPausedTime();
+			return std::chrono::duration<double, std::nano>(elapsed).count() / (double)iterations;
+		}
+
+		uint64_t Calibrate(const BenchCase& bench, double minRepMs)
+		{
+			const double minRepNs = minRepMs * 1000000.0;
+			uint64_t iterations = 1;
+			while (iterations < (1ull << 40))
+			{
+				const double ns = RunOnce(bench, iterations) * (double)iterations;
+				if (ns >= minRepNs)
+					break;
+				// jump close to the target once the timing is out of the noise, double otherwise
+				if (ns > minRepNs / 16.0)
+					iterations = (uint64_t)((double)iterations * minRepNs / ns * 1.2) + 1;
+				else
+					iterations *= 2;
+			}
+			return iterations;
+		}
+
+		bool Matches(const BenchCase& bench, const lstr& filter)
+		{
+			if (filter.isEmpty())
+				return true;
+			lstr name = lstr(bench.Group) + "/" + bench.Variant;
+			return name.contains(filter);
+		}
+
+		void WriteJsonString(FILE* f, const char* s)
+		{
+			fputc('"', f);
+			for (; *s; s++)
+			{
+				if (*s == '"' || *s == '\\')
+					fputc('\\', f);
+				fputc(*s, f);
+			}
+			fputc('"', f);
+		}
+
+		struct Comparison
+		{
+			const BenchResult* Baseline;
+			const BenchResult* Candidate;
+			// baseline median / candidate median, > 1 means the candidate is faster
+			double Speedup;
+			RankTestResult Test;
+		};
+
+		void WriteJson(FILE* f, const BenchOptions& options, const larray<BenchResult>& results, const larray<Comparison>& comparisons)
+		{
+			char date[32] = {};
+			const time_t now = time(nullptr);
+			strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+			fprintf(f, "{\n  \"context\": {\n");
+			fprintf(f, "    \"date\": \"%s\",\n", date);
+			fprintf(f, "    \"version\": \"%s\",\n", VERSIONSTR);
+			fprintf(f, "    \"commit\": ");
+			WriteJsonString(f, options.Commit.c_str());
+			fprintf(f, ",\n    \"machine\": \"%s\",\n    \"machine_desc\": ", BenchBaseline::GetMachine().Id.c_str());
+			WriteJsonString(f, BenchBaseline::GetMachine().Description.c_str());
+			fprintf(f, ",\n");
+#ifdef NDEBUG
+			fprintf(f, "    \"build\": \"release\",\n");
+#else
+			fprintf(f, "    \"build\": \"debug\",\n");
+#endif
+			fprintf(f, "    \"warmup_reps\": %u,\n", options.WarmupReps);
+			fprintf(f, "    \"repetitions\": %u,\n", options.Repetitions);
+			fprintf(f, "    \"min_rep_ms\": %g,\n", options.MinRepMs);
+			fprintf(f, "    \"alpha\": %g\n  },\n", options.Alpha);
+
+			fprintf(f, "  \"benchmarks\": [");
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const BenchResult& r = results[i];
+				fprintf(f, "%s\n    {\"group\": ", i ? "," : "");
+				WriteJsonString(f, r.Case->Group);
+				fprintf(f, ", \"variant\": ");
+				WriteJsonString(f, r.Case->Variant);
+				fprintf(f, ", \"iterations\": %llu, \"min_ns\": %.4f, \"median_ns\": %.4f, \"mean_ns\": %.4f, \"stddev_ns\": %.4f, \"samples_ns\": [",
+					(unsigned long long)r.Iterations, r.Min, r.Median, r.Mean, r.StdDev);
+				for (size_t s = 0; s < r.Samples.size(); s++)
+					fprintf(f, "%s%.4f", s ? ", " : "", r.Samples[s]);
+				fprintf(f, "]}");
+			}
+			fprintf(f, "\n  ],\n");
+
+			fprintf(f, "  \"comparisons\": [");
+			for (size_t i = 0; i < comparisons.size(); i++)
+			{
+				const Comparison& c = comparisons[i];
+				fprintf(f, "%s\n    {\"group\": ", i ? "," : "");
+				WriteJsonString(f, c.Baseline->Case->Group);
+				fprintf(f, ", \"baseline\": ");
+				WriteJsonString(f, c.Baseline->Case->Variant);
+				fprintf(f, ", \"candidate\": ");
+				WriteJsonString(f, c.Candidate->Case->Variant);
+				fprintf(f, ", \"speedup\": %.4f, \"u\": %.1f, \"z\": %.4f, \"p_value\": %.6g, \"significant\": %s}",
+					c.Speedup, c.Test.U, c.Test.Z, c.Test.PValue, c.Test.PValue < options.Alpha ? "true" : "false");
+			}
+			fprintf(f, "\n  ]\n}\n");
+		}
+	}
+
+	int Bench::Register(const char* group, const char* variant, BenchFn fn)
+	{
+		GetRegistry().push_back({ group, variant, fn });
+		return (int)GetRegistry().size();
+	}
+
+	const larray<BenchCase>& Bench::GetCases()
+	{
+		return GetRegistry();
+	}
+
+	int Bench::Run(const BenchOptions& options)
+	{
+		const larray<BenchCase>& cases = GetRegistry();
+
+		if (options.List)
+		{
+			for (const BenchCase& bench : cases)
+			{
+				if (Matches(bench, options.Filter))
+					printf("%s/%s\n", bench.Group, bench.Variant);
+			}
+			return 0;
+		}
+
+		larray<BenchResult> results;
+		larray<size_t> groupStarts;
+		for (size_t i = 0; i < cases.size(); i++)
+		{
+			if (!Matches(cases[i], options.Filter))
+				continue;
+			if (results.empty() || strcmp(results.back().Case->Group, cases[i].Group) != 0)
+				groupStarts.push_back(results.size());
+			BenchResult r;
+			r.Case = &cases[i];
+			results.push_back(r);
+		}
+		if (results.empty())
+		{
+			fprintf(stderr, "no benchmark matches '%s'\n", options.Filter.c_str());
+			return 1;
+		}
+		groupStarts.push_back(results.size());
+
+		// variants of a group run interleaved, one repetition each in turn, so clock drift and
+		// background load hit every variant alike instead of skewing the comparison
+		for (size_t g = 0; g + 1 < groupStarts.size(); g++)
+		{
+			const size_t first = groupStarts[g];
+			const size_t last = groupStarts[g + 1];
+
+			for (size_t i = first; i < last; i++)
+				results[i].Iterations = Calibrate(*results[i].Case, options.MinRepMs);
+			for (uint32_t rep = 0; rep < options.WarmupReps; rep++)
+			{
+				for (size_t i = first; i < last; i++)
+					RunOnce(*results[i].Case, results[i].Iterations);
+			}
+			for (uint32_t rep = 0; rep < options.Repetitions; rep++)
+			{
+				for (size_t i = first; i < last; i++)
+					results[i].Samples.push_back(RunOnce(*results[i].Case, results[i].Iterations));
+			}
+
+			for (size_t i = first; i < last; i++)
+			{
+				BenchResult& r = results[i];
+				const SampleSummary s = Summarize(r.Samples);
+				r.Min = s.Min;
+				r.Median = s.Median;
+				r.Mean = s.Mean;
+				r.StdDev = s.StdDev;
+
+				char median[32], stddev[32];
+				printf("%-36s %-14s %12s  +-%-12s %10llu iters\n", r.Case->Group, r.Case->Variant,
+					FormatNs(median, sizeof(median), r.Median), FormatNs(stddev, sizeof(stddev), r.StdDev), (unsigned long long)r.Iterations);
+			}
+			fflush(stdout);
+		}
+
+		larray<Comparison> comparisons;
+		for (size_t g = 0; g + 1 < groupStarts.size(); g++)
+		{
+			const BenchResult& baseline = results[groupStarts[g]];
+			for (size_t i = groupStarts[g] + 1; i < groupStarts[g + 1]; i++)
+			{
+				Comparison c;
+				c.Baseline = &baseline;
+				c.Candidate = &results[i];
+				c.Speedup = results[i].Median > 0.0 ? baseline.Median / results[i].Median : 0.0;
+				c.Test = MannWhitneyU(baseline.Samples, results[i].Samples);
+				comparisons.push_back(c);
+			}
+		}
+
+		if (!comparisons.empty())
+		{
+			printf("\n%-36s %-30s %9s %10s\n", "group", "candidate vs baseline", "speedup", "p");
+			for (const Comparison& c : comparisons)
+			{
+				lstr versus = lstr(c.Candidate->Case->Variant) + " vs " + c.Baseline->Case->Variant;
+				printf("%-36s %-30s %8.2fx %10.2g %s\n", c.Baseline->Case->Group, versus.c_str(), c.Speedup, c.Test.PValue,
+					c.Test.PValue < options.Alpha ? "" : "(not significant)");
+			}
+		}
+
+		if (!options.JsonPath.isEmpty())
+		{
+			const bool toStdout = options.JsonPath == "-";
+			FILE* f = toStdout ? stdout : fopen(options.JsonPath.c_str(), "wb");
+			if (!f)
+			{
+				fprintf(stderr, "can't open %s\n", options.JsonPath.c_str());
+				return 1;
+			}
+			WriteJson(f, options, results, comparisons);
+			if (!toStdout)
+			{
+				fclose(f);
+				printf("\nwrote %s\n", options.JsonPath.c_str());
+			}
+		}
+		return 0;
+	}
+
+}
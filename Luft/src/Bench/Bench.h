@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace Luft {
+
+	// Passed to every benchmark function. The function runs its body Iterations times; setup that
+	// shouldn't be measured goes between PauseTiming/ResumeTiming, which cost two clock reads each.
+	class BenchState
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		explicit BenchState(uint64_t iterations) : Iterations(iterations) {}
+
+		const uint64_t Iterations;
+
+		void PauseTiming() { m_PauseStart = Clock::now(); }
+		void ResumeTiming() { m_Paused += Clock::now() - m_PauseStart; }
+		Clock::duration GetPausedTime() const { return m_Paused; }
+
+	private:
+		Clock::time_point m_PauseStart;
+		Clock::duration m_Paused = Clock::duration::zero();
+	};
+
+	typedef void (*BenchFn)(BenchState& state);
+
+	struct BenchCase
+	{
+		// cases sharing a group are compared against each other, the first registered variant is
+		// the baseline
+		const char* Group;
+		const char* Variant;
+		BenchFn Fn;
+	};
+
+	struct BenchOptions
+	{
+		// substring matched against "group/variant", empty runs everything
+		lstr Filter;
+		uint32_t WarmupReps = 3;
+		uint32_t Repetitions = 15;
+		// iterations per repetition are doubled until one repetition takes at least this long
+		double MinRepMs = 2.0;
+		// two-sided Mann-Whitney p-value below which a difference is reported as significant
+		double Alpha = 0.01;
+		// "-" writes to stdout, empty writes no JSON
+		lstr JsonPath;
+		// recorded in the JSON context, the key of stored baselines
+		lstr Commit;
+		bool List = false;
+	};
+
+	struct BenchResult
+	{
+		const BenchCase* Case = nullptr;
+		uint64_t Iterations = 0;
+		// nanoseconds per iteration, one per repetition, in run order
+		larray<double> Samples;
+		double Min = 0.0;
+		double Median = 0.0;
+		double Mean = 0.0;
+		double StdDev = 0.0;
+	};
+
+	class Bench
+	{
+	public:
+		static int Register(const char* group, const char* variant, BenchFn fn);
+		static const larray<BenchCase>& GetCases();
+
+		// runs every matching case, prints a table and writes the JSON report. Returns the process
+		// exit code
+		static int Run(const BenchOptions& options);
+	};
+
+	// keeps the compiler from discarding a value, or the stores that produced it
+	template <typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		const volatile char* p = (const volatile char*)&value;
+		(void)*p;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	inline void ClobberMemory()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : : "memory");
+#endif
+	}
+
+}
+
+#define LUFT_BENCH_CONCAT2(a, b) a##b
+#define LUFT_BENCH_CONCAT(a, b) LUFT_BENCH_CONCAT2(a, b)
+
+// registers fn at static init, e.g. LUFT_BENCH("larray/push_back/1000", "larray", PushBackLarray)
+#define LUFT_BENCH(group, variant, fn) \
+	static const int LUFT_BENCH_CONCAT(s_BenchReg, __LINE__) = ::Luft::Bench::Register(group, variant, fn)
@@ -0,0 +1,618 @@
+#include "BenchBaseline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include "BenchStats.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define LUFT_POPEN _popen
+#define LUFT_PCLOSE _pclose
+#else
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#define LUFT_POPEN popen
+#define LUFT_PCLOSE pclose
+#endif
+
+namespace Luft {
+
+	namespace
+	{
+		// frames dropped from the start of a capture, startup uploads and first-use allocations
+		constexpr size_t CaptureWarmupFrames = 60;
+
+		lstr GetCpuName()
+		{
+			char brand[49] = {};
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+			int regs[4];
+			__cpuid(regs, 0x80000000);
+			if ((unsigned)regs[0] >= 0x80000004)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					__cpuid(regs, 0x80000002 + i);
+					memcpy(brand + i * 16, regs, 16);
+				}
+			}
+#elif defined(__x86_64__) || defined(__i386__)
+			unsigned regs[4];
+			if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004)
+			{
+				for (unsigned i = 0; i < 3; i++)
+				{
+					__get_cpuid(0x80000002 + i, &regs[0], &regs[1], &regs[2], &regs[3]);
+					memcpy(brand + i * 16, regs, 16);
+				}
+			}
+#endif
+			lstr name = brand;
+			name.trim();
+			return name.isEmpty() ? lstr("unknown cpu") : name;
+		}
+
+		uint64_t HashFnv1a(const lstr& s)
+		{
+			uint64_t h = 14695981039346656037ull;
+			for (size_t i = 0; i < s.size(); i++)
+			{
+				h ^= (unsigned char)s[i];
+				h *= 1099511628211ull;
+			}
+			return h;
+		}
+
+		bool ReadFile(const lstr& path, lstr& out)
+		{
+			FILE* f = fopen(path.c_str(), "rb");
+			if (!f)
+				return false;
+			char buf[4096];
+			size_t n;
+			while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+				out.append(buf, n);
+			fclose(f);
+			return true;
+		}
+
+		// Reads the JSON Bench::Run writes. Enough of JSON to skip what it doesn't know, values
+		// it keeps are strings and arrays of numbers
+		class JsonReader
+		{
+		public:
+			explicit JsonReader(const lstr& text) : m_Text(text.c_str()), m_End(text.c_str() + text.size()) {}
+
+			bool Failed() const { return m_Failed; }
+
+			bool Consume(char c)
+			{
+				SkipSpace();
+				if (m_Text < m_End && *m_Text == c)
+				{
+					m_Text++;
+					return true;
+				}
+				return false;
+			}
+
+			bool Expect(char c)
+			{
+				if (!Consume(c))
+					m_Failed = true;
+				return !m_Failed;
+			}
+
+			bool ReadString(lstr& out)
+			{
+				out.clear();
+				if (!Expect('"'))
+					return false;
+				while (m_Text < m_End && *m_Text != '"')
+				{
+					if (*m_Text == '\\' && m_Text + 1 < m_End)
+						m_Text++;
+					out.append(m_Text, 1);
+					m_Text++;
+				}
+				return Expect('"');
+			}
+
+			bool ReadNumber(double& out)
+			{
+				SkipSpace();
+				char* end = nullptr;
+				out = strtod(m_Text, &end);
+				if (end == m_Text)
+					m_Failed = true;
+				m_Text = end;
+				return !m_Failed;
+			}
+
+			bool ReadNumbers(larray<double>& out)
+			{
+				if (!Expect('['))
+					return false;
+				if (Consume(']'))
+					return true;
+				do
+				{
+					double v;
+					if (!ReadNumber(v))
+						return false;
+					out.push_back(v);
+				} while (Consume(','));
+				return Expect(']');
+			}
+
+			// walks an object, calling onKey(key) for every member. onKey reads the value or
+			// returns false to have it skipped
+			template <typename Fn>
+			bool ReadObject(Fn onKey)
+			{
+				if (!Expect('{'))
+					return false;
+				if (Consume('}'))
+					return true;
+				do
+				{
+					lstr key;
+					if (!ReadString(key) || !Expect(':'))
+						return false;
+					if (!onKey(key))
+						SkipValue();
+				} while (!m_Failed && Consume(','));
+				return Expect('}');
+			}
+
+			template <typename Fn>
+			bool ReadArray(Fn onElement)
+			{
+				if (!Expect('['))
+					return false;
+				if (Consume(']'))
+					return true;
+				do
+				{
+					onElement();
+				} while (!m_Failed && Consume(','));
+				return Expect(']');
+			}
+
+			void SkipValue()
+			{
+				SkipSpace();
+				if (m_Text >= m_End)
+				{
+					m_Failed = true;
+					return;
+				}
+				if (*m_Text == '{')
+					ReadObject([](const lstr&) { return false; });
+				else if (*m_Text == '[')
+					ReadArray([this]() { SkipValue(); });
+				else if (*m_Text == '"')
+				{
+					lstr ignored;
+					ReadString(ignored);
+				}
+				else
+				{
+					// number, true, false or null
+					while (m_Text < m_End && !strchr(",}] \t\r\n", *m_Text))
+						m_Text++;
+				}
+			}
+
+		private:
+			void SkipSpace()
+			{
+				while (m_Text < m_End && (*m_Text == ' ' || *m_Text == '\t' || *m_Text == '\r' || *m_Text == '\n'))
+					m_Text++;
+			}
+
+			const char* m_Text;
+			const char* m_End;
+			bool m_Failed = false;
+		};
+
+		bool LoadJson(const lstr& text, StoredRun& run)
+		{
+			JsonReader reader(text);
+			reader.ReadObject([&](const lstr& key) {
+				if (key == "context")
+				{
+					reader.ReadObject([&](const lstr& field) {
+						if (field == "commit")
+							return reader.ReadString(run.Commit);
+						if (field == "machine")
+							return reader.ReadString(run.Machine);
+						return false;
+					});
+					return true;
+				}
+				if (key == "benchmarks")
+				{
+					reader.ReadArray([&]() {
+						StoredSeries series;
+						reader.ReadObject([&](const lstr& field) {
+							if (field == "group")
+								return reader.ReadString(series.Group);
+							if (field == "variant")
+								return reader.ReadString(series.Variant);
+							if (field == "samples_ns")
+								return reader.ReadNumbers(series.Samples);
+							return false;
+						});
+						run.Series.push_back(std::move(series));
+					});
+					return true;
+				}
+				return false;
+			});
+			return !reader.Failed();
+		}
+
+		// columns of FrameStats' CSV: frame,time_s,frame_ms,cpu_ms,gpu_ms,present_ms,wait_ms,hitch,skipped
+		bool LoadFrameCsv(const lstr& text, StoredRun& run)
+		{
+			static const char* const Metrics[] = { "frame_ms", "cpu_ms", "gpu_ms" };
+			constexpr int FirstColumn = 2;
+			larray<double> values[3];
+
+			const char* line = text.c_str();
+			const char* end = line + text.size();
+			if (strncmp(line, "frame,", 6) != 0)
+				return false;
+			size_t row = 0;
+			for (line = strchr(line, '\n'); line && line + 1 < end; line = strchr(line, '\n'), row++)
+			{
+				line++;
+				if (row < CaptureWarmupFrames)
+					continue;
+				const char* field = line;
+				for (int column = 0; field && column < FirstColumn + 3; column++)
+				{
+					if (column >= FirstColumn)
+					{
+						// gpu_ms is empty for frames the GPU timer couldn't resolve
+						char* fieldEnd = nullptr;
+						const double ms = strtod(field, &fieldEnd);
+						if (fieldEnd != field)
+							values[column - FirstColumn].push_back(ms * 1000000.0);
+					}
+					field = strchr(field, ',');
+					if (field)
+						field++;
+				}
+			}
+
+			for (int i = 0; i < 3; i++)
+			{
+				if (values[i].empty())
+					continue;
+				StoredSeries series;
+				series.Group = "frame";
+				series.Variant = Metrics[i];
+				series.Samples = std::move(values[i]);
+				run.Series.push_back(std::move(series));
+			}
+			return !run.Series.empty();
+		}
+
+		double Percentile(larray<double> values, double p)
+		{
+			if (values.empty())
+				return 0.0;
+			std::sort(values.begin(), values.end());
+			const double pos = p * (double)(values.size() - 1);
+			const size_t lo = (size_t)pos;
+			const size_t hi = std::min(lo + 1, values.size() - 1);
+			return values[lo] + (values[hi] - values[lo]) * (pos - (double)lo);
+		}
+
+		struct Verdict
+		{
+			const StoredSeries* Baseline = nullptr;
+			const StoredSeries* Candidate = nullptr;
+			double BaselineMedian = 0.0;
+			double CandidateMedian = 0.0;
+			// candidate / baseline - 1 in percent, positive is slower
+			double ChangePct = 0.0;
+			double ThresholdPct = 0.0;
+			double PValue = 1.0;
+			const char* Label = "";
+		};
+
+		void WriteMarkdown(FILE* f, const StoredRun& baseline, const StoredRun& candidate, const larray<Verdict>& verdicts, int regressions)
+		{
+			fprintf(f, "# Performance comparison\n\n");
+			fprintf(f, "- machine: %s (%s)\n", BenchBaseline::GetMachine().Description.c_str(), BenchBaseline::GetMachine().Id.c_str());
+			fprintf(f, "- baseline: `%s`\n- candidate: `%s`\n", baseline.Commit.c_str(), candidate.Commit.c_str());
+			fprintf(f, "- regressions: **%d**\n\n", regressions);
+			fprintf(f, "| group | variant | baseline | candidate | change | threshold | p | |\n");
+			fprintf(f, "|---|---|---:|---:|---:|---:|---:|---|\n");
+			for (const Verdict& v : verdicts)
+			{
+				char base[32] = "-", cand[32] = "-";
+				if (v.Baseline)
+					FormatNs(base, sizeof(base), v.BaselineMedian);
+				if (v.Candidate)
+					FormatNs(cand, sizeof(cand), v.CandidateMedian);
+				const StoredSeries* s = v.Candidate ? v.Candidate : v.Baseline;
+				fprintf(f, "| %s | %s | %s | %s | %+.1f%% | %.1f%% | %.2g | %s |\n", s->Group.c_str(), s->Variant.c_str(),
+					base, cand, v.ChangePct, v.ThresholdPct, v.PValue, v.Label);
+			}
+		}
+	}
+
+	const MachineFingerprint& BenchBaseline::GetMachine()
+	{
+		static MachineFingerprint s_Machine;
+		if (s_Machine.Id.isEmpty())
+		{
+			char cores[16];
+			snprintf(cores, sizeof(cores), "%u", std::thread::hardware_concurrency());
+			lstr desc = GetCpuName() + ", " + cores + " threads";
+#if defined(_WIN32)
+			desc.append(", windows");
+#elif defined(__linux__)
+			desc.append(", linux");
+#else
+			desc.append(", other os");
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+			desc.append(", msvc");
+#elif defined(__clang__)
+			desc.append(", clang");
+#else
+			desc.append(", gcc");
+#endif
+#ifdef NDEBUG
+			desc.append(", release");
+#else
+			desc.append(", debug");
+#endif
+			char id[20];
+			snprintf(id, sizeof(id), "%012llx", (unsigned long long)(HashFnv1a(desc) & 0xffffffffffffull));
+			s_Machine.Description = desc;
+			s_Machine.Id = id;
+		}
+		return s_Machine;
+	}
+
+	lstr BenchBaseline::GetCommit(bool* dirty)
+	{
+		if (dirty)
+			*dirty = false;
+		if (const char* env = getenv("LUFT_COMMIT"))
+		{
+			if (*env)
+				return env;
+		}
+
+		lstr commit;
+#ifdef LUFT_SOURCE_DIR
+		const char* command = "git -C \"" LUFT_SOURCE_DIR "\" rev-parse --short=12 HEAD";
+#else
+		const char* command = "git rev-parse --short=12 HEAD";
+#endif
+		if (FILE* pipe = LUFT_POPEN(command, "r"))
+		{
+			char buf[64] = {};
+			if (fgets(buf, sizeof(buf), pipe))
+				commit = buf;
+			LUFT_PCLOSE(pipe);
+		}
+		commit.trim();
+		if (commit.isEmpty())
+			return lstr("unknown");
+
+		// untracked files are left out, a build directory inside the tree would always count
+#ifdef LUFT_SOURCE_DIR
+		const char* status = "git -C \"" LUFT_SOURCE_DIR "\" status --porcelain --untracked-files=no";
+#else
+		const char* status = "git status --porcelain --untracked-files=no";
+#endif
+		if (dirty)
+		{
+			if (FILE* pipe = LUFT_POPEN(status, "r"))
+			{
+				char buf[256];
+				*dirty = fgets(buf, sizeof(buf), pipe) != nullptr;
+				LUFT_PCLOSE(pipe);
+			}
+		}
+		return commit;
+	}
+
+	lstr BenchBaseline::GetPath(const lstr& dir, const lstr& suite, const lstr& commit)
+	{
+		return dir + "/" + GetMachine().Id + "/" + suite + "/" + commit + ".json";
+	}
+
+	lstr BenchBaseline::GetLatestCommit(const lstr& dir, const lstr& suite)
+	{
+		lstr history;
+		if (!ReadFile(dir + "/" + GetMachine().Id + "/" + suite + "/history.txt", history))
+			return lstr();
+
+		history.trim();
+		const int32_t lastLine = history.find_last_of("\n");
+		lstr latest = history.c_str() + (lastLine + 1);
+		latest.trim();
+		return latest;
+	}
+
+	bool BenchBaseline::Store(const lstr& dir, const lstr& suite, const StoredRun& run)
+	{
+		const lstr machineDir = dir + "/" + GetMachine().Id;
+		std::error_code ec;
+		std::filesystem::create_directories((machineDir + "/" + suite).c_str(), ec);
+		if (ec)
+		{
+			fprintf(stderr, "can't create %s/%s: %s\n", machineDir.c_str(), suite.c_str(), ec.message().c_str());
+			return false;
+		}
+
+		if (FILE* f = fopen((machineDir + "/machine.txt").c_str(), "wb"))
+		{
+			fprintf(f, "%s\n", GetMachine().Description.c_str());
+			fclose(f);
+		}
+
+		const lstr path = GetPath(dir, suite, run.Commit);
+		if (!WriteJson(path, run))
+			return false;
+
+		// storing the same commit twice replaces the file, but only the first entry orders it
+		if (GetLatestCommit(dir, suite) != run.Commit)
+		{
+			FILE* f = fopen((machineDir + "/" + suite + "/history.txt").c_str(), "ab");
+			if (!f)
+				return false;
+			fprintf(f, "%s\n", run.Commit.c_str());
+			fclose(f);
+		}
+		printf("stored baseline %s\n", path.c_str());
+		return true;
+	}
+
+	bool BenchBaseline::Load(const lstr& path, StoredRun& run)
+	{
+		lstr text;
+		if (!ReadFile(path, text))
+		{
+			fprintf(stderr, "can't open %s\n", path.c_str());
+			return false;
+		}
+
+		const bool ok = path.endsWith(".csv") ? LoadFrameCsv(text, run) : LoadJson(text, run);
+		if (!ok)
+			fprintf(stderr, "can't read results from %s\n", path.c_str());
+		return ok;
+	}
+
+	bool BenchBaseline::WriteJson(const lstr& path, const StoredRun& run)
+	{
+		FILE* f = fopen(path.c_str(), "wb");
+		if (!f)
+		{
+			fprintf(stderr, "can't open %s\n", path.c_str());
+			return false;
+		}
+
+		// the subset of Bench::Run's report that Load reads back
+		fprintf(f, "{\n  \"context\": {\"commit\": \"%s\", \"machine\": \"%s\"},\n", run.Commit.c_str(), run.Machine.c_str());
+		fprintf(f, "  \"benchmarks\": [");
+		for (size_t i = 0; i < run.Series.size(); i++)
+		{
+			const StoredSeries& s = run.Series[i];
+			fprintf(f, "%s\n    {\"group\": \"%s\", \"variant\": \"%s\", \"samples_ns\": [", i ? "," : "", s.Group.c_str(), s.Variant.c_str());
+			for (size_t k = 0; k < s.Samples.size(); k++)
+				fprintf(f, "%s%.4f", k ? ", " : "", s.Samples[k]);
+			fprintf(f, "]}");
+		}
+		fprintf(f, "\n  ]\n}\n");
+		fclose(f);
+		return true;
+	}
+
+	int BenchBaseline::Compare(const StoredRun& baseline, const StoredRun& candidate, const CompareOptions& options)
+	{
+		if (!baseline.Machine.isEmpty() && !candidate.Machine.isEmpty() && baseline.Machine != candidate.Machine)
+			printf("warning: baseline is from machine %s, candidate from %s\n", baseline.Machine.c_str(), candidate.Machine.c_str());
+
+		larray<Verdict> verdicts;
+		int regressions = 0;
+		for (const StoredSeries& cand : candidate.Series)
+		{
+			Verdict v;
+			v.Candidate = &cand;
+			v.CandidateMedian = Summarize(cand.Samples).Median;
+			for (const StoredSeries& base : baseline.Series)
+			{
+				if (base.Group == cand.Group && base.Variant == cand.Variant)
+					v.Baseline = &base;
+			}
+			if (!v.Baseline)
+			{
+				v.Label = "new";
+				verdicts.push_back(v);
+				continue;
+			}
+
+			v.BaselineMedian = Summarize(v.Baseline->Samples).Median;
+			if (v.BaselineMedian > 0.0)
+			{
+				v.ChangePct = (v.CandidateMedian / v.BaselineMedian - 1.0) * 100.0;
+				// half the interquartile range: a noisy baseline needs a bigger move before it counts
+				const double spread = 0.5 * (Percentile(v.Baseline->Samples, 0.75) - Percentile(v.Baseline->Samples, 0.25));
+				v.ThresholdPct = std::max(options.ThresholdPct, spread / v.BaselineMedian * 100.0);
+			}
+			v.PValue = MannWhitneyU(v.Baseline->Samples, cand.Samples).PValue;
+
+			const bool significant = v.PValue < options.Alpha && fabs(v.ChangePct) > v.ThresholdPct;
+			if (significant && v.ChangePct > 0.0)
+			{
+				v.Label = "REGRESSION";
+				regressions++;
+			}
+			else if (significant)
+				v.Label = "faster";
+			else
+				v.Label = "~";
+			verdicts.push_back(v);
+		}
+		for (const StoredSeries& base : baseline.Series)
+		{
+			bool found = false;
+			for (const StoredSeries& cand : candidate.Series)
+				found |= base.Group == cand.Group && base.Variant == cand.Variant;
+			if (!found)
+			{
+				Verdict v;
+				v.Baseline = &base;
+				v.BaselineMedian = Summarize(base.Samples).Median;
+				v.Label = "missing";
+				verdicts.push_back(v);
+			}
+		}
+
+		printf("\nbaseline %s vs candidate %s on %s\n", baseline.Commit.c_str(), candidate.Commit.c_str(), GetMachine().Description.c_str());
+		printf("%-36s %-14s %12s %12s %9s %9s %9s\n", "group", "variant", "baseline", "candidate", "change", "thresh", "p");
+		for (const Verdict& v : verdicts)
+		{
+			char base[32] = "-", cand[32] = "-";
+			if (v.Baseline)
+				FormatNs(base, sizeof(base), v.BaselineMedian);
+			if (v.Candidate)
+				FormatNs(cand, sizeof(cand), v.CandidateMedian);
+			const StoredSeries* s = v.Candidate ? v.Candidate : v.Baseline;
+			printf("%-36s %-14s %12s %12s %+8.1f%% %8.1f%% %9.2g %s\n", s->Group.c_str(), s->Variant.c_str(), base, cand,
+				v.ChangePct, v.ThresholdPct, v.PValue, v.Label);
+		}
+		printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+
+		if (!options.ReportPath.isEmpty())
+		{
+			FILE* f = fopen(options.ReportPath.c_str(), "wb");
+			if (f)
+			{
+				WriteMarkdown(f, baseline, candidate, verdicts, regressions);
+				fclose(f);
+				printf("wrote %s\n", options.ReportPath.c_str());
+			}
+			else
+				fprintf(stderr, "can't open %s\n", options.ReportPath.c_str());
+		}
+		return regressions;
+	}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	struct MachineFingerprint
+	{
+		// cpu, logical cores, os, compiler and build type, e.g. for the report header
+		lstr Description;
+		// short hash of Description, the baseline store directory name
+		lstr Id;
+	};
+
+	// one benchmark, or one frame metric of a replay, as read back from a result file
+	struct StoredSeries
+	{
+		lstr Group;
+		lstr Variant;
+		// nanoseconds per iteration for benchmarks, per frame for replays
+		larray<double> Samples;
+	};
+
+	struct StoredRun
+	{
+		lstr Commit;
+		lstr Machine;
+		larray<StoredSeries> Series;
+	};
+
+	struct CompareOptions
+	{
+		// two-sided Mann-Whitney p-value below which a change counts at all
+		double Alpha = 0.01;
+		// ...and the median must also move by more than this many percent, or by more than the
+		// baseline's own spread if that is larger
+		double ThresholdPct = 5.0;
+		// markdown copy of the report, empty writes none
+		lstr ReportPath;
+	};
+
+	// Baselines live under <dir>/<machine id>/<suite>/<commit>.json, with history.txt listing
+	// the stored commits oldest first. Timings only compare on the same machine and build, so the
+	// machine id is part of the key.
+	class BenchBaseline
+	{
+	public:
+		static const MachineFingerprint& GetMachine();
+		// LUFT_COMMIT from the environment, else git rev-parse of the source tree, else "unknown".
+		// dirty is set when the commit is the tree's HEAD and tracked files have changed since
+		static lstr GetCommit(bool* dirty = nullptr);
+
+		static lstr GetPath(const lstr& dir, const lstr& suite, const lstr& commit);
+		// most recently stored commit of the suite on this machine, empty if there is none
+		static lstr GetLatestCommit(const lstr& dir, const lstr& suite);
+		// writes the run as run.Commit's baseline and appends the commit to the history
+		static bool Store(const lstr& dir, const lstr& suite, const StoredRun& run);
+
+		// a Luft-Bench JSON report, or a FrameStats CSV capture (".csv") whose frame, cpu and gpu
+		// columns become the series of group "frame"
+		static bool Load(const lstr& path, StoredRun& run);
+		static bool WriteJson(const lstr& path, const StoredRun& run);
+
+		// prints the report and returns the number of regressions
+		static int Compare(const StoredRun& baseline, const StoredRun& candidate, const CompareOptions& options);
+	};
+
+}
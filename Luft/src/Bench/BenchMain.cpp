@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <filesystem>
+#include "Bench.h"
+#include "BenchBaseline.h"
+#include "Luft/Core/Log.h"
+
+namespace {
+
+	void PrintUsage()
+	{
+		printf("usage: Luft-Bench [options]\n"
+			"  --filter <text>     only run benchmarks whose group/variant contains text\n"
+			"  --list              list benchmarks and exit\n"
+			"  --warmup <n>        discarded repetitions per benchmark (default 3)\n"
+			"  --reps <n>          measured repetitions per benchmark (default 15)\n"
+			"  --min-rep-ms <ms>   minimum duration of one repetition (default 2)\n"
+			"  --alpha <p>         significance level for comparisons (default 0.01)\n"
+			"  --json <path>       write results as JSON, - for stdout\n"
+			"\n"
+			"regression checks, exit code 2 when a comparison finds a regression:\n"
+			"  --baseline-dir <d>  baseline store (default perf-baselines)\n"
+			"  --commit <id>       commit the results belong to (default $LUFT_COMMIT or git HEAD)\n"
+			"  --save-baseline     store the results as the commit's baseline for this machine, not\n"
+			"                      when a comparison regressed or the tree has uncommitted changes\n"
+			"  --compare <commit>  compare against a stored baseline, latest for the newest one\n"
+			"  --frames <csv>      check a FrameStats capture (Luft-Client --frame-csv) instead of running\n"
+			"  --suite <name>      baseline suite (default bench, frames with --frames)\n"
+			"  --threshold <pct>   smallest change reported as a regression (default 5)\n"
+			"  --report <path>     also write the comparison as markdown\n"
+			"  --diff <a> <b>      compare two result files (.json or .csv) and exit\n");
+	}
+
+	// compare against a stored baseline and / or store the run, the candidate side of both. A run
+	// that regressed isn't stored, or it would become the baseline the next check passes against
+	int CheckBaseline(const lstr& resultPath, const lstr& dir, const lstr& suite, const lstr& commit,
+		const lstr& compareWith, bool save, const Luft::CompareOptions& compare)
+	{
+		Luft::StoredRun candidate;
+		if (!Luft::BenchBaseline::Load(resultPath, candidate))
+			return 1;
+		candidate.Commit = commit;
+		candidate.Machine = Luft::BenchBaseline::GetMachine().Id;
+
+		int regressions = 0;
+		if (!compareWith.isEmpty())
+		{
+			const lstr ref = compareWith == "latest" ? Luft::BenchBaseline::GetLatestCommit(dir, suite) : compareWith;
+			Luft::StoredRun baseline;
+			if (ref.isEmpty())
+				printf("no %s baseline for this machine yet (%s), nothing to compare\n", suite.c_str(), Luft::BenchBaseline::GetMachine().Description.c_str());
+			else if (!Luft::BenchBaseline::Load(Luft::BenchBaseline::GetPath(dir, suite, ref), baseline))
+				return 1;
+			else
+				regressions = Luft::BenchBaseline::Compare(baseline, candidate, compare);
+		}
+
+		if (save && regressions > 0)
+			printf("%d regressions, not stored as %s's %s baseline\n", regressions, commit.c_str(), suite.c_str());
+		else if (save && !Luft::BenchBaseline::Store(dir, suite, candidate))
+			return 1;
+		return regressions > 0 ? 2 : 0;
+	}
+
+}
+
+int main(int argc, char** argv)
+{
+	// no background log thread competing with the measurements
+	Luft::LogSettings logSettings;
+	logSettings.Async = false;
+	logSettings.ConsoleCapacity = 0;
+	Luft::Log::Init(logSettings);
+
+	Luft::BenchOptions options;
+	Luft::CompareOptions compare;
+	lstr baselineDir = "perf-baselines";
+	lstr suite;
+	lstr compareWith;
+	lstr framesPath;
+	lstr diffBaseline, diffCandidate;
+	bool saveBaseline = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		const bool takesValue = strcmp(arg, "--list") != 0 && strcmp(arg, "--help") != 0 && strcmp(arg, "-h") != 0
+			&& strcmp(arg, "--save-baseline") != 0;
+		if (takesValue && !value)
+		{
+			fprintf(stderr, "missing value for %s\n", arg);
+			return 1;
+		}
+
+		if (strcmp(arg, "--filter") == 0)
+			options.Filter = value;
+		else if (strcmp(arg, "--warmup") == 0)
+			options.WarmupReps = (uint32_t)atoi(value);
+		else if (strcmp(arg, "--reps") == 0)
+			options.Repetitions = (uint32_t)atoi(value);
+		else if (strcmp(arg, "--min-rep-ms") == 0)
+			options.MinRepMs = atof(value);
+		else if (strcmp(arg, "--alpha") == 0)
+			options.Alpha = atof(value);
+		else if (strcmp(arg, "--json") == 0)
+			options.JsonPath = value;
+		else if (strcmp(arg, "--list") == 0)
+			options.List = true;
+		else if (strcmp(arg, "--baseline-dir") == 0)
+			baselineDir = value;
+		else if (strcmp(arg, "--commit") == 0)
+			options.Commit = value;
+		else if (strcmp(arg, "--save-baseline") == 0)
+			saveBaseline = true;
+		else if (strcmp(arg, "--compare") == 0)
+			compareWith = value;
+		else if (strcmp(arg, "--frames") == 0)
+			framesPath = value;
+		else if (strcmp(arg, "--suite") == 0)
+			suite = value;
+		else if (strcmp(arg, "--threshold") == 0)
+			compare.ThresholdPct = atof(value);
+		else if (strcmp(arg, "--report") == 0)
+			compare.ReportPath = value;
+		else if (strcmp(arg, "--diff") == 0 && i + 2 < argc)
+		{
+			diffBaseline = value;
+			diffCandidate = argv[i + 2];
+			i++;
+		}
+		else
+		{
+			PrintUsage();
+			return strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 ? 0 : 1;
+		}
+
+		if (takesValue)
+			i++;
+	}
+
+	if (options.Repetitions < 2)
+		options.Repetitions = 2;
+
+	compare.Alpha = options.Alpha;
+	if (!diffBaseline.isEmpty())
+	{
+		Luft::StoredRun baseline, candidate;
+		if (!Luft::BenchBaseline::Load(diffBaseline, baseline) || !Luft::BenchBaseline::Load(diffCandidate, candidate))
+			return 1;
+		if (baseline.Commit.isEmpty())
+			baseline.Commit = diffBaseline;
+		if (candidate.Commit.isEmpty())
+			candidate.Commit = diffCandidate;
+		return Luft::BenchBaseline::Compare(baseline, candidate, compare) > 0 ? 2 : 0;
+	}
+
+	if (options.Commit.isEmpty())
+	{
+		// HEAD doesn't describe a tree with uncommitted changes, its baseline would be overwritten
+		// by whatever is being worked on
+		bool dirty = false;
+		options.Commit = Luft::BenchBaseline::GetCommit(&dirty);
+		if (dirty && saveBaseline)
+		{
+			fprintf(stderr, "the working tree has uncommitted changes, not storing them as %s's baseline "
+				"(commit them, or name the run with --commit)\n", options.Commit.c_str());
+			return 1;
+		}
+	}
+
+	const bool checking = saveBaseline || !compareWith.isEmpty();
+	if (!checking)
+	{
+		if (!framesPath.isEmpty())
+		{
+			fprintf(stderr, "--frames needs --compare or --save-baseline\n");
+			return 1;
+		}
+		return Luft::Bench::Run(options);
+	}
+
+	if (suite.isEmpty())
+		suite = framesPath.isEmpty() ? "bench" : "frames";
+
+	lstr resultPath = framesPath;
+	if (resultPath.isEmpty())
+	{
+		// the checks read the run back from its JSON, so there has to be a file
+		if (options.JsonPath.isEmpty() || options.JsonPath == "-")
+			options.JsonPath = baselineDir + "/last-run.json";
+		std::error_code ec;
+		std::filesystem::create_directories(baselineDir.c_str(), ec);
+		const int status = Luft::Bench::Run(options);
+		if (status != 0)
+			return status;
+		resultPath = options.JsonPath;
+	}
+	return CheckBaseline(resultPath, baselineDir, suite, options.Commit, compareWith, saveBaseline, compare);
+}
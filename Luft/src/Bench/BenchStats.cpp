@@ -0,0 +1,102 @@
+#include "BenchStats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+
+namespace Luft {
+
+	SampleSummary Summarize(const larray<double>& samples)
+	{
+		SampleSummary s;
+		const size_t n = samples.size();
+		if (n == 0)
+			return s;
+
+		larray<double> sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		s.Min = sorted[0];
+		s.Median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+
+		double sum = 0.0;
+		for (double v : sorted)
+			sum += v;
+		s.Mean = sum / n;
+
+		if (n > 1)
+		{
+			double sq = 0.0;
+			for (double v : sorted)
+				sq += (v - s.Mean) * (v - s.Mean);
+			s.StdDev = sqrt(sq / (n - 1));
+		}
+		return s;
+	}
+
+	RankTestResult MannWhitneyU(const larray<double>& a, const larray<double>& b)
+	{
+		RankTestResult result;
+		const size_t n1 = a.size();
+		const size_t n2 = b.size();
+		const size_t n = n1 + n2;
+		if (n1 == 0 || n2 == 0)
+			return result;
+
+		struct Value
+		{
+			double V;
+			bool FromA;
+		};
+		larray<Value> all;
+		all.reserve(n);
+		for (double v : a)
+			all.push_back({ v, true });
+		for (double v : b)
+			all.push_back({ v, false });
+		std::sort(all.begin(), all.end(), [](const Value& x, const Value& y) { return x.V < y.V; });
+
+		// tied values share the average of their ranks
+		double rankSumA = 0.0;
+		double tieTerm = 0.0;
+		for (size_t i = 0; i < n;)
+		{
+			size_t j = i + 1;
+			while (j < n && all[j].V == all[i].V)
+				j++;
+			const double rank = 0.5 * (double)(i + 1 + j);
+			for (size_t k = i; k < j; k++)
+			{
+				if (all[k].FromA)
+					rankSumA += rank;
+			}
+			const double t = (double)(j - i);
+			tieTerm += t * t * t - t;
+			i = j;
+		}
+
+		result.U = rankSumA - 0.5 * (double)n1 * (double)(n1 + 1);
+		const double mu = 0.5 * (double)n1 * (double)n2;
+		const double variance = (double)n1 * (double)n2 / 12.0 * ((double)(n + 1) - tieTerm / ((double)n * (double)(n - 1)));
+		if (variance <= 0.0)
+			return result;
+
+		// continuity correction towards the mean
+		const double diff = result.U - mu;
+		const double corrected = diff > 0.5 ? diff - 0.5 : (diff < -0.5 ? diff + 0.5 : 0.0);
+		result.Z = corrected / sqrt(variance);
+		result.PValue = erfc(fabs(result.Z) / sqrt(2.0));
+		return result;
+	}
+
+	const char* FormatNs(char* buf, size_t size, double ns)
+	{
+		if (ns < 1000.0)
+			snprintf(buf, size, "%.2f ns", ns);
+		else if (ns < 1000000.0)
+			snprintf(buf, size, "%.2f us", ns / 1000.0);
+		else
+			snprintf(buf, size, "%.2f ms", ns / 1000000.0);
+		return buf;
+	}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include "Luft/Core/larray.h"
+
+namespace Luft {
+
+	struct SampleSummary
+	{
+		double Min = 0.0;
+		double Median = 0.0;
+		double Mean = 0.0;
+		double StdDev = 0.0;
+	};
+
+	struct RankTestResult
+	{
+		// U statistic of the first sample
+		double U = 0.0;
+		double Z = 0.0;
+		// two-sided, from the normal approximation with tie correction. Fine from ~8 samples a side
+		double PValue = 1.0;
+	};
+
+	SampleSummary Summarize(const larray<double>& samples);
+	// Mann-Whitney U test: are values from a systematically larger or smaller than values from b.
+	// Makes no normality assumption, which suits timings with their long right tail
+	RankTestResult MannWhitneyU(const larray<double>& a, const larray<double>& b);
+	// ns, us or ms with two decimals, whichever keeps the number readable
+	const char* FormatNs(char* buf, size_t size, double ns);
+
+}
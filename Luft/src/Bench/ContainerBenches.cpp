@@ -0,0 +1,146 @@
+#include <vector>
+#include "Bench.h"
+
+// larray against std::vector for the operations the engine leans on. std::vector registers first
+// in every group, so it's the baseline the comparisons are reported against.
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr size_t SmallCount = 16;
+		constexpr size_t LargeCount = 4096;
+		constexpr size_t EditCount = 1024;
+
+		struct Item
+		{
+			uint32_t Id;
+			float Value[3];
+		};
+
+		template <typename Array>
+		void PushBack(BenchState& state, size_t count)
+		{
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				Array a;
+				for (size_t i = 0; i < count; i++)
+					a.push_back(Item{ (uint32_t)i, { 1.0f, 2.0f, 3.0f } });
+				DoNotOptimize(a.data());
+				ClobberMemory();
+			}
+		}
+
+		template <typename Array>
+		void ReservePushBack(BenchState& state, size_t count)
+		{
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				Array a;
+				a.reserve(count);
+				for (size_t i = 0; i < count; i++)
+					a.push_back(Item{ (uint32_t)i, { 1.0f, 2.0f, 3.0f } });
+				DoNotOptimize(a.data());
+				ClobberMemory();
+			}
+		}
+
+		inline void InsertAt(std::vector<Item>& a, size_t offs, const Item& item) { a.insert(a.begin() + offs, item); }
+		inline void InsertAt(larray<Item>& a, size_t offs, const Item& item) { a.insert(offs, item); }
+		inline void EraseAt(std::vector<Item>& a, size_t offs) { a.erase(a.begin() + offs); }
+		inline void EraseAt(larray<Item>& a, size_t offs) { a.erase(offs); }
+
+		// every insert lands in the middle, so the cost is dominated by shifting the tail
+		template <typename Array>
+		void InsertMiddle(BenchState& state)
+		{
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				Array a;
+				a.reserve(EditCount);
+				for (size_t i = 0; i < EditCount; i++)
+					InsertAt(a, a.size() / 2, Item{ (uint32_t)i, { 0.0f, 0.0f, 0.0f } });
+				DoNotOptimize(a.data());
+				ClobberMemory();
+			}
+		}
+
+		template <typename Array>
+		void EraseMiddle(BenchState& state)
+		{
+			Array source;
+			for (size_t i = 0; i < EditCount; i++)
+				source.push_back(Item{ (uint32_t)i, { 0.0f, 0.0f, 0.0f } });
+
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				state.PauseTiming();
+				Array a = source;
+				state.ResumeTiming();
+				while (!a.empty())
+					EraseAt(a, a.size() / 2);
+				DoNotOptimize(a.data());
+				ClobberMemory();
+			}
+		}
+
+		// the common "remove one element from the back half" pattern, e.g. a layer list
+		template <typename Array>
+		void EraseBack(BenchState& state)
+		{
+			Array source;
+			for (size_t i = 0; i < EditCount; i++)
+				source.push_back(Item{ (uint32_t)i, { 0.0f, 0.0f, 0.0f } });
+
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				state.PauseTiming();
+				Array a = source;
+				state.ResumeTiming();
+				while (!a.empty())
+					EraseAt(a, a.size() - 1);
+				DoNotOptimize(a.data());
+				ClobberMemory();
+			}
+		}
+
+		template <typename Array>
+		void Iterate(BenchState& state)
+		{
+			Array a;
+			for (size_t i = 0; i < LargeCount; i++)
+				a.push_back(Item{ (uint32_t)i, { 1.0f, 2.0f, 3.0f } });
+
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				float sum = 0.0f;
+				for (const Item& item : a)
+					sum += item.Value[0] + item.Value[2];
+				DoNotOptimize(sum);
+			}
+		}
+
+		void PushBackSmallVector(BenchState& state) { PushBack<std::vector<Item>>(state, SmallCount); }
+		void PushBackSmallLarray(BenchState& state) { PushBack<larray<Item>>(state, SmallCount); }
+		void PushBackLargeVector(BenchState& state) { PushBack<std::vector<Item>>(state, LargeCount); }
+		void PushBackLargeLarray(BenchState& state) { PushBack<larray<Item>>(state, LargeCount); }
+		void ReserveVector(BenchState& state) { ReservePushBack<std::vector<Item>>(state, LargeCount); }
+		void ReserveLarray(BenchState& state) { ReservePushBack<larray<Item>>(state, LargeCount); }
+	}
+
+	LUFT_BENCH("containers/push_back/16", "std::vector", PushBackSmallVector);
+	LUFT_BENCH("containers/push_back/16", "larray", PushBackSmallLarray);
+	LUFT_BENCH("containers/push_back/4096", "std::vector", PushBackLargeVector);
+	LUFT_BENCH("containers/push_back/4096", "larray", PushBackLargeLarray);
+	LUFT_BENCH("containers/reserve+push_back/4096", "std::vector", ReserveVector);
+	LUFT_BENCH("containers/reserve+push_back/4096", "larray", ReserveLarray);
+	LUFT_BENCH("containers/insert_middle/1024", "std::vector", InsertMiddle<std::vector<Item>>);
+	LUFT_BENCH("containers/insert_middle/1024", "larray", InsertMiddle<larray<Item>>);
+	LUFT_BENCH("containers/erase_middle/1024", "std::vector", EraseMiddle<std::vector<Item>>);
+	LUFT_BENCH("containers/erase_middle/1024", "larray", EraseMiddle<larray<Item>>);
+	LUFT_BENCH("containers/erase_back/1024", "std::vector", EraseBack<std::vector<Item>>);
+	LUFT_BENCH("containers/erase_back/1024", "larray", EraseBack<larray<Item>>);
+	LUFT_BENCH("containers/iterate/4096", "std::vector", Iterate<std::vector<Item>>);
+	LUFT_BENCH("containers/iterate/4096", "larray", Iterate<larray<Item>>);
+
+}
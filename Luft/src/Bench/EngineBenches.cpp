@@ -0,0 +1,123 @@
+#include "Bench.h"
+#include "Luft/Core/LayerStack.h"
+#include "Luft/Events/ApplicationEvents.h"
+
+// event dispatch and LayerStack walks, shaped like Application::OnEvent and Application::Run
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr int LayerCount = 16;
+
+		class BenchLayer : public Layer
+		{
+		public:
+			BenchLayer() : Layer("BenchLayer") {}
+
+			void OnUpdate(Timestep ts) override { m_Accum += (float)ts; }
+
+			void OnEvent(Event& event) override
+			{
+				EventDispatcher dispatcher(event);
+				dispatcher.Dispatch<WindowResizeEvent>([this](WindowResizeEvent& e) {
+					m_Width = e.GetWidth();
+					return false;
+				});
+				dispatcher.Dispatch<AppTickEvent>([this](AppTickEvent&) {
+					m_Ticks++;
+					return false;
+				});
+			}
+
+			uint32_t m_Width = 0;
+			uint32_t m_Ticks = 0;
+			float m_Accum = 0.0f;
+		};
+
+		void FillStack(LayerStack& stack)
+		{
+			for (int i = 0; i < LayerCount; i++)
+			{
+				if (i % 4 == 3)
+					stack.PushOverlay(new BenchLayer());
+				else
+					stack.PushLayer(new BenchLayer());
+			}
+		}
+
+		// the body of Application::OnEvent, which is private
+		void Propagate(LayerStack& stack, Event& e)
+		{
+			for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+			{
+				if (e.Handled)
+					break;
+				(*it)->OnEvent(e);
+			}
+		}
+
+		void DispatchSingle(BenchState& state)
+		{
+			uint32_t width = 0;
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				WindowResizeEvent e((unsigned int)it, 720);
+				Event& base = e;
+				DoNotOptimize(base);
+				EventDispatcher dispatcher(base);
+				dispatcher.Dispatch<WindowCloseEvent>([](WindowCloseEvent&) { return true; });
+				dispatcher.Dispatch<WindowResizeEvent>([&width](WindowResizeEvent& r) {
+					width += r.GetWidth();
+					return false;
+				});
+				DoNotOptimize(width);
+			}
+		}
+
+		void PropagateThroughStack(BenchState& state)
+		{
+			LayerStack stack;
+			FillStack(stack);
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				WindowResizeEvent e((unsigned int)it, 720);
+				Propagate(stack, e);
+				ClobberMemory();
+			}
+		}
+
+		void UpdateStack(BenchState& state)
+		{
+			LayerStack stack;
+			FillStack(stack);
+			const Timestep ts(0.016f);
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				for (Layer* layer : stack)
+					layer->OnUpdate(ts);
+				ClobberMemory();
+			}
+		}
+
+		void LookupByHandle(BenchState& state)
+		{
+			LayerStack stack;
+			LayerHandle handles[LayerCount];
+			for (int i = 0; i < LayerCount; i++)
+				handles[i] = stack.PushLayer(new BenchLayer());
+
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				Layer* layer = stack.Get(handles[it % LayerCount]);
+				DoNotOptimize(layer);
+			}
+		}
+	}
+
+	LUFT_BENCH("events/dispatch", "EventDispatcher", DispatchSingle);
+	LUFT_BENCH("events/propagate/16_layers", "LayerStack", PropagateThroughStack);
+	LUFT_BENCH("layers/update/16_layers", "LayerStack", UpdateStack);
+	LUFT_BENCH("layers/get_by_handle", "LayerStack", LookupByHandle);
+
+}
@@ -0,0 +1,110 @@
+#include "Bench.h"
+#include "Luft/Core/DerivedDataCache.h"
+#include "Luft/Core/KeyTable.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/SystemService.h"
+#include "Luft/ImGui/GlyphCache.h"
+
+// startup cost of the UI font, ImGuiLayer::OnAttach's GlyphCache::Build with and without its
+// atlas in the derived data cache, and what a display scale change costs once it's built. Run from
+// the client's directory so the configured font is found. The cache is cache/bench_ddc
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr uint32_t CellCount = 2048;
+
+		void LoadKeys()
+		{
+			static const bool s_Loaded = KeyTable::Load("resources/config/keys.lkt", "resources/config/keys.txt");
+			(void)s_Loaded;
+		}
+
+		void InitCache()
+		{
+			static const bool s_Ready = [] {
+				const spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+				Log::GetCoreLogger()->set_level(spdlog::level::warn);
+				DerivedDataCache::Init("cache/bench_ddc", 64ull * 1024 * 1024);
+				Log::GetCoreLogger()->set_level(level);
+				return true;
+			}();
+			(void)s_Ready;
+		}
+
+		const char* GetFontPath()
+		{
+			LoadKeys();
+			return GetResVal(ResKey::font_path_puhui3);
+		}
+
+		struct Sizes
+		{
+			float Values[3];
+		};
+
+		// ImGuiLayer's UIFont sizes
+		Sizes GetSizes()
+		{
+			LoadKeys();
+			return { { (float)GetIntVal(IntKey::font_size_normal), (float)GetIntVal(IntKey::font_size_title), (float)GetIntVal(IntKey::font_size_max) } };
+		}
+
+		void Build(BenchState& state, bool useCache)
+		{
+			const Sizes sizes = GetSizes();
+			// a line per build otherwise
+			const spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+			Log::GetCoreLogger()->set_level(spdlog::level::warn);
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				GlyphCache cache;
+				if (!cache.Build(GetFontPath(), sizes.Values, 3, CellCount, useCache))
+					break;
+				DoNotOptimize(cache.GetFont());
+			}
+			Log::GetCoreLogger()->set_level(level);
+		}
+
+		void BuildFromFont(BenchState& state)
+		{
+			Build(state, false);
+		}
+
+		void ReadFromCache(BenchState& state)
+		{
+			state.PauseTiming();
+			InitCache();
+			// written by the first build, every later one reads it
+			GlyphCache warm;
+			const Sizes sizes = GetSizes();
+			warm.Build(GetFontPath(), sizes.Values, 3, CellCount, true);
+			state.ResumeTiming();
+			Build(state, true);
+		}
+
+		void Rescale(BenchState& state)
+		{
+			state.PauseTiming();
+			GlyphCache cache;
+			const Sizes sizes = GetSizes();
+			InitCache();
+			const bool built = cache.Build(GetFontPath(), sizes.Values, 3, CellCount, true);
+			state.ResumeTiming();
+			if (!built)
+				return;
+			// between 100% and 150%, every font's metrics and lookup tables are redone
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				cache.SetScale(it % 2 ? 1.0f : 1.5f);
+				DoNotOptimize(cache.GetFont()->FontSize);
+			}
+		}
+	}
+
+	LUFT_BENCH("font/ui_atlas", "build", BuildFromFont);
+	LUFT_BENCH("font/ui_atlas", "cache", ReadFromCache);
+	LUFT_BENCH("font/ui_atlas", "rescale", Rescale);
+
+}
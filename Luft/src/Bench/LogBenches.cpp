@@ -0,0 +1,52 @@
+#include "Bench.h"
+#include "Luft/Core/BinaryLog.h"
+#include "spdlog/sinks/null_sink.h"
+
+// cost of a log statement on the calling thread. spdlog formats there even when the write is
+// queued, the binary channel only copies the arguments
+
+namespace Luft {
+
+	namespace
+	{
+		void SpdlogText(BenchState& state)
+		{
+			static std::shared_ptr<spdlog::logger> s_Logger = std::make_shared<spdlog::logger>("bench-null", std::make_shared<spdlog::sinks::null_sink_st>());
+			for (uint64_t it = 0; it < state.Iterations; it++)
+				s_Logger->info("frame {0} upload {1} bytes to {2}, {3:.2f} ms", it, 65536, "vertex buffer", 0.25);
+		}
+
+		void BinaryChannel(BenchState& state)
+		{
+			state.PauseTiming();
+			BinaryLogSettings settings;
+			// large enough that the drain keeps up and the loop never takes the dropped path
+			settings.RingBytes = 1u << 24;
+			settings.DrainIntervalMs = 1;
+			settings.FormatToLog = false;
+			BinaryLog::Start(settings);
+			state.ResumeTiming();
+
+			for (uint64_t it = 0; it < state.Iterations; it++)
+				LUFT_BLOG(spdlog::level::info, "frame {0} upload {1} bytes to {2}, {3:.2f} ms", it, 65536, "vertex buffer", 0.25);
+
+			state.PauseTiming();
+			BinaryLog::Stop();
+			state.ResumeTiming();
+		}
+
+		void BinaryChannelStopped(BenchState& state)
+		{
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				LUFT_BLOG(spdlog::level::info, "frame {0} upload {1} bytes to {2}, {3:.2f} ms", it, 65536, "vertex buffer", 0.25);
+				ClobberMemory();
+			}
+		}
+	}
+
+	LUFT_BENCH("log/statement/4_args", "spdlog", SpdlogText);
+	LUFT_BENCH("log/statement/4_args", "BinaryLog", BinaryChannel);
+	LUFT_BENCH("log/statement/4_args", "BinaryLog stopped", BinaryChannelStopped);
+
+}
@@ -0,0 +1,114 @@
+#include <string>
+#include "Bench.h"
+
+// lstr against std::string. The construct groups straddle the small string boundaries: lstr keeps
+// up to 22 characters inline on 64-bit, MSVC and libstdc++ std::string 15, libc++ 22.
+
+namespace Luft {
+
+	namespace
+	{
+		const char s_Text[] =
+			"The quick brown fox jumps over the lazy dog while the engine streams another frame";
+
+		template <typename String, size_t Length>
+		void ConstructCopy(BenchState& state)
+		{
+			static_assert(Length < sizeof(s_Text), "text too short");
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				String a(s_Text, Length);
+				String b(a);
+				DoNotOptimize(a);
+				DoNotOptimize(b);
+			}
+		}
+
+		// typical name building: a handful of short pieces into a path-like string
+		template <typename String>
+		void Append(BenchState& state)
+		{
+			const char* pieces[] = { "Luft", "/", "resources", "/", "fonts", "/", "NotoSansSC-Regular", ".ttf" };
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				String s;
+				for (int rep = 0; rep < 4; rep++)
+				{
+					for (const char* piece : pieces)
+						s += piece;
+				}
+				DoNotOptimize(s);
+			}
+		}
+
+		template <typename String>
+		void AppendChar(BenchState& state)
+		{
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				String s;
+				for (int i = 0; i < 256; i++)
+					s += (char)('a' + (i % 26));
+				DoNotOptimize(s);
+			}
+		}
+
+		template <typename String>
+		String MakeHaystack()
+		{
+			String s;
+			for (int i = 0; i < 64; i++)
+				s += "lorem ipsum dolor sit amet consectetur adipiscing elit sed do ";
+			s += "needle";
+			return s;
+		}
+
+		inline bool FindIn(const lstr& haystack, const char* needle) { return haystack.find(needle) >= 0; }
+		inline bool FindIn(const std::string& haystack, const char* needle) { return haystack.find(needle) != std::string::npos; }
+		inline bool FindIn(const lstr& haystack, char needle) { return haystack.find(needle) >= 0; }
+		inline bool FindIn(const std::string& haystack, char needle) { return haystack.find(needle) != std::string::npos; }
+
+		// the match is at the very end, so the whole ~4KB haystack is scanned
+		template <typename String>
+		void FindSubstring(BenchState& state)
+		{
+			const String haystack = MakeHaystack<String>();
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				bool found = FindIn(haystack, "needle");
+				DoNotOptimize(found);
+			}
+		}
+
+		template <typename String>
+		void FindChar(BenchState& state)
+		{
+			const String haystack = MakeHaystack<String>();
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				bool found = FindIn(haystack, 'n') && FindIn(haystack, 'z');
+				DoNotOptimize(found);
+			}
+		}
+	}
+
+	LUFT_BENCH("strings/construct+copy/15", "std::string", (ConstructCopy<std::string, 15>));
+	LUFT_BENCH("strings/construct+copy/15", "lstr", (ConstructCopy<lstr, 15>));
+	LUFT_BENCH("strings/construct+copy/16", "std::string", (ConstructCopy<std::string, 16>));
+	LUFT_BENCH("strings/construct+copy/16", "lstr", (ConstructCopy<lstr, 16>));
+	LUFT_BENCH("strings/construct+copy/22", "std::string", (ConstructCopy<std::string, 22>));
+	LUFT_BENCH("strings/construct+copy/22", "lstr", (ConstructCopy<lstr, 22>));
+	LUFT_BENCH("strings/construct+copy/23", "std::string", (ConstructCopy<std::string, 23>));
+	LUFT_BENCH("strings/construct+copy/23", "lstr", (ConstructCopy<lstr, 23>));
+	LUFT_BENCH("strings/construct+copy/64", "std::string", (ConstructCopy<std::string, 64>));
+	LUFT_BENCH("strings/construct+copy/64", "lstr", (ConstructCopy<lstr, 64>));
+	LUFT_BENCH("strings/append", "std::string", Append<std::string>);
+	LUFT_BENCH("strings/append", "lstr", Append<lstr>);
+	LUFT_BENCH("strings/append_char/256", "std::string", AppendChar<std::string>);
+	LUFT_BENCH("strings/append_char/256", "lstr", AppendChar<lstr>);
+	LUFT_BENCH("strings/find_substring/4K", "std::string", FindSubstring<std::string>);
+	LUFT_BENCH("strings/find_substring/4K", "lstr", FindSubstring<lstr>);
+	LUFT_BENCH("strings/find_char/4K", "std::string", FindChar<std::string>);
+	LUFT_BENCH("strings/find_char/4K", "lstr", FindChar<lstr>);
+
+}
@@ -0,0 +1,127 @@
+#include "Bench.h"
+#include <stdio.h>
+#include <filesystem>
+#include <system_error>
+#include "Luft/Core/KeyValueFile.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/VirtualFileSystem.h"
+
+// opening assets through the VirtualFileSystem: many small files from a directory mount against
+// the same files in a pack, and a large entry stored as is against one decompressed from LZ4
+// blocks. The files are generated under cache/bench_vfs on first use
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr uint32_t SmallCount = 256;
+		constexpr uint32_t SmallSize = 2048;
+		constexpr uint32_t LargeSize = 4 * 1024 * 1024;
+		const char* const Root = "cache/bench_vfs";
+
+		lstr GetSmallName(uint32_t i)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "small/%03u.txt", i);
+			return name;
+		}
+
+		// text-like, so it compresses about as well as config and shader sources do
+		void Fill(larray<uint8_t>& out, size_t size, uint32_t seed)
+		{
+			static const char* const s_Words[] = { "font", "size", "window", "layer", " = ", "\n", "resources/", "color", "0.75", "[panel]" };
+			out.clear();
+			uint32_t state = seed * 2654435761u + 1;
+			while (out.size() < size)
+			{
+				state = state * 1664525u + 1013904223u;
+				const char* word = s_Words[(state >> 24) % ARRAYSIZE(s_Words)];
+				out.append((const uint8_t*)word, strlen(word));
+			}
+			out.resize(size);
+		}
+
+		bool Setup()
+		{
+			const spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+			Log::GetCoreLogger()->set_level(spdlog::level::warn);
+			const lstr loose = lstr(Root) + "/loose";
+			std::error_code ec;
+			std::filesystem::create_directories((loose + "/small").c_str(), ec);
+			larray<uint8_t> bytes;
+			bool ok = true;
+			for (uint32_t i = 0; i < SmallCount && ok; i++)
+			{
+				Fill(bytes, SmallSize, i);
+				ok = KeyValueFile::WriteReplacing(loose + "/" + GetSmallName(i), bytes.data(), bytes.size());
+			}
+			Fill(bytes, LargeSize, SmallCount);
+			ok = ok && KeyValueFile::WriteReplacing(loose + "/large.bin", bytes.data(), bytes.size())
+				&& VirtualFileSystem::BuildPack(loose, lstr(Root) + "/stored.lpak", false)
+				&& VirtualFileSystem::BuildPack(loose, lstr(Root) + "/lz4.lpak", true)
+				&& VirtualFileSystem::Mount("loose", loose)
+				&& VirtualFileSystem::Mount("stored", lstr(Root) + "/stored.lpak")
+				&& VirtualFileSystem::Mount("lz4", lstr(Root) + "/lz4.lpak");
+			Log::GetCoreLogger()->set_level(level);
+			return ok;
+		}
+
+		bool Prepare()
+		{
+			static const bool s_Ready = Setup();
+			return s_Ready;
+		}
+
+		void OpenSmall(BenchState& state, const char* mountPoint)
+		{
+			state.PauseTiming();
+			const bool ready = Prepare();
+			larray<lstr> paths;
+			for (uint32_t i = 0; i < SmallCount; i++)
+				paths.push_back(lstr(mountPoint) + "/" + GetSmallName(i));
+			state.ResumeTiming();
+			if (!ready)
+				return;
+			VirtualFile file;
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				for (const lstr& path : paths)
+				{
+					VirtualFileSystem::Open(path, file);
+					DoNotOptimize(file.Data()[file.Size() - 1]);
+				}
+			}
+		}
+
+		void OpenLarge(BenchState& state, const char* mountPoint)
+		{
+			state.PauseTiming();
+			const bool ready = Prepare();
+			const lstr path = lstr(mountPoint) + "/large.bin";
+			state.ResumeTiming();
+			if (!ready)
+				return;
+			VirtualFile file;
+			for (uint64_t it = 0; it < state.Iterations; it++)
+			{
+				VirtualFileSystem::Open(path, file);
+				// a byte per page, the mapped entry is only read when it's touched
+				uint32_t sum = 0;
+				for (size_t i = 0; i < file.Size(); i += 4096)
+					sum += file.Data()[i];
+				DoNotOptimize(sum);
+			}
+		}
+
+		void OpenSmallFromDirectory(BenchState& state) { OpenSmall(state, "loose"); }
+		void OpenSmallFromPack(BenchState& state) { OpenSmall(state, "stored"); }
+		void OpenLargeStored(BenchState& state) { OpenLarge(state, "stored"); }
+		void OpenLargeCompressed(BenchState& state) { OpenLarge(state, "lz4"); }
+	}
+
+	LUFT_BENCH("vfs/open/256_files", "directory", OpenSmallFromDirectory);
+	LUFT_BENCH("vfs/open/256_files", "pack", OpenSmallFromPack);
+	LUFT_BENCH("vfs/open/4mb_file", "stored", OpenLargeStored);
+	LUFT_BENCH("vfs/open/4mb_file", "lz4", OpenLargeCompressed);
+
+}
@@ -3,7 +3,8 @@
 class EditorApp : public Luft::Application
 {
 public:
-	EditorApp()
+	EditorApp(const Luft::ApplicationSpecification& specification)
+		: Luft::Application(specification)
 	{
 
 	}
@@ -14,7 +15,10 @@ public:
 	}
 };
 
-Luft::Application* Luft::CreateApplication()
+Luft::Application* Luft::CreateApplication(Luft::ApplicationCommandLineArgs args)
 {
-	return new EditorApp();
+	Luft::ApplicationSpecification spec;
+	spec.Name = "Luft-Editor";
+	spec.CommandLineArgs = args;
+	return new EditorApp(spec);
 }
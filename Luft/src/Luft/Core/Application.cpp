@@ -1,12 +1,68 @@
 #include "Application.h"
+#include <stdlib.h>
+#include <string.h>
 #include "Platform/Windows/WinUtils.h"
 #include "Log.h"
+#include "BinaryLog.h"
+#include "KeyTable.h"
+#include "Localization.h"
+#include "Memory.h"
+#include "VirtualFileSystem.h"
+#include "AssetStreamer.h"
+#include "DerivedDataCache.h"
+#include "FileWatcher.h"
+#include "Luft/Debug/Profiler.h"
+#include "Luft/Debug/FrameStats.h"
 
 namespace Luft
 {
+	namespace
+	{
+		void ApplyCommandLine(ApplicationSpecification& spec)
+		{
+			const ApplicationCommandLineArgs& args = spec.CommandLineArgs;
+			for (int i = 1; i < args.Count; i++)
+			{
+				if (strcmp(args[i], "--headless") == 0)
+					spec.Headless = true;
+				else if (strcmp(args[i], "--offscreen") == 0)
+					spec.Headless = spec.OffscreenVulkan = true;
+				else if (strcmp(args[i], "--frames") == 0 && i + 1 < args.Count)
+					spec.FrameLimit = strtoull(args[++i], nullptr, 10);
+				else if (strcmp(args[i], "--frame-csv") == 0 && i + 1 < args.Count)
+					spec.FrameCsvPath = args[++i];
+				else if (strcmp(args[i], "--blog-dump") == 0 && i + 1 < args.Count)
+					spec.BinaryLogDumpPath = args[++i];
+				else if (strcmp(args[i], "--lang") == 0 && i + 1 < args.Count)
+					spec.Language = args[++i];
+				else if (strcmp(args[i], "--ddc") == 0 && i + 1 < args.Count)
+					spec.DerivedDataPath = args[++i];
+				else if (strcmp(args[i], "--ddc-limit") == 0 && i + 1 < args.Count)
+					spec.DerivedDataLimitMB = strtoull(args[++i], nullptr, 10);
+				else if (strcmp(args[i], "--present") == 0 && i + 1 < args.Count)
+				{
+					const char* mode = args[++i];
+					if (strcmp(mode, "fifo") == 0)
+						spec.Present = PresentMode::Fifo;
+					else if (strcmp(mode, "mailbox") == 0)
+						spec.Present = PresentMode::Mailbox;
+					else if (strcmp(mode, "immediate") == 0)
+						spec.Present = PresentMode::Immediate;
+					else
+						CORE_LOG_WRAN("Unknown present mode {0}, expected fifo, mailbox or immediate", mode);
+				}
+				else if (strcmp(args[i], "--frames-in-flight") == 0 && i + 1 < args.Count)
+					spec.FramesInFlight = (uint32_t)strtoul(args[++i], nullptr, 10);
+				else if (strcmp(args[i], "--always-render") == 0)
+					spec.RenderOnChange = false;
+			}
+		}
+	}
+
 	Application* Application::s_Instance = nullptr;
 
-	Application::Application()
+	Application::Application(const ApplicationSpecification& specification)
+		: m_Specification(specification)
 	{
 		if (s_Instance != nullptr)
 		{
@@ -14,8 +70,37 @@ namespace Luft
 		}
 		else
 		{
+			LUFT_PROFILE_THREAD("Main");
 			s_Instance = this;
-			m_Window = Window::Create(WindowProps("Luft-Editor"));
+			ApplyCommandLine(m_Specification);
+
+			BinaryLogSettings blog;
+			blog.DumpPath = m_Specification.BinaryLogDumpPath;
+			BinaryLog::Start(blog);
+
+			// assets come from the pack the build made, the loose tree has what it doesn't
+			VirtualFileSystem::Mount("resources", "resources");
+			const bool packed = VirtualFileSystem::Mount("resources", "resources.lpak");
+			DerivedDataCache::Init(m_Specification.DerivedDataPath, m_Specification.DerivedDataLimitMB * 1024 * 1024);
+			AssetStreamer::Init();
+			FileWatcher::Init();
+			// before the layers watch what they load from it, so a rebuilt pack is remounted first
+			if (packed)
+			{
+				FileWatcher::Watch("resources.lpak", nullptr, [](const larray<lstr>&, const Ref<void>&) {
+					VirtualFileSystem::Remount("resources.lpak");
+				});
+			}
+			// the ImGui layer reads its fonts from the key table
+			KeyTable::Load("resources/config/keys.lkt", "resources/config/keys.txt");
+			Localization::Init("resources/localization", m_Specification.Language);
+
+			WindowProps props(m_Specification.Name);
+			props.Headless = m_Specification.Headless;
+			props.OffscreenVulkan = m_Specification.OffscreenVulkan;
+			props.Present = m_Specification.Present;
+			props.FramesInFlight = m_Specification.FramesInFlight;
+			m_Window = Window::Create(props);
 			m_Window->SetEventCallback(BIND_EVENT_FN(Application::OnEvent));
 			m_ImGuiLayer = new ImGuiLayer();
 			PushOverlay(m_ImGuiLayer);
@@ -26,12 +111,30 @@ namespace Luft
 
 	Application::~Application()
 	{
+		Localization::Shutdown();
+		KeyTable::Unload();
+		FileWatcher::Shutdown();
+		AssetStreamer::Shutdown();
+		DerivedDataCache::Shutdown();
+		VirtualFileSystem::UnmountAll();
+		BinaryLog::Stop();
 	}
 
 	void Application::Run()
 	{
+		if (!m_Specification.FrameCsvPath.empty() && !FrameStats::BeginCsvCapture(m_Specification.FrameCsvPath))
+			CORE_LOG_ERROR("Can't capture frames to {0}", m_Specification.FrameCsvPath.c_str());
+
 		while (m_running)
 		{
+			LUFT_PROFILE_BEGIN_FRAME();
+			FrameStats::BeginFrame();
+			LUFT_PROFILE_SCOPE("RunLoop");
+			Memory::NewFrame();
+			// reloaded and loaded assets arrive here, between frames
+			FileWatcher::Update();
+			AssetStreamer::Update();
+
 			float time = Time::GetTime();
 			Timestep timestep = time - m_lastFrameTime;
 			m_lastFrameTime = time;
@@ -39,30 +142,60 @@ namespace Luft
 			if (m_windowFocused)
 			{
 				//Layer Logic Update
-				for (Layer* layer : m_LayerStack)
-					layer->OnUpdate(timestep);
+				{
+					LUFT_PROFILE_SCOPE("LayerStack OnUpdate");
+					for (Layer* layer : m_LayerStack)
+						layer->OnUpdate(timestep);
+				}
 
 				//Layer Render
 				m_ImGuiLayer->Begin();
-				for (Layer* layer : m_LayerStack)
-					layer->OnImGuiRender();
+				{
+					LUFT_PROFILE_SCOPE("LayerStack OnImGuiRender");
+					for (Layer* layer : m_LayerStack)
+						layer->OnImGuiRender();
+				}
 				m_ImGuiLayer->End();
 			}
 
-			m_Window->OnUpdate();
+			{
+				LUFT_PROFILE_SCOPE("Window OnUpdate");
+				m_Window->OnUpdate();
+			}
+
+			m_FrameCount++;
+			if (m_Specification.FrameLimit != 0 && m_FrameCount >= m_Specification.FrameLimit)
+				m_running = false;
 		}
 
-		//
+		if (m_Specification.FrameLimit != 0)
+			LogRunSummary();
+		if (FrameStats::IsCsvCapturing())
+			FrameStats::EndCsvCapture();
+	}
+
+	void Application::LogRunSummary() const
+	{
+		// closes the last frame, so every frame that ran is part of the summary
+		FrameStats::BeginFrame();
+		const FrameStatsSummary& s = FrameStats::GetSummary();
+		CORE_LOG_INFO("Ran {0} frames{1}, last {2} in the statistics (ms)", m_FrameCount, m_Window->IsHeadless() ? " headless" : "", s.SampleCount);
+		if (s.SkippedCount > 0)
+			CORE_LOG_INFO("  {0} frames unchanged, not rendered", s.SkippedCount);
+		CORE_LOG_INFO("  frame   p50 {0:.3f}  p95 {1:.3f}  p99 {2:.3f}  max {3:.3f}", s.Frame.P50, s.Frame.P95, s.Frame.P99, s.Frame.Max);
+		CORE_LOG_INFO("  cpu     p50 {0:.3f}  p95 {1:.3f}  p99 {2:.3f}  max {3:.3f}", s.Cpu.P50, s.Cpu.P95, s.Cpu.P99, s.Cpu.Max);
+		if (s.Gpu.Max > 0.0f)
+			CORE_LOG_INFO("  gpu     p50 {0:.3f}  p95 {1:.3f}  p99 {2:.3f}  max {3:.3f}", s.Gpu.P50, s.Gpu.P95, s.Gpu.P99, s.Gpu.Max);
 	}
 
-	void Application::PushLayer(Layer* layer)
+	LayerHandle Application::PushLayer(Layer* layer)
 	{
-		m_LayerStack.PushLayer(layer);
+		return m_LayerStack.PushLayer(layer);
 	}
 
-	void Application::PushOverlay(Layer* layer)
+	LayerHandle Application::PushOverlay(Layer* layer)
 	{
-		m_LayerStack.PushOverlay(layer);
+		return m_LayerStack.PushOverlay(layer);
 	}
 
 	void Application::OnEvent(Event& e)
@@ -10,28 +10,70 @@ int main(int argc, char** argv);
 
 namespace Luft
 {
+	struct ApplicationCommandLineArgs
+	{
+		int Count = 0;
+		char** Args = nullptr;
+
+		const char* operator[](int index) const { return Args[index]; }
+	};
+
+	struct ApplicationSpecification
+	{
+		lstr Name = "Luft-Editor";
+		// no display or GPU needed, ImGui frames are still built but never presented
+		bool Headless = false;
+		// headless, but ImGui is rendered offscreen through Vulkan (lavapipe when there's no GPU)
+		bool OffscreenVulkan = false;
+		// Run() returns after this many frames and logs the frame statistics, 0 runs until closed
+		uint64_t FrameLimit = 0;
+		// streams every frame to this CSV, the input Luft-Bench --frames compares against a baseline
+		lstr FrameCsvPath;
+		// raw LUFT_BLOG_* records go here too, decode with --decode-blog <path>
+		lstr BinaryLogDumpPath;
+		// pack of resources/localization to start with, switchable at runtime
+		lstr Language = "zh-CN";
+		// imported assets are kept here, point several checkouts at one directory to share it
+		lstr DerivedDataPath = "cache/ddc";
+		uint64_t DerivedDataLimitMB = 1024;
+		// switchable at runtime from the Debug menu
+		PresentMode Present = PresentMode::Fifo;
+		uint32_t FramesInFlight = 2;
+		// frames drawing the same as the last one aren't rendered, the editor idles until input
+		bool RenderOnChange = true;
+		// --headless, --offscreen, --frames <n>, --frame-csv <path>, --blog-dump <path>,
+		// --lang <language>, --ddc <dir>, --ddc-limit <MB>, --present <fifo|mailbox|immediate>,
+		// --frames-in-flight <n> and --always-render override the fields above
+		ApplicationCommandLineArgs CommandLineArgs;
+	};
+
 	class LUFT_API Application
 	{
 	public:
-		Application();
+		Application(const ApplicationSpecification& specification = ApplicationSpecification());
 		virtual ~Application();
 		void Run();
 
 	public:
-		void PushLayer(Layer* layer);
-		void PushOverlay(Layer* layer);
+		LayerHandle PushLayer(Layer* layer);
+		LayerHandle PushOverlay(Layer* layer);
+		Layer* GetLayer(LayerHandle handle) const { return m_LayerStack.Get(handle); }
 		void PushEvent(Event& eve)
 		{
 			OnEvent(eve);
 		}
 		static Application& Get() { return *s_Instance; }
 		Window& GetWindow() { return *m_Window; }
+		const ApplicationSpecification& GetSpecification() const { return m_Specification; }
 	private:
 		void OnEvent(Event& e);
 		bool OnWindowClose(WindowCloseEvent& e);
 		bool OnWindowResize(WindowResizeEvent& e);
 
+		void LogRunSummary() const;
+
 		static Application* s_Instance;
+		ApplicationSpecification m_Specification;
 		Scope<Window> m_Window;
 		ImGuiLayer* m_ImGuiLayer;
 		LayerStack m_LayerStack;
@@ -40,8 +82,10 @@ namespace Luft
 		std::atomic<bool> m_running = false;
 		std::atomic<bool> m_windowFocused = false;
 		double m_lastFrameTime = 0;
+		uint64_t m_FrameCount = 0;
 		
 	};
 
-	Application* CreateApplication();
+	// defined by the client
+	Application* CreateApplication(ApplicationCommandLineArgs args);
 }
\ No newline at end of file
@@ -0,0 +1,463 @@
+#include "AssetStreamer.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+#include "Luft/Core/FileReader.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/VirtualFileSystem.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr uint32_t PriorityCount = (uint32_t)AssetPriority::Count;
+		// the most of one file a batch reads, so a file queued later waits for one batch at most
+		constexpr uint64_t ChunkSize = 1u << 20;
+
+		enum class RequestStage : uint8_t
+		{
+			Read,
+			Decode,
+			Done
+		};
+
+		struct AssetRequest
+		{
+			AssetHandle Handle;
+			lstr Path;
+			AssetDecodeFn Decode;
+			AssetReadyFn Ready;
+			// written by the threads working on it, Ready, Failed and Cancelled only by the main thread
+			std::atomic<AssetState> State{ AssetState::Queued };
+			std::atomic<bool> Cancelled{ false };
+
+			// under s_Mutex
+			AssetPriority Priority = AssetPriority::Normal;
+			RequestStage At = RequestStage::Read;
+			bool InBatch = false;
+
+			// the I/O thread's until the read is done, then the decode thread's
+			bool Located = false;
+			VirtualFileLocation Location;
+			intptr_t File = FileReader::InvalidFile;
+			uint64_t ReadBytes = 0;
+			larray<uint8_t> Bytes;
+
+			// set before it's queued as finished
+			Ref<void> Asset;
+			bool Ok = false;
+		};
+
+		typedef larray<Ref<AssetRequest>> RequestQueue;
+
+		std::mutex s_Mutex;
+		std::condition_variable s_ReadWake;
+		std::condition_variable s_DecodeWake;
+		bool s_Stop = false;
+		// in the order they were asked for, a request is in the queue of its stage and priority
+		// until a thread takes it. Reads stay queued while they are in a batch
+		RequestQueue s_ReadQueues[PriorityCount];
+		RequestQueue s_DecodeQueues[PriorityCount];
+		RequestQueue s_Finished;
+
+		std::thread* s_IoThread = nullptr;
+		larray<std::thread*> s_DecodeThreads;
+		uint32_t s_QueueDepth = 1;
+		std::atomic<uint64_t> s_BytesRead{ 0 };
+
+		// main thread
+		lslotmap<Ref<AssetRequest>> s_Requests;
+		RequestQueue s_Delivering;
+		AssetStreamerStats s_Stats;
+
+		bool HasAny(const RequestQueue* queues)
+		{
+			for (uint32_t p = 0; p < PriorityCount; p++)
+			{
+				if (!queues[p].empty())
+					return true;
+			}
+			return false;
+		}
+
+		bool RemoveFrom(RequestQueue& queue, const AssetRequest* request)
+		{
+			for (size_t i = 0; i < queue.size(); i++)
+			{
+				if (queue[i].get() == request)
+				{
+					queue.erase(i);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// under s_Mutex
+		void Finish(const Ref<AssetRequest>& request, bool ok)
+		{
+			request->At = RequestStage::Done;
+			if (request->Cancelled)
+				return;
+			request->Ok = ok;
+			s_Finished.push_back(request);
+		}
+
+		// opens the request's file and makes room for it, false if it can't be read
+		bool Prepare(FileReader& reader, AssetRequest& request)
+		{
+			request.Located = true;
+			request.State = AssetState::Reading;
+			if (!VirtualFileSystem::Locate(request.Path, request.Location))
+			{
+				CORE_LOG_ERROR("Asset {0} not found", request.Path.c_str());
+				return false;
+			}
+			request.File = reader.OpenFile(request.Location.FilePath);
+			if (request.File == FileReader::InvalidFile)
+			{
+				CORE_LOG_ERROR("Can't open {0} for asset {1}", request.Location.FilePath.c_str(), request.Path.c_str());
+				return false;
+			}
+			request.Bytes.resize((size_t)request.Location.StoredSize);
+			return true;
+		}
+
+		void IoMain()
+		{
+			LUFT_PROFILE_THREAD("Asset I/O");
+			FileReader reader;
+			reader.Init(s_QueueDepth);
+			larray<Ref<AssetRequest>> batch;
+			larray<uint64_t> scheduled;
+			larray<uint8_t> failed;
+			larray<FileReadOp> ops;
+			larray<uint32_t> opOwners;
+			uint32_t mountGeneration = VirtualFileSystem::GetMountGeneration();
+
+			for (;;)
+			{
+				batch.clear();
+				// a remounted pack is a new file under the same path, reads that started go on in the old one
+				if (mountGeneration != VirtualFileSystem::GetMountGeneration())
+				{
+					mountGeneration = VirtualFileSystem::GetMountGeneration();
+					reader.RetireFiles();
+				}
+				{
+					std::unique_lock<std::mutex> lock(s_Mutex);
+					if (!s_Stop && !HasAny(s_ReadQueues))
+					{
+						// nothing stays open between bursts
+						lock.unlock();
+						reader.CloseFiles();
+						lock.lock();
+						s_ReadWake.wait(lock, [] { return s_Stop || HasAny(s_ReadQueues); });
+					}
+					if (s_Stop)
+						break;
+					for (uint32_t p = 0; p < PriorityCount && batch.size() < s_QueueDepth; p++)
+					{
+						// prefetching doesn't share a batch, it waits until nothing else is queued
+						if (p == (uint32_t)AssetPriority::Background && !batch.empty())
+							break;
+						for (size_t i = 0; i < s_ReadQueues[p].size() && batch.size() < s_QueueDepth; i++)
+						{
+							s_ReadQueues[p][i]->InBatch = true;
+							batch.push_back(s_ReadQueues[p][i]);
+						}
+					}
+				}
+
+				LUFT_PROFILE_SCOPE("Read assets");
+				scheduled.resize(batch.size());
+				failed.resize(batch.size());
+				for (size_t i = 0; i < batch.size(); i++)
+				{
+					AssetRequest& request = *batch[i];
+					failed[i] = request.Cancelled || (!request.Located && !Prepare(reader, request));
+					scheduled[i] = request.ReadBytes;
+				}
+
+				// a chunk of every file, then more of them while the queue depth allows
+				ops.clear();
+				opOwners.clear();
+				for (bool added = true; added && ops.size() < s_QueueDepth;)
+				{
+					added = false;
+					for (uint32_t i = 0; i < batch.size() && ops.size() < s_QueueDepth; i++)
+					{
+						AssetRequest& request = *batch[i];
+						if (failed[i] || scheduled[i] == request.Location.StoredSize)
+							continue;
+						const uint64_t size = std::min(ChunkSize, request.Location.StoredSize - scheduled[i]);
+						ops.push_back({ request.File, request.Location.Offset + scheduled[i], request.Bytes.data() + scheduled[i], (size_t)size, false });
+						opOwners.push_back(i);
+						scheduled[i] += size;
+						added = true;
+					}
+				}
+				reader.ReadBatch(ops.data(), (uint32_t)ops.size());
+
+				uint64_t bytesRead = 0;
+				for (size_t i = 0; i < ops.size(); i++)
+				{
+					if (ops[i].Ok)
+						bytesRead += ops[i].Size;
+					else if (!failed[opOwners[i]])
+					{
+						CORE_LOG_ERROR("Can't read {0} for asset {1}", batch[opOwners[i]]->Location.FilePath.c_str(), batch[opOwners[i]]->Path.c_str());
+						failed[opOwners[i]] = true;
+					}
+				}
+				s_BytesRead += bytesRead;
+
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				for (size_t i = 0; i < batch.size(); i++)
+				{
+					const Ref<AssetRequest>& request = batch[i];
+					request->InBatch = false;
+					request->ReadBytes = scheduled[i];
+					if (!failed[i] && request->ReadBytes < request->Location.StoredSize)
+						continue;
+					RemoveFrom(s_ReadQueues[(uint32_t)request->Priority], request.get());
+					if (failed[i] || request->Cancelled)
+					{
+						request->Bytes.clear();
+						Finish(request, false);
+						continue;
+					}
+					request->At = RequestStage::Decode;
+					request->State = AssetState::Decoding;
+					s_DecodeQueues[(uint32_t)request->Priority].push_back(request);
+					s_DecodeWake.notify_one();
+				}
+			}
+			reader.Shutdown();
+		}
+
+		void DecodeMain()
+		{
+			LUFT_PROFILE_THREAD("Asset decode");
+			for (;;)
+			{
+				Ref<AssetRequest> request;
+				{
+					std::unique_lock<std::mutex> lock(s_Mutex);
+					s_DecodeWake.wait(lock, [] { return s_Stop || HasAny(s_DecodeQueues); });
+					if (s_Stop)
+						return;
+					for (uint32_t p = 0; p < PriorityCount && !request; p++)
+					{
+						if (s_DecodeQueues[p].empty())
+							continue;
+						request = s_DecodeQueues[p][0];
+						s_DecodeQueues[p].erase(0);
+					}
+				}
+
+				bool ok = false;
+				if (!request->Cancelled)
+				{
+					LUFT_PROFILE_SCOPE("Decode asset");
+					ok = VirtualFileSystem::Decode(request->Location, request->Bytes);
+					if (!ok)
+						CORE_LOG_ERROR("{0} doesn't decompress", request->Path.c_str());
+					else if (request->Decode)
+					{
+						ok = request->Decode(request->Bytes, request->Asset);
+						if (!ok)
+							CORE_LOG_ERROR("Can't decode asset {0}", request->Path.c_str());
+					}
+					else
+					{
+						Ref<larray<uint8_t>> bytes = CreateRef<larray<uint8_t>>();
+						bytes->swap(request->Bytes);
+						request->Asset = bytes;
+					}
+				}
+				larray<uint8_t>().swap(request->Bytes);
+
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				Finish(request, ok);
+			}
+		}
+	}
+
+	void AssetStreamer::Init(uint32_t decodeThreads, uint32_t queueDepth)
+	{
+		Shutdown();
+		if (decodeThreads == 0)
+			decodeThreads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		s_QueueDepth = std::max(1u, queueDepth);
+		s_Stop = false;
+		s_IoThread = new std::thread(IoMain);
+		for (uint32_t i = 0; i < decodeThreads; i++)
+			s_DecodeThreads.push_back(new std::thread(DecodeMain));
+		CORE_LOG_INFO("Asset streaming with {0} decode threads", decodeThreads);
+	}
+
+	void AssetStreamer::Shutdown()
+	{
+		if (!s_IoThread)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_Stop = true;
+		}
+		s_ReadWake.notify_all();
+		s_DecodeWake.notify_all();
+		s_IoThread->join();
+		delete s_IoThread;
+		s_IoThread = nullptr;
+		for (std::thread* thread : s_DecodeThreads)
+		{
+			thread->join();
+			delete thread;
+		}
+		s_DecodeThreads.clear();
+
+		for (uint32_t p = 0; p < PriorityCount; p++)
+		{
+			s_ReadQueues[p].clear();
+			s_DecodeQueues[p].clear();
+		}
+		s_Finished.clear();
+		s_Delivering.clear();
+		s_Requests.clear();
+		s_Stats.Pending = 0;
+	}
+
+	AssetHandle AssetStreamer::Load(const lstr& path, AssetPriority priority, AssetDecodeFn decode, AssetReadyFn ready)
+	{
+		if (!s_IoThread)
+		{
+			CORE_LOG_ERROR("AssetStreamer isn't running, can't load {0}", path.c_str());
+			return AssetHandle();
+		}
+		Ref<AssetRequest> request = CreateRef<AssetRequest>();
+		request->Path = path;
+		request->Decode = std::move(decode);
+		request->Ready = std::move(ready);
+		request->Priority = priority < AssetPriority::Count ? priority : AssetPriority::Background;
+		request->Handle = s_Requests.insert(request);
+		if (request->Handle.isNull())
+			return AssetHandle();
+		s_Stats.Pending++;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_ReadQueues[(uint32_t)request->Priority].push_back(request);
+		}
+		s_ReadWake.notify_one();
+		return request->Handle;
+	}
+
+	void AssetStreamer::SetPriority(AssetHandle handle, AssetPriority priority)
+	{
+		Ref<AssetRequest>* found = s_Requests.get(handle);
+		if (!found || priority >= AssetPriority::Count)
+			return;
+		AssetRequest& request = **found;
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (request.Priority == priority)
+			return;
+		RequestQueue* queues = request.At == RequestStage::Read ? s_ReadQueues : request.At == RequestStage::Decode ? s_DecodeQueues : nullptr;
+		// a decode that started isn't queued anymore
+		if (queues && RemoveFrom(queues[(uint32_t)request.Priority], &request))
+			queues[(uint32_t)priority].push_back(*found);
+		request.Priority = priority;
+	}
+
+	void AssetStreamer::Release(AssetHandle handle)
+	{
+		Ref<AssetRequest>* found = s_Requests.get(handle);
+		if (!found)
+			return;
+		Ref<AssetRequest> request = *found;
+		s_Requests.erase(handle);
+		const AssetState state = request->State;
+		if (state == AssetState::Ready || state == AssetState::Failed)
+			return;
+
+		request->Cancelled = true;
+		request->State = AssetState::Cancelled;
+		s_Stats.Pending--;
+		s_Stats.Cancelled++;
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		// the threads drop it when they get to it, unless it can go right away
+		if (request->At == RequestStage::Read && !request->InBatch)
+			RemoveFrom(s_ReadQueues[(uint32_t)request->Priority], request.get());
+		else if (request->At == RequestStage::Decode)
+			RemoveFrom(s_DecodeQueues[(uint32_t)request->Priority], request.get());
+	}
+
+	AssetState AssetStreamer::GetState(AssetHandle handle)
+	{
+		const Ref<AssetRequest>* found = s_Requests.get(handle);
+		return found ? (*found)->State.load() : AssetState::Cancelled;
+	}
+
+	Ref<void> AssetStreamer::GetAsset(AssetHandle handle)
+	{
+		const Ref<AssetRequest>* found = s_Requests.get(handle);
+		return found && (*found)->State == AssetState::Ready ? (*found)->Asset : nullptr;
+	}
+
+	uint32_t AssetStreamer::Update(float budgetMs)
+	{
+		LUFT_PROFILE_FUNCTION();
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (!s_Finished.empty())
+			{
+				s_Delivering.append(s_Finished);
+				s_Finished.clear();
+			}
+		}
+		if (s_Delivering.empty())
+			return 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		uint32_t delivered = 0;
+		size_t i = 0;
+		for (; i < s_Delivering.size(); i++)
+		{
+			if (delivered > 0 && std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() > budgetMs)
+				break;
+			AssetRequest& request = *s_Delivering[i];
+			if (request.Cancelled)
+				continue;
+			s_Stats.Pending--;
+			delivered++;
+			request.Decode = nullptr;
+			if (!request.Ok)
+			{
+				request.State = AssetState::Failed;
+				request.Ready = nullptr;
+				s_Stats.Failed++;
+				continue;
+			}
+			request.State = AssetState::Ready;
+			s_Stats.Completed++;
+			AssetReadyFn ready = std::move(request.Ready);
+			request.Ready = nullptr;
+			if (ready)
+				ready(request.Handle, request.Asset);
+		}
+		s_Delivering.erase(0, i);
+		return delivered;
+	}
+
+	AssetStreamerStats AssetStreamer::GetStats()
+	{
+		AssetStreamerStats stats = s_Stats;
+		stats.BytesRead = s_BytesRead;
+		return stats;
+	}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Core/lslotmap.h"
+
+namespace Luft {
+
+	typedef lhandle32 AssetHandle;
+
+	// the order assets are read and decoded in, and within a class the order they were asked for
+	enum class AssetPriority : uint8_t
+	{
+		// needed to draw the next frames, e.g. the UI font
+		Immediate,
+		High,
+		Normal,
+		// prefetching, only read while nothing else waits
+		Background,
+		Count
+	};
+
+	enum class AssetState : uint8_t
+	{
+		Queued,
+		Reading,
+		Decoding,
+		Ready,
+		Failed,
+		// released before it was ready, also what a stale handle reports
+		Cancelled
+	};
+
+	// runs on a decode thread: turns the file's bytes into the asset, which may take them over.
+	// False fails the asset
+	typedef std::function<bool(larray<uint8_t>& bytes, Ref<void>& asset)> AssetDecodeFn;
+	// runs on the main thread from Update, between frames
+	typedef std::function<void(AssetHandle handle, const Ref<void>& asset)> AssetReadyFn;
+
+	struct AssetStreamerStats
+	{
+		// loaded, not yet delivered
+		uint32_t Pending = 0;
+		uint64_t Completed = 0;
+		uint64_t Failed = 0;
+		uint64_t Cancelled = 0;
+		uint64_t BytesRead = 0;
+	};
+
+	// Loads assets in the background so asking for one never blocks a frame. One I/O thread reads
+	// in priority order through a FileReader, a few chunks of every queued file per batch so an
+	// urgent asset doesn't wait behind a large one; decode threads then decompress pack entries and
+	// run each asset's decode function. Finished assets are handed to the main thread in Update,
+	// where GetState turns Ready and the ready callback runs. Until then Get returns a placeholder.
+	// Paths go through the VirtualFileSystem. Everything but the decode functions is main thread only.
+	class LUFT_API AssetStreamer
+	{
+	public:
+		// decodeThreads 0 picks one less than there are cores, at least one
+		static void Init(uint32_t decodeThreads = 0, uint32_t queueDepth = 32);
+		// stops the threads, what hasn't been delivered is dropped
+		static void Shutdown();
+
+		// without a decode function the asset is the file's larray<uint8_t>
+		static AssetHandle Load(const lstr& path, AssetPriority priority, AssetDecodeFn decode = nullptr, AssetReadyFn ready = nullptr);
+		// takes effect for reads and decodes that haven't started
+		static void SetPriority(AssetHandle handle, AssetPriority priority);
+		// drops the asset, cancelling it when it's still being loaded. The handle goes stale
+		static void Release(AssetHandle handle);
+
+		static AssetState GetState(AssetHandle handle);
+		// null until Ready
+		static Ref<void> GetAsset(AssetHandle handle);
+		template <typename T>
+		static Ref<T> Get(AssetHandle handle, const Ref<T>& placeholder = nullptr)
+		{
+			Ref<void> asset = GetAsset(handle);
+			return asset ? std::static_pointer_cast<T>(asset) : placeholder;
+		}
+
+		// delivers finished assets until budgetMs is spent, at least one. Returns how many
+		static uint32_t Update(float budgetMs = 2.0f);
+
+		static AssetStreamerStats GetStats();
+	};
+
+}
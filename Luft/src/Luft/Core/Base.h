@@ -7,8 +7,11 @@
 #else
 #define LUFT_API __declspec(dllimport)
 #endif
+#elif defined(LUFT_PLATFORM_LINUX)
+// static library only, nothing to export
+#define LUFT_API
 #else
-#error Luft only supports Windows!
+#error Luft only supports Windows and Linux!
 #endif
 
 #define LUFT_RENDERER_BACKEND_VULKAN
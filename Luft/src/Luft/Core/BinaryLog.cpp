@@ -0,0 +1,541 @@
+#include "BinaryLog.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <new>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "spdlog/fmt/bundled/args.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/Memory.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	namespace
+	{
+		// every record starts 8 byte aligned with this header, the argument bytes follow
+		struct RecordHeader
+		{
+			// 0 marks padding up to the end of the ring
+			uint32_t SiteId;
+			uint32_t Size;
+			uint64_t Ticks;
+		};
+
+		struct ThreadRing
+		{
+			uint8_t* Data;
+			uint32_t Size;
+			uint32_t Id;
+			// head is written by the owning thread only, tail by the drain thread only
+			alignas(64) std::atomic<uint32_t> Head;
+			alignas(64) std::atomic<uint32_t> Tail;
+			std::atomic<uint64_t> Dropped;
+			ThreadRing* Next;
+		};
+
+		// what formatting needs from a site, owned so it also works for sites read from a dump
+		struct SiteInfo
+		{
+			lstr Format;
+			lstr File;
+			int Line = 0;
+			spdlog::level::level_enum Level = spdlog::level::info;
+			uint8_t ArgCount = 0;
+			BinaryLogArg ArgTypes[BinaryLogSite::MaxArgs] = {};
+		};
+
+		// conversion from ticks to wall clock, from two points of both clocks
+		struct ClockSync
+		{
+			uint64_t Ticks0 = 0;
+			int64_t Ns0 = 0;
+			double NsPerTick = 0.0;
+
+			spdlog::log_clock::time_point ToTime(uint64_t ticks) const
+			{
+				const int64_t ns = Ns0 + (int64_t)((double)(int64_t)(ticks - Ticks0) * NsPerTick);
+				return spdlog::log_clock::time_point(std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(ns)));
+			}
+		};
+
+		constexpr char DumpMagic[8] = { 'L', 'B', 'L', 'O', 'G', '1', 0, 0 };
+
+		std::atomic<ThreadRing*> s_Rings{ nullptr };
+		std::atomic<uint32_t> s_NextRingId{ 0 };
+		thread_local ThreadRing* t_Ring = nullptr;
+		thread_local uint32_t t_PendingHead = 0;
+
+		std::mutex s_SiteMutex;
+		larray<BinaryLogSite*> s_Sites;
+
+		BinaryLogSettings s_Settings;
+		std::thread s_Thread;
+		std::mutex s_WakeMutex;
+		std::condition_variable s_Wake;
+		bool s_StopRequested = false;
+
+		// drain thread state
+		FILE* s_DumpFile = nullptr;
+		larray<SiteInfo> s_KnownSites;
+		ClockSync s_Clock;
+		uint64_t s_StartTicks = 0;
+		std::chrono::steady_clock::time_point s_StartSteady;
+
+		uint32_t Align8(uint32_t size) { return (size + 7) & ~7u; }
+
+		int64_t SystemNowNs()
+		{
+			using namespace std::chrono;
+			return (int64_t)duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+		}
+
+		ThreadRing* CreateRing(uint32_t size)
+		{
+			ThreadRing* ring = (ThreadRing*)Memory::Allocate(sizeof(ThreadRing), MemoryTag::Log);
+			new (ring) ThreadRing();
+			ring->Data = (uint8_t*)Memory::Allocate(size, MemoryTag::Log);
+			ring->Size = size;
+			ring->Id = s_NextRingId.fetch_add(1, std::memory_order_relaxed);
+			ring->Head.store(0, std::memory_order_relaxed);
+			ring->Tail.store(0, std::memory_order_relaxed);
+			ring->Dropped.store(0, std::memory_order_relaxed);
+
+			// rings are never freed, a thread that exits leaves its ring for the next drain
+			ThreadRing* head = s_Rings.load(std::memory_order_relaxed);
+			do
+			{
+				ring->Next = head;
+			} while (!s_Rings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+			return ring;
+		}
+
+		template <typename T>
+		T Read(const uint8_t*& src)
+		{
+			T v;
+			memcpy(&v, src, sizeof(T));
+			src += sizeof(T);
+			return v;
+		}
+
+		// false if the arguments don't match the site, e.g. a damaged dump
+		bool FormatRecord(const SiteInfo& site, const uint8_t* args, uint32_t size, fmt::memory_buffer& out)
+		{
+			const uint8_t* src = args;
+			const uint8_t* end = args + size;
+			fmt::dynamic_format_arg_store<fmt::format_context> store;
+			for (uint32_t i = 0; i < site.ArgCount; i++)
+			{
+				const uint32_t need = site.ArgTypes[i] == BinaryLogArg::String ? 4 : (site.ArgTypes[i] == BinaryLogArg::Bool || site.ArgTypes[i] == BinaryLogArg::Char ? 1 : 8);
+				if (src + need > end)
+					return false;
+				switch (site.ArgTypes[i])
+				{
+				case BinaryLogArg::Int: store.push_back(Read<int64_t>(src)); break;
+				case BinaryLogArg::UInt: store.push_back(Read<uint64_t>(src)); break;
+				case BinaryLogArg::Double: store.push_back(Read<double>(src)); break;
+				case BinaryLogArg::Bool: store.push_back(Read<uint8_t>(src) != 0); break;
+				case BinaryLogArg::Char: store.push_back((char)Read<uint8_t>(src)); break;
+				case BinaryLogArg::Pointer: store.push_back((const void*)(uintptr_t)Read<uint64_t>(src)); break;
+				case BinaryLogArg::String:
+				{
+					const uint32_t len = Read<uint32_t>(src);
+					if (src + len > end)
+						return false;
+					// a view into the record, which outlives the vformat below
+					store.push_back(fmt::string_view((const char*)src, len));
+					src += len;
+					break;
+				}
+				}
+			}
+
+			const size_t start = out.size();
+			try
+			{
+				fmt::vformat_to(fmt::appender(out), fmt::string_view(site.Format.c_str(), site.Format.size()), store);
+			}
+			catch (const fmt::format_error& e)
+			{
+				out.resize(start);
+				fmt::format_to(fmt::appender(out), "<bad format \"{}\": {}>", site.Format.c_str(), e.what());
+			}
+			return true;
+		}
+
+		void DumpWrite(const void* data, size_t size)
+		{
+			fwrite(data, 1, size, s_DumpFile);
+		}
+
+		void DumpString(const lstr& s)
+		{
+			const uint16_t len = (uint16_t)(s.size() < 0xffff ? s.size() : 0xffff);
+			DumpWrite(&len, 2);
+			DumpWrite(s.c_str(), len);
+		}
+
+		void DumpClock(uint64_t ticks, int64_t ns)
+		{
+			DumpWrite("C", 1);
+			DumpWrite(&ticks, 8);
+			DumpWrite(&ns, 8);
+		}
+
+		// picks up sites registered since the last drain. Sites register before their first record
+		// is written, so every id a drain meets is known after this
+		void SyncSites()
+		{
+			std::lock_guard<std::mutex> lock(s_SiteMutex);
+			for (size_t i = s_KnownSites.size(); i < s_Sites.size(); i++)
+			{
+				const BinaryLogSite* site = s_Sites[i];
+				SiteInfo info;
+				info.Format = site->Format;
+				info.File = site->File;
+				info.Line = site->Line;
+				info.Level = site->Level;
+				info.ArgCount = site->ArgCount;
+				memcpy(info.ArgTypes, site->ArgTypes, sizeof(info.ArgTypes));
+
+				if (s_DumpFile)
+				{
+					const uint32_t id = (uint32_t)i + 1;
+					const uint32_t line = (uint32_t)info.Line;
+					const uint8_t level = (uint8_t)info.Level;
+					DumpWrite("S", 1);
+					DumpWrite(&id, 4);
+					DumpWrite(&level, 1);
+					DumpWrite(&info.ArgCount, 1);
+					DumpWrite(info.ArgTypes, info.ArgCount);
+					DumpWrite(&line, 4);
+					DumpString(info.Format);
+					DumpString(info.File);
+				}
+				s_KnownSites.push_back(std::move(info));
+			}
+		}
+
+		void UpdateClock()
+		{
+			const uint64_t ticks = Profiler::Now();
+			const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_StartSteady).count();
+			if (ticks > s_StartTicks && ns > 1000000.0)
+				s_Clock.NsPerTick = ns / (double)(ticks - s_StartTicks);
+			if (s_DumpFile)
+				DumpClock(ticks, s_Clock.Ns0 + (int64_t)ns);
+		}
+
+		void Drain()
+		{
+			LUFT_PROFILE_FUNCTION();
+			SyncSites();
+			UpdateClock();
+
+			fmt::memory_buffer text;
+			const std::shared_ptr<spdlog::logger>& logger = Log::GetHotLogger();
+			for (ThreadRing* ring = s_Rings.load(std::memory_order_acquire); ring; ring = ring->Next)
+			{
+				const uint32_t mask = ring->Size - 1;
+				uint32_t tail = ring->Tail.load(std::memory_order_relaxed);
+				const uint32_t head = ring->Head.load(std::memory_order_acquire);
+				while (tail != head)
+				{
+					const uint32_t offset = tail & mask;
+					// padding may be as short as 8 bytes, so only its site id is read
+					uint32_t siteId;
+					memcpy(&siteId, ring->Data + offset, sizeof(siteId));
+					if (siteId == 0)
+					{
+						tail += ring->Size - offset;
+						continue;
+					}
+					RecordHeader header;
+					memcpy(&header, ring->Data + offset, sizeof(header));
+
+					const uint8_t* args = ring->Data + offset + sizeof(RecordHeader);
+					if (s_DumpFile)
+					{
+						DumpWrite("R", 1);
+						DumpWrite(&ring->Id, 4);
+						DumpWrite(&header, sizeof(header));
+						DumpWrite(args, header.Size);
+					}
+					if (s_Settings.FormatToLog && logger && header.SiteId <= s_KnownSites.size())
+					{
+						const SiteInfo& site = s_KnownSites[header.SiteId - 1];
+						text.clear();
+						FormatRecord(site, args, header.Size, text);
+						logger->log(s_Clock.ToTime(header.Ticks), spdlog::source_loc{ site.File.c_str(), site.Line, "" }, site.Level,
+							spdlog::string_view_t(text.data(), text.size()));
+					}
+					tail += sizeof(RecordHeader) + Align8(header.Size);
+				}
+				ring->Tail.store(tail, std::memory_order_release);
+			}
+			if (s_DumpFile)
+				fflush(s_DumpFile);
+		}
+
+		void DrainThread()
+		{
+			LUFT_PROFILE_THREAD("BinaryLog");
+			std::unique_lock<std::mutex> lock(s_WakeMutex);
+			while (!s_StopRequested)
+			{
+				s_Wake.wait_for(lock, std::chrono::milliseconds(s_Settings.DrainIntervalMs));
+				lock.unlock();
+				Drain();
+				lock.lock();
+			}
+		}
+	}
+
+	std::atomic<bool> BinaryLog::s_Running{ false };
+
+	bool BinaryLog::Start(const BinaryLogSettings& settings)
+	{
+		if (s_Running.load(std::memory_order_relaxed))
+			return false;
+
+		s_Settings = settings;
+		uint32_t size = 4096;
+		while (size < settings.RingBytes && size < (1u << 30))
+			size <<= 1;
+		s_Settings.RingBytes = size;
+
+		if (!settings.DumpPath.isEmpty())
+		{
+			s_DumpFile = fopen(settings.DumpPath.c_str(), "wb");
+			if (!s_DumpFile)
+			{
+				CORE_LOG_ERROR("BinaryLog: can't open {0}", settings.DumpPath.c_str());
+				return false;
+			}
+			DumpWrite(DumpMagic, sizeof(DumpMagic));
+		}
+
+		s_StartTicks = Profiler::Now();
+		s_StartSteady = std::chrono::steady_clock::now();
+		s_Clock.Ticks0 = s_StartTicks;
+		s_Clock.Ns0 = SystemNowNs();
+		s_Clock.NsPerTick = Profiler::TicksToMicroseconds(1000000) / 1000000.0 * 1000.0;
+		if (s_DumpFile)
+			DumpClock(s_Clock.Ticks0, s_Clock.Ns0);
+
+		// records a previous session left behind would reference its sites and clock
+		s_KnownSites.clear();
+		for (ThreadRing* ring = s_Rings.load(std::memory_order_acquire); ring; ring = ring->Next)
+			ring->Tail.store(ring->Head.load(std::memory_order_acquire), std::memory_order_release);
+
+		s_StopRequested = false;
+		s_Running.store(true, std::memory_order_release);
+		s_Thread = std::thread(DrainThread);
+		return true;
+	}
+
+	void BinaryLog::Stop()
+	{
+		if (!s_Running.exchange(false))
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(s_WakeMutex);
+			s_StopRequested = true;
+		}
+		s_Wake.notify_one();
+		s_Thread.join();
+
+		// a statement that passed the running check just before the store above may still be
+		// writing. Its record is lost if it lands after this drain
+		Drain();
+		if (s_DumpFile)
+		{
+			fclose(s_DumpFile);
+			s_DumpFile = nullptr;
+		}
+	}
+
+	uint64_t BinaryLog::GetDroppedCount()
+	{
+		uint64_t dropped = 0;
+		for (ThreadRing* ring = s_Rings.load(std::memory_order_acquire); ring; ring = ring->Next)
+			dropped += ring->Dropped.load(std::memory_order_relaxed);
+		return dropped;
+	}
+
+	uint32_t BinaryLog::RegisterSite(BinaryLogSite& site, const BinaryLogArg* types, uint32_t count)
+	{
+		std::lock_guard<std::mutex> lock(s_SiteMutex);
+		uint32_t id = site.Id.load(std::memory_order_relaxed);
+		if (id != 0)
+			return id;
+
+		site.ArgCount = (uint8_t)count;
+		memcpy(site.ArgTypes, types, count * sizeof(BinaryLogArg));
+		s_Sites.push_back(&site);
+		id = (uint32_t)s_Sites.size();
+		site.Id.store(id, std::memory_order_release);
+		return id;
+	}
+
+	uint8_t* BinaryLog::BeginRecord(uint32_t siteId, uint32_t size)
+	{
+		ThreadRing* ring = t_Ring;
+		if (!ring)
+			ring = t_Ring = CreateRing(s_Settings.RingBytes);
+
+		const uint32_t total = (uint32_t)sizeof(RecordHeader) + Align8(size);
+		const uint32_t head = ring->Head.load(std::memory_order_relaxed);
+		const uint32_t tail = ring->Tail.load(std::memory_order_acquire);
+		const uint32_t offset = head & (ring->Size - 1);
+		const uint32_t contiguous = ring->Size - offset;
+		// a record never wraps, the rest of the ring is padded instead
+		const uint32_t needed = contiguous < total ? contiguous + total : total;
+		if (total > ring->Size / 2 || ring->Size - (head - tail) < needed)
+		{
+			ring->Dropped.store(ring->Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		uint32_t start = head;
+		if (contiguous < total)
+		{
+			const RecordHeader pad = { 0, 0, 0 };
+			memcpy(ring->Data + offset, &pad, contiguous < sizeof(pad) ? contiguous : sizeof(pad));
+			start += contiguous;
+		}
+
+		uint8_t* dst = ring->Data + (start & (ring->Size - 1));
+		const RecordHeader header = { siteId, size, Profiler::Now() };
+		memcpy(dst, &header, sizeof(header));
+		t_PendingHead = start + total;
+		return dst + sizeof(RecordHeader);
+	}
+
+	void BinaryLog::EndRecord()
+	{
+		t_Ring->Head.store(t_PendingHead, std::memory_order_release);
+	}
+
+	bool BinaryLog::DecodeDump(const lstr& path, FILE* out)
+	{
+		FILE* f = fopen(path.c_str(), "rb");
+		if (!f)
+			return false;
+		larray<uint8_t> data;
+		uint8_t buf[16384];
+		size_t n;
+		while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		{
+			const size_t old = data.size();
+			data.resize(old + n);
+			memcpy(data.data() + old, buf, n);
+		}
+		fclose(f);
+		if (data.size() < sizeof(DumpMagic) || memcmp(data.data(), DumpMagic, sizeof(DumpMagic)) != 0)
+			return false;
+
+		const uint8_t* begin = data.data() + sizeof(DumpMagic);
+		const uint8_t* end = data.data() + data.size();
+
+		// first pass: sites and the first and last clock points, which give the tick rate for the
+		// whole dump
+		larray<SiteInfo> sites;
+		ClockSync clock;
+		bool haveClock = false;
+		uint64_t lastTicks = 0;
+		int64_t lastNs = 0;
+		larray<const uint8_t*> records;
+		for (const uint8_t* p = begin; p < end;)
+		{
+			const char tag = (char)*p++;
+			if (tag == 'C' && p + 16 <= end)
+			{
+				lastTicks = Read<uint64_t>(p);
+				lastNs = Read<int64_t>(p);
+				if (!haveClock)
+				{
+					clock.Ticks0 = lastTicks;
+					clock.Ns0 = lastNs;
+					haveClock = true;
+				}
+			}
+			else if (tag == 'S' && p + 6 <= end)
+			{
+				SiteInfo info;
+				const uint32_t id = Read<uint32_t>(p);
+				if (id == 0)
+					break;
+				info.Level = (spdlog::level::level_enum)Read<uint8_t>(p);
+				info.ArgCount = Read<uint8_t>(p);
+				if (info.ArgCount > BinaryLogSite::MaxArgs || p + info.ArgCount + 4 > end)
+					break;
+				memcpy(info.ArgTypes, p, info.ArgCount);
+				p += info.ArgCount;
+				info.Line = (int)Read<uint32_t>(p);
+				for (lstr* s : { &info.Format, &info.File })
+				{
+					if (p + 2 > end)
+						break;
+					const uint16_t len = Read<uint16_t>(p);
+					if (p + len > end)
+						break;
+					s->assign((const char*)p, len);
+					p += len;
+				}
+				if (sites.size() < id)
+					sites.resize(id);
+				sites[id - 1] = std::move(info);
+			}
+			else if (tag == 'R' && p + 4 + sizeof(RecordHeader) <= end)
+			{
+				records.push_back(p);
+				RecordHeader header;
+				memcpy(&header, p + 4, sizeof(header));
+				p += 4 + sizeof(header) + header.Size;
+			}
+			else
+				break; // truncated, e.g. the process died mid-write
+		}
+		if (lastTicks > clock.Ticks0)
+			clock.NsPerTick = (double)(lastNs - clock.Ns0) / (double)(lastTicks - clock.Ticks0);
+
+		// second pass: the records, in the order they were drained
+		fmt::memory_buffer text;
+		for (const uint8_t* p : records)
+		{
+			const uint32_t thread = Read<uint32_t>(p);
+			RecordHeader header;
+			memcpy(&header, p, sizeof(header));
+			p += sizeof(header);
+			if (p + header.Size > end)
+				break;
+
+			text.clear();
+			const spdlog::log_clock::time_point time = clock.ToTime(header.Ticks);
+			const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+			const time_t seconds = (time_t)(ms / 1000);
+			char stamp[32];
+			strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&seconds));
+			if (header.SiteId == 0 || header.SiteId > sites.size() || sites[header.SiteId - 1].Format.isEmpty())
+			{
+				fprintf(out, "[%s.%03d] [T%u] <unknown site %u>\n", stamp, (int)(ms % 1000), thread, header.SiteId);
+				continue;
+			}
+
+			const SiteInfo& site = sites[header.SiteId - 1];
+			if (!FormatRecord(site, p, header.Size, text))
+				fmt::format_to(fmt::appender(text), "<damaged record>");
+			const spdlog::string_view_t level = spdlog::level::to_string_view(site.Level);
+			fprintf(out, "[%s.%03d] [T%u] %.*s: %.*s (%s:%d)\n", stamp, (int)(ms % 1000), thread, (int)level.size(), level.data(),
+				(int)text.size(), text.data(), site.File.c_str(), site.Line);
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	// how an argument is stored in a record. Integers are widened to 64 bits, strings are copied
+	enum class BinaryLogArg : uint8_t
+	{
+		Int,
+		UInt,
+		Double,
+		Bool,
+		Char,
+		String,
+		Pointer
+	};
+
+	// One log statement. Lives in a function-local static, so it is constant-initialized and gets
+	// its id on first use; records then carry just that id instead of the format string.
+	struct BinaryLogSite
+	{
+		static constexpr uint32_t MaxArgs = 16;
+
+		constexpr BinaryLogSite(const char* format, const char* file, int line, spdlog::level::level_enum level)
+			: Format(format), File(file), Line(line), Level(level)
+		{
+		}
+
+		const char* Format;
+		const char* File;
+		int Line;
+		spdlog::level::level_enum Level;
+		uint8_t ArgCount = 0;
+		BinaryLogArg ArgTypes[MaxArgs] = {};
+		// 0 until registered
+		std::atomic<uint32_t> Id{ 0 };
+	};
+
+	struct BinaryLogSettings
+	{
+		// per thread, rounded up to a power of two. A record that doesn't fit is dropped
+		uint32_t RingBytes = 1u << 16;
+		// how often the background thread drains the rings
+		uint32_t DrainIntervalMs = 5;
+		// decode and format on the background thread, into the "Luft-Hot" spdlog logger
+		bool FormatToLog = true;
+		// also append the raw records to this file, decoded later by DecodeDump. Empty writes none
+		lstr DumpPath;
+	};
+
+	// Deferred-formatting log channel for hot paths. LUFT_BLOG_* copy the site id, a timestamp and
+	// the raw argument bytes into the calling thread's ring and return; a background thread drains
+	// the rings and formats, or streams them to a dump file for offline decoding. Order is kept per
+	// thread only. Statements issued while the channel isn't started cost one relaxed load.
+	class LUFT_API BinaryLog
+	{
+	public:
+		static bool Start(const BinaryLogSettings& settings = BinaryLogSettings());
+		// drains what is left and joins the background thread
+		static void Stop();
+		static bool IsRunning() { return s_Running.load(std::memory_order_relaxed); }
+		// records lost to full rings since Start
+		static uint64_t GetDroppedCount();
+
+		// formats every record of a dump as text lines, out may be stdout. Returns false if the
+		// file isn't a dump
+		static bool DecodeDump(const lstr& path, FILE* out);
+
+		template <typename... Args>
+		static void Write(BinaryLogSite& site, const Args&... args)
+		{
+			static_assert(sizeof...(Args) <= BinaryLogSite::MaxArgs, "too many arguments for a binary log statement");
+			if (!s_Running.load(std::memory_order_relaxed))
+				return;
+
+			uint32_t id = site.Id.load(std::memory_order_acquire);
+			if (id == 0)
+			{
+				const BinaryLogArg types[] = { ArgType<Args>()..., BinaryLogArg::Int };
+				id = RegisterSite(site, types, (uint32_t)sizeof...(Args));
+			}
+
+			const uint32_t size = (0u + ... + EncodedSize(args));
+			uint8_t* dst = BeginRecord(id, size);
+			if (!dst)
+				return;
+			(Encode(dst, args), ...);
+			EndRecord();
+		}
+
+	private:
+		template <typename T>
+		static constexpr BinaryLogArg ArgType()
+		{
+			typedef std::decay_t<T> D;
+			if constexpr (std::is_same_v<D, bool>)
+				return BinaryLogArg::Bool;
+			else if constexpr (std::is_same_v<D, char>)
+				return BinaryLogArg::Char;
+			else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*> || std::is_same_v<D, lstr>)
+				return BinaryLogArg::String;
+			else if constexpr (std::is_floating_point_v<D>)
+				return BinaryLogArg::Double;
+			else if constexpr (std::is_enum_v<D>)
+				return std::is_signed_v<std::underlying_type_t<D>> ? BinaryLogArg::Int : BinaryLogArg::UInt;
+			else if constexpr (std::is_integral_v<D>)
+				return std::is_signed_v<D> ? BinaryLogArg::Int : BinaryLogArg::UInt;
+			else
+			{
+				static_assert(std::is_pointer_v<D>, "binary log arguments are numbers, strings, enums or pointers");
+				return BinaryLogArg::Pointer;
+			}
+		}
+
+		template <typename T>
+		static uint32_t EncodedSize(const T& value)
+		{
+			constexpr BinaryLogArg type = ArgType<T>();
+			if constexpr (type == BinaryLogArg::String)
+				return 4 + (uint32_t)StringLength(value);
+			else if constexpr (type == BinaryLogArg::Bool || type == BinaryLogArg::Char)
+				return 1;
+			else
+				return 8;
+		}
+
+		template <typename T>
+		static void Encode(uint8_t*& dst, const T& value)
+		{
+			constexpr BinaryLogArg type = ArgType<T>();
+			if constexpr (type == BinaryLogArg::String)
+			{
+				const uint32_t len = (uint32_t)StringLength(value);
+				memcpy(dst, &len, 4);
+				memcpy(dst + 4, StringData(value), len);
+				dst += 4 + len;
+			}
+			else if constexpr (type == BinaryLogArg::Bool || type == BinaryLogArg::Char)
+				*dst++ = (uint8_t)value;
+			else
+			{
+				if constexpr (type == BinaryLogArg::Double)
+				{
+					const double v = (double)value;
+					memcpy(dst, &v, 8);
+				}
+				else if constexpr (type == BinaryLogArg::Pointer)
+				{
+					const uint64_t v = (uint64_t)(uintptr_t)value;
+					memcpy(dst, &v, 8);
+				}
+				else if constexpr (type == BinaryLogArg::Int)
+				{
+					const int64_t v = (int64_t)value;
+					memcpy(dst, &v, 8);
+				}
+				else
+				{
+					const uint64_t v = (uint64_t)value;
+					memcpy(dst, &v, 8);
+				}
+				dst += 8;
+			}
+		}
+
+		// a record holds at most 64K of arguments, longer strings are cut
+		static size_t StringLength(const char* s) { return s ? strnlen(s, 0xffff) : 0; }
+		static size_t StringLength(const lstr& s) { return s.size() < 0xffff ? s.size() : 0xffff; }
+		static const char* StringData(const char* s) { return s; }
+		static const char* StringData(const lstr& s) { return s.c_str(); }
+
+		static uint32_t RegisterSite(BinaryLogSite& site, const BinaryLogArg* types, uint32_t count);
+		// space for size argument bytes in the calling thread's ring, nullptr if it is full
+		static uint8_t* BeginRecord(uint32_t siteId, uint32_t size);
+		static void EndRecord();
+
+		static std::atomic<bool> s_Running;
+	};
+
+}
+
+#define LUFT_BLOG_CONCAT2(a, b) a##b
+#define LUFT_BLOG_CONCAT(a, b) LUFT_BLOG_CONCAT2(a, b)
+
+#define LUFT_BLOG(level, format, ...) \
+	do \
+	{ \
+		static ::Luft::BinaryLogSite LUFT_BLOG_CONCAT(luftBlogSite, __LINE__)(format, __FILE__, __LINE__, level); \
+		::Luft::BinaryLog::Write(LUFT_BLOG_CONCAT(luftBlogSite, __LINE__), ##__VA_ARGS__); \
+	} while (0)
+
+// Same levels and stripping as the text macros in Log.h. The format string must be a literal,
+// arguments follow the fmt "{0}" syntax
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_TRACE
+#define LUFT_BLOG_TRACE(format, ...)	LUFT_BLOG(spdlog::level::trace, format, ##__VA_ARGS__)
+#else
+#define LUFT_BLOG_TRACE(format, ...)	(void)0
+#endif
+
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_INFO
+#define LUFT_BLOG_INFO(format, ...)		LUFT_BLOG(spdlog::level::info, format, ##__VA_ARGS__)
+#else
+#define LUFT_BLOG_INFO(format, ...)		(void)0
+#endif
+
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_WARN
+#define LUFT_BLOG_WRAN(format, ...)		LUFT_BLOG(spdlog::level::warn, format, ##__VA_ARGS__)
+#else
+#define LUFT_BLOG_WRAN(format, ...)		(void)0
+#endif
+
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_ERROR
+#define LUFT_BLOG_ERROR(format, ...)	LUFT_BLOG(spdlog::level::err, format, ##__VA_ARGS__)
+#else
+#define LUFT_BLOG_ERROR(format, ...)	(void)0
+#endif
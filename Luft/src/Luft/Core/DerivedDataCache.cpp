@@ -0,0 +1,374 @@
+#include "DerivedDataCache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr char EntryMagic[8] = { 'L', 'D', 'D', 'C', '1', 0, 0, 0 };
+		// the rest of the entry is the data
+		struct EntryHeader
+		{
+			char Magic[8];
+			uint64_t Hi;
+			uint64_t Lo;
+			uint64_t Size;
+		};
+
+		// temporary files older than this were left by a writer that died
+		constexpr auto StaleTempAge = std::chrono::hours(1);
+
+		struct Entry
+		{
+			uint64_t Hi;
+			uint64_t Lo;
+			uint64_t Size;
+			// of its file
+			std::filesystem::file_time_type LastUse;
+		};
+
+		std::mutex s_Mutex;
+		bool s_Running = false;
+		lstr s_Dir;
+		uint64_t s_MaxBytes = 0;
+		// every entry in the directory as far as this process knows, in no order
+		larray<Entry> s_Entries;
+		DerivedDataStats s_Stats;
+		std::atomic<uint32_t> s_TempCounter{ 0 };
+
+		uint64_t Mix(uint64_t h)
+		{
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+			h *= 0xc4ceb9fe1a85ec53ull;
+			h ^= h >> 33;
+			return h;
+		}
+
+		lstr ToHex(uint64_t hi, uint64_t lo)
+		{
+			char hex[33];
+			snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long)hi, (unsigned long long)lo);
+			return hex;
+		}
+
+		bool FromHex(const char* hex, size_t length, uint64_t& hi, uint64_t& lo)
+		{
+			if (length != 32)
+				return false;
+			uint64_t words[2] = {};
+			for (size_t i = 0; i < 32; i++)
+			{
+				const char c = hex[i];
+				const int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+				if (digit < 0)
+					return false;
+				words[i / 16] = words[i / 16] << 4 | (uint64_t)digit;
+			}
+			hi = words[0];
+			lo = words[1];
+			return true;
+		}
+
+		// <dir>/<first two digits>/<all 32>.ldd, so no directory gets too many files
+		lstr GetEntryPath(uint64_t hi, uint64_t lo)
+		{
+			const lstr hex = ToHex(hi, lo);
+			return s_Dir + "/" + hex.substr(0, 2) + "/" + hex + ".ldd";
+		}
+
+		// under s_Mutex
+		Entry* FindEntry(uint64_t hi, uint64_t lo)
+		{
+			for (Entry& entry : s_Entries)
+			{
+				if (entry.Hi == hi && entry.Lo == lo)
+					return &entry;
+			}
+			return nullptr;
+		}
+
+		// under s_Mutex
+		void RemoveEntry(uint64_t hi, uint64_t lo)
+		{
+			for (size_t i = 0; i < s_Entries.size(); i++)
+			{
+				if (s_Entries[i].Hi == hi && s_Entries[i].Lo == lo)
+				{
+					s_Stats.Bytes -= s_Entries[i].Size;
+					s_Entries.erase(i);
+					return;
+				}
+			}
+		}
+
+		// under s_Mutex. Deletes the least recently used entries until they fit in seven eighths of
+		// the limit, so the next few writes don't each trim again
+		void Trim()
+		{
+			if (s_Stats.Bytes <= s_MaxBytes)
+				return;
+			std::sort(s_Entries.begin(), s_Entries.end(), [](const Entry& a, const Entry& b) { return a.LastUse < b.LastUse; });
+			const uint64_t target = s_MaxBytes / 8 * 7;
+			size_t kept = 0;
+			for (size_t i = 0; i < s_Entries.size(); i++)
+			{
+				if (s_Stats.Bytes > target)
+				{
+					// a file that's already gone, evicted by another process sharing the cache, is
+					// dropped all the same
+					std::error_code ec;
+					const bool removed = std::filesystem::remove(GetEntryPath(s_Entries[i].Hi, s_Entries[i].Lo).c_str(), ec);
+					if (removed || !ec)
+					{
+						s_Stats.Bytes -= s_Entries[i].Size;
+						if (removed)
+							s_Stats.Evictions++;
+						continue;
+					}
+				}
+				// past the target, or still open somewhere it can't be deleted from
+				s_Entries[kept++] = s_Entries[i];
+			}
+			s_Entries.resize(kept);
+		}
+
+		// under s_Mutex, an entry just read or written
+		void Touch(uint64_t hi, uint64_t lo, uint64_t size, std::filesystem::file_time_type now)
+		{
+			Entry* entry = FindEntry(hi, lo);
+			if (!entry)
+			{
+				s_Entries.push_back({ hi, lo, 0, now });
+				entry = &s_Entries.back();
+			}
+			s_Stats.Bytes += size - entry->Size;
+			entry->Size = size;
+			entry->LastUse = now;
+		}
+	}
+
+	DerivedDataKey::DerivedDataKey(const char* importer, uint32_t version)
+		: m_Hi(0x6a09e667f3bcc908ull), m_Lo(0xbb67ae8584caa73bull)
+	{
+		Add(importer, strlen(importer) + 1);
+		AddValue(version);
+	}
+
+	DerivedDataKey& DerivedDataKey::Add(const void* data, size_t size)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		m_Length += size;
+		// two lanes of eight bytes a step, sources like fonts are megabytes
+		for (; size >= 8; p += 8, size -= 8)
+		{
+			uint64_t word;
+			memcpy(&word, p, 8);
+			m_Lo = (m_Lo ^ word) * 0x9e3779b97f4a7c15ull;
+			m_Lo ^= m_Lo >> 29;
+			m_Hi = (m_Hi ^ (word << 31 | word >> 33)) * 0xc2b2ae3d27d4eb4full;
+			m_Hi ^= m_Hi >> 32;
+		}
+		if (size > 0)
+		{
+			uint64_t word = 0;
+			memcpy(&word, p, size);
+			word ^= (uint64_t)size << 56;
+			m_Lo = (m_Lo ^ word) * 0x9e3779b97f4a7c15ull;
+			m_Hi = (m_Hi ^ (word << 31 | word >> 33)) * 0xc2b2ae3d27d4eb4full;
+		}
+		return *this;
+	}
+
+	void DerivedDataKey::GetHash(uint64_t& hi, uint64_t& lo) const
+	{
+		lo = Mix(m_Lo ^ m_Length);
+		hi = Mix(m_Hi + lo);
+		lo = Mix(lo ^ hi);
+	}
+
+	lstr DerivedDataKey::ToString() const
+	{
+		uint64_t hi, lo;
+		GetHash(hi, lo);
+		return ToHex(hi, lo);
+	}
+
+	void DerivedDataCache::Init(const lstr& dir, uint64_t maxBytes)
+	{
+		Shutdown();
+		LUFT_PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Dir = dir;
+		while (s_Dir.size() > 1 && s_Dir.back() == '/')
+			s_Dir.pop_back();
+		s_MaxBytes = maxBytes;
+		s_Stats = DerivedDataStats();
+
+		std::error_code ec;
+		std::filesystem::create_directories(s_Dir.c_str(), ec);
+		const std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+		for (std::filesystem::recursive_directory_iterator it(s_Dir.c_str(), ec), end; !ec && it != end; it.increment(ec))
+		{
+			std::error_code fileEc;
+			if (!it->is_regular_file(fileEc))
+				continue;
+			const std::filesystem::path& path = it->path();
+			const std::filesystem::file_time_type time = it->last_write_time(fileEc);
+			if (path.extension() == ".tmp")
+			{
+				if (!fileEc && now - time > StaleTempAge)
+					std::filesystem::remove(path, fileEc);
+				continue;
+			}
+			const std::string stem = path.stem().string();
+			Entry entry;
+			if (path.extension() != ".ldd" || !FromHex(stem.c_str(), stem.size(), entry.Hi, entry.Lo))
+				continue;
+			entry.Size = it->file_size(fileEc);
+			entry.LastUse = time;
+			if (fileEc)
+				continue;
+			s_Entries.push_back(entry);
+			s_Stats.Bytes += entry.Size;
+		}
+		Trim();
+		s_Running = true;
+		CORE_LOG_INFO("Derived data cache {0}: {1} entries, {2:.1f} of {3:.0f} MB", s_Dir.c_str(), s_Entries.size(),
+			s_Stats.Bytes / (1024.0 * 1024.0), s_MaxBytes / (1024.0 * 1024.0));
+	}
+
+	void DerivedDataCache::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Running = false;
+		s_Entries.clear();
+		s_Dir.clear();
+	}
+
+	bool DerivedDataCache::Get(const DerivedDataKey& key, DerivedData& out)
+	{
+		LUFT_PROFILE_FUNCTION();
+		uint64_t hi, lo;
+		key.GetHash(hi, lo);
+		lstr path;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (!s_Running)
+				return false;
+			path = GetEntryPath(hi, lo);
+		}
+
+		// a file another process wrote counts as much as one from the index
+		out = DerivedData();
+		EntryHeader header;
+		bool valid = out.m_File.Open(path) && out.m_File.Size() >= sizeof(header);
+		if (valid)
+		{
+			memcpy(&header, out.m_File.Data(), sizeof(header));
+			valid = memcmp(header.Magic, EntryMagic, sizeof(EntryMagic)) == 0 && header.Hi == hi && header.Lo == lo
+				&& header.Size == out.m_File.Size() - sizeof(header);
+			if (!valid)
+				CORE_LOG_WRAN("{0} is corrupt, dropping it", path.c_str());
+		}
+
+		std::error_code ec;
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (!valid)
+		{
+			if (out.m_File.IsOpen())
+			{
+				out.m_File.Close();
+				std::filesystem::remove(path.c_str(), ec);
+			}
+			RemoveEntry(hi, lo);
+			s_Stats.Misses++;
+			return false;
+		}
+		out.m_Data = out.m_File.Data() + sizeof(header);
+		out.m_Size = (size_t)header.Size;
+		// its write time is what the next run sorts by
+		const std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+		std::filesystem::last_write_time(path.c_str(), now, ec);
+		if (s_Running)
+			Touch(hi, lo, out.m_File.Size(), now);
+		s_Stats.Hits++;
+		return true;
+	}
+
+	bool DerivedDataCache::Put(const DerivedDataKey& key, const void* data, size_t size)
+	{
+		LUFT_PROFILE_FUNCTION();
+		uint64_t hi, lo;
+		key.GetHash(hi, lo);
+		lstr path;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (!s_Running)
+				return false;
+			path = GetEntryPath(hi, lo);
+		}
+
+		EntryHeader header = {};
+		memcpy(header.Magic, EntryMagic, sizeof(EntryMagic));
+		header.Hi = hi;
+		header.Lo = lo;
+		header.Size = size;
+
+		// named for this writer alone, other threads and processes may be writing the same entry
+		char suffix[48];
+		snprintf(suffix, sizeof(suffix), ".%zx.%x.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()),
+			s_TempCounter.fetch_add(1, std::memory_order_relaxed));
+		const lstr temp = path + suffix;
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(path.c_str()).parent_path(), ec);
+		FILE* f = fopen(temp.c_str(), "wb");
+		bool written = f && fwrite(&header, sizeof(header), 1, f) == 1 && (size == 0 || fwrite(data, 1, size, f) == size);
+		if (f)
+			written = fclose(f) == 0 && written;
+		if (written)
+			std::filesystem::rename(temp.c_str(), path.c_str(), ec);
+		if (!written || ec)
+		{
+			std::filesystem::remove(temp.c_str(), ec);
+			CORE_LOG_WRAN("Can't write {0} to the derived data cache", path.c_str());
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		if (!s_Running)
+			return true;
+		Touch(hi, lo, sizeof(header) + size, std::filesystem::file_time_type::clock::now());
+		s_Stats.Writes++;
+		Trim();
+		return true;
+	}
+
+	DerivedDataStats DerivedDataCache::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		DerivedDataStats stats = s_Stats;
+		stats.Entries = (uint32_t)s_Entries.size();
+		return stats;
+	}
+
+	lstr DerivedDataCache::GetDirectory()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		return s_Dir;
+	}
+
+}
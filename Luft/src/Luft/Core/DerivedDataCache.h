@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Core/MappedFile.h"
+
+namespace Luft {
+
+	// What an importer's output is keyed by: a 128-bit hash of the importer's name and version,
+	// the source's bytes and every setting that changes the output. Bump the version whenever the
+	// importer's code would turn the same source into something else.
+	class LUFT_API DerivedDataKey
+	{
+	public:
+		DerivedDataKey(const char* importer, uint32_t version);
+
+		DerivedDataKey& Add(const void* data, size_t size);
+		DerivedDataKey& Add(const lstr& s) { return Add(s.c_str(), s.size() + 1); }
+		template <typename T>
+		DerivedDataKey& AddValue(const T& value) { return Add(&value, sizeof(T)); }
+
+		// the final hash, which is also the entry's file name in hex
+		void GetHash(uint64_t& hi, uint64_t& lo) const;
+		lstr ToString() const;
+
+	private:
+		uint64_t m_Hi;
+		uint64_t m_Lo;
+		uint64_t m_Length = 0;
+	};
+
+	// an entry read from the cache, mapped rather than copied
+	class LUFT_API DerivedData
+	{
+	public:
+		bool IsOpen() const { return m_File.IsOpen(); }
+		const uint8_t* Data() const { return m_Data; }
+		size_t Size() const { return m_Size; }
+
+	private:
+		friend class DerivedDataCache;
+		MappedFile m_File;
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+	};
+
+	struct DerivedDataStats
+	{
+		uint64_t Hits = 0;
+		uint64_t Misses = 0;
+		uint64_t Writes = 0;
+		uint64_t Evictions = 0;
+		uint64_t Bytes = 0;
+		uint32_t Entries = 0;
+	};
+
+	// Imported assets kept on disk, so the same source is only ever processed once. Entries are
+	// files under one directory named by their key; nothing but the key decides what's in one, so
+	// runs, branches and checkouts pointed at the same directory share it. Once the entries add up
+	// to more than the limit the least recently used are deleted, use is their write time and so
+	// survives a restart. Writes go through a temporary file and a rename, readers never see half
+	// an entry. Thread-safe, importers call it from decode threads. Before Init nothing is found
+	// and nothing kept.
+	class LUFT_API DerivedDataCache
+	{
+	public:
+		// finds the entries already in dir and trims them to maxBytes
+		static void Init(const lstr& dir, uint64_t maxBytes);
+		static void Shutdown();
+
+		// false on a miss, the importer then does its work and Puts the result
+		static bool Get(const DerivedDataKey& key, DerivedData& out);
+		static bool Put(const DerivedDataKey& key, const void* data, size_t size);
+
+		static DerivedDataStats GetStats();
+		static lstr GetDirectory();
+	};
+
+}
@@ -1,24 +1,56 @@
+#include <stdio.h>
+#include <string.h>
 #include "Log.h"
+#include "BinaryLog.h"
+#include "KeyTable.h"
+#include "Localization.h"
+#include "VirtualFileSystem.h"
 #include "Version.h"
-#ifdef LUFT_PLATFORM_WINDOWS
+#if defined(LUFT_PLATFORM_WINDOWS) || defined(LUFT_PLATFORM_LINUX)
 
-extern Luft::Application* Luft::CreateApplication();
+extern Luft::Application* Luft::CreateApplication(Luft::ApplicationCommandLineArgs args);
 
 int main(int argc, char** argv)
 {
+	// offline decoding of a --blog-dump file, no engine needed
+	if (argc == 3 && strcmp(argv[1], "--decode-blog") == 0)
+	{
+		if (Luft::BinaryLog::DecodeDump(argv[2], stdout))
+			return 0;
+		fprintf(stderr, "%s is not a binary log dump\n", argv[2]);
+		return 1;
+	}
+
 	Luft::Log::Init();
+
+	// build and packaging steps: compile a keys.txt or a language without starting the engine
+	if (argc == 4 && (strcmp(argv[1], "--compile-keys") == 0 || strcmp(argv[1], "--compile-lang") == 0))
+	{
+		const bool compiled = strcmp(argv[1], "--compile-keys") == 0 ? Luft::KeyTable::Compile(argv[2], argv[3]) : Luft::Localization::Compile(argv[2], argv[3]);
+		Luft::Log::Shutdown();
+		return compiled ? 0 : 1;
+	}
+	// the resources/ tree into one pack, --pack-store keeps every entry uncompressed
+	if (argc == 4 && (strcmp(argv[1], "--pack") == 0 || strcmp(argv[1], "--pack-store") == 0))
+	{
+		const bool packed = Luft::VirtualFileSystem::BuildPack(argv[2], argv[3], strcmp(argv[1], "--pack") == 0);
+		Luft::Log::Shutdown();
+		return packed ? 0 : 1;
+	}
+
 	CORE_LOG_INFO("spdlog initialized");
 
 	CORE_LOG_INFO("Luft ({0}) Startup", VERSIONSTR);
 	// do something before loop
 
 	CORE_LOG_INFO("Luft Run");
-	auto app = Luft::CreateApplication();
+	auto app = Luft::CreateApplication({ argc, argv });
 	app->Run();
 
 	CORE_LOG_INFO("Luft End");
 	delete app;
-	
+	Luft::Log::Shutdown();
+
 	return 0;
 }
 
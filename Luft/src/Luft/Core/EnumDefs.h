@@ -1,23 +1,39 @@
 #pragma once
-#include <optional>
+
+// Keys of the data-driven tables: int and res keys in resources/config/keys.txt, text keys in each
+// language of resources/localization. A key's name there is the name given here, its slot in the
+// compiled table the enum value
+#define LUFT_INT_KEYS(X) \
+	X(font_size_max) \
+	X(font_size_title) \
+	X(font_size_normal)
+
+#define LUFT_RES_KEYS(X) \
+	X(font_path_puhui3)
+
+#define LUFT_TEXT_KEYS(X) \
+	X(text_1) \
+	X(text_2)
+
+#define LUFT_KEY_ENUM_ENTRY(name) name,
 
 namespace Luft
 {
 	enum class IntKey
 	{
-		font_size_max,
-		font_size_title,
-		font_size_normal
+		LUFT_INT_KEYS(LUFT_KEY_ENUM_ENTRY)
+		Count
 	};
 
 	enum class ResKey
 	{
-		font_path_puhui3,
+		LUFT_RES_KEYS(LUFT_KEY_ENUM_ENTRY)
+		Count
 	};
 
 	enum class TextKey
 	{
-		text_1,
-		text_2,
+		LUFT_TEXT_KEYS(LUFT_KEY_ENUM_ENTRY)
+		Count
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,323 @@
+#include "FileReader.h"
+
+#include <string.h>
+#include <errno.h>
+#include "Luft/Core/Log.h"
+
+#ifdef LUFT_PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+// headers old enough to lack the probe lack IORING_OP_READ too
+#ifdef IO_URING_OP_SUPPORTED
+#define LUFT_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+namespace Luft {
+
+	namespace
+	{
+		// the most one read asks for, larger ops continue like short reads
+		constexpr size_t MaxChunk = 1u << 30;
+	}
+
+	void FileReader::Init(uint32_t queueDepth)
+	{
+		Shutdown();
+		m_QueueDepth = queueDepth > 0 ? queueDepth : 1;
+		if (!InitRing())
+			CORE_LOG_INFO("File reads without io_uring, one at a time");
+	}
+
+	void FileReader::Shutdown()
+	{
+		CloseFiles();
+		ShutdownRing();
+	}
+
+	intptr_t FileReader::OpenFile(const lstr& path)
+	{
+		for (const OpenedFile& file : m_Files)
+		{
+			if (!file.Retired && file.Path == path)
+				return file.File;
+		}
+
+#ifdef LUFT_PLATFORM_WINDOWS
+		HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (handle == INVALID_HANDLE_VALUE)
+			return InvalidFile;
+		const intptr_t file = (intptr_t)handle;
+#else
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return InvalidFile;
+		const intptr_t file = fd;
+#endif
+		m_Files.push_back({ path, file, false });
+		return file;
+	}
+
+	void FileReader::RetireFiles()
+	{
+		for (OpenedFile& file : m_Files)
+			file.Retired = true;
+	}
+
+	void FileReader::CloseFiles()
+	{
+		for (const OpenedFile& file : m_Files)
+		{
+#ifdef LUFT_PLATFORM_WINDOWS
+			CloseHandle((HANDLE)file.File);
+#else
+			close((int)file.File);
+#endif
+		}
+		m_Files.clear();
+	}
+
+	void FileReader::ReadBatch(FileReadOp* ops, uint32_t count)
+	{
+		if (m_Ring >= 0 && count > 1)
+		{
+			ReadRing(ops, count);
+			return;
+		}
+		for (uint32_t i = 0; i < count; i++)
+			ops[i].Ok = ReadDirect(ops[i]);
+	}
+
+	bool FileReader::ReadDirect(FileReadOp& op)
+	{
+		size_t done = 0;
+		while (done < op.Size)
+		{
+			const size_t chunk = op.Size - done < MaxChunk ? op.Size - done : MaxChunk;
+#ifdef LUFT_PLATFORM_WINDOWS
+			OVERLAPPED at = {};
+			const uint64_t offset = op.Offset + done;
+			at.Offset = (DWORD)offset;
+			at.OffsetHigh = (DWORD)(offset >> 32);
+			DWORD read = 0;
+			if (!ReadFile((HANDLE)op.File, op.Dst + done, (DWORD)chunk, &read, &at) || read == 0)
+				return false;
+#else
+			const ssize_t read = pread((int)op.File, op.Dst + done, chunk, (off_t)(op.Offset + done));
+			if (read < 0 && errno == EINTR)
+				continue;
+			if (read <= 0)
+				return false;
+#endif
+			done += (size_t)read;
+		}
+		return true;
+	}
+
+#ifdef LUFT_HAS_IO_URING
+	bool FileReader::InitRing()
+	{
+		io_uring_params params = {};
+		const int ring = (int)syscall(__NR_io_uring_setup, m_QueueDepth, &params);
+		// ENOSYS on old kernels, EPERM where seccomp or sysctl turn it off
+		if (ring < 0)
+			return false;
+		m_Ring = ring;
+
+		// kernels 5.1 to 5.5 set a ring up but fail every IORING_OP_READ, and have no probe either
+		alignas(io_uring_probe) uint8_t probeBytes[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)] = {};
+		io_uring_probe* probe = (io_uring_probe*)probeBytes;
+		if (syscall(__NR_io_uring_register, ring, IORING_REGISTER_PROBE, probe, 256) < 0
+			|| probe->last_op < IORING_OP_READ || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+		{
+			ShutdownRing();
+			return false;
+		}
+
+		m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			m_SqRingSize = m_CqRingSize = m_SqRingSize > m_CqRingSize ? m_SqRingSize : m_CqRingSize;
+		m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+		void* sq = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+		void* cq = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq
+			: mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+		void* sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+		m_SqRing = sq == MAP_FAILED ? nullptr : sq;
+		m_CqRing = cq == MAP_FAILED ? nullptr : cq;
+		m_Sqes = sqes == MAP_FAILED ? nullptr : sqes;
+		if (!m_SqRing || !m_CqRing || !m_Sqes)
+		{
+			ShutdownRing();
+			return false;
+		}
+
+		uint8_t* sqBase = (uint8_t*)m_SqRing;
+		uint8_t* cqBase = (uint8_t*)m_CqRing;
+		m_SqTail = (uint32_t*)(sqBase + params.sq_off.tail);
+		m_SqMask = *(uint32_t*)(sqBase + params.sq_off.ring_mask);
+		m_SqArray = (uint32_t*)(sqBase + params.sq_off.array);
+		m_CqHead = (uint32_t*)(cqBase + params.cq_off.head);
+		m_CqTail = (uint32_t*)(cqBase + params.cq_off.tail);
+		m_CqMask = *(uint32_t*)(cqBase + params.cq_off.ring_mask);
+		m_Cqes = cqBase + params.cq_off.cqes;
+		// the kernel rounds up, the completion ring is twice the submission ring so it can't overflow
+		if (m_QueueDepth > params.sq_entries)
+			m_QueueDepth = params.sq_entries;
+		CORE_LOG_INFO("File reads through io_uring, {0} in flight", m_QueueDepth);
+		return true;
+	}
+
+	void FileReader::ShutdownRing()
+	{
+		if (m_Sqes)
+			munmap(m_Sqes, m_SqesSize);
+		if (m_CqRing && m_CqRing != m_SqRing)
+			munmap(m_CqRing, m_CqRingSize);
+		if (m_SqRing)
+			munmap(m_SqRing, m_SqRingSize);
+		if (m_Ring >= 0)
+			close(m_Ring);
+		m_Ring = -1;
+		m_SqRing = m_CqRing = m_Sqes = m_Cqes = nullptr;
+		m_SqTail = m_SqArray = m_CqHead = m_CqTail = nullptr;
+	}
+
+	void FileReader::ReadRing(FileReadOp* ops, uint32_t count)
+	{
+		enum : uint8_t { Waiting, InFlight, Finished };
+		larray<size_t> done;
+		larray<uint8_t> state;
+		done.resize(count);
+		state.resize(count);
+		uint32_t inFlight = 0;
+		uint32_t unsubmitted = 0;
+		uint32_t finished = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			ops[i].Ok = ops[i].Size == 0;
+			if (ops[i].Ok)
+			{
+				state[i] = Finished;
+				finished++;
+			}
+		}
+
+		io_uring_sqe* sqes = (io_uring_sqe*)m_Sqes;
+		const io_uring_cqe* cqes = (const io_uring_cqe*)m_Cqes;
+		auto reap = [&]()
+		{
+			uint32_t head = *m_CqHead;
+			const uint32_t cqTail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+			for (; head != cqTail; head++)
+			{
+				const io_uring_cqe& cqe = cqes[head & m_CqMask];
+				const uint32_t i = (uint32_t)cqe.user_data;
+				inFlight--;
+				if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+				{
+					state[i] = Waiting;
+					continue;
+				}
+				if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP)
+				{
+					// the ring can't read this file, a positional read can
+					ops[i].Ok = ReadDirect(ops[i]);
+					state[i] = Finished;
+					finished++;
+					continue;
+				}
+				if (cqe.res > 0)
+					done[i] += (size_t)cqe.res;
+				if (cqe.res > 0 && done[i] < ops[i].Size)
+				{
+					state[i] = Waiting;
+					continue;
+				}
+				// an error or the end of the file before Size
+				ops[i].Ok = done[i] == ops[i].Size;
+				state[i] = Finished;
+				finished++;
+			}
+			__atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+		};
+
+		while (finished < count)
+		{
+			// everything waiting, as far as the queue depth allows
+			uint32_t tail = *m_SqTail;
+			uint32_t submit = 0;
+			for (uint32_t i = 0; i < count && inFlight < m_QueueDepth; i++)
+			{
+				if (state[i] != Waiting)
+					continue;
+				const FileReadOp& op = ops[i];
+				const size_t chunk = op.Size - done[i] < MaxChunk ? op.Size - done[i] : MaxChunk;
+				const uint32_t slot = tail & m_SqMask;
+				io_uring_sqe& sqe = sqes[slot];
+				memset(&sqe, 0, sizeof(sqe));
+				sqe.opcode = IORING_OP_READ;
+				sqe.fd = (int)op.File;
+				sqe.off = op.Offset + done[i];
+				sqe.addr = (uint64_t)(uintptr_t)(op.Dst + done[i]);
+				sqe.len = (uint32_t)chunk;
+				sqe.user_data = i;
+				m_SqArray[slot] = slot;
+				tail++;
+				submit++;
+				state[i] = InFlight;
+				inFlight++;
+			}
+			__atomic_store_n(m_SqTail, tail, __ATOMIC_RELEASE);
+
+			// entries an interrupted enter didn't take are still in the ring and go with the next
+			unsubmitted += submit;
+			const int entered = (int)syscall(__NR_io_uring_enter, m_Ring, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (entered > 0)
+				unsubmitted -= (uint32_t)entered;
+			if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			{
+				// the ring itself is unusable, the rest of this batch and later ones are read directly.
+				// Reads the kernel took still land in the callers' buffers, so they're waited for
+				// before it's closed. Entries it never took are taken back
+				CORE_LOG_ERROR("io_uring_enter failed: {0}", strerror(errno));
+				__atomic_store_n(m_SqTail, tail - unsubmitted, __ATOMIC_RELEASE);
+				inFlight -= unsubmitted;
+				while (inFlight > 0)
+				{
+					const uint32_t before = inFlight;
+					reap();
+					if (inFlight == before && syscall(__NR_io_uring_enter, m_Ring, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+						usleep(1000);
+				}
+				ShutdownRing();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (state[i] != Finished)
+						ops[i].Ok = ReadDirect(ops[i]);
+				}
+				return;
+			}
+
+			reap();
+		}
+	}
+#else
+	bool FileReader::InitRing() { return false; }
+	void FileReader::ShutdownRing() {}
+	void FileReader::ReadRing(FileReadOp* ops, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			ops[i].Ok = ReadDirect(ops[i]);
+	}
+#endif
+
+}
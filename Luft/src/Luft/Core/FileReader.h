@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	// one read of a batch, Ok is set by ReadBatch
+	struct FileReadOp
+	{
+		intptr_t File;
+		uint64_t Offset;
+		uint8_t* Dst;
+		size_t Size;
+		bool Ok;
+	};
+
+	// Explicit reads into caller buffers, for a thread that wants to decide the order of its I/O
+	// rather than fault pages of a mapping in. On Linux a batch is submitted to an io_uring at once
+	// and the kernel works on every read together; where io_uring isn't allowed or predates
+	// IORING_OP_READ (before 5.6), and on Windows, the reads are positional reads one after
+	// another. Files are opened once per path and stay open until CloseFiles. Not thread-safe,
+	// meant to be owned by one I/O thread.
+	class LUFT_API FileReader
+	{
+	public:
+		static constexpr intptr_t InvalidFile = -1;
+
+		FileReader() = default;
+		~FileReader() { Shutdown(); }
+
+		FileReader(const FileReader&) = delete;
+		FileReader& operator=(const FileReader&) = delete;
+
+		// batches of up to queueDepth reads are in flight together
+		void Init(uint32_t queueDepth);
+		void Shutdown();
+
+		// InvalidFile if it can't be opened
+		intptr_t OpenFile(const lstr& path);
+		// later OpenFile calls open the files again, e.g. after they were replaced. The handles
+		// given out so far stay valid until CloseFiles
+		void RetireFiles();
+		void CloseFiles();
+
+		// returns once every op is done, short reads are continued
+		void ReadBatch(FileReadOp* ops, uint32_t count);
+
+		uint32_t GetQueueDepth() const { return m_QueueDepth; }
+		const char* GetBackendName() const { return m_Ring >= 0 ? "io_uring" : "pread"; }
+
+	private:
+		struct OpenedFile
+		{
+			lstr Path;
+			intptr_t File;
+			bool Retired;
+		};
+
+		bool InitRing();
+		void ShutdownRing();
+		void ReadRing(FileReadOp* ops, uint32_t count);
+		static bool ReadDirect(FileReadOp& op);
+
+		uint32_t m_QueueDepth = 1;
+		larray<OpenedFile> m_Files;
+
+		// io_uring, mapped from the kernel. m_Ring stays -1 where there's none
+		int m_Ring = -1;
+		void* m_SqRing = nullptr;
+		size_t m_SqRingSize = 0;
+		void* m_CqRing = nullptr;
+		size_t m_CqRingSize = 0;
+		void* m_Sqes = nullptr;
+		size_t m_SqesSize = 0;
+		uint32_t* m_SqTail = nullptr;
+		uint32_t m_SqMask = 0;
+		uint32_t* m_SqArray = nullptr;
+		uint32_t* m_CqHead = nullptr;
+		uint32_t* m_CqTail = nullptr;
+		uint32_t m_CqMask = 0;
+		void* m_Cqes = nullptr;
+	};
+
+}
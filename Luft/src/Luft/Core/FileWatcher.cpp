@@ -0,0 +1,486 @@
+#include "FileWatcher.h"
+
+#include <string.h>
+#include <errno.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <condition_variable>
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+#ifdef LUFT_PLATFORM_LINUX
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Luft {
+
+	namespace
+	{
+		typedef std::chrono::steady_clock Clock;
+		// how often the fallback looks at the watched files
+		constexpr int64_t PollIntervalMs = 500;
+
+		// a file as the fallback last saw it
+		struct FileStamp
+		{
+			lstr Path;
+			std::filesystem::file_time_type Time;
+			uintmax_t Size;
+		};
+
+		struct WatchEntry
+		{
+			lstr Path;
+			bool IsDirectory = false;
+			FileReimportFn Reimport;
+			FileApplyFn Apply;
+			std::atomic<bool> Removed{ false };
+			// under s_Mutex
+			larray<lstr> Pending;
+			Clock::time_point LastChange;
+			// the fallback's, on the watcher thread once the watch is made
+			larray<FileStamp> Stamps;
+		};
+
+		struct ImportedBatch
+		{
+			Ref<WatchEntry> Watch;
+			larray<lstr> Changed;
+			Ref<void> Asset;
+		};
+
+		std::mutex s_Mutex;
+		// held while a reimport runs, so Unwatch can wait for it
+		std::mutex s_ReimportMutex;
+		std::condition_variable s_Wake;
+		bool s_Stop = false;
+		std::thread* s_Thread = nullptr;
+		int64_t s_DebounceMs = 200;
+		// under s_Mutex
+		larray<Ref<WatchEntry>> s_Watches;
+		larray<ImportedBatch> s_Imported;
+
+		// main thread
+		lslotmap<Ref<WatchEntry>> s_Handles;
+
+#ifdef LUFT_PLATFORM_LINUX
+		struct WatchedDirectory
+		{
+			int Descriptor;
+			lstr Path;
+		};
+
+		constexpr uint32_t EventMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+		int s_Inotify = -1;
+		// wakes the thread out of poll on Shutdown
+		int s_WakeFd = -1;
+		// under s_Mutex
+		larray<WatchedDirectory> s_Directories;
+#endif
+
+		lstr Join(const lstr& dir, const char* name)
+		{
+			return dir.empty() ? lstr(name) : dir + "/" + name;
+		}
+
+		bool Covers(const WatchEntry& watch, const lstr& path)
+		{
+			if (!watch.IsDirectory)
+				return path.size() == watch.Path.size() && memcmp(path.c_str(), watch.Path.c_str(), path.size()) == 0;
+			return path.size() > watch.Path.size() && path[watch.Path.size()] == '/'
+				&& memcmp(path.c_str(), watch.Path.c_str(), watch.Path.size()) == 0;
+		}
+
+		// under s_Mutex
+		void AddChange(const lstr& path, Clock::time_point now)
+		{
+			for (const Ref<WatchEntry>& watch : s_Watches)
+			{
+				if (!Covers(*watch, path))
+					continue;
+				if (std::find(watch->Pending.begin(), watch->Pending.end(), path) == watch->Pending.end())
+					watch->Pending.push_back(path);
+				watch->LastChange = now;
+			}
+		}
+
+		bool StampLess(const FileStamp& a, const FileStamp& b)
+		{
+			return strcmp(a.Path.c_str(), b.Path.c_str()) < 0;
+		}
+
+		// every file the watch covers, sorted by path
+		void Scan(const WatchEntry& watch, larray<FileStamp>& out)
+		{
+			out.clear();
+			std::error_code ec;
+			if (!watch.IsDirectory)
+			{
+				const std::filesystem::file_time_type time = std::filesystem::last_write_time(watch.Path.c_str(), ec);
+				if (!ec)
+					out.push_back({ watch.Path, time, std::filesystem::file_size(watch.Path.c_str(), ec) });
+				return;
+			}
+			for (std::filesystem::recursive_directory_iterator it(watch.Path.c_str(), ec), end; !ec && it != end; it.increment(ec))
+			{
+				if (!it->is_regular_file(ec))
+					continue;
+				out.push_back({ it->path().generic_string().c_str(), it->last_write_time(ec), it->file_size(ec) });
+			}
+			std::sort(out.begin(), out.end(), StampLess);
+		}
+
+		// the fallback: compares every watch against what it saw last time
+		void PollChanges()
+		{
+			LUFT_PROFILE_SCOPE("Poll watched files");
+			larray<Ref<WatchEntry>> watches;
+			{
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				watches = s_Watches;
+			}
+			larray<FileStamp> stamps;
+			larray<lstr> changed;
+			for (const Ref<WatchEntry>& watch : watches)
+			{
+				Scan(*watch, stamps);
+				size_t a = 0, b = 0;
+				const larray<FileStamp>& old = watch->Stamps;
+				while (a < old.size() || b < stamps.size())
+				{
+					const int order = a == old.size() ? 1 : b == stamps.size() ? -1 : strcmp(old[a].Path.c_str(), stamps[b].Path.c_str());
+					if (order < 0)
+						changed.push_back(old[a++].Path);
+					else if (order > 0)
+						changed.push_back(stamps[b++].Path);
+					else
+					{
+						if (old[a].Time != stamps[b].Time || old[a].Size != stamps[b].Size)
+							changed.push_back(stamps[b].Path);
+						a++;
+						b++;
+					}
+				}
+				watch->Stamps.swap(stamps);
+			}
+			if (changed.empty())
+				return;
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			const Clock::time_point now = Clock::now();
+			for (const lstr& path : changed)
+				AddChange(path, now);
+		}
+
+#ifdef LUFT_PLATFORM_LINUX
+		// under s_Mutex
+		void WatchDirectory(const lstr& dir)
+		{
+			const int descriptor = inotify_add_watch(s_Inotify, dir.empty() ? "." : dir.c_str(), EventMask);
+			if (descriptor < 0)
+			{
+				// ENOSPC when max_user_watches is reached
+				CORE_LOG_WRAN("Can't watch {0}: {1}", dir.c_str(), strerror(errno));
+				return;
+			}
+			for (const WatchedDirectory& watched : s_Directories)
+			{
+				if (watched.Descriptor == descriptor)
+					return;
+			}
+			s_Directories.push_back({ descriptor, dir });
+		}
+
+		// under s_Mutex. inotify isn't recursive, every directory of the tree gets its own watch
+		void WatchTree(const lstr& dir)
+		{
+			WatchDirectory(dir);
+			std::error_code ec;
+			for (std::filesystem::recursive_directory_iterator it(dir.c_str(), ec), end; !ec && it != end; it.increment(ec))
+			{
+				if (it->is_directory(ec))
+					WatchDirectory(it->path().generic_string().c_str());
+			}
+		}
+
+		void ReadEvents()
+		{
+			alignas(inotify_event) char buffer[16 * 1024];
+			const ssize_t size = read(s_Inotify, buffer, sizeof(buffer));
+			if (size <= 0)
+				return;
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			const Clock::time_point now = Clock::now();
+			for (ssize_t offset = 0; offset < size;)
+			{
+				const inotify_event* event = (const inotify_event*)(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					// changes were lost, everything may have changed
+					CORE_LOG_WRAN("Too many file changes at once, reloading every watch");
+					for (const Ref<WatchEntry>& watch : s_Watches)
+						AddChange(watch->IsDirectory ? watch->Path + "/" : watch->Path, now);
+					continue;
+				}
+				size_t dir = 0;
+				while (dir < s_Directories.size() && s_Directories[dir].Descriptor != event->wd)
+					dir++;
+				if (dir == s_Directories.size())
+					continue;
+				if (event->mask & IN_IGNORED)
+				{
+					// the directory is gone
+					s_Directories.erase(dir);
+					continue;
+				}
+				if (event->len == 0)
+					continue;
+				const lstr path = Join(s_Directories[dir].Path, event->name);
+				if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+					WatchTree(path);
+				AddChange(path, now);
+			}
+		}
+#endif
+
+		// how long the thread may sleep: until the first pending batch settles, or the next poll
+		int64_t GetWaitMs(Clock::time_point now, Clock::time_point nextPoll, bool polling)
+		{
+			int64_t wait = polling ? std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(nextPoll - now).count()) : -1;
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			for (const Ref<WatchEntry>& watch : s_Watches)
+			{
+				if (watch->Pending.empty())
+					continue;
+				const int64_t quiet = std::chrono::duration_cast<std::chrono::milliseconds>(now - watch->LastChange).count();
+				const int64_t left = std::max<int64_t>(0, s_DebounceMs - quiet);
+				wait = wait < 0 ? left : std::min(wait, left);
+			}
+			return wait;
+		}
+
+		void ReimportSettled()
+		{
+			larray<Ref<WatchEntry>> settled;
+			larray<larray<lstr>> changes;
+			{
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				const Clock::time_point now = Clock::now();
+				for (const Ref<WatchEntry>& watch : s_Watches)
+				{
+					if (watch->Pending.empty() || now - watch->LastChange < std::chrono::milliseconds(s_DebounceMs))
+						continue;
+					settled.push_back(watch);
+					changes.push_back(larray<lstr>());
+					changes.back().swap(watch->Pending);
+				}
+			}
+
+			for (size_t i = 0; i < settled.size(); i++)
+			{
+				std::lock_guard<std::mutex> reimport(s_ReimportMutex);
+				if (settled[i]->Removed)
+					continue;
+				Ref<void> asset;
+				if (settled[i]->Reimport)
+				{
+					LUFT_PROFILE_SCOPE("Reimport");
+					asset = settled[i]->Reimport(changes[i]);
+				}
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				s_Imported.push_back({ settled[i], changes[i], asset });
+			}
+		}
+
+		void ThreadMain()
+		{
+			LUFT_PROFILE_THREAD("File watcher");
+#ifdef LUFT_PLATFORM_LINUX
+			const bool polling = s_Inotify < 0;
+#else
+			const bool polling = true;
+#endif
+			Clock::time_point nextPoll = Clock::now() + std::chrono::milliseconds(PollIntervalMs);
+			for (;;)
+			{
+				const int64_t waitMs = GetWaitMs(Clock::now(), nextPoll, polling);
+#ifdef LUFT_PLATFORM_LINUX
+				if (!polling)
+				{
+					pollfd fds[2] = { { s_Inotify, POLLIN, 0 }, { s_WakeFd, POLLIN, 0 } };
+					if (poll(fds, 2, (int)waitMs) > 0 && (fds[0].revents & POLLIN))
+						ReadEvents();
+				}
+				else
+#endif
+				{
+					std::unique_lock<std::mutex> lock(s_Mutex);
+					s_Wake.wait_for(lock, std::chrono::milliseconds(waitMs), [] { return s_Stop; });
+				}
+				{
+					std::lock_guard<std::mutex> lock(s_Mutex);
+					if (s_Stop)
+						return;
+				}
+				if (polling && Clock::now() >= nextPoll)
+				{
+					PollChanges();
+					nextPoll = Clock::now() + std::chrono::milliseconds(PollIntervalMs);
+				}
+				ReimportSettled();
+			}
+		}
+	}
+
+	void FileWatcher::Init(uint32_t debounceMs)
+	{
+		Shutdown();
+		s_DebounceMs = debounceMs;
+		s_Stop = false;
+#ifdef LUFT_PLATFORM_LINUX
+		s_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		s_WakeFd = s_Inotify >= 0 ? eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) : -1;
+		if (s_Inotify >= 0 && s_WakeFd < 0)
+		{
+			close(s_Inotify);
+			s_Inotify = -1;
+		}
+#endif
+		s_Thread = new std::thread(ThreadMain);
+		CORE_LOG_INFO("Watching files through {0}", GetBackendName());
+	}
+
+	void FileWatcher::Shutdown()
+	{
+		if (!s_Thread)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_Stop = true;
+		}
+		s_Wake.notify_all();
+#ifdef LUFT_PLATFORM_LINUX
+		if (s_WakeFd >= 0)
+		{
+			const uint64_t one = 1;
+			(void)write(s_WakeFd, &one, sizeof(one));
+		}
+#endif
+		s_Thread->join();
+		delete s_Thread;
+		s_Thread = nullptr;
+
+#ifdef LUFT_PLATFORM_LINUX
+		if (s_Inotify >= 0)
+			close(s_Inotify);
+		if (s_WakeFd >= 0)
+			close(s_WakeFd);
+		s_Inotify = s_WakeFd = -1;
+		s_Directories.clear();
+#endif
+		for (const Ref<WatchEntry>& watch : s_Watches)
+			watch->Removed = true;
+		s_Watches.clear();
+		s_Imported.clear();
+		s_Handles.clear();
+	}
+
+	bool FileWatcher::IsRunning()
+	{
+		return s_Thread != nullptr;
+	}
+
+	FileWatchHandle FileWatcher::Watch(const lstr& path, FileReimportFn reimport, FileApplyFn apply)
+	{
+		if (!s_Thread)
+		{
+			CORE_LOG_ERROR("FileWatcher isn't running, can't watch {0}", path.c_str());
+			return FileWatchHandle();
+		}
+		Ref<WatchEntry> watch = CreateRef<WatchEntry>();
+		watch->Path = std::filesystem::path(path.c_str()).lexically_normal().generic_string().c_str();
+		while (watch->Path.size() > 1 && watch->Path.back() == '/')
+			watch->Path.pop_back();
+		std::error_code ec;
+		watch->IsDirectory = std::filesystem::is_directory(watch->Path.c_str(), ec);
+		watch->Reimport = std::move(reimport);
+		watch->Apply = std::move(apply);
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+#ifdef LUFT_PLATFORM_LINUX
+		if (s_Inotify >= 0)
+		{
+			// a file through its directory, editors replace files rather than write them in place
+			if (watch->IsDirectory)
+				WatchTree(watch->Path);
+			else
+				WatchDirectory(std::filesystem::path(watch->Path.c_str()).parent_path().generic_string().c_str());
+		}
+		else
+#endif
+			Scan(*watch, watch->Stamps);
+		s_Watches.push_back(watch);
+		return s_Handles.insert(watch);
+	}
+
+	void FileWatcher::Unwatch(FileWatchHandle handle)
+	{
+		Ref<WatchEntry>* found = s_Handles.get(handle);
+		if (!found)
+			return;
+		Ref<WatchEntry> watch = *found;
+		s_Handles.erase(handle);
+		watch->Removed = true;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			for (size_t i = 0; i < s_Watches.size(); i++)
+			{
+				if (s_Watches[i] == watch)
+				{
+					s_Watches.erase(i);
+					break;
+				}
+			}
+		}
+		std::lock_guard<std::mutex> reimport(s_ReimportMutex);
+	}
+
+	uint32_t FileWatcher::Update()
+	{
+		larray<ImportedBatch> imported;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			if (s_Imported.empty())
+				return 0;
+			imported.swap(s_Imported);
+		}
+		LUFT_PROFILE_FUNCTION();
+		uint32_t applied = 0;
+		for (const ImportedBatch& batch : imported)
+		{
+			if (batch.Watch->Removed || !batch.Watch->Apply)
+				continue;
+			batch.Watch->Apply(batch.Changed, batch.Asset);
+			applied++;
+		}
+		return applied;
+	}
+
+	const char* FileWatcher::GetBackendName()
+	{
+#ifdef LUFT_PLATFORM_LINUX
+		if (s_Inotify >= 0)
+			return "inotify";
+#endif
+		return "polling";
+	}
+
+}
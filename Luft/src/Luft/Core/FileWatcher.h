@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Core/lslotmap.h"
+
+namespace Luft {
+
+	typedef lhandle32 FileWatchHandle;
+
+	// runs on the watcher thread once changes have settled, with the files that changed under the
+	// watched path. What it returns is handed to the apply function
+	typedef std::function<Ref<void>(const larray<lstr>& changed)> FileReimportFn;
+	// runs on the main thread from Update, between frames
+	typedef std::function<void(const larray<lstr>& changed, const Ref<void>& imported)> FileApplyFn;
+
+	// Hot reload. Watches files and directory trees, through inotify on Linux and by looking at
+	// their write times twice a second where that isn't available. Changes are collected until a
+	// watch has seen none for the debounce time, so an editor's save of several writes and a rename
+	// is one batch; the watch's reimport function then runs on the watcher thread and its apply
+	// function swaps the result in on the main thread. Batches that settle together are applied in
+	// the order the watches were made. Everything but the reimport functions is main thread only.
+	class LUFT_API FileWatcher
+	{
+	public:
+		static void Init(uint32_t debounceMs = 200);
+		// pending changes are dropped
+		static void Shutdown();
+		static bool IsRunning();
+
+		// path is a file, which may not exist yet, or a directory whose whole tree is watched.
+		// reimport may be null, apply then gets a null asset
+		static FileWatchHandle Watch(const lstr& path, FileReimportFn reimport, FileApplyFn apply);
+		// waits for the watch's running reimport, after it neither function is called again.
+		// Not from a reimport function
+		static void Unwatch(FileWatchHandle handle);
+
+		// applies the batches reimported since the last call. Returns how many
+		static uint32_t Update();
+
+		static const char* GetBackendName();
+	};
+
+}
@@ -0,0 +1,316 @@
+#include "KeyTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <filesystem>
+#include "Luft/Core/FileWatcher.h"
+#include "Luft/Core/KeyValueFile.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/MappedFile.h"
+
+#define LUFT_KEY_NAME_ENTRY(name) #name,
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr char TableMagic[8] = { 'L', 'K', 'T', 'B', 'L', '2', 0, 0 };
+		constexpr uint32_t IntCount = (uint32_t)IntKey::Count;
+		constexpr uint32_t ResCount = (uint32_t)ResKey::Count;
+
+		// followed by int32 ints, uint32 res offsets and the string blob
+		struct TableHeader
+		{
+			char Magic[8];
+			// of the key names, so a table compiled against other enums isn't read with these
+			uint32_t SchemaHash;
+			uint32_t IntCount;
+			uint32_t ResCount;
+			uint32_t StringBytes;
+		};
+
+		const char* const s_IntNames[] = { LUFT_INT_KEYS(LUFT_KEY_NAME_ENTRY) };
+		const char* const s_ResNames[] = { LUFT_RES_KEYS(LUFT_KEY_NAME_ENTRY) };
+
+		// what lookups see before anything is loaded
+		const int32_t s_NoInts[IntCount] = {};
+		const uint32_t s_NoResOffsets[ResCount] = {};
+		const KeyTableData s_EmptyTable = { s_NoInts, s_NoResOffsets, "" };
+
+		struct LoadedTable
+		{
+			KeyTableData Data;
+			// a table is either mapped, or compiled in memory by a reload
+			MappedFile File;
+			larray<uint8_t> Bytes;
+		};
+
+		// every table loaded since startup, the last one is current
+		larray<Ref<LoadedTable>> s_Tables;
+
+		lstr s_TablePath;
+		lstr s_SourcePath;
+		FileWatchHandle s_SourceWatch;
+		FileWatchHandle s_TableWatch;
+		// watcher thread: of the table a source reload wrote, which needn't be mapped again
+		std::filesystem::file_time_type s_WrittenTableTime;
+
+		uint32_t HashNames(uint32_t hash, const char* kind, const char* const* names, uint32_t count)
+		{
+			auto mix = [&hash](const char* s) {
+				for (; *s; s++)
+				{
+					hash ^= (uint8_t)*s;
+					hash *= 16777619u;
+				}
+				hash ^= '\n';
+				hash *= 16777619u;
+			};
+			mix(kind);
+			for (uint32_t i = 0; i < count; i++)
+				mix(names[i]);
+			return hash;
+		}
+
+		uint32_t GetSchemaHash()
+		{
+			uint32_t hash = 2166136261u;
+			hash = HashNames(hash, "int", s_IntNames, IntCount);
+			hash = HashNames(hash, "res", s_ResNames, ResCount);
+			return hash;
+		}
+
+		int FindName(const char* const* names, uint32_t count, const lstr& name)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (name == names[i])
+					return (int)i;
+			}
+			return -1;
+		}
+
+		// checks the layout before anything is read through it
+		bool Validate(const uint8_t* data, size_t size, const lstr& path, KeyTableData& out)
+		{
+			if (size < sizeof(TableHeader))
+			{
+				CORE_LOG_ERROR("{0} is not a key table", path.c_str());
+				return false;
+			}
+
+			TableHeader header;
+			memcpy(&header, data, sizeof(header));
+			if (memcmp(header.Magic, TableMagic, sizeof(TableMagic)) != 0)
+			{
+				CORE_LOG_ERROR("{0} is not a key table", path.c_str());
+				return false;
+			}
+			if (header.SchemaHash != GetSchemaHash() || header.IntCount != IntCount || header.ResCount != ResCount)
+			{
+				CORE_LOG_ERROR("{0} was compiled for other keys, recompile it from keys.txt", path.c_str());
+				return false;
+			}
+
+			const size_t stringsAt = sizeof(TableHeader) + 4 * ((size_t)IntCount + ResCount);
+			if (header.StringBytes == 0 || size != stringsAt + header.StringBytes || data[size - 1] != 0)
+			{
+				CORE_LOG_ERROR("{0} is truncated", path.c_str());
+				return false;
+			}
+
+			out.Ints = (const int32_t*)(data + sizeof(TableHeader));
+			out.ResOffsets = (const uint32_t*)(out.Ints + IntCount);
+			out.Strings = (const char*)(data + stringsAt);
+			for (uint32_t i = 0; i < ResCount; i++)
+			{
+				if (out.ResOffsets[i] >= header.StringBytes)
+				{
+					CORE_LOG_ERROR("{0} is corrupt", path.c_str());
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	std::atomic<const KeyTableData*> KeyTable::s_Current{ &s_EmptyTable };
+
+	bool KeyTable::CompileToMemory(const lstr& sourcePath, larray<uint8_t>& out)
+	{
+		larray<KeyValueEntry> entries;
+		if (!KeyValueFile::Read(sourcePath, entries))
+			return false;
+
+		int32_t ints[IntCount] = {};
+		lstr strings[ResCount];
+		bool set[IntCount + ResCount] = {};
+		bool ok = true;
+		for (const KeyValueEntry& entry : entries)
+		{
+			const bool isInt = entry.Section == "int";
+			if (!isInt && entry.Section != "res")
+			{
+				CORE_LOG_ERROR("{0}:{1}: keys go under [int] or [res]", sourcePath.c_str(), entry.Line);
+				ok = false;
+				continue;
+			}
+
+			const int slot = isInt ? FindName(s_IntNames, IntCount, entry.Name) : FindName(s_ResNames, ResCount, entry.Name);
+			if (slot < 0)
+			{
+				CORE_LOG_WRAN("{0}:{1}: no such key '{2}', add it to EnumDefs.h first", sourcePath.c_str(), entry.Line, entry.Name.c_str());
+				continue;
+			}
+
+			if (isInt)
+			{
+				char* parsedEnd;
+				const long v = strtol(entry.Value.c_str(), &parsedEnd, 0);
+				if (entry.Value.empty() || *parsedEnd != 0)
+				{
+					CORE_LOG_ERROR("{0}:{1}: '{2}' is not an integer", sourcePath.c_str(), entry.Line, entry.Value.c_str());
+					ok = false;
+					continue;
+				}
+				ints[slot] = (int32_t)v;
+				set[slot] = true;
+			}
+			else
+			{
+				strings[slot] = entry.Value;
+				set[IntCount + slot] = true;
+			}
+		}
+		if (!ok)
+			return false;
+
+		for (uint32_t i = 0; i < IntCount + ResCount; i++)
+		{
+			if (!set[i])
+				CORE_LOG_WRAN("{0}: no value for '{1}'", sourcePath.c_str(), i < IntCount ? s_IntNames[i] : s_ResNames[i - IntCount]);
+		}
+
+		// offset 0 is the empty string, shared by every unset value
+		larray<char> blob;
+		blob.push_back(0);
+		uint32_t offsets[ResCount] = {};
+		for (uint32_t i = 0; i < ResCount; i++)
+		{
+			if (strings[i].empty())
+				continue;
+			offsets[i] = (uint32_t)blob.size();
+			blob.append(strings[i].c_str(), strings[i].size() + 1);
+		}
+
+		TableHeader header = {};
+		memcpy(header.Magic, TableMagic, sizeof(TableMagic));
+		header.SchemaHash = GetSchemaHash();
+		header.IntCount = IntCount;
+		header.ResCount = ResCount;
+		header.StringBytes = (uint32_t)blob.size();
+
+		out.clear();
+		out.append((const uint8_t*)&header, sizeof(header));
+		out.append((const uint8_t*)ints, 4 * IntCount);
+		out.append((const uint8_t*)offsets, 4 * ResCount);
+		out.append((const uint8_t*)blob.data(), blob.size());
+		return true;
+	}
+
+	bool KeyTable::Compile(const lstr& sourcePath, const lstr& tablePath)
+	{
+		larray<uint8_t> bytes;
+		if (!CompileToMemory(sourcePath, bytes))
+			return false;
+		if (!KeyValueFile::WriteReplacing(tablePath, bytes.data(), bytes.size()))
+		{
+			CORE_LOG_ERROR("Can't write key table {0}", tablePath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool KeyTable::Load(const lstr& tablePath, const lstr& sourcePath)
+	{
+		FileWatcher::Unwatch(s_SourceWatch);
+		FileWatcher::Unwatch(s_TableWatch);
+		s_SourceWatch = s_TableWatch = FileWatchHandle();
+		s_TablePath = tablePath;
+		s_SourcePath = sourcePath;
+		const std::filesystem::file_time_type sourceTime = sourcePath.empty() ? std::filesystem::file_time_type::min() : KeyValueFile::GetWriteTime(sourcePath);
+
+		if (sourceTime != std::filesystem::file_time_type::min() && KeyValueFile::GetWriteTime(tablePath) < sourceTime)
+		{
+			CORE_LOG_INFO("Compiling {0}", sourcePath.c_str());
+			Compile(sourcePath, tablePath);
+		}
+
+		Ref<LoadedTable> table = CreateRef<LoadedTable>();
+		if (!table->File.Open(tablePath))
+		{
+			CORE_LOG_ERROR("Can't open key table {0}", tablePath.c_str());
+			return false;
+		}
+		if (!Validate(table->File.Data(), table->File.Size(), tablePath, table->Data))
+		{
+			// e.g. built before keys were added: one more try from the source
+			table->File.Close();
+			if (sourceTime == std::filesystem::file_time_type::min() || !Compile(sourcePath, tablePath) ||
+				!table->File.Open(tablePath) || !Validate(table->File.Data(), table->File.Size(), tablePath, table->Data))
+				return false;
+		}
+		s_Tables.push_back(table);
+		s_Current.store(&table->Data, std::memory_order_release);
+
+		if (FileWatcher::IsRunning())
+		{
+			s_WrittenTableTime = std::filesystem::file_time_type::min();
+			auto apply = [](const larray<lstr>& changed, const Ref<void>& imported) {
+				if (!imported)
+					return;
+				Ref<LoadedTable> table = std::static_pointer_cast<LoadedTable>(imported);
+				s_Tables.push_back(table);
+				s_Current.store(&table->Data, std::memory_order_release);
+				CORE_LOG_INFO("Reloaded key table from {0}", changed[0].c_str());
+			};
+			if (!sourcePath.empty())
+			{
+				s_SourceWatch = FileWatcher::Watch(sourcePath, [](const larray<lstr>&) -> Ref<void> {
+					// compiled straight into memory: the mapped file can't be replaced on every
+					// platform while it is in use, so writing it back is only an attempt
+					Ref<LoadedTable> table = CreateRef<LoadedTable>();
+					if (!CompileToMemory(s_SourcePath, table->Bytes) || !Validate(table->Bytes.data(), table->Bytes.size(), s_SourcePath, table->Data))
+						return nullptr;
+					if (KeyValueFile::WriteReplacing(s_TablePath, table->Bytes.data(), table->Bytes.size()))
+						s_WrittenTableTime = KeyValueFile::GetWriteTime(s_TablePath);
+					else
+						CORE_LOG_WRAN("Can't update {0} while it's mapped, it is rebuilt on the next start", s_TablePath.c_str());
+					return table;
+				}, apply);
+			}
+			s_TableWatch = FileWatcher::Watch(tablePath, [](const larray<lstr>&) -> Ref<void> {
+				const std::filesystem::file_time_type tableTime = KeyValueFile::GetWriteTime(s_TablePath);
+				if (tableTime == std::filesystem::file_time_type::min() || tableTime == s_WrittenTableTime)
+					return nullptr;
+				Ref<LoadedTable> table = CreateRef<LoadedTable>();
+				if (!table->File.Open(s_TablePath) || !Validate(table->File.Data(), table->File.Size(), s_TablePath, table->Data))
+					return nullptr;
+				return table;
+			}, apply);
+		}
+		return true;
+	}
+
+	void KeyTable::Unload()
+	{
+		FileWatcher::Unwatch(s_SourceWatch);
+		FileWatcher::Unwatch(s_TableWatch);
+		s_SourceWatch = s_TableWatch = FileWatchHandle();
+		s_Current.store(&s_EmptyTable, std::memory_order_release);
+		s_Tables.clear();
+		s_TablePath.clear();
+		s_SourcePath.clear();
+	}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/EnumDefs.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	// one loaded table, arrays indexed by key
+	struct KeyTableData
+	{
+		const int32_t* Ints;
+		// into Strings, each value is null terminated
+		const uint32_t* ResOffsets;
+		const char* Strings;
+	};
+
+	// IntKey/ResKey values, compiled from resources/config/keys.txt into a flat binary table
+	// that is memory-mapped at startup. A lookup is one load and an index. Until a table is loaded,
+	// and for keys a table has no value for, ints are 0 and strings empty.
+	// Hot reload swaps in a whole new table when the FileWatcher sees either file change; replaced
+	// tables stay mapped until Unload, so strings handed out before stay valid.
+	class LUFT_API KeyTable
+	{
+	public:
+		// Maps the compiled table. With a source path the table is first (re)compiled when it is
+		// missing or older than the source. Both files are watched while the FileWatcher runs
+		static bool Load(const lstr& tablePath, const lstr& sourcePath = lstr());
+		// compiles every key of the source, warning about unknown or missing ones
+		static bool Compile(const lstr& sourcePath, const lstr& tablePath);
+		static void Unload();
+
+		static int GetInt(IntKey key) { return s_Current.load(std::memory_order_acquire)->Ints[(size_t)key]; }
+		static const char* GetRes(ResKey key)
+		{
+			const KeyTableData* t = s_Current.load(std::memory_order_acquire);
+			return t->Strings + t->ResOffsets[(size_t)key];
+		}
+
+	private:
+		static bool CompileToMemory(const lstr& sourcePath, larray<uint8_t>& out);
+
+		static std::atomic<const KeyTableData*> s_Current;
+	};
+
+}
@@ -0,0 +1,155 @@
+#include "KeyValueFile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <system_error>
+#include "Luft/Core/Log.h"
+
+namespace Luft {
+
+	namespace
+	{
+		bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		// a quoted value, or the rest of the line trimmed
+		bool ParseValue(const char* s, const char* end, lstr& out)
+		{
+			while (end > s && IsSpace(end[-1]))
+				end--;
+			if (s == end || *s != '"')
+			{
+				out.append(s, end - s);
+				return true;
+			}
+
+			for (s++; s < end; s++)
+			{
+				if (*s == '"')
+					return true;
+				if (*s == '\\' && s + 1 < end)
+				{
+					s++;
+					switch (*s)
+					{
+					case 'n': out.push_back('\n'); break;
+					case 't': out.push_back('\t'); break;
+					default: out.push_back(*s); break;
+					}
+				}
+				else
+					out.push_back(*s);
+			}
+			// no closing quote
+			return false;
+		}
+	}
+
+	bool KeyValueFile::Read(const lstr& path, larray<KeyValueEntry>& out)
+	{
+		FILE* f = fopen(path.c_str(), "rb");
+		if (!f)
+		{
+			CORE_LOG_ERROR("Can't open {0}", path.c_str());
+			return false;
+		}
+		larray<char> text;
+		char buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+			text.append(buffer, read);
+		fclose(f);
+
+		const char* s = text.data();
+		const char* const end = s + text.size();
+		// a UTF-8 byte order mark, as some editors write one
+		if (text.size() >= 3 && memcmp(s, "\xEF\xBB\xBF", 3) == 0)
+			s += 3;
+
+		lstr section;
+		bool ok = true;
+		for (int lineNumber = 1; s < end; lineNumber++)
+		{
+			const char* lineEnd = (const char*)memchr(s, '\n', end - s);
+			if (!lineEnd)
+				lineEnd = end;
+			const char* line = s;
+			s = lineEnd + 1;
+
+			while (line < lineEnd && IsSpace(*line))
+				line++;
+			if (line == lineEnd || *line == '#')
+				continue;
+
+			if (*line == '[')
+			{
+				const char* close = (const char*)memchr(line, ']', lineEnd - line);
+				if (!close)
+				{
+					CORE_LOG_ERROR("{0}:{1}: missing ]", path.c_str(), lineNumber);
+					ok = false;
+					continue;
+				}
+				section = lstr(line + 1, close - line - 1);
+				continue;
+			}
+
+			const char* equals = (const char*)memchr(line, '=', lineEnd - line);
+			if (!equals)
+			{
+				CORE_LOG_ERROR("{0}:{1}: expected name = value", path.c_str(), lineNumber);
+				ok = false;
+				continue;
+			}
+			const char* nameEnd = equals;
+			while (nameEnd > line && IsSpace(nameEnd[-1]))
+				nameEnd--;
+			const char* value = equals + 1;
+			while (value < lineEnd && IsSpace(*value))
+				value++;
+
+			KeyValueEntry entry;
+			entry.Section = section;
+			entry.Name = lstr(line, nameEnd - line);
+			entry.Line = lineNumber;
+			if (!ParseValue(value, lineEnd, entry.Value))
+			{
+				CORE_LOG_ERROR("{0}:{1}: missing closing quote", path.c_str(), lineNumber);
+				ok = false;
+				continue;
+			}
+			out.push_back(entry);
+		}
+		return ok;
+	}
+
+	bool KeyValueFile::WriteReplacing(const lstr& path, const void* data, size_t size)
+	{
+		const lstr temp = path + ".tmp";
+		FILE* f = fopen(temp.c_str(), "wb");
+		if (!f)
+			return false;
+		const bool written = fwrite(data, 1, size, f) == size;
+		fclose(f);
+
+		std::error_code ec;
+		if (written)
+			std::filesystem::rename(temp.c_str(), path.c_str(), ec);
+		if (!written || ec)
+		{
+			std::filesystem::remove(temp.c_str(), ec);
+			return false;
+		}
+		return true;
+	}
+
+	std::filesystem::file_time_type KeyValueFile::GetWriteTime(const lstr& path)
+	{
+		std::error_code ec;
+		std::filesystem::file_time_type time = std::filesystem::last_write_time(path.c_str(), ec);
+		return ec ? std::filesystem::file_time_type::min() : time;
+	}
+
+}
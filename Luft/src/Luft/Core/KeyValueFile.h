@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <filesystem>
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	struct KeyValueEntry
+	{
+		// the [section] above the line, empty before the first one
+		lstr Section;
+		lstr Name;
+		// quotes removed and escapes resolved
+		lstr Value;
+		int Line;
+	};
+
+	// The text sources the engine compiles into binary tables (keys.txt, localization). One
+	// "name = value" per line under [section] headers, lines starting with '#' are comments.
+	// Values may be quoted, with \n \t \" \\ escapes.
+	class KeyValueFile
+	{
+	public:
+		// logs malformed lines as path:line and returns false if there were any
+		static bool Read(const lstr& path, larray<KeyValueEntry>& out);
+		// writes aside and renames over path, so a mapped older version is never changed underneath
+		static bool WriteReplacing(const lstr& path, const void* data, size_t size);
+		// file_time_type::min() if the file doesn't exist
+		static std::filesystem::file_time_type GetWriteTime(const lstr& path);
+	};
+
+}
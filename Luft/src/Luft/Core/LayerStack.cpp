@@ -11,17 +11,19 @@ namespace Luft {
 		}
 	}
 
-	void LayerStack::PushLayer(Layer* layer)
+	LayerHandle LayerStack::PushLayer(Layer* layer)
 	{
 		m_Layers.emplace(m_Layers.begin() + m_LayerInsertIndex, layer);
 		m_LayerInsertIndex++;
 		layer->OnAttach();
+		return m_Handles.insert(layer);
 	}
 
-	void LayerStack::PushOverlay(Layer* overlay)
+	LayerHandle LayerStack::PushOverlay(Layer* overlay)
 	{
 		m_Layers.emplace_back(overlay);
 		overlay->OnAttach();
+		return m_Handles.insert(overlay);
 	}
 
 	void LayerStack::PopLayer(Layer* layer)
@@ -32,6 +34,7 @@ namespace Luft {
 			layer->OnDetach();
 			m_Layers.erase(it);
 			m_LayerInsertIndex--;
+			ReleaseHandle(layer);
 		}
 	}
 
@@ -42,6 +45,26 @@ namespace Luft {
 		{
 			overlay->OnDetach();
 			m_Layers.erase(it);
+			ReleaseHandle(overlay);
+		}
+	}
+
+	Layer* LayerStack::Get(LayerHandle handle) const
+	{
+		Layer* const* layer = m_Handles.get(handle);
+		return layer ? *layer : nullptr;
+	}
+
+	void LayerStack::ReleaseHandle(Layer* layer)
+	{
+		// popping is rare, a linear walk over the dense handles is fine
+		for (size_t i = 0; i < m_Handles.size(); i++)
+		{
+			if (m_Handles[i] == layer)
+			{
+				m_Handles.erase(m_Handles.handleAt(i));
+				return;
+			}
 		}
 	}
 
@@ -3,21 +3,28 @@
 #include <vector>
 #include "Base.h"
 #include "Layer.h"
+#include "lslotmap.h"
 
 
 namespace Luft {
 
+	// stable reference to a pushed layer, resolves to nullptr once the layer is popped
+	typedef lhandle32 LayerHandle;
+
 	class LayerStack
 	{
 	public:
 		LayerStack() = default;
 		~LayerStack();
 
-		void PushLayer(Layer* layer);
-		void PushOverlay(Layer* overlay);
+		LayerHandle PushLayer(Layer* layer);
+		LayerHandle PushOverlay(Layer* overlay);
 		void PopLayer(Layer* layer);
 		void PopOverlay(Layer* overlay);
 
+		// O(1), validated against the handle's generation
+		Layer* Get(LayerHandle handle) const;
+
 		std::vector<Layer*>::iterator begin() { return m_Layers.begin(); }
 		std::vector<Layer*>::iterator end() { return m_Layers.end(); }
 		std::vector<Layer*>::reverse_iterator rbegin() { return m_Layers.rbegin(); }
@@ -28,8 +35,11 @@ namespace Luft {
 		std::vector<Layer*>::const_reverse_iterator rbegin() const { return m_Layers.rbegin(); }
 		std::vector<Layer*>::const_reverse_iterator rend() const { return m_Layers.rend(); }
 	private:
+		void ReleaseHandle(Layer* layer);
+
 		std::vector<Layer*> m_Layers;
 		unsigned int m_LayerInsertIndex = 0;
+		lslotmap<Layer*> m_Handles;
 	};
 
 }
\ No newline at end of file
@@ -1,19 +1,309 @@
-#include "SystemService.h"
+#include "Localization.h"
 
-#define RCAST_CSTR(pointer) reinterpret_cast<const char*>(pointer)
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include "Luft/Core/FileWatcher.h"
+#include "Luft/Core/KeyValueFile.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/MappedFile.h"
 
-namespace Luft
-{
-	std::optional<char const*> Luft::GetTextVal(TextKey e)
+#define LUFT_KEY_NAME_ENTRY(name) #name,
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr char PackMagic[8] = { 'L', 'L', 'P', 'K', '1', 0, 0, 0 };
+		constexpr uint32_t TextCount = (uint32_t)TextKey::Count;
+
+		// followed by uint32 offsets, one per TextKey, and the string blob
+		struct PackHeader
+		{
+			char Magic[8];
+			// of the TextKey names, a pack built for other keys isn't read with these
+			uint32_t SchemaHash;
+			uint32_t Count;
+			uint32_t StringBytes;
+			uint32_t Reserved;
+		};
+
+		const char* const s_TextNames[] = { LUFT_TEXT_KEYS(LUFT_KEY_NAME_ENTRY) };
+
+		const uint32_t s_NoOffsets[TextCount] = {};
+		const LocalizationPackData s_EmptyPack = { s_NoOffsets, "" };
+
+		struct LoadedPack
+		{
+			lstr Language;
+			LocalizationPackData Data;
+			// mapped, or compiled in memory by a reload
+			MappedFile File;
+			larray<uint8_t> Bytes;
+		};
+
+		// every pack mapped since Init, the current language's newest one is in use
+		larray<Ref<LoadedPack>> s_Packs;
+		lstr s_Dir;
+		FileWatchHandle s_Watch;
+
+		lstr GetSourcePath(const lstr& language) { return s_Dir + "/" + language + ".txt"; }
+		lstr GetPackPath(const lstr& language) { return s_Dir + "/" + language + ".lpk"; }
+
+		uint32_t GetSchemaHash()
+		{
+			uint32_t hash = 2166136261u;
+			for (const char* name : s_TextNames)
+			{
+				for (const char* c = name; *c; c++)
+				{
+					hash ^= (uint8_t)*c;
+					hash *= 16777619u;
+				}
+				hash ^= '\n';
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+
+		bool Validate(const uint8_t* data, size_t size, const lstr& path, LocalizationPackData& out)
+		{
+			PackHeader header;
+			if (size < sizeof(header))
+			{
+				CORE_LOG_ERROR("{0} is not a localization pack", path.c_str());
+				return false;
+			}
+			memcpy(&header, data, sizeof(header));
+			if (memcmp(header.Magic, PackMagic, sizeof(PackMagic)) != 0)
+			{
+				CORE_LOG_ERROR("{0} is not a localization pack", path.c_str());
+				return false;
+			}
+			if (header.SchemaHash != GetSchemaHash() || header.Count != TextCount)
+			{
+				CORE_LOG_ERROR("{0} was built for other text keys", path.c_str());
+				return false;
+			}
+
+			const size_t stringsAt = sizeof(PackHeader) + 4 * (size_t)TextCount;
+			if (header.StringBytes == 0 || size != stringsAt + header.StringBytes || data[size - 1] != 0)
+			{
+				CORE_LOG_ERROR("{0} is truncated", path.c_str());
+				return false;
+			}
+
+			out.Offsets = (const uint32_t*)(data + sizeof(PackHeader));
+			out.Strings = (const char*)(data + stringsAt);
+			for (uint32_t i = 0; i < TextCount; i++)
+			{
+				if (out.Offsets[i] >= header.StringBytes)
+				{
+					CORE_LOG_ERROR("{0} is corrupt", path.c_str());
+					return false;
+				}
+			}
+			return true;
+		}
+
+		LoadedPack* FindPack(const lstr& language)
+		{
+			for (size_t i = s_Packs.size(); i > 0; i--)
+			{
+				if (s_Packs[i - 1]->Language == language)
+					return s_Packs[i - 1].get();
+			}
+			return nullptr;
+		}
+	}
+
+	std::atomic<const LocalizationPackData*> Localization::s_Current{ &s_EmptyPack };
+	lstr Localization::s_Language;
+	larray<lstr> Localization::s_Languages;
+
+	bool Localization::CompileToMemory(const lstr& sourcePath, larray<uint8_t>& out)
+	{
+		larray<KeyValueEntry> entries;
+		if (!KeyValueFile::Read(sourcePath, entries))
+			return false;
+
+		lstr texts[TextCount];
+		bool set[TextCount] = {};
+		for (const KeyValueEntry& entry : entries)
+		{
+			int slot = -1;
+			for (uint32_t i = 0; i < TextCount && slot < 0; i++)
+			{
+				if (entry.Name == s_TextNames[i])
+					slot = (int)i;
+			}
+			if (slot < 0)
+			{
+				CORE_LOG_WRAN("{0}:{1}: no such text key '{2}'", sourcePath.c_str(), entry.Line, entry.Name.c_str());
+				continue;
+			}
+			texts[slot] = entry.Value;
+			set[slot] = true;
+		}
+
+		larray<char> blob;
+		uint32_t offsets[TextCount] = {};
+		for (uint32_t i = 0; i < TextCount; i++)
+		{
+			if (!set[i])
+			{
+				CORE_LOG_WRAN("{0}: no text for '{1}'", sourcePath.c_str(), s_TextNames[i]);
+				texts[i] = s_TextNames[i];
+			}
+			offsets[i] = (uint32_t)blob.size();
+			blob.append(texts[i].c_str(), texts[i].size() + 1);
+		}
+
+		PackHeader header = {};
+		memcpy(header.Magic, PackMagic, sizeof(PackMagic));
+		header.SchemaHash = GetSchemaHash();
+		header.Count = TextCount;
+		header.StringBytes = (uint32_t)blob.size();
+
+		out.clear();
+		out.append((const uint8_t*)&header, sizeof(header));
+		out.append((const uint8_t*)offsets, 4 * TextCount);
+		out.append((const uint8_t*)blob.data(), blob.size());
+		return true;
+	}
+
+	bool Localization::Compile(const lstr& sourcePath, const lstr& packPath)
+	{
+		larray<uint8_t> bytes;
+		if (!CompileToMemory(sourcePath, bytes))
+			return false;
+		if (!KeyValueFile::WriteReplacing(packPath, bytes.data(), bytes.size()))
+		{
+			CORE_LOG_ERROR("Can't write localization pack {0}", packPath.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool Localization::Init(const lstr& dir, const lstr& language)
+	{
+		FileWatcher::Unwatch(s_Watch);
+		s_Watch = FileWatchHandle();
+		s_Dir = dir;
+		s_Languages.clear();
+
+		std::error_code ec;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir.c_str(), ec))
+		{
+			const std::filesystem::path& path = entry.path();
+			if (path.extension() != ".lpk" && path.extension() != ".txt")
+				continue;
+			const lstr name = path.stem().string().c_str();
+			if (std::find(s_Languages.begin(), s_Languages.end(), name) == s_Languages.end())
+				s_Languages.push_back(name);
+		}
+		std::sort(s_Languages.begin(), s_Languages.end());
+
+		if (FileWatcher::IsRunning())
+		{
+			s_Watch = FileWatcher::Watch(dir, [](const larray<lstr>& changed) -> Ref<void> {
+				// compiled in memory, a mapped pack may not be replaceable while it's in use
+				Ref<larray<Ref<LoadedPack>>> packs = CreateRef<larray<Ref<LoadedPack>>>();
+				larray<lstr> sources = changed;
+				if (std::find_if(changed.begin(), changed.end(), [](const lstr& path) { return path.back() == '/'; }) != changed.end())
+				{
+					// the watcher lost track, every text may have changed
+					sources.clear();
+					std::error_code ec;
+					for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(s_Dir.c_str(), ec))
+						sources.push_back(entry.path().generic_string().c_str());
+				}
+				for (const lstr& sourcePath : sources)
+				{
+					const std::filesystem::path path = sourcePath.c_str();
+					if (path.extension() != ".txt" || KeyValueFile::GetWriteTime(sourcePath) == std::filesystem::file_time_type::min())
+						continue;
+					Ref<LoadedPack> pack = CreateRef<LoadedPack>();
+					pack->Language = path.stem().string().c_str();
+					if (!CompileToMemory(sourcePath, pack->Bytes) || !Validate(pack->Bytes.data(), pack->Bytes.size(), sourcePath, pack->Data))
+						continue;
+					const lstr packPath = GetPackPath(pack->Language);
+					if (!KeyValueFile::WriteReplacing(packPath, pack->Bytes.data(), pack->Bytes.size()))
+						CORE_LOG_WRAN("Can't update {0} while it's mapped, it is rebuilt on the next start", packPath.c_str());
+					packs->push_back(pack);
+				}
+				return packs->empty() ? nullptr : packs;
+			}, [](const larray<lstr>&, const Ref<void>& imported) {
+				if (!imported)
+					return;
+				for (const Ref<LoadedPack>& pack : *std::static_pointer_cast<larray<Ref<LoadedPack>>>(imported))
+				{
+					if (std::find(s_Languages.begin(), s_Languages.end(), pack->Language) == s_Languages.end())
+					{
+						s_Languages.push_back(pack->Language);
+						std::sort(s_Languages.begin(), s_Languages.end());
+					}
+					// a language that was never selected maps the rewritten pack when it is
+					if (!FindPack(pack->Language))
+						continue;
+					s_Packs.push_back(pack);
+					if (pack->Language == s_Language)
+						s_Current.store(&pack->Data, std::memory_order_release);
+					CORE_LOG_INFO("Reloaded {0}", GetSourcePath(pack->Language).c_str());
+				}
+			});
+		}
+
+		return SetLanguage(language);
+	}
+
+	bool Localization::SetLanguage(const lstr& language)
 	{
-		switch (e)
+		LoadedPack* pack = FindPack(language);
+		if (!pack)
 		{
-		case TextKey::text_1:
-			return RCAST_CSTR(u8"ı1");
-		case TextKey::text_2:
-			return RCAST_CSTR(u8"ı2");
+			const lstr sourcePath = GetSourcePath(language);
+			const lstr packPath = GetPackPath(language);
+			const std::filesystem::file_time_type sourceTime = KeyValueFile::GetWriteTime(sourcePath);
+			const bool hasSource = sourceTime != std::filesystem::file_time_type::min();
+			if (hasSource && KeyValueFile::GetWriteTime(packPath) < sourceTime)
+			{
+				CORE_LOG_INFO("Compiling {0}", sourcePath.c_str());
+				Compile(sourcePath, packPath);
+			}
 
+			Ref<LoadedPack> loadedPack = CreateRef<LoadedPack>();
+			loadedPack->Language = language;
+			bool loaded = loadedPack->File.Open(packPath) && Validate(loadedPack->File.Data(), loadedPack->File.Size(), packPath, loadedPack->Data);
+			if (!loaded && hasSource)
+			{
+				// e.g. a stale pack that can't be replaced right now
+				loadedPack->File.Close();
+				loaded = CompileToMemory(sourcePath, loadedPack->Bytes) && Validate(loadedPack->Bytes.data(), loadedPack->Bytes.size(), sourcePath, loadedPack->Data);
+			}
+			if (!loaded)
+			{
+				CORE_LOG_ERROR("No localization for {0}", language.c_str());
+				return false;
+			}
+			s_Packs.push_back(loadedPack);
+			pack = loadedPack.get();
 		}
-		return std::optional<char const*>();
+
+		s_Language = language;
+		s_Current.store(&pack->Data, std::memory_order_release);
+		return true;
 	}
-}
\ No newline at end of file
+
+	void Localization::Shutdown()
+	{
+		FileWatcher::Unwatch(s_Watch);
+		s_Watch = FileWatchHandle();
+		s_Current.store(&s_EmptyPack, std::memory_order_release);
+		s_Packs.clear();
+		s_Languages.clear();
+		s_Language.clear();
+	}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/EnumDefs.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	// one language's strings, indexed by TextKey
+	struct LocalizationPackData
+	{
+		const uint32_t* Offsets;
+		const char* Strings;
+	};
+
+	// Localized text. Each language is a pack <dir>/<language>.lpk, a string table compiled from
+	// <dir>/<language>.txt by the localization-packs build step or, when the text is newer, on
+	// first use. A pack is memory-mapped the first time its language is selected and stays mapped,
+	// so switching back and forth costs one pointer swap and strings handed out stay valid. While
+	// the FileWatcher runs, an edited text is recompiled and the new pack swapped in the same way.
+	// Before Init every text is empty; a key a language has no text for shows its own name.
+	class LUFT_API Localization
+	{
+	public:
+		// finds the languages in dir and selects one
+		static bool Init(const lstr& dir, const lstr& language);
+		static void Shutdown();
+
+		// maps the language's pack if it isn't yet. Keeps the current language on failure
+		static bool SetLanguage(const lstr& language);
+		static const lstr& GetLanguage() { return s_Language; }
+		// every language with a pack or a source in the directory, sorted
+		static const larray<lstr>& GetLanguages() { return s_Languages; }
+
+		static bool Compile(const lstr& sourcePath, const lstr& packPath);
+
+		static const char* Get(TextKey key)
+		{
+			const LocalizationPackData* pack = s_Current.load(std::memory_order_acquire);
+			return pack->Strings + pack->Offsets[(size_t)key];
+		}
+
+	private:
+		static bool CompileToMemory(const lstr& sourcePath, larray<uint8_t>& out);
+
+		static std::atomic<const LocalizationPackData*> s_Current;
+		static lstr s_Language;
+		static larray<lstr> s_Languages;
+	};
+
+}
@@ -1,21 +1,96 @@
 #include "Log.h"
+#include "spdlog/async.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
+#include "Luft/Debug/Profiler.h"
 
 namespace Luft
 {
 	std::shared_ptr<spdlog::logger> Log::s_CoreLogger;
 	std::shared_ptr<spdlog::logger> Log::s_ClientLogger;
+	std::shared_ptr<spdlog::logger> Log::s_HotLogger;
+	std::shared_ptr<LogRingSink> Log::s_ConsoleSink;
 
-	void Log::Init()
+	namespace
+	{
+		spdlog::async_overflow_policy ToSpdlog(LogOverflowPolicy policy)
+		{
+			switch (policy)
+			{
+			case LogOverflowPolicy::Block: return spdlog::async_overflow_policy::block;
+			case LogOverflowPolicy::DiscardNew: return spdlog::async_overflow_policy::discard_new;
+			default: return spdlog::async_overflow_policy::overrun_oldest;
+			}
+		}
+
+		std::shared_ptr<spdlog::logger> CreateLogger(const char* name, const LogSettings& settings, const std::shared_ptr<LogRingSink>& consoleSink)
+		{
+			// every logger shares the console sink, so their lines don't interleave mid-write
+			static std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> s_Sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+			std::vector<spdlog::sink_ptr> sinks = { s_Sink };
+			if (consoleSink)
+				sinks.push_back(consoleSink);
+
+			std::shared_ptr<spdlog::logger> logger;
+			if (settings.Async)
+				logger = std::make_shared<spdlog::async_logger>(name, sinks.begin(), sinks.end(), spdlog::thread_pool(), ToSpdlog(settings.Overflow));
+			else
+				logger = std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+			// registers it and applies the global pattern, like the spdlog factories do
+			spdlog::initialize_logger(logger);
+			logger->set_level(spdlog::level::trace);
+			logger->flush_on(settings.FlushLevel);
+			return logger;
+		}
+	}
+
+	void Log::Init(const LogSettings& settings)
 	{
 		// color [time] loger (source file line) logtext 
 		// pattern detail see: https://github.com/gabime/spdlog/wiki/3.-Custom-formatting#customizing-format-using-set_pattern
 		spdlog::set_pattern("%^[%T] %n %@: %v%$");
-		s_CoreLogger = spdlog::stdout_color_mt("Luft-Core");
-		s_CoreLogger->set_level(spdlog::level::trace);
+		if (settings.Async)
+		{
+			// one worker keeps the output in order
+			spdlog::init_thread_pool(settings.QueueSize, 1, [] { LUFT_PROFILE_THREAD("Log"); });
+		}
+
+		if (settings.ConsoleCapacity > 0)
+			s_ConsoleSink = std::make_shared<LogRingSink>(settings.ConsoleCapacity);
+
+		s_CoreLogger = CreateLogger("Luft-Core", settings, s_ConsoleSink);
+		s_ClientLogger = CreateLogger("Luft-Client", settings, s_ConsoleSink);
+
+		LogSettings sync = settings;
+		sync.Async = false;
+		s_HotLogger = CreateLogger("Luft-Hot", sync, s_ConsoleSink);
+	}
+
+	void Log::Shutdown()
+	{
+		// drops the registry's thread pool, whose worker writes out what is queued before it joins
+		spdlog::shutdown();
+
+		// anything logged from here on, e.g. by static destructors, goes straight to the console
+		LogSettings sync;
+		sync.Async = false;
+		s_CoreLogger = CreateLogger("Luft-Core", sync, s_ConsoleSink);
+		s_ClientLogger = CreateLogger("Luft-Client", sync, s_ConsoleSink);
+		s_HotLogger = CreateLogger("Luft-Hot", sync, s_ConsoleSink);
+	}
 
-		s_ClientLogger = spdlog::stdout_color_mt("Luft-Client");
-		s_CoreLogger->set_level(spdlog::level::trace);
+	void Log::Flush()
+	{
+		if (s_CoreLogger)
+			s_CoreLogger->flush();
+		if (s_ClientLogger)
+			s_ClientLogger->flush();
+		if (s_HotLogger)
+			s_HotLogger->flush();
+	}
 
+	size_t Log::GetDroppedCount()
+	{
+		std::shared_ptr<spdlog::details::thread_pool> pool = spdlog::thread_pool();
+		return pool ? pool->overrun_counter() + pool->discard_counter() : 0;
 	}
 }
@@ -1,33 +1,113 @@
 #pragma once
 #include "Luft/Core/Base.h"
+#include "Luft/Core/LogRingSink.h"
 #include "spdlog/spdlog.h"
 
+// Levels for LUFT_LOG_ACTIVE_LEVEL. Macros below the active level expand to nothing, so their
+// arguments aren't evaluated either
+#define LUFT_LOG_LEVEL_TRACE 0
+#define LUFT_LOG_LEVEL_INFO 2
+#define LUFT_LOG_LEVEL_WARN 3
+#define LUFT_LOG_LEVEL_ERROR 4
+#define LUFT_LOG_LEVEL_FATAL 5
+#define LUFT_LOG_LEVEL_OFF 6
+
+#ifndef LUFT_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define LUFT_LOG_ACTIVE_LEVEL LUFT_LOG_LEVEL_INFO
+#else
+#define LUFT_LOG_ACTIVE_LEVEL LUFT_LOG_LEVEL_TRACE
+#endif
+#endif
+
 namespace Luft
 {
+	enum class LogOverflowPolicy
+	{
+		// the logging thread waits for room, nothing is lost
+		Block,
+		// the oldest queued message makes room
+		OverrunOldest,
+		// the new message is dropped, the logging thread never waits
+		DiscardNew
+	};
+
+	struct LogSettings
+	{
+		// format and write on a background thread, the calling thread only queues the message
+		bool Async = true;
+		// messages, preallocated
+		size_t QueueSize = 8192;
+		LogOverflowPolicy Overflow = LogOverflowPolicy::OverrunOldest;
+		// messages at this level and above are flushed right away, async or not
+		spdlog::level::level_enum FlushLevel = spdlog::level::err;
+		// messages every logger also keeps for the in-editor console, 0 keeps none
+		uint32_t ConsoleCapacity = 16384;
+	};
+
 	class LUFT_API Log
 	{
 	public:
-		static void Init();
+		static void Init(const LogSettings& settings = LogSettings());
+		// drains the async queue and stops its thread, later messages are written synchronously
+		static void Shutdown();
+		static void Flush();
+		// messages lost to a full queue since Init, always 0 in sync mode or with Block
+		static size_t GetDroppedCount();
 
 		inline static std::shared_ptr<spdlog::logger>& GetCoreLogger() { return s_CoreLogger; }
 		inline static std::shared_ptr<spdlog::logger>& GetClientLogger() { return s_ClientLogger; }
+		// BinaryLog's output. Only its background thread writes here, so it's always synchronous
+		inline static std::shared_ptr<spdlog::logger>& GetHotLogger() { return s_HotLogger; }
+		// null when LogSettings::ConsoleCapacity is 0
+		inline static std::shared_ptr<LogRingSink>& GetConsoleSink() { return s_ConsoleSink; }
 
 	private:
 		static std::shared_ptr<spdlog::logger> s_CoreLogger;
 		static std::shared_ptr<spdlog::logger> s_ClientLogger;
+		static std::shared_ptr<spdlog::logger> s_HotLogger;
+		static std::shared_ptr<LogRingSink> s_ConsoleSink;
 	};
 }
 
-// Core Log Macros
+// Core (CORE_LOG_*) and Client (LUFT_LOG_*) Log Macros
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_TRACE
 #define CORE_LOG_TRACE(...)		::Luft::Log::GetCoreLogger()->trace(__VA_ARGS__)
-#define CORE_LOG_INFO(...)		::Luft::Log::GetCoreLogger()->info(__VA_ARGS__)
-#define CORE_LOG_WRAN(...)		::Luft::Log::GetCoreLogger()->warn(__VA_ARGS__)
-#define CORE_LOG_ERROR(...)		::Luft::Log::GetCoreLogger()->error(__VA_ARGS__)
-#define CORE_LOG_FATAL(...)		::Luft::Log::GetCoreLogger()->fatal(__VA_ARGS__)
-
-// Client Log Macros
 #define LUFT_LOG_TRACE(...)		::Luft::Log::GetClientLogger()->trace(__VA_ARGS__)
+#else
+#define CORE_LOG_TRACE(...)		(void)0
+#define LUFT_LOG_TRACE(...)		(void)0
+#endif
+
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_INFO
+#define CORE_LOG_INFO(...)		::Luft::Log::GetCoreLogger()->info(__VA_ARGS__)
 #define LUFT_LOG_INFO(...)		::Luft::Log::GetClientLogger()->info(__VA_ARGS__)
+#else
+#define CORE_LOG_INFO(...)		(void)0
+#define LUFT_LOG_INFO(...)		(void)0
+#endif
+
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_WARN
+#define CORE_LOG_WRAN(...)		::Luft::Log::GetCoreLogger()->warn(__VA_ARGS__)
 #define LUFT_LOG_WRAN(...)		::Luft::Log::GetClientLogger()->warn(__VA_ARGS__)
+#else
+#define CORE_LOG_WRAN(...)		(void)0
+#define LUFT_LOG_WRAN(...)		(void)0
+#endif
+
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_ERROR
+#define CORE_LOG_ERROR(...)		::Luft::Log::GetCoreLogger()->error(__VA_ARGS__)
 #define LUFT_LOG_ERROR(...)		::Luft::Log::GetClientLogger()->error(__VA_ARGS__)
-#define LUFT_LOG_FATAL(...)		::Luft::Log::GetClientLogger()->fatal(__VA_ARGS__)
\ No newline at end of file
+#else
+#define CORE_LOG_ERROR(...)		(void)0
+#define LUFT_LOG_ERROR(...)		(void)0
+#endif
+
+// spdlog calls its highest level critical
+#if LUFT_LOG_ACTIVE_LEVEL <= LUFT_LOG_LEVEL_FATAL
+#define CORE_LOG_FATAL(...)		::Luft::Log::GetCoreLogger()->critical(__VA_ARGS__)
+#define LUFT_LOG_FATAL(...)		::Luft::Log::GetClientLogger()->critical(__VA_ARGS__)
+#else
+#define CORE_LOG_FATAL(...)		(void)0
+#define LUFT_LOG_FATAL(...)		(void)0
+#endif
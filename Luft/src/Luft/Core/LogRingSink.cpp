@@ -0,0 +1,121 @@
+#include "LogRingSink.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include "Luft/Core/Memory.h"
+
+namespace Luft {
+
+	LogRingSink::LogRingSink(uint32_t capacity)
+	{
+		uint32_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		m_Mask = size - 1;
+
+		m_Slots = (Slot*)Memory::Allocate(sizeof(Slot) * size, MemoryTag::Log, alignof(Slot));
+		for (uint32_t i = 0; i < size; i++)
+			new (&m_Slots[i]) Slot();
+	}
+
+	LogRingSink::~LogRingSink()
+	{
+		for (uint32_t i = 0; i <= m_Mask; i++)
+			m_Slots[i].~Slot();
+		Memory::Free(m_Slots);
+	}
+
+	void LogRingSink::log(const spdlog::details::log_msg& msg)
+	{
+		if (!should_log(msg.level))
+			return;
+
+		const uint64_t index = m_Write.fetch_add(1, std::memory_order_relaxed);
+		Slot& slot = m_Slots[index & m_Mask];
+
+		// the slot normally holds the previous lap's record. If a writer from that lap is still in
+		// it, or one from a later lap got here first, this record is dropped rather than waiting.
+		// The reader finds the index unpublished and counts it as lost
+		uint64_t seq = slot.Sequence.load(std::memory_order_relaxed);
+		if ((seq & 1) || seq > 2 * index ||
+			!slot.Sequence.compare_exchange_strong(seq, 2 * index + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			return;
+
+		LogRecord& record = slot.Record;
+		record.Time = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count();
+		record.Level = (uint8_t)msg.level;
+
+		size_t nameLength = msg.logger_name.size() < LogRecord::MaxLogger ? msg.logger_name.size() : LogRecord::MaxLogger;
+		memcpy(record.Logger, msg.logger_name.data(), nameLength);
+		record.Logger[nameLength] = 0;
+
+		size_t length = msg.payload.size();
+		if (length > LogRecord::MaxText)
+		{
+			// cut on a UTF-8 character boundary
+			length = LogRecord::MaxText;
+			while (length > 0 && ((uint8_t)msg.payload.data()[length] & 0xc0) == 0x80)
+				length--;
+		}
+		memcpy(record.Text, msg.payload.data(), length);
+		record.TextLength = (uint16_t)length;
+
+		slot.Sequence.store(2 * index + 2, std::memory_order_release);
+	}
+
+	uint32_t LogRingSink::Read(LogRecord* out, uint32_t maxCount)
+	{
+		const uint64_t write = m_Write.load(std::memory_order_acquire);
+		const uint64_t capacity = (uint64_t)m_Mask + 1;
+		if (write - m_Read > capacity)
+		{
+			m_Lost.fetch_add(write - capacity - m_Read, std::memory_order_relaxed);
+			m_Read = write - capacity;
+		}
+
+		uint32_t count = 0;
+		while (m_Read < write && count < maxCount)
+		{
+			const Slot& slot = m_Slots[m_Read & m_Mask];
+			const uint64_t expected = 2 * m_Read + 2;
+			const uint64_t seq = slot.Sequence.load(std::memory_order_acquire);
+			if (seq < expected)
+			{
+				// claimed but not published yet. Give the writer until the next call; a slot still
+				// unpublished by then belongs to a writer that gave up
+				if (m_Read != m_StalledIndex)
+				{
+					m_StalledIndex = m_Read;
+					break;
+				}
+				m_Lost.fetch_add(1, std::memory_order_relaxed);
+				m_Read++;
+				continue;
+			}
+
+			if (seq == expected)
+			{
+				LogRecord& record = out[count];
+				memcpy(&record, &slot.Record, offsetof(LogRecord, Text));
+				const uint32_t length = record.TextLength <= LogRecord::MaxText ? record.TextLength : LogRecord::MaxText;
+				memcpy(record.Text, slot.Record.Text, length);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				// a writer from the next lap may have started on the slot while it was copied
+				if (slot.Sequence.load(std::memory_order_relaxed) == expected)
+				{
+					record.TextLength = (uint16_t)length;
+					count++;
+				}
+				else
+					m_Lost.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+				m_Lost.fetch_add(1, std::memory_order_relaxed);
+			m_Read++;
+		}
+		return count;
+	}
+
+}
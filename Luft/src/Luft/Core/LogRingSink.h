@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "Luft/Core/Base.h"
+#include "spdlog/sinks/sink.h"
+
+namespace Luft {
+
+	// one message as the console sees it, text is the unformatted payload cut to MaxText bytes
+	struct LogRecord
+	{
+		static constexpr uint32_t MaxText = 232;
+		static constexpr uint32_t MaxLogger = 15;
+
+		// nanoseconds since the epoch
+		int64_t Time;
+		uint16_t TextLength;
+		uint8_t Level;
+		char Logger[MaxLogger + 1];
+		char Text[MaxText];
+	};
+
+	// spdlog sink keeping the last Capacity messages in a fixed ring, for the in-editor console.
+	// Any number of threads may log into it without taking a lock: a writer claims a slot with one
+	// fetch_add and publishes it through the slot's sequence number. A single reader polls from its
+	// own cursor; messages the writers lapped before it got to them are counted as lost.
+	class LUFT_API LogRingSink : public spdlog::sinks::sink
+	{
+	public:
+		// rounded up to a power of two
+		explicit LogRingSink(uint32_t capacity);
+		~LogRingSink();
+
+		virtual void log(const spdlog::details::log_msg& msg) override;
+		virtual void flush() override {}
+		// the console formats records itself
+		virtual void set_pattern(const std::string&) override {}
+		virtual void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+
+		// copies up to maxCount published records after the reader cursor into out and advances
+		// it. Stops at a slot that is still being written, so order is kept
+		uint32_t Read(LogRecord* out, uint32_t maxCount);
+		// records overwritten before Read got to them or dropped by their writer
+		uint64_t GetLostCount() const { return m_Lost.load(std::memory_order_relaxed); }
+		uint32_t GetCapacity() const { return m_Mask + 1; }
+
+	private:
+		struct Slot
+		{
+			// 2 * index + 1 while written, 2 * index + 2 once published, 0 never used
+			std::atomic<uint64_t> Sequence{ 0 };
+			LogRecord Record;
+		};
+
+		Slot* m_Slots = nullptr;
+		uint32_t m_Mask = 0;
+		alignas(64) std::atomic<uint64_t> m_Write{ 0 };
+		alignas(64) uint64_t m_Read = 0;
+		// the unpublished slot the last Read stopped at
+		uint64_t m_StalledIndex = UINT64_MAX;
+		std::atomic<uint64_t> m_Lost{ 0 };
+	};
+
+}
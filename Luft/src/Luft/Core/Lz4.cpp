@@ -0,0 +1,191 @@
+#include "Lz4.h"
+
+#include <string.h>
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr uint32_t HashBits = 14;
+		constexpr size_t MinMatch = 4;
+		// the format ends on at least this many literals, and no match starts in the last MatchLimit bytes
+		constexpr size_t LastLiterals = 5;
+		constexpr size_t MatchLimit = 12;
+		constexpr size_t MaxOffset = 65535;
+
+		uint32_t Read32(const uint8_t* p)
+		{
+			uint32_t v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		uint32_t Hash(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HashBits);
+		}
+
+		// a length past the token's 4 bits, as 255s and a remainder
+		void WriteLength(uint8_t*& op, size_t length)
+		{
+			for (; length >= 255; length -= 255)
+				*op++ = 255;
+			*op++ = (uint8_t)length;
+		}
+
+		bool ReadLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+		{
+			uint8_t b;
+			do
+			{
+				if (ip == end)
+					return false;
+				b = *ip++;
+				length += b;
+			} while (b == 255);
+			return true;
+		}
+
+		// literals, then a match unless matchLength is 0
+		bool WriteSequence(uint8_t*& op, const uint8_t* end, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+		{
+			const size_t needed = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+			if ((size_t)(end - op) < needed)
+				return false;
+
+			uint8_t* token = op++;
+			*token = (uint8_t)((literalCount < 15 ? literalCount : 15) << 4);
+			if (literalCount >= 15)
+				WriteLength(op, literalCount - 15);
+			memcpy(op, literals, literalCount);
+			op += literalCount;
+			if (matchLength == 0)
+				return true;
+
+			*op++ = (uint8_t)offset;
+			*op++ = (uint8_t)(offset >> 8);
+			const size_t extra = matchLength - MinMatch;
+			*token |= (uint8_t)(extra < 15 ? extra : 15);
+			if (extra >= 15)
+				WriteLength(op, extra - 15);
+			return true;
+		}
+	}
+
+	size_t Lz4::Compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity)
+	{
+		uint8_t* op = dst;
+		const uint8_t* const end = dst + capacity;
+		size_t anchor = 0;
+
+		if (size > MatchLimit)
+		{
+			// positions + 1, 0 is empty
+			uint32_t table[1u << HashBits] = {};
+			const size_t matchStartLimit = size - MatchLimit;
+			const size_t matchEndLimit = size - LastLiterals;
+			size_t ip = 0;
+			while (ip < matchStartLimit)
+			{
+				const uint32_t sequence = Read32(src + ip);
+				uint32_t& slot = table[Hash(sequence)];
+				const size_t candidate = slot;
+				slot = (uint32_t)(ip + 1);
+				if (candidate == 0 || ip - (candidate - 1) > MaxOffset || Read32(src + candidate - 1) != sequence)
+				{
+					// steps grow through data that doesn't compress
+					ip += 1 + ((ip - anchor) >> 6);
+					continue;
+				}
+
+				size_t match = candidate - 1;
+				// back over literals that match too
+				while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1])
+				{
+					ip--;
+					match--;
+				}
+				size_t length = MinMatch;
+				while (ip + length < matchEndLimit && src[match + length] == src[ip + length])
+					length++;
+
+				if (!WriteSequence(op, end, src + anchor, ip - anchor, ip - match, length))
+					return 0;
+				ip += length;
+				anchor = ip;
+			}
+		}
+
+		if (!WriteSequence(op, end, src + anchor, size - anchor, 0, 0))
+			return 0;
+		return (size_t)(op - dst);
+	}
+
+	bool Lz4::Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+	{
+		const uint8_t* ip = src;
+		const uint8_t* const inEnd = src + srcSize;
+		uint8_t* op = dst;
+		uint8_t* const outEnd = dst + dstSize;
+
+		for (;;)
+		{
+			if (ip == inEnd)
+				return false;
+			const uint8_t token = *ip++;
+
+			size_t literals = token >> 4;
+			if (literals == 15 && !ReadLength(ip, inEnd, literals))
+				return false;
+			if (literals > (size_t)(inEnd - ip) || literals > (size_t)(outEnd - op))
+				return false;
+			// short runs as one fixed size copy when there's room to overshoot, what follows
+			// overwrites the excess
+			if (literals <= 16 && inEnd - ip >= 16 && outEnd - op >= 16)
+				memcpy(op, ip, 16);
+			else
+				memcpy(op, ip, literals);
+			ip += literals;
+			op += literals;
+			// the last sequence has no match
+			if (ip == inEnd)
+				return op == outEnd;
+
+			if (inEnd - ip < 2)
+				return false;
+			const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > (size_t)(op - dst))
+				return false;
+
+			size_t length = token & 15;
+			if (length == 15 && !ReadLength(ip, inEnd, length))
+				return false;
+			length += MinMatch;
+			if (length > (size_t)(outEnd - op))
+				return false;
+
+			const uint8_t* match = op - offset;
+			if (offset >= 8 && (size_t)(outEnd - op) >= length + 8)
+			{
+				// 8 bytes at a time, each chunk reads bytes written before it
+				uint8_t* const end = op + length;
+				for (uint8_t* to = op; to < end; to += 8, match += 8)
+					memcpy(to, match, 8);
+				op = end;
+			}
+			else if (offset >= length)
+			{
+				memcpy(op, match, length);
+				op += length;
+			}
+			else
+			{
+				// overlapping, the match repeats what it's writing
+				for (size_t i = 0; i < length; i++)
+					*op++ = match[i];
+			}
+		}
+	}
+
+}
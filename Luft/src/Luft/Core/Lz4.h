@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Luft/Core/Base.h"
+
+namespace Luft {
+
+	// Blocks in the LZ4 block format: a byte oriented LZ77 whose decoder is little more than two
+	// copies per sequence, a few GB/s on one core. The encoder is a greedy single probe one, close
+	// to the reference's fast mode in ratio. No frame format, the caller keeps both sizes.
+	class LUFT_API Lz4
+	{
+	public:
+		// the most Compress can write for size input bytes
+		static size_t GetBound(size_t size) { return size + size / 255 + 16; }
+		// the compressed size, 0 when it doesn't fit in capacity
+		static size_t Compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity);
+		// false unless src decodes to exactly dstSize bytes without reading or writing outside
+		static bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+	};
+
+}
@@ -0,0 +1,107 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef LUFT_PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Luft {
+
+	bool MappedFile::Open(const lstr& path)
+	{
+		Close();
+
+#ifdef LUFT_PLATFORM_WINDOWS
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_File = file;
+		m_Size = (size_t)size.QuadPart;
+		m_Open = true;
+		if (m_Size == 0)
+			return true;
+
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping)
+		{
+			Close();
+			return false;
+		}
+		m_Mapping = mapping;
+		m_Data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		m_Size = (size_t)st.st_size;
+		m_Open = true;
+		if (m_Size > 0)
+		{
+			void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+			m_Data = data == MAP_FAILED ? nullptr : (const uint8_t*)data;
+		}
+		// the mapping keeps the file referenced
+		close(fd);
+#endif
+
+		if (m_Size > 0 && !m_Data)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef LUFT_PLATFORM_WINDOWS
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle((HANDLE)m_Mapping);
+		if (m_File)
+			CloseHandle((HANDLE)m_File);
+		m_File = m_Mapping = nullptr;
+#else
+		if (m_Data)
+			munmap((void*)m_Data, m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Open = false;
+	}
+
+	void MappedFile::Swap(MappedFile& o)
+	{
+		std::swap(m_Data, o.m_Data);
+		std::swap(m_Size, o.m_Size);
+		std::swap(m_Open, o.m_Open);
+#ifdef LUFT_PLATFORM_WINDOWS
+		std::swap(m_File, o.m_File);
+		std::swap(m_Mapping, o.m_Mapping);
+#endif
+	}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/lstr.h"
+
+namespace Luft {
+
+	// Read-only view of a whole file through the OS page cache. Pages are faulted in as they're
+	// touched, so opening a large file costs nothing up front and several processes share it.
+	class LUFT_API MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& o) noexcept { Swap(o); }
+		MappedFile& operator=(MappedFile&& o) noexcept
+		{
+			Close();
+			Swap(o);
+			return *this;
+		}
+
+		// false if the file can't be opened. An empty file opens with Data() nullptr
+		bool Open(const lstr& path);
+		void Close();
+
+		bool IsOpen() const { return m_Open; }
+		const uint8_t* Data() const { return m_Data; }
+		size_t Size() const { return m_Size; }
+
+	private:
+		void Swap(MappedFile& o);
+
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+		bool m_Open = false;
+#ifdef LUFT_PLATFORM_WINDOWS
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+	};
+
+}
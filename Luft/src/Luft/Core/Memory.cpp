@@ -0,0 +1,231 @@
+#include "Memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+
+namespace Luft
+{
+	namespace
+	{
+		constexpr size_t TagCount = (size_t)MemoryTag::Count;
+
+		// sits immediately before every pointer we hand out
+		struct alignas(16) AllocHeader
+		{
+			uint64_t size;
+			// distance from the malloc'd block to the user pointer
+			uint32_t offset;
+			uint8_t tag;
+			uint8_t pad[3];
+		};
+		static_assert(sizeof(AllocHeader) == 16, "AllocHeader must stay 16 bytes");
+
+		// Counters are written only by their owning thread (relaxed load + store, no RMW), and read by
+		// anyone summing a snapshot. Frees are charged to the freeing thread, so a single thread's
+		// numbers can go negative but the sum over all threads is exact.
+		struct ThreadCounters
+		{
+			std::atomic<uint64_t> allocBytes[TagCount];
+			std::atomic<uint64_t> allocCount[TagCount];
+			std::atomic<uint64_t> freeBytes[TagCount];
+			std::atomic<uint64_t> freeCount[TagCount];
+			ThreadCounters* next;
+		};
+
+		std::atomic<ThreadCounters*> s_ThreadList{ nullptr };
+		thread_local ThreadCounters* t_Counters = nullptr;
+
+		ThreadCounters* GetThreadCounters()
+		{
+			ThreadCounters* c = t_Counters;
+			if (c)
+				return c;
+
+			// counters are never released, so totals stay correct after a thread exits. Allocated
+			// straight from the CRT so they don't show up in their own statistics
+			c = (ThreadCounters*)calloc(1, sizeof(ThreadCounters));
+			ThreadCounters* head = s_ThreadList.load(std::memory_order_relaxed);
+			do
+			{
+				c->next = head;
+			} while (!s_ThreadList.compare_exchange_weak(head, c, std::memory_order_release, std::memory_order_relaxed));
+
+			t_Counters = c;
+			return c;
+		}
+
+		inline void Bump(std::atomic<uint64_t>& counter, uint64_t v)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+		}
+
+		inline AllocHeader* GetHeader(void* p)
+		{
+			return (AllocHeader*)p - 1;
+		}
+
+		double Now()
+		{
+			using namespace std::chrono;
+			return duration<double>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		const char* s_TagNames[TagCount] = {
+			"Unknown",
+			"Array",
+			"String",
+			"Vulkan",
+			"ImGui",
+			"Pool",
+			"Profiler",
+			"Log",
+		};
+	}
+
+	MemorySnapshot Memory::s_FrameSnapshot;
+	MemorySnapshot Memory::s_PrevFrameSnapshot;
+	MemorySnapshot Memory::s_RateWindowStart;
+	int64_t Memory::s_PeakBytes[TagCount] = {};
+	double Memory::s_AllocRate[TagCount] = {};
+
+	MemorySnapshot MemorySnapshot::Diff(const MemorySnapshot& base) const
+	{
+		MemorySnapshot ret;
+		ret.Time = Time - base.Time;
+		for (size_t i = 0; i < TagCount; i++)
+		{
+			ret.Tags[i].LiveBytes = Tags[i].LiveBytes - base.Tags[i].LiveBytes;
+			ret.Tags[i].LiveCount = Tags[i].LiveCount - base.Tags[i].LiveCount;
+			ret.Tags[i].TotalAllocBytes = Tags[i].TotalAllocBytes - base.Tags[i].TotalAllocBytes;
+			ret.Tags[i].TotalAllocCount = Tags[i].TotalAllocCount - base.Tags[i].TotalAllocCount;
+		}
+		return ret;
+	}
+
+	void* Memory::Allocate(size_t size, MemoryTag tag, size_t alignment)
+	{
+		if (alignment < DefaultAlignment)
+			alignment = DefaultAlignment;
+
+		// room for the header plus enough slack to align the user pointer
+		const size_t total = size + sizeof(AllocHeader) + (alignment - DefaultAlignment);
+		char* raw = (char*)malloc(total);
+		if (raw == NULL)
+			return NULL;
+
+		uintptr_t user = (uintptr_t)(raw + sizeof(AllocHeader));
+		user = (user + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+		AllocHeader* header = GetHeader((void*)user);
+		header->size = size;
+		header->offset = (uint32_t)(user - (uintptr_t)raw);
+		header->tag = (uint8_t)tag;
+
+		ThreadCounters* c = GetThreadCounters();
+		Bump(c->allocBytes[(size_t)tag], size);
+		Bump(c->allocCount[(size_t)tag], 1);
+
+		return (void*)user;
+	}
+
+	void* Memory::Reallocate(void* p, size_t size, MemoryTag tag, size_t alignment)
+	{
+		if (p == NULL)
+			return Allocate(size, tag, alignment);
+
+		if (size == 0)
+		{
+			Free(p);
+			return NULL;
+		}
+
+		const size_t oldSize = (size_t)GetHeader(p)->size;
+
+		void* ret = Allocate(size, tag, alignment);
+		if (ret == NULL)
+			return NULL;
+
+		memcpy(ret, p, oldSize < size ? oldSize : size);
+		Free(p);
+		return ret;
+	}
+
+	void Memory::Free(void* p)
+	{
+		if (p == NULL)
+			return;
+
+		AllocHeader* header = GetHeader(p);
+		const size_t tag = header->tag < TagCount ? header->tag : (size_t)MemoryTag::Unknown;
+
+		ThreadCounters* c = GetThreadCounters();
+		Bump(c->freeBytes[tag], header->size);
+		Bump(c->freeCount[tag], 1);
+
+		free((char*)p - header->offset);
+	}
+
+	const char* Memory::GetTagName(MemoryTag tag)
+	{
+		if ((size_t)tag >= TagCount)
+			return "Invalid";
+		return s_TagNames[(size_t)tag];
+	}
+
+	MemorySnapshot Memory::TakeSnapshot()
+	{
+		MemorySnapshot ret;
+		ret.Time = Now();
+
+		for (ThreadCounters* c = s_ThreadList.load(std::memory_order_acquire); c; c = c->next)
+		{
+			for (size_t i = 0; i < TagCount; i++)
+			{
+				const uint64_t ab = c->allocBytes[i].load(std::memory_order_relaxed);
+				const uint64_t ac = c->allocCount[i].load(std::memory_order_relaxed);
+				const uint64_t fb = c->freeBytes[i].load(std::memory_order_relaxed);
+				const uint64_t fc = c->freeCount[i].load(std::memory_order_relaxed);
+
+				ret.Tags[i].TotalAllocBytes += ab;
+				ret.Tags[i].TotalAllocCount += ac;
+				ret.Tags[i].LiveBytes += (int64_t)(ab - fb);
+				ret.Tags[i].LiveCount += (int64_t)(ac - fc);
+			}
+		}
+
+		return ret;
+	}
+
+	void Memory::NewFrame()
+	{
+		// window the rate is averaged over, in seconds
+		const double rateWindow = 0.5;
+
+		s_PrevFrameSnapshot = s_FrameSnapshot;
+		s_FrameSnapshot = TakeSnapshot();
+
+		for (size_t i = 0; i < TagCount; i++)
+		{
+			if (s_FrameSnapshot.Tags[i].LiveBytes > s_PeakBytes[i])
+				s_PeakBytes[i] = s_FrameSnapshot.Tags[i].LiveBytes;
+		}
+
+		if (s_RateWindowStart.Time == 0.0)
+		{
+			s_RateWindowStart = s_FrameSnapshot;
+			return;
+		}
+
+		const double elapsed = s_FrameSnapshot.Time - s_RateWindowStart.Time;
+		if (elapsed < rateWindow)
+			return;
+
+		MemorySnapshot delta = s_FrameSnapshot.Diff(s_RateWindowStart);
+		for (size_t i = 0; i < TagCount; i++)
+			s_AllocRate[i] = (double)delta.Tags[i].TotalAllocBytes / elapsed;
+
+		s_RateWindowStart = s_FrameSnapshot;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Base.h"
+
+namespace Luft
+{
+	// subsystem a tracked allocation is charged to
+	enum class MemoryTag : uint8_t
+	{
+		Unknown = 0,
+		Array,
+		String,
+		Vulkan,
+		ImGui,
+		Pool,
+		Profiler,
+		Log,
+		Count
+	};
+
+	struct MemoryTagStats
+	{
+		int64_t LiveBytes = 0;
+		int64_t LiveCount = 0;
+		// monotonic totals since startup, used to derive the allocation rate
+		uint64_t TotalAllocBytes = 0;
+		uint64_t TotalAllocCount = 0;
+	};
+
+	struct MemorySnapshot
+	{
+		double Time = 0.0;
+		MemoryTagStats Tags[(size_t)MemoryTag::Count];
+
+		const MemoryTagStats& operator[](MemoryTag tag) const { return Tags[(size_t)tag]; }
+		// per-tag difference (this - base), i.e. growth since the base snapshot
+		MemorySnapshot Diff(const MemorySnapshot& base) const;
+	};
+
+	// Tracking heap. Every allocation carries a small header with its size and tag, and the
+	// counters are kept per thread so the hot path never touches a shared cache line.
+	class LUFT_API Memory
+	{
+	public:
+		static constexpr size_t DefaultAlignment = 16;
+
+		// returns NULL on failure, like malloc
+		static void* Allocate(size_t size, MemoryTag tag, size_t alignment = DefaultAlignment);
+		// realloc semantics: NULL p allocates, size 0 frees and returns NULL
+		static void* Reallocate(void* p, size_t size, MemoryTag tag, size_t alignment = DefaultAlignment);
+		// NULL is a no-op
+		static void Free(void* p);
+
+		static const char* GetTagName(MemoryTag tag);
+
+		// sums the per-thread counters. Safe to call from any thread at any time, the result is
+		// only approximate while other threads are allocating
+		static MemorySnapshot TakeSnapshot();
+
+		// call once per frame: samples the counters and updates peak and allocation rate
+		static void NewFrame();
+		static const MemorySnapshot& GetFrameSnapshot() { return s_FrameSnapshot; }
+		static const MemorySnapshot& GetPreviousFrameSnapshot() { return s_PrevFrameSnapshot; }
+		static int64_t GetPeakBytes(MemoryTag tag) { return s_PeakBytes[(size_t)tag]; }
+		// bytes allocated per second, averaged over a short window
+		static double GetAllocRate(MemoryTag tag) { return s_AllocRate[(size_t)tag]; }
+
+	private:
+		static MemorySnapshot s_FrameSnapshot;
+		static MemorySnapshot s_PrevFrameSnapshot;
+		static MemorySnapshot s_RateWindowStart;
+		static int64_t s_PeakBytes[(size_t)MemoryTag::Count];
+		static double s_AllocRate[(size_t)MemoryTag::Count];
+	};
+}
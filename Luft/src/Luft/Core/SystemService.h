@@ -1,11 +1,13 @@
-#include "EnumDefs.h"
+#pragma once
+#include "KeyTable.h"
+#include "Localization.h"
 
 namespace Luft
 {
 	//locatization
-	std::optional<char const*> GetTextVal(TextKey);
+	inline const char* GetTextVal(TextKey key) { return Localization::Get(key); }
 	//resource
-	std::optional<char const*> GetResVal(ResKey);
+	inline const char* GetResVal(ResKey key) { return KeyTable::GetRes(key); }
 	//
-	std::optional<int> GetIntVal(IntKey);
-}
\ No newline at end of file
+	inline int GetIntVal(IntKey key) { return KeyTable::GetInt(key); }
+}
@@ -0,0 +1,751 @@
+#include "VirtualFileSystem.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include "Luft/Core/KeyValueFile.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/Lz4.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	namespace
+	{
+		constexpr char PackMagic[8] = { 'L', 'P', 'A', 'K', '1', 0, 0, 0 };
+		constexpr uint64_t Alignment = 4096;
+		// of the uncompressed data, the unit the worker threads decompress
+		constexpr uint32_t BlockSize = 256 * 1024;
+		// set in a block's stored size when the block didn't compress and is kept as is
+		constexpr uint32_t RawBlock = 0x80000000u;
+
+		enum class Codec : uint32_t
+		{
+			Stored,
+			// a uint32 stored size per block, then the blocks
+			Lz4Blocks,
+		};
+
+		// followed by the entries, sorted by name, and the names. Entries' data from DataOffset on
+		struct PackHeader
+		{
+			char Magic[8];
+			uint32_t EntryCount;
+			uint32_t NameBytes;
+			uint64_t DataOffset;
+		};
+
+		struct PackEntry
+		{
+			uint32_t NameOffset;
+			uint32_t NameLength;
+			Codec Compression;
+			uint32_t BlockCount;
+			// a multiple of Alignment
+			uint64_t Offset;
+			uint64_t StoredSize;
+			uint64_t Size;
+		};
+
+		struct Block
+		{
+			const uint8_t* Src;
+			uint32_t StoredSize;
+			uint8_t* Dst;
+			uint32_t Size;
+			// which of OpenAll's files, written by the thread that decoded it
+			uint32_t File;
+			bool Ok;
+		};
+
+		uint64_t AlignUp(uint64_t value) { return (value + Alignment - 1) & ~(Alignment - 1); }
+		uint32_t GetBlockCount(uint64_t size) { return (uint32_t)((size + BlockSize - 1) / BlockSize); }
+
+		int CompareName(const char* name, uint32_t length, const char* key, size_t keyLength)
+		{
+			const int c = memcmp(name, key, length < keyLength ? length : keyLength);
+			if (c != 0)
+				return c;
+			return length < keyLength ? -1 : (length > keyLength ? 1 : 0);
+		}
+
+		// path below the mount point, null when it isn't. An empty mount point holds every path
+		const char* GetRelative(const lstr& mountPoint, const lstr& path)
+		{
+			const size_t prefix = mountPoint.size();
+			if (prefix == 0)
+				return path.c_str();
+			if (path.size() <= prefix || memcmp(path.c_str(), mountPoint.c_str(), prefix) != 0 || path[prefix] != '/')
+				return nullptr;
+			return path.c_str() + prefix + 1;
+		}
+
+		// Threads ParallelFor shares its indices with, started by the first call that has more than
+		// one and kept until exit, so opening files doesn't start threads. One call at a time uses
+		// them, another one meanwhile works through its indices alone
+		class WorkerPool
+		{
+		public:
+			~WorkerPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					m_Stop = true;
+				}
+				m_Wake.notify_all();
+				for (std::thread* worker : m_Workers)
+				{
+					worker->join();
+					delete worker;
+				}
+			}
+
+			void Run(size_t count, const std::function<void(size_t)>& fn)
+			{
+				std::unique_lock<std::mutex> run(m_RunMutex, std::try_to_lock);
+				if (run.owns_lock())
+					Start((uint32_t)std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency())) - 1);
+				if (!run.owns_lock() || m_Workers.empty())
+				{
+					for (size_t i = 0; i < count; i++)
+						fn(i);
+					return;
+				}
+
+				m_Next.store(0, std::memory_order_relaxed);
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					m_Fn = &fn;
+					m_Count = count;
+					m_Job++;
+				}
+				m_Wake.notify_all();
+				Work(fn, count);
+
+				// workers that haven't picked the job up by now don't get it
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Fn = nullptr;
+				m_Done.wait(lock, [this]() { return m_Working == 0; });
+			}
+
+		private:
+			void Work(const std::function<void(size_t)>& fn, size_t count)
+			{
+				for (size_t i = m_Next++; i < count; i = m_Next++)
+					fn(i);
+			}
+
+			// under m_RunMutex. A thread that can't be started leaves the pool with the ones that were
+			void Start(uint32_t workers)
+			{
+				while (m_Workers.size() < workers && !m_StartFailed)
+				{
+					try
+					{
+						m_Workers.push_back(new std::thread([this]() { WorkerMain(); }));
+					}
+					catch (const std::system_error& e)
+					{
+						CORE_LOG_WRAN("Can't start a file worker thread, going on with {0}: {1}", m_Workers.size(), e.what());
+						m_StartFailed = true;
+					}
+				}
+			}
+
+			void WorkerMain()
+			{
+				LUFT_PROFILE_THREAD("File Worker");
+				uint64_t seen = 0;
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				for (;;)
+				{
+					m_Wake.wait(lock, [&]() { return m_Stop || m_Job != seen; });
+					if (m_Stop)
+						return;
+					seen = m_Job;
+					if (!m_Fn)
+						continue;
+					const std::function<void(size_t)>& fn = *m_Fn;
+					const size_t count = m_Count;
+					m_Working++;
+					lock.unlock();
+					Work(fn, count);
+					lock.lock();
+					if (--m_Working == 0)
+						m_Done.notify_one();
+				}
+			}
+
+			std::mutex m_RunMutex;
+			larray<std::thread*> m_Workers;
+			bool m_StartFailed = false;
+
+			std::mutex m_Mutex;
+			std::condition_variable m_Wake;
+			std::condition_variable m_Done;
+			bool m_Stop = false;
+			uint64_t m_Job = 0;
+			const std::function<void(size_t)>* m_Fn = nullptr;
+			size_t m_Count = 0;
+			uint32_t m_Working = 0;
+			std::atomic<size_t> m_Next{ 0 };
+		};
+
+		// fn(index) for every index, spread over the worker pool when there's more than one
+		void ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+		{
+			static WorkerPool s_Pool;
+			if (count <= 1)
+			{
+				for (size_t i = 0; i < count; i++)
+					fn(i);
+				return;
+			}
+			s_Pool.Run(count, fn);
+		}
+
+		bool DecodeBlock(const Block& block)
+		{
+			if (block.StoredSize & RawBlock)
+			{
+				if ((block.StoredSize & ~RawBlock) != block.Size)
+					return false;
+				memcpy(block.Dst, block.Src, block.Size);
+				return true;
+			}
+			return Lz4::Decompress(block.Src, block.StoredSize, block.Dst, block.Size);
+		}
+	}
+
+	struct ResourcePack
+	{
+		MappedFile File;
+		lstr Path;
+		const PackEntry* Entries = nullptr;
+		uint32_t Count = 0;
+		const char* Names = nullptr;
+
+		bool Open(const lstr& path)
+		{
+			Path = path;
+			if (!File.Open(path))
+				return false;
+
+			const uint8_t* data = File.Data();
+			const size_t size = File.Size();
+			PackHeader header;
+			if (size < sizeof(header) || (memcpy(&header, data, sizeof(header)), memcmp(header.Magic, PackMagic, sizeof(PackMagic)) != 0))
+			{
+				CORE_LOG_ERROR("{0} is not a resource pack", path.c_str());
+				return false;
+			}
+			const uint64_t namesAt = sizeof(PackHeader) + (uint64_t)header.EntryCount * sizeof(PackEntry);
+			if (namesAt + header.NameBytes > header.DataOffset || header.DataOffset > size)
+			{
+				CORE_LOG_ERROR("{0} is truncated", path.c_str());
+				return false;
+			}
+
+			Entries = (const PackEntry*)(data + sizeof(PackHeader));
+			Count = header.EntryCount;
+			Names = (const char*)(data + namesAt);
+			for (uint32_t i = 0; i < Count; i++)
+			{
+				const PackEntry& entry = Entries[i];
+				const bool inside = (uint64_t)entry.NameOffset + entry.NameLength <= header.NameBytes
+					&& entry.Offset >= header.DataOffset && entry.Offset <= size && entry.StoredSize <= size - entry.Offset;
+				const bool sorted = i == 0 || CompareName(Names + Entries[i - 1].NameOffset, Entries[i - 1].NameLength, Names + entry.NameOffset, entry.NameLength) < 0;
+				const bool coded = entry.Compression == Codec::Stored ? entry.StoredSize == entry.Size
+					: entry.Compression == Codec::Lz4Blocks && entry.BlockCount == GetBlockCount(entry.Size) && entry.StoredSize >= 4ull * entry.BlockCount;
+				if (!inside || !sorted || !coded)
+				{
+					CORE_LOG_ERROR("{0} is corrupt", path.c_str());
+					return false;
+				}
+			}
+			return true;
+		}
+
+		const PackEntry* Find(const char* name, size_t length) const
+		{
+			uint32_t first = 0;
+			uint32_t last = Count;
+			while (first < last)
+			{
+				const uint32_t mid = first + (last - first) / 2;
+				const int c = CompareName(Names + Entries[mid].NameOffset, Entries[mid].NameLength, name, length);
+				if (c == 0)
+					return &Entries[mid];
+				if (c < 0)
+					first = mid + 1;
+				else
+					last = mid;
+			}
+			return nullptr;
+		}
+	};
+
+	std::mutex VirtualFileSystem::s_Mutex;
+	larray<VirtualFileSystem::MountPoint*> VirtualFileSystem::s_Mounts;
+	std::atomic<uint32_t> VirtualFileSystem::s_Generation{ 0 };
+
+	void VirtualFile::Adopt(larray<uint8_t>& bytes)
+	{
+		Close();
+		m_Bytes.swap(bytes);
+		m_Data = m_Bytes.data();
+		m_Size = m_Bytes.size();
+		m_Open = true;
+	}
+
+	void VirtualFile::Close()
+	{
+		m_File.Close();
+		m_Pack.reset();
+		m_Bytes.clear();
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Open = false;
+	}
+
+	void VirtualFile::Swap(VirtualFile& o)
+	{
+		std::swap(m_Data, o.m_Data);
+		std::swap(m_Size, o.m_Size);
+		std::swap(m_Open, o.m_Open);
+		std::swap(m_File, o.m_File);
+		m_Pack.swap(o.m_Pack);
+		m_Bytes.swap(o.m_Bytes);
+	}
+
+	bool VirtualFileSystem::Mount(const lstr& mountPoint, const lstr& path)
+	{
+		std::error_code ec;
+		MountPoint* mount = new MountPoint();
+		mount->Prefix = mountPoint;
+		mount->Path = path;
+		if (!std::filesystem::is_directory(path.c_str(), ec))
+		{
+			if (!std::filesystem::is_regular_file(path.c_str(), ec))
+			{
+				CORE_LOG_INFO("Nothing to mount at {0}", path.c_str());
+				delete mount;
+				return false;
+			}
+			mount->Pack = CreateRef<ResourcePack>();
+			if (!mount->Pack->Open(path))
+			{
+				delete mount;
+				return false;
+			}
+			CORE_LOG_INFO("Mounted {0} ({1} files) at '{2}'", path.c_str(), mount->Pack->Count, mountPoint.c_str());
+		}
+
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_Mounts.push_back(mount);
+		s_Generation++;
+		return true;
+	}
+
+	void VirtualFileSystem::Unmount(const lstr& mountPoint)
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		larray<MountPoint*> kept;
+		for (MountPoint* mount : s_Mounts)
+		{
+			if (mount->Prefix == mountPoint)
+				delete mount;
+			else
+				kept.push_back(mount);
+		}
+		s_Mounts.swap(kept);
+		s_Generation++;
+	}
+
+	void VirtualFileSystem::UnmountAll()
+	{
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		for (MountPoint* mount : s_Mounts)
+			delete mount;
+		s_Mounts.clear();
+		s_Generation++;
+	}
+
+	bool VirtualFileSystem::Remount(const lstr& packPath)
+	{
+		Ref<ResourcePack> pack = CreateRef<ResourcePack>();
+		if (!pack->Open(packPath))
+			return false;
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		bool found = false;
+		for (MountPoint* mount : s_Mounts)
+		{
+			if (mount->Pack && mount->Path == packPath)
+			{
+				mount->Pack = pack;
+				found = true;
+			}
+		}
+		if (!found)
+			return false;
+		s_Generation++;
+		CORE_LOG_INFO("Remounted {0} ({1} files)", packPath.c_str(), pack->Count);
+		return true;
+	}
+
+	bool VirtualFileSystem::Exists(const lstr& path)
+	{
+		VirtualFileLocation location;
+		return Locate(path, location);
+	}
+
+	bool VirtualFileSystem::Locate(const lstr& path, VirtualFileLocation& out)
+	{
+		std::error_code ec;
+		{
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			for (size_t i = s_Mounts.size(); i > 0; i--)
+			{
+				const MountPoint& mount = *s_Mounts[i - 1];
+				const char* relative = GetRelative(mount.Prefix, path);
+				if (!relative)
+					continue;
+				if (mount.Pack)
+				{
+					const PackEntry* entry = mount.Pack->Find(relative, strlen(relative));
+					if (!entry)
+						continue;
+					out.FilePath = mount.Path;
+					out.Offset = entry->Offset;
+					out.StoredSize = entry->StoredSize;
+					out.Size = entry->Size;
+					out.Compressed = entry->Compression != Codec::Stored;
+					return true;
+				}
+				const lstr file = mount.Path + "/" + relative;
+				const uintmax_t size = std::filesystem::file_size(file.c_str(), ec);
+				if (!ec && std::filesystem::is_regular_file(file.c_str(), ec))
+				{
+					out.FilePath = file;
+					out.Offset = 0;
+					out.StoredSize = out.Size = size;
+					out.Compressed = false;
+					return true;
+				}
+			}
+		}
+		const uintmax_t size = std::filesystem::file_size(path.c_str(), ec);
+		if (ec || !std::filesystem::is_regular_file(path.c_str(), ec))
+			return false;
+		out.FilePath = path;
+		out.Offset = 0;
+		out.StoredSize = out.Size = size;
+		out.Compressed = false;
+		return true;
+	}
+
+	bool VirtualFileSystem::Decode(const VirtualFileLocation& location, larray<uint8_t>& bytes)
+	{
+		if (bytes.size() != location.StoredSize)
+			return false;
+		if (!location.Compressed)
+			return true;
+
+		const uint32_t blockCount = GetBlockCount(location.Size);
+		if (bytes.size() < 4ull * blockCount)
+			return false;
+		larray<uint8_t> out;
+		out.resize((size_t)location.Size);
+		const uint8_t* src = bytes.data() + 4ull * blockCount;
+		const uint8_t* const srcEnd = bytes.data() + bytes.size();
+		for (uint32_t b = 0; b < blockCount; b++)
+		{
+			uint32_t storedSize;
+			memcpy(&storedSize, bytes.data() + 4ull * b, 4);
+			const uint64_t at = (uint64_t)b * BlockSize;
+			const Block block = { src, storedSize, out.data() + at, (uint32_t)std::min<uint64_t>(BlockSize, location.Size - at), 0, false };
+			if ((storedSize & ~RawBlock) > (size_t)(srcEnd - src) || !DecodeBlock(block))
+				return false;
+			src += storedSize & ~RawBlock;
+		}
+		bytes.swap(out);
+		return true;
+	}
+
+	bool VirtualFileSystem::Open(const lstr& path, VirtualFile& out)
+	{
+		return OpenAll(&path, 1, &out);
+	}
+
+	bool VirtualFileSystem::OpenAll(const lstr* paths, size_t count, VirtualFile* out)
+	{
+		LUFT_PROFILE_FUNCTION();
+		larray<Block> blocks;
+		bool opened = true;
+
+		for (size_t f = 0; f < count; f++)
+		{
+			const lstr& path = paths[f];
+			VirtualFile& file = out[f];
+			file.Close();
+
+			Ref<ResourcePack> pack;
+			const PackEntry* entry = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(s_Mutex);
+				for (size_t i = s_Mounts.size(); i > 0 && !file.m_Open && !entry; i--)
+				{
+					const MountPoint& mount = *s_Mounts[i - 1];
+					const char* relative = GetRelative(mount.Prefix, path);
+					if (!relative)
+						continue;
+					if (mount.Pack)
+					{
+						entry = mount.Pack->Find(relative, strlen(relative));
+						if (entry)
+							pack = mount.Pack;
+					}
+					else if (file.m_File.Open(mount.Path + "/" + relative))
+					{
+						file.m_Open = true;
+					}
+				}
+			}
+
+			if (!file.m_Open && !entry && !file.m_File.Open(path))
+			{
+				CORE_LOG_ERROR("Can't open {0}", path.c_str());
+				opened = false;
+				continue;
+			}
+			if (!entry)
+			{
+				file.m_Data = file.m_File.Data();
+				file.m_Size = file.m_File.Size();
+				file.m_Open = true;
+				continue;
+			}
+
+			const uint8_t* stored = pack->File.Data() + entry->Offset;
+			if (entry->Compression == Codec::Stored)
+			{
+				file.m_Pack = pack;
+				file.m_Data = stored;
+				file.m_Size = (size_t)entry->Size;
+				file.m_Open = true;
+				continue;
+			}
+
+			// the block table, then blocks that decode BlockSize bytes each but the last
+			const uint32_t* storedSizes = (const uint32_t*)stored;
+			const uint8_t* src = stored + 4ull * entry->BlockCount;
+			const uint8_t* const srcEnd = stored + entry->StoredSize;
+			file.m_Bytes.resize((size_t)entry->Size);
+			const size_t firstBlock = blocks.size();
+			bool valid = true;
+			for (uint32_t b = 0; b < entry->BlockCount && valid; b++)
+			{
+				const uint32_t storedSize = storedSizes[b] & ~RawBlock;
+				const uint64_t at = (uint64_t)b * BlockSize;
+				valid = storedSize <= (size_t)(srcEnd - src);
+				blocks.push_back({ src, storedSizes[b], file.m_Bytes.data() + at, (uint32_t)std::min<uint64_t>(BlockSize, entry->Size - at), (uint32_t)f, false });
+				src += storedSize;
+			}
+			if (!valid)
+			{
+				CORE_LOG_ERROR("{0} is corrupt in {1}", path.c_str(), pack->Path.c_str());
+				blocks.resize(firstBlock);
+				file.Close();
+				opened = false;
+				continue;
+			}
+			file.m_Data = file.m_Bytes.data();
+			file.m_Size = file.m_Bytes.size();
+			file.m_Open = true;
+		}
+
+		if (blocks.empty())
+			return opened;
+
+		LUFT_PROFILE_SCOPE("Decompress");
+		ParallelFor(blocks.size(), [&](size_t i) { blocks[i].Ok = DecodeBlock(blocks[i]); });
+		for (const Block& block : blocks)
+		{
+			VirtualFile& file = out[block.File];
+			if (!block.Ok && file.m_Open)
+			{
+				CORE_LOG_ERROR("{0} doesn't decompress", paths[block.File].c_str());
+				file.Close();
+				opened = false;
+			}
+		}
+		return opened;
+	}
+
+	bool VirtualFileSystem::BuildPack(const lstr& dir, const lstr& packPath, bool compress)
+	{
+		const uint64_t start = Profiler::Now();
+
+		struct Source
+		{
+			lstr Name;
+			MappedFile File;
+			larray<uint8_t> Compressed;
+			Codec Compression = Codec::Stored;
+		};
+		larray<Source*> sources;
+		std::error_code ec;
+		const std::filesystem::path root(dir.c_str());
+		for (std::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec))
+		{
+			if (!it->is_regular_file(ec))
+				continue;
+			Source* source = new Source();
+			source->Name = it->path().lexically_relative(root).generic_string().c_str();
+			if (!source->File.Open(it->path().string().c_str()))
+			{
+				CORE_LOG_ERROR("Can't read {0}", it->path().string());
+				delete source;
+				continue;
+			}
+			sources.push_back(source);
+		}
+		if (ec)
+		{
+			CORE_LOG_ERROR("Can't list {0}: {1}", dir.c_str(), ec.message());
+			for (Source* source : sources)
+				delete source;
+			return false;
+		}
+		std::sort(sources.begin(), sources.end(), [](const Source* a, const Source* b) { return strcmp(a->Name.c_str(), b->Name.c_str()) < 0; });
+
+		if (compress)
+		{
+			// every block of every file at once, then each file decides whether it paid
+			struct Job
+			{
+				Source* Owner;
+				uint32_t Index;
+				larray<uint8_t> Out;
+			};
+			larray<Job*> jobs;
+			for (Source* source : sources)
+			{
+				for (uint32_t b = 0; b < GetBlockCount(source->File.Size()); b++)
+					jobs.push_back(new Job{ source, b, {} });
+			}
+			ParallelFor(jobs.size(), [&](size_t i) {
+				Job& job = *jobs[i];
+				const size_t at = (size_t)job.Index * BlockSize;
+				const size_t size = std::min<size_t>(BlockSize, job.Owner->File.Size() - at);
+				job.Out.resize(Lz4::GetBound(size));
+				const size_t packed = Lz4::Compress(job.Owner->File.Data() + at, size, job.Out.data(), job.Out.size());
+				if (packed == 0 || packed >= size)
+					job.Out.clear();
+				else
+					job.Out.resize(packed);
+			});
+
+			size_t j = 0;
+			for (Source* source : sources)
+			{
+				const uint32_t blockCount = GetBlockCount(source->File.Size());
+				larray<uint8_t> bytes;
+				bytes.resize(4ull * blockCount);
+				for (uint32_t b = 0; b < blockCount; b++)
+				{
+					const Job& job = *jobs[j + b];
+					const size_t at = (size_t)b * BlockSize;
+					uint32_t storedSize;
+					if (job.Out.empty())
+					{
+						storedSize = (uint32_t)std::min<size_t>(BlockSize, source->File.Size() - at);
+						bytes.append(source->File.Data() + at, storedSize);
+						storedSize |= RawBlock;
+					}
+					else
+					{
+						storedSize = (uint32_t)job.Out.size();
+						bytes.append(job.Out.data(), job.Out.size());
+					}
+					memcpy(bytes.data() + 4ull * b, &storedSize, 4);
+				}
+				j += blockCount;
+				if (bytes.size() < source->File.Size() - source->File.Size() / 8)
+				{
+					source->Compressed.swap(bytes);
+					source->Compression = Codec::Lz4Blocks;
+				}
+			}
+			for (Job* job : jobs)
+				delete job;
+		}
+
+		PackHeader header = {};
+		memcpy(header.Magic, PackMagic, sizeof(PackMagic));
+		header.EntryCount = (uint32_t)sources.size();
+		larray<PackEntry> entries;
+		larray<char> names;
+		for (const Source* source : sources)
+		{
+			PackEntry entry = {};
+			entry.NameOffset = (uint32_t)names.size();
+			entry.NameLength = (uint32_t)source->Name.size();
+			entry.Compression = source->Compression;
+			entry.BlockCount = source->Compression == Codec::Stored ? 0 : GetBlockCount(source->File.Size());
+			entry.StoredSize = source->Compression == Codec::Stored ? source->File.Size() : source->Compressed.size();
+			entry.Size = source->File.Size();
+			names.append(source->Name.c_str(), source->Name.size());
+			entries.push_back(entry);
+		}
+		header.NameBytes = (uint32_t)names.size();
+		header.DataOffset = AlignUp(sizeof(PackHeader) + entries.byteSize() + names.size());
+		uint64_t offset = header.DataOffset;
+		for (PackEntry& entry : entries)
+		{
+			entry.Offset = offset;
+			offset = AlignUp(offset + entry.StoredSize);
+		}
+
+		larray<uint8_t> pack;
+		pack.reserve((size_t)offset);
+		pack.append((const uint8_t*)&header, sizeof(header));
+		pack.append((const uint8_t*)entries.data(), entries.byteSize());
+		pack.append((const uint8_t*)names.data(), names.size());
+		uint64_t stored = 0;
+		for (size_t i = 0; i < sources.size(); i++)
+		{
+			const Source* source = sources[i];
+			pack.resize((size_t)entries[i].Offset);
+			if (source->Compression == Codec::Stored)
+				pack.append(source->File.Data(), source->File.Size());
+			else
+				pack.append(source->Compressed.data(), source->Compressed.size());
+			stored += entries[i].StoredSize;
+		}
+		pack.resize((size_t)offset);
+
+		uint64_t total = 0;
+		for (Source* source : sources)
+		{
+			total += source->File.Size();
+			delete source;
+		}
+		if (!KeyValueFile::WriteReplacing(packPath, pack.data(), pack.size()))
+		{
+			CORE_LOG_ERROR("Can't write resource pack {0}", packPath.c_str());
+			return false;
+		}
+		CORE_LOG_INFO("Packed {0} files of {1} into {2}, {3} KB stored of {4} KB in {5:.1f} ms", entries.size(), dir.c_str(), packPath.c_str(),
+			stored / 1024, total / 1024, Profiler::TicksToMilliseconds(Profiler::Now() - start));
+		return true;
+	}
+
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <atomic>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Core/MappedFile.h"
+
+namespace Luft {
+
+	struct ResourcePack;
+
+	// A file opened through the VirtualFileSystem, read-only. Points into the mapped pack or file
+	// when it's stored as is, owns the decompressed bytes otherwise; either way the data stays
+	// valid until Close, even if its mount goes away.
+	class LUFT_API VirtualFile
+	{
+	public:
+		VirtualFile() = default;
+		~VirtualFile() { Close(); }
+
+		VirtualFile(const VirtualFile&) = delete;
+		VirtualFile& operator=(const VirtualFile&) = delete;
+		VirtualFile(VirtualFile&& o) noexcept { Swap(o); }
+		VirtualFile& operator=(VirtualFile&& o) noexcept
+		{
+			Close();
+			Swap(o);
+			return *this;
+		}
+
+		// takes over bytes read some other way, bytes is left empty
+		void Adopt(larray<uint8_t>& bytes);
+		void Close();
+
+		bool IsOpen() const { return m_Open; }
+		const uint8_t* Data() const { return m_Data; }
+		size_t Size() const { return m_Size; }
+		// straight from a mapping, no copy was made
+		bool IsMapped() const { return m_File.IsOpen() || m_Pack != nullptr; }
+
+	private:
+		friend class VirtualFileSystem;
+		void Swap(VirtualFile& o);
+
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+		bool m_Open = false;
+		// one of them holds the data
+		MappedFile m_File;
+		Ref<ResourcePack> m_Pack;
+		larray<uint8_t> m_Bytes;
+	};
+
+	// where a file's stored bytes are, for readers that do their own I/O instead of mapping
+	struct VirtualFileLocation
+	{
+		// a loose file or the pack holding the entry
+		lstr FilePath;
+		uint64_t Offset = 0;
+		uint64_t StoredSize = 0;
+		// once decoded
+		uint64_t Size = 0;
+		bool Compressed = false;
+	};
+
+	// Asset paths like "resources/fonts/x.ttf" resolved through mount points. A mount point is a
+	// path prefix backed by a directory or by a resource pack, one mapped archive whose table of
+	// contents is sorted by path, so opening an entry is a binary search and no file system call.
+	// Entries start on 4K boundaries and are stored as is, handed out zero-copy, or as LZ4 blocks
+	// that decompress on worker threads. Mounts are searched newest first and a path none of them
+	// has is opened as it is, relative to the working directory. Open is safe from any thread.
+	class LUFT_API VirtualFileSystem
+	{
+	public:
+		// path is a pack file or a directory. False if there's neither
+		static bool Mount(const lstr& mountPoint, const lstr& path);
+		static void Unmount(const lstr& mountPoint);
+		static void UnmountAll();
+		// opens a mounted pack again after it was rebuilt, in the same place of the search order.
+		// Files opened from the old one stay valid
+		static bool Remount(const lstr& packPath);
+		// changes whenever paths may resolve differently, for readers that keep files open
+		static uint32_t GetMountGeneration() { return s_Generation.load(std::memory_order_acquire); }
+
+		static bool Exists(const lstr& path);
+		static bool Locate(const lstr& path, VirtualFileLocation& out);
+		// turns the StoredSize bytes read from a location into the file's, in place
+		static bool Decode(const VirtualFileLocation& location, larray<uint8_t>& bytes);
+		static bool Open(const lstr& path, VirtualFile& out);
+		// opens count paths into out, decompressing all of their blocks together across threads.
+		// False if any failed, those stay closed
+		static bool OpenAll(const lstr* paths, size_t count, VirtualFile* out);
+
+		// packs every file under dir, by its path relative to dir. With compress an entry is
+		// stored as LZ4 blocks when that saves an eighth of it
+		static bool BuildPack(const lstr& dir, const lstr& packPath, bool compress);
+
+	private:
+		struct MountPoint
+		{
+			lstr Prefix;
+			lstr Path;
+			// null for a directory
+			Ref<ResourcePack> Pack;
+		};
+
+		static std::mutex s_Mutex;
+		static larray<MountPoint*> s_Mounts;
+		static std::atomic<uint32_t> s_Generation;
+	};
+
+}
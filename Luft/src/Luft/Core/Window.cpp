@@ -1,5 +1,7 @@
 #include "Window.h"
 
+#include "Log.h"
+#include "Platform/Headless/HeadlessWindow.h"
 #ifdef LUFT_PLATFORM_WINDOWS
 #include "Platform/Windows/WindowsWindow.h"
 #endif
@@ -8,10 +10,13 @@ namespace Luft
 {
 	Scope<Window> Window::Create(const WindowProps& props)
 	{
+		if (props.Headless)
+			return CreateScope<HeadlessWindow>(props);
 	#ifdef LUFT_PLATFORM_WINDOWS
 		return CreateScope<WindowsWindow>(props);
 	#else
-		return nullptr;
+		CORE_LOG_WRAN("No windowed backend on this platform, running headless");
+		return CreateScope<HeadlessWindow>(props);
 	#endif
 	}
 
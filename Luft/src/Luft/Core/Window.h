@@ -6,11 +6,31 @@
 
 namespace Luft {
 
+	// how finished frames reach the display
+	enum class PresentMode
+	{
+		// queued and shown at vertical blank, never tears and caps the frame rate: VSync
+		Fifo,
+		// the newest frame replaces the queued one at vertical blank, no tearing and no cap
+		Mailbox,
+		// shown at once, the lowest latency but may tear
+		Immediate,
+		Count
+	};
+
 	struct WindowProps
 	{
 		lstr Title;
 		uint32_t Width;
 		uint32_t Height;
+		// no display: a HeadlessWindow of Width x Height that never produces input
+		bool Headless = false;
+		// headless only, also create a surfaceless Vulkan device to render offscreen
+		bool OffscreenVulkan = false;
+		// a mode the surface doesn't support falls back to Fifo
+		PresentMode Present = PresentMode::Fifo;
+		// frames the CPU may record ahead of the GPU, whatever the swapchain's image count
+		uint32_t FramesInFlight = 2;
 
 		WindowProps(const lstr& title = "Luft Editor",
 			uint32_t width = 1600,
@@ -39,6 +59,7 @@ namespace Luft {
 		virtual bool IsVSync() const = 0;
 
 		virtual void* GetNativeWindow() const = 0;
+		virtual bool IsHeadless() const { return false; }
 
 		static Scope<Window> Create(const WindowProps& props = WindowProps());
 	};
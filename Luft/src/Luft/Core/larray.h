@@ -6,6 +6,7 @@
 #include <initializer_list>
 #include <type_traits>
 #include "Log.h"
+#include "Memory.h"
 
 template <typename T, bool isStd = std::is_trivial<T>::value>
 struct ItemHelper
@@ -84,11 +85,13 @@ protected:
     size_t usedCount;
 
     /////////////////////////////////////////////////////////////////
-    // memory management, in a dll safe way
+    // memory management, in a dll safe way. Goes through the tracking heap so array storage shows
+    // up under MemoryTag::Array
     static T* allocate(size_t count)
     {
         T* ret = NULL;
-        ret = (T*)malloc(count * sizeof(T));
+        ret = (T*)Luft::Memory::Allocate(count * sizeof(T), Luft::MemoryTag::Array,
+                                         alignof(T) > Luft::Memory::DefaultAlignment ? alignof(T) : Luft::Memory::DefaultAlignment);
         if (ret == NULL)
         {
             CORE_LOG_ERROR("Out of memory");
@@ -97,7 +100,7 @@ protected:
     }
     static void deallocate(T* p)
     {
-        free((void*)p);
+        Luft::Memory::Free((void*)p);
     }
 
     inline void setUsedCount(size_t newCount) { usedCount = newCount; }
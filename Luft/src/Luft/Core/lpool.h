@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <new>
+#include <utility>
+#include "larray.h"
+#include "Memory.h"
+
+// Fixed-size object pool. Objects are carved out of chunks of ChunkSize slots and never move, so
+// pointers stay valid until Destroy(). Freed slots are threaded into an intrusive free list and
+// reused LIFO, which keeps recently freed (cache-warm) memory hot.
+template <typename T, size_t ChunkSize = 64>
+class lpool
+{
+	union Slot
+	{
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	larray<Slot*> m_Chunks;
+	Slot* m_FreeList = NULL;
+	size_t m_Live = 0;
+
+	void grow()
+	{
+		Slot* chunk = (Slot*)Luft::Memory::Allocate(sizeof(Slot) * ChunkSize, Luft::MemoryTag::Pool,
+			alignof(Slot) > Luft::Memory::DefaultAlignment ? alignof(Slot) : Luft::Memory::DefaultAlignment);
+		if (chunk == NULL)
+		{
+			CORE_LOG_ERROR("Out of memory");
+			return;
+		}
+
+		// link back to front so the first Create() hands out the lowest address
+		for (size_t i = ChunkSize; i > 0; i--)
+		{
+			chunk[i - 1].next = m_FreeList;
+			m_FreeList = &chunk[i - 1];
+		}
+
+		m_Chunks.push_back(chunk);
+	}
+
+public:
+	lpool() = default;
+	lpool(const lpool&) = delete;
+	lpool& operator=(const lpool&) = delete;
+
+	~lpool()
+	{
+		// the pool doesn't know which slots are live, so it can't run destructors for them
+		if (m_Live != 0)
+			CORE_LOG_ERROR("lpool destroyed with {0} live objects", m_Live);
+
+		for (Slot* chunk : m_Chunks)
+			Luft::Memory::Free(chunk);
+	}
+
+	template <typename... Args>
+	T* Create(Args&&... args)
+	{
+		if (m_FreeList == NULL)
+			grow();
+		if (m_FreeList == NULL)
+			return NULL;
+
+		Slot* slot = m_FreeList;
+		m_FreeList = slot->next;
+		m_Live++;
+
+		return new(slot->storage) T(std::forward<Args>(args)...);
+	}
+
+	void Destroy(T* obj)
+	{
+		if (obj == NULL)
+			return;
+
+		obj->~T();
+
+		Slot* slot = (Slot*)obj;
+		slot->next = m_FreeList;
+		m_FreeList = slot;
+		m_Live--;
+	}
+
+	// true if obj points at a slot in this pool, live or not
+	bool owns(const T* obj) const
+	{
+		for (Slot* chunk : m_Chunks)
+		{
+			if ((const void*)obj >= (const void*)chunk && (const void*)obj < (const void*)(chunk + ChunkSize))
+				return true;
+		}
+		return false;
+	}
+
+	size_t size() const { return m_Live; }
+	size_t capacity() const { return m_Chunks.size() * ChunkSize; }
+	bool empty() const { return m_Live == 0; }
+};
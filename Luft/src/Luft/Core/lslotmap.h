@@ -0,0 +1,207 @@
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include "larray.h"
+
+// Generational handle: the low IndexBits select a slot, the rest hold the slot's generation at the
+// time the handle was issued. Generation 0 is never issued, so a zero handle is always invalid.
+template <typename IntT, unsigned IndexBits>
+struct lhandle
+{
+	static constexpr unsigned GenerationBits = sizeof(IntT) * 8 - IndexBits;
+	static constexpr IntT IndexMask = (IntT(1) << IndexBits) - 1;
+	static constexpr IntT GenerationMask = (IntT(1) << GenerationBits) - 1;
+	static constexpr size_t MaxSlots = size_t(IndexMask);
+
+	IntT value = 0;
+
+	lhandle() = default;
+	lhandle(IntT index, IntT generation) : value(index | (generation << IndexBits)) {}
+
+	IntT index() const { return value & IndexMask; }
+	IntT generation() const { return (value >> IndexBits) & GenerationMask; }
+	bool isNull() const { return value == 0; }
+	explicit operator bool() const { return value != 0; }
+
+	bool operator==(const lhandle& o) const { return value == o.value; }
+	bool operator!=(const lhandle& o) const { return value != o.value; }
+	bool operator<(const lhandle& o) const { return value < o.value; }
+};
+
+// 1M slots and 4096 generations before a slot's handles can alias
+typedef lhandle<uint32_t, 20> lhandle32;
+// 4G slots and 4G generations
+typedef lhandle<uint64_t, 32> lhandle64;
+
+// Slot map with dense storage. Values live contiguously in insertion order (with swap-remove), so
+// iteration is a linear walk. Handles are validated in O(1) by comparing generations, and a handle
+// to a removed element stays safely invalid until its slot's generation wraps around.
+// Not thread-safe: it's meant to be owned by a single system.
+template <typename T, typename HandleT = lhandle32>
+class lslotmap
+{
+	typedef decltype(HandleT().value) IntT;
+
+	struct Slot
+	{
+		// index into the dense arrays while live, next free slot while free
+		IntT dense;
+		IntT generation;
+	};
+
+	static constexpr IntT InvalidIndex = ~IntT(0);
+
+	larray<T> m_Values;
+	larray<IntT> m_DenseToSlot;
+	larray<Slot> m_Slots;
+	IntT m_FreeHead = InvalidIndex;
+
+	HandleT allocSlot()
+	{
+		IntT slotIdx;
+		if (m_FreeHead != InvalidIndex)
+		{
+			slotIdx = m_FreeHead;
+			m_FreeHead = m_Slots[slotIdx].dense;
+		}
+		else
+		{
+			if (m_Slots.size() >= HandleT::MaxSlots)
+			{
+				CORE_LOG_ERROR("lslotmap is full ({0} slots)", m_Slots.size());
+				return HandleT();
+			}
+			slotIdx = (IntT)m_Slots.size();
+			Slot s;
+			s.dense = InvalidIndex;
+			s.generation = 1;
+			m_Slots.push_back(s);
+		}
+
+		Slot& slot = m_Slots[slotIdx];
+		slot.dense = (IntT)m_Values.size();
+		m_DenseToSlot.push_back(slotIdx);
+		return HandleT(slotIdx, slot.generation);
+	}
+
+	const Slot* lookup(HandleT h) const
+	{
+		const IntT idx = h.index();
+		if (h.isNull() || idx >= m_Slots.size())
+			return NULL;
+		// free slots hold the free-list link in 'dense', but their generation was bumped on erase so
+		// no outstanding handle can match it
+		const Slot& slot = m_Slots[idx];
+		if (slot.generation != h.generation())
+			return NULL;
+		return &slot;
+	}
+
+public:
+	typedef HandleT handle_type;
+
+	HandleT insert(const T& value)
+	{
+		HandleT h = allocSlot();
+		if (!h.isNull())
+			m_Values.push_back(value);
+		return h;
+	}
+
+	HandleT insert(T&& value)
+	{
+		HandleT h = allocSlot();
+		if (!h.isNull())
+			m_Values.push_back(std::move(value));
+		return h;
+	}
+
+	template <typename... Args>
+	HandleT emplace(Args&&... args)
+	{
+		return insert(T(std::forward<Args>(args)...));
+	}
+
+	// returns false if the handle was already stale
+	bool erase(HandleT h)
+	{
+		const Slot* found = lookup(h);
+		if (found == NULL)
+			return false;
+
+		const IntT slotIdx = h.index();
+		const IntT dense = found->dense;
+		const IntT last = (IntT)m_Values.size() - 1;
+
+		// swap-remove to keep the values packed, then patch the moved element's slot
+		if (dense != last)
+		{
+			m_Values[dense] = std::move(m_Values[last]);
+			m_DenseToSlot[dense] = m_DenseToSlot[last];
+			m_Slots[m_DenseToSlot[dense]].dense = dense;
+		}
+		m_Values.pop_back();
+		m_DenseToSlot.pop_back();
+
+		// retire the slot: bump the generation (skipping 0) and push it on the free list
+		Slot& slot = m_Slots[slotIdx];
+		slot.generation = (slot.generation + 1) & HandleT::GenerationMask;
+		if (slot.generation == 0)
+			slot.generation = 1;
+		slot.dense = m_FreeHead;
+		m_FreeHead = slotIdx;
+
+		return true;
+	}
+
+	T* get(HandleT h)
+	{
+		const Slot* slot = lookup(h);
+		return slot ? &m_Values[slot->dense] : NULL;
+	}
+	const T* get(HandleT h) const
+	{
+		const Slot* slot = lookup(h);
+		return slot ? &m_Values[slot->dense] : NULL;
+	}
+	bool contains(HandleT h) const { return lookup(h) != NULL; }
+
+	void clear()
+	{
+		for (size_t i = 0; i < m_DenseToSlot.size(); i++)
+		{
+			IntT slotIdx = m_DenseToSlot[i];
+			Slot& slot = m_Slots[slotIdx];
+			slot.generation = (slot.generation + 1) & HandleT::GenerationMask;
+			if (slot.generation == 0)
+				slot.generation = 1;
+			slot.dense = m_FreeHead;
+			m_FreeHead = slotIdx;
+		}
+		m_Values.clear();
+		m_DenseToSlot.clear();
+	}
+
+	void reserve(size_t s)
+	{
+		m_Values.reserve(s);
+		m_DenseToSlot.reserve(s);
+		m_Slots.reserve(s);
+	}
+
+	// dense access, e.g. for (T& v : map) or by index with handleAt(i)
+	size_t size() const { return m_Values.size(); }
+	bool empty() const { return m_Values.empty(); }
+	T* begin() { return m_Values.begin(); }
+	T* end() { return m_Values.end(); }
+	const T* begin() const { return m_Values.begin(); }
+	const T* end() const { return m_Values.end(); }
+	T& operator[](size_t denseIdx) { return m_Values[denseIdx]; }
+	const T& operator[](size_t denseIdx) const { return m_Values[denseIdx]; }
+	HandleT handleAt(size_t denseIdx) const
+	{
+		const IntT slotIdx = m_DenseToSlot[denseIdx];
+		return HandleT(slotIdx, m_Slots[slotIdx].generation);
+	}
+};
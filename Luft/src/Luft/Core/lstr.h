@@ -4,6 +4,7 @@
 #include <string.h>     // for memcpy, etc
 #include <algorithm>    // for std::swap
 #include "Log.h"
+#include "Memory.h"
 
 
 class lstrliteral
@@ -94,10 +95,11 @@ private:
 	bool is_fixed() const { return !!(d.fixed.flags & FIXED_STATE); }
 	bool is_array() const { return !is_alloc() && !is_fixed(); }
 
+	// heap storage goes through the tracking heap, charged to MemoryTag::String
 	static char* allocate(size_t count)
 	{
 		char* ret = NULL;
-		ret = (char*)malloc(count);
+		ret = (char*)Luft::Memory::Allocate(count, Luft::MemoryTag::String);
 		if (ret == NULL)
 		{
 			CORE_LOG_ERROR("Out of memory");
@@ -107,7 +109,7 @@ private:
 
 	static void deallocate(char* p)
 	{
-		free((void*)p);
+		Luft::Memory::Free((void*)p);
 	}
 
 	// if we're not already mutable (i.e. fixed string) then change to a mutable string
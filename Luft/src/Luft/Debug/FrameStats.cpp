@@ -0,0 +1,244 @@
+#include "FrameStats.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include "Luft/Core/Log.h"
+
+namespace Luft {
+
+	namespace
+	{
+		// frames a streamed CSV row waits for its GPU time before being written
+		constexpr uint64_t CsvDelay = 8;
+
+		FILE* s_CsvFile = nullptr;
+		uint64_t s_CsvNextIndex = 0;
+		uint64_t s_FirstTicks = 0;
+
+		FrameMetricStats ComputeStats(float* values, uint32_t count)
+		{
+			FrameMetricStats stats;
+			if (count == 0)
+				return stats;
+
+			std::sort(values, values + count);
+			auto percentile = [&](double p) {
+				uint32_t idx = (uint32_t)(p * count + 0.999999);
+				idx = idx == 0 ? 0 : idx - 1;
+				return values[idx < count ? idx : count - 1];
+			};
+			stats.P50 = percentile(0.50);
+			stats.P95 = percentile(0.95);
+			stats.P99 = percentile(0.99);
+			stats.Max = values[count - 1];
+			return stats;
+		}
+
+		void WriteCsvHeader(FILE* f)
+		{
+			fputs("frame,time_s,frame_ms,cpu_ms,gpu_ms,present_ms,wait_ms,hitch,skipped\n", f);
+		}
+
+		void WriteCsvRow(FILE* f, const FrameSample& s, float hitchThresholdMs)
+		{
+			fprintf(f, "%llu,%.6f,%.4f,%.4f,", (unsigned long long)s.Index, s.Time, s.FrameMs, s.CpuMs);
+			if (s.GpuMs >= 0.0f)
+				fprintf(f, "%.4f", s.GpuMs);
+			fprintf(f, ",%.4f,%.4f,%d,%d\n", s.PresentMs, s.WaitMs, !s.Skipped && s.FrameMs > hitchThresholdMs ? 1 : 0, s.Skipped ? 1 : 0);
+		}
+	}
+
+	FrameSample FrameStats::s_Samples[HistorySize];
+	uint32_t FrameStats::s_SampleCount = 0;
+	uint64_t FrameStats::s_FrameIndex = 0;
+	uint64_t FrameStats::s_FrameStartTicks = 0;
+	double FrameStats::s_CurrentPresentMs = 0.0;
+	double FrameStats::s_CurrentWaitMs = 0.0;
+	bool FrameStats::s_CurrentSkipped = false;
+	uint64_t FrameStats::s_SkippedCount = 0;
+	float FrameStats::s_HitchThresholdMs = 33.3f;
+	uint64_t FrameStats::s_HitchCount = 0;
+	larray<FrameHitch> FrameStats::s_Hitches;
+	FrameStatsSummary FrameStats::s_Summary;
+	uint64_t FrameStats::s_SummaryFrame = ~0ull;
+
+	void FrameStats::BeginFrame()
+	{
+		const uint64_t now = Profiler::Now();
+		if (s_FirstTicks == 0)
+			s_FirstTicks = now;
+
+		if (s_FrameStartTicks != 0)
+		{
+			FrameSample& sample = s_Samples[s_FrameIndex % HistorySize];
+			sample.Index = s_FrameIndex;
+			sample.Time = Profiler::TicksToMicroseconds(s_FrameStartTicks - s_FirstTicks) / 1000000.0;
+			sample.FrameMs = (float)Profiler::TicksToMilliseconds(now - s_FrameStartTicks);
+			sample.PresentMs = (float)s_CurrentPresentMs;
+			sample.WaitMs = (float)s_CurrentWaitMs;
+			sample.CpuMs = std::max(sample.FrameMs - sample.PresentMs - sample.WaitMs, 0.0f);
+			sample.GpuMs = -1.0f;
+			sample.Skipped = s_CurrentSkipped;
+			if (s_SampleCount < HistorySize)
+				s_SampleCount++;
+			if (sample.Skipped)
+				s_SkippedCount++;
+
+			if (!sample.Skipped && sample.FrameMs > s_HitchThresholdMs)
+			{
+				s_HitchCount++;
+				if (s_Hitches.size() >= MaxHitches)
+					s_Hitches.erase(0);
+				FrameHitch hitch;
+				hitch.Sample = sample;
+				// the profiler has just drained this frame
+				hitch.Zones = Profiler::GetLastFrameZones();
+				s_Hitches.push_back(std::move(hitch));
+			}
+
+			if (s_CsvFile)
+			{
+				while (s_CsvNextIndex + CsvDelay <= s_FrameIndex)
+				{
+					WriteCsvRow(s_CsvFile, s_Samples[s_CsvNextIndex % HistorySize], s_HitchThresholdMs);
+					s_CsvNextIndex++;
+				}
+			}
+
+			s_FrameIndex++;
+		}
+
+		s_FrameStartTicks = now;
+		s_CurrentPresentMs = 0.0;
+		s_CurrentWaitMs = 0.0;
+		s_CurrentSkipped = false;
+	}
+
+	FrameSample* FrameStats::FindSample(uint64_t frameIndex)
+	{
+		if (frameIndex >= s_FrameIndex || s_FrameIndex - frameIndex > s_SampleCount)
+			return nullptr;
+		return &s_Samples[frameIndex % HistorySize];
+	}
+
+	void FrameStats::ReportGpu(uint64_t frameIndex, double ms)
+	{
+		FrameSample* sample = FindSample(frameIndex);
+		if (sample)
+			sample->GpuMs = (float)ms;
+
+		for (FrameHitch& hitch : s_Hitches)
+		{
+			if (hitch.Sample.Index == frameIndex)
+				hitch.Sample.GpuMs = (float)ms;
+		}
+	}
+
+	const FrameSample& FrameStats::GetSample(uint32_t i)
+	{
+		return s_Samples[(s_FrameIndex - s_SampleCount + i) % HistorySize];
+	}
+
+	const FrameSample* FrameStats::GetLastSample()
+	{
+		return s_SampleCount > 0 ? &GetSample(s_SampleCount - 1) : nullptr;
+	}
+
+	const FrameStatsSummary& FrameStats::GetSummary()
+	{
+		if (s_SummaryFrame == s_FrameIndex)
+			return s_Summary;
+		s_SummaryFrame = s_FrameIndex;
+
+		float values[HistorySize];
+		const uint32_t count = s_SampleCount;
+
+		for (uint32_t i = 0; i < count; i++)
+			values[i] = GetSample(i).FrameMs;
+		s_Summary.Frame = ComputeStats(values, count);
+
+		for (uint32_t i = 0; i < count; i++)
+			values[i] = GetSample(i).CpuMs;
+		s_Summary.Cpu = ComputeStats(values, count);
+
+		for (uint32_t i = 0; i < count; i++)
+			values[i] = GetSample(i).PresentMs;
+		s_Summary.Present = ComputeStats(values, count);
+
+		uint32_t gpuCount = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (GetSample(i).GpuMs >= 0.0f)
+				values[gpuCount++] = GetSample(i).GpuMs;
+		}
+		s_Summary.Gpu = ComputeStats(values, gpuCount);
+
+		s_Summary.SampleCount = count;
+		s_Summary.HitchCount = s_HitchCount;
+		s_Summary.SkippedCount = s_SkippedCount;
+		return s_Summary;
+	}
+
+	void FrameStats::ClearHitches()
+	{
+		s_Hitches.clear();
+		s_HitchCount = 0;
+	}
+
+	bool FrameStats::ExportCsv(const lstr& path)
+	{
+		FILE* f = fopen(path.c_str(), "wb");
+		if (!f)
+		{
+			CORE_LOG_ERROR("FrameStats: can't open {0}", path.c_str());
+			return false;
+		}
+
+		WriteCsvHeader(f);
+		for (uint32_t i = 0; i < s_SampleCount; i++)
+			WriteCsvRow(f, GetSample(i), s_HitchThresholdMs);
+		fclose(f);
+		CORE_LOG_INFO("FrameStats: wrote {0} frames to {1}", s_SampleCount, path.c_str());
+		return true;
+	}
+
+	bool FrameStats::BeginCsvCapture(const lstr& path)
+	{
+		if (s_CsvFile)
+			return false;
+
+		s_CsvFile = fopen(path.c_str(), "wb");
+		if (!s_CsvFile)
+		{
+			CORE_LOG_ERROR("FrameStats: can't open {0}", path.c_str());
+			return false;
+		}
+
+		WriteCsvHeader(s_CsvFile);
+		s_CsvNextIndex = s_FrameIndex;
+		CORE_LOG_INFO("FrameStats: capturing to {0}", path.c_str());
+		return true;
+	}
+
+	void FrameStats::EndCsvCapture()
+	{
+		if (!s_CsvFile)
+			return;
+
+		// the last few rows go out without waiting for their GPU times
+		while (s_CsvNextIndex < s_FrameIndex)
+		{
+			WriteCsvRow(s_CsvFile, s_Samples[s_CsvNextIndex % HistorySize], s_HitchThresholdMs);
+			s_CsvNextIndex++;
+		}
+		fclose(s_CsvFile);
+		s_CsvFile = nullptr;
+		CORE_LOG_INFO("FrameStats: capture finished");
+	}
+
+	bool FrameStats::IsCsvCapturing()
+	{
+		return s_CsvFile != nullptr;
+	}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	struct FrameSample
+	{
+		uint64_t Index = 0;
+		// seconds since startup at the start of the frame
+		double Time = 0.0;
+		// start to start of the next frame
+		float FrameMs = 0.0f;
+		// frame time minus present and waiting for the GPU / swapchain
+		float CpuMs = 0.0f;
+		// negative until the GPU timer resolves the frame, which happens a few frames later
+		float GpuMs = -1.0f;
+		float PresentMs = 0.0f;
+		float WaitMs = 0.0f;
+		// the UI was the same as last frame, nothing was rendered or presented. Waiting for input
+		// afterwards counts as WaitMs
+		bool Skipped = false;
+	};
+
+	struct FrameMetricStats
+	{
+		float P50 = 0.0f;
+		float P95 = 0.0f;
+		float P99 = 0.0f;
+		float Max = 0.0f;
+	};
+
+	struct FrameStatsSummary
+	{
+		uint32_t SampleCount = 0;
+		FrameMetricStats Frame;
+		FrameMetricStats Cpu;
+		// over the samples whose GPU time is known
+		FrameMetricStats Gpu;
+		FrameMetricStats Present;
+		uint64_t HitchCount = 0;
+		uint64_t SkippedCount = 0;
+	};
+
+	struct FrameHitch
+	{
+		FrameSample Sample;
+		// everything the profiler recorded during the frame
+		larray<ProfileZone> Zones;
+	};
+
+	// Per-frame timing service, fed by Application::Run and the ImGui layer. Keeps a ring of recent
+	// samples with rolling percentiles, and remembers the profiler zones of frames that took longer
+	// than the hitch threshold. Main thread only.
+	class LUFT_API FrameStats
+	{
+	public:
+		static constexpr uint32_t HistorySize = 1024;
+		static constexpr uint32_t MaxHitches = 32;
+
+		// closes the previous frame. Call right after the profiler's BeginFrame so the closed frame's
+		// zones are still available for hitch capture
+		static void BeginFrame();
+		static uint64_t GetFrameIndex() { return s_FrameIndex; }
+
+		// time the current frame spent in present, and blocked on fences / image acquisition
+		static void ReportPresent(double ms) { s_CurrentPresentMs += ms; }
+		static void ReportWait(double ms) { s_CurrentWaitMs += ms; }
+		// nothing was rendered this frame. Never a hitch, however long the wait for input was
+		static void ReportSkipped() { s_CurrentSkipped = true; }
+		// GPU time of an earlier frame, by FrameStats frame index
+		static void ReportGpu(uint64_t frameIndex, double ms);
+
+		// 0 is the oldest sample
+		static uint32_t GetSampleCount() { return s_SampleCount; }
+		static const FrameSample& GetSample(uint32_t i);
+		static const FrameSample* GetLastSample();
+		// rolling stats over the whole history, recomputed at most once per frame
+		static const FrameStatsSummary& GetSummary();
+
+		static void SetHitchThreshold(float ms) { s_HitchThresholdMs = ms; }
+		static float GetHitchThreshold() { return s_HitchThresholdMs; }
+		// most recent last
+		static const larray<FrameHitch>& GetHitches() { return s_Hitches; }
+		static void ClearHitches();
+
+		// writes the current history
+		static bool ExportCsv(const lstr& path);
+		// streams every frame to the file until stopped, for soak tests. Rows are written a few
+		// frames late so GPU times have arrived
+		static bool BeginCsvCapture(const lstr& path);
+		static void EndCsvCapture();
+		static bool IsCsvCapturing();
+
+	private:
+		static FrameSample* FindSample(uint64_t frameIndex);
+
+		static FrameSample s_Samples[HistorySize];
+		static uint32_t s_SampleCount;
+		static uint64_t s_FrameIndex;
+		static uint64_t s_FrameStartTicks;
+		static double s_CurrentPresentMs;
+		static double s_CurrentWaitMs;
+		static bool s_CurrentSkipped;
+		static uint64_t s_SkippedCount;
+
+		static float s_HitchThresholdMs;
+		static uint64_t s_HitchCount;
+		static larray<FrameHitch> s_Hitches;
+
+		static FrameStatsSummary s_Summary;
+		static uint64_t s_SummaryFrame;
+	};
+
+}
@@ -0,0 +1,398 @@
+#include "Profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include "Luft/Core/Log.h"
+#include "Luft/Core/Memory.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LUFT_PROFILE_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define LUFT_PROFILE_RDTSC 0
+#endif
+
+namespace Luft {
+
+	namespace
+	{
+		// per-thread ring capacity in zones, must be a power of two. 128K zones is 4MB per thread and
+		// comfortably holds a 100k zone frame. The ring isn't initialized, so a worker that records a
+		// few zones a frame only ever touches the first pages of it
+		constexpr uint32_t RingSize = 1u << 17;
+		constexpr uint32_t RingMask = RingSize - 1;
+
+		struct ThreadState
+		{
+			ProfileZone ring[RingSize];
+			// head is written by the owning thread only, tail by the draining (main) thread only
+			std::atomic<uint32_t> head{ 0 };
+			std::atomic<uint32_t> tail{ 0 };
+			std::atomic<uint64_t> dropped{ 0 };
+			// the owning thread has exited, the next new thread takes the state over
+			std::atomic<bool> released{ false };
+			std::atomic<uint32_t> id{ 0 };
+			uint32_t depth = 0;
+			char name[64] = {};
+			ThreadState* next = nullptr;
+		};
+
+		std::atomic<ThreadState*> s_Threads{ nullptr };
+		std::atomic<uint32_t> s_NextThreadId{ 0 };
+		thread_local ThreadState* t_State = nullptr;
+
+		// releases the thread's state when it exits. Apart from t_State, so the lookup on every
+		// zone stays a plain thread_local without a destructor
+		struct ThreadStateOwner
+		{
+			ThreadState* State = nullptr;
+			~ThreadStateOwner()
+			{
+				if (State)
+					State->released.store(true, std::memory_order_release);
+			}
+		};
+		thread_local ThreadStateOwner t_Owner;
+
+		void NameThreadState(ThreadState* ts)
+		{
+			ts->id.store(s_NextThreadId.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+			ts->depth = 0;
+			snprintf(ts->name, sizeof(ts->name), "Thread %u", ts->id.load(std::memory_order_relaxed));
+		}
+
+		ThreadState* CreateThreadState()
+		{
+			// default-initialized, the ring is left as it is
+			ThreadState* ts = new (Memory::Allocate(sizeof(ThreadState), MemoryTag::Profiler, alignof(ThreadState))) ThreadState;
+			NameThreadState(ts);
+
+			// states are never freed so the drain can walk the list without locking, those of exited
+			// threads are reused instead
+			ThreadState* head = s_Threads.load(std::memory_order_relaxed);
+			do
+			{
+				ts->next = head;
+			} while (!s_Threads.compare_exchange_weak(head, ts, std::memory_order_release, std::memory_order_relaxed));
+
+			return ts;
+		}
+
+		// the state of an exited thread whose zones have all been drained. It gets a new id, the
+		// zones drained from it before keep the old one
+		ThreadState* ReuseThreadState()
+		{
+			for (ThreadState* ts = s_Threads.load(std::memory_order_acquire); ts; ts = ts->next)
+			{
+				if (!ts->released.load(std::memory_order_relaxed)
+					|| ts->head.load(std::memory_order_relaxed) != ts->tail.load(std::memory_order_acquire))
+					continue;
+				bool released = true;
+				if (ts->released.compare_exchange_strong(released, false, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					NameThreadState(ts);
+					return ts;
+				}
+			}
+			return nullptr;
+		}
+
+		ThreadState* GetThreadState()
+		{
+			ThreadState* ts = t_State;
+			if (ts)
+				return ts;
+
+			ts = ReuseThreadState();
+			if (!ts)
+				ts = CreateThreadState();
+			t_State = ts;
+			t_Owner.State = ts;
+			return ts;
+		}
+
+		ThreadState* FindThreadState(uint32_t id)
+		{
+			for (ThreadState* ts = s_Threads.load(std::memory_order_acquire); ts; ts = ts->next)
+			{
+				if (ts->id.load(std::memory_order_relaxed) == id)
+					return ts;
+			}
+			return nullptr;
+		}
+
+		void Push(ThreadState* ts, const char* name, uint64_t start, uint64_t end, uint32_t depth)
+		{
+			const uint32_t head = ts->head.load(std::memory_order_relaxed);
+			const uint32_t tail = ts->tail.load(std::memory_order_acquire);
+			if (head - tail >= RingSize)
+			{
+				ts->dropped.store(ts->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				return;
+			}
+
+			ProfileZone& zone = ts->ring[head & RingMask];
+			zone.Name = name;
+			zone.Start = start;
+			zone.End = end;
+			zone.ThreadId = ts->id.load(std::memory_order_relaxed);
+			zone.Depth = depth;
+
+			ts->head.store(head + 1, std::memory_order_release);
+		}
+
+		uint64_t NowNanoseconds()
+		{
+			using namespace std::chrono;
+			return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+		}
+
+		// reference points for converting ticks to time. With RDTSC the rate is re-estimated every
+		// frame from the growing interval since startup, so it converges without a blocking calibration.
+		// Zones are converted on any thread, so the rate is atomic
+		const uint64_t s_BaseTicks = Profiler::Now();
+		const uint64_t s_BaseNanoseconds = NowNanoseconds();
+		std::atomic<double> s_TicksPerMicrosecond{ 0.0 };
+
+		// the rate, estimated first when nothing has been yet
+		double Calibrate()
+		{
+#if LUFT_PROFILE_RDTSC
+			const uint64_t ticks = Profiler::Now() - s_BaseTicks;
+			const uint64_t ns = NowNanoseconds() - s_BaseNanoseconds;
+			// wait for at least a millisecond of history before trusting the estimate
+			double rate = s_TicksPerMicrosecond.load(std::memory_order_relaxed);
+			if (ns > 1000000)
+				rate = (double)ticks * 1000.0 / (double)ns;
+			else if (rate == 0.0)
+				rate = 3000.0;
+#else
+			const double rate = 1000.0;
+#endif
+			s_TicksPerMicrosecond.store(rate, std::memory_order_relaxed);
+			return rate;
+		}
+
+		double GetTicksPerMicrosecond()
+		{
+			const double rate = s_TicksPerMicrosecond.load(std::memory_order_relaxed);
+			return rate != 0.0 ? rate : Calibrate();
+		}
+
+		// === Chrome trace capture ===
+		FILE* s_CaptureFile = nullptr;
+		uint64_t s_CaptureBaseTicks = 0;
+		bool s_CaptureFirstEvent = true;
+		bool s_CaptureStopRequested = false;
+
+		void WriteJsonString(FILE* f, const char* str)
+		{
+			fputc('"', f);
+			for (const char* c = str; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+				{
+					fputc('\\', f);
+					fputc(*c, f);
+				}
+				else if ((unsigned char)*c < 0x20)
+				{
+					fprintf(f, "\\u%04x", (unsigned)(unsigned char)*c);
+				}
+				else
+				{
+					fputc(*c, f);
+				}
+			}
+			fputc('"', f);
+		}
+
+		void WriteCaptureZone(const ProfileZone& zone)
+		{
+			// zones that started before the capture did are clipped off
+			if (zone.Start < s_CaptureBaseTicks)
+				return;
+
+			const double ts = Profiler::TicksToMicroseconds(zone.Start - s_CaptureBaseTicks);
+			const double dur = Profiler::TicksToMicroseconds(zone.End - zone.Start);
+
+			fputs(s_CaptureFirstEvent ? "\n" : ",\n", s_CaptureFile);
+			s_CaptureFirstEvent = false;
+			fputs("{\"cat\":\"zone\",\"name\":", s_CaptureFile);
+			WriteJsonString(s_CaptureFile, zone.Name);
+			fprintf(s_CaptureFile, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", zone.ThreadId, ts, dur);
+		}
+
+		void CloseCapture()
+		{
+			// thread names as metadata events so lanes are labelled in the viewer
+			for (ThreadState* ts = s_Threads.load(std::memory_order_acquire); ts; ts = ts->next)
+			{
+				fputs(s_CaptureFirstEvent ? "\n" : ",\n", s_CaptureFile);
+				s_CaptureFirstEvent = false;
+				fprintf(s_CaptureFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", ts->id.load(std::memory_order_relaxed));
+				WriteJsonString(s_CaptureFile, ts->name);
+				fputs("}}", s_CaptureFile);
+			}
+
+			fputs("\n]}\n", s_CaptureFile);
+			fclose(s_CaptureFile);
+			s_CaptureFile = nullptr;
+			s_CaptureStopRequested = false;
+			CORE_LOG_INFO("Profiler capture finished");
+		}
+	}
+
+	uint64_t Profiler::s_FrameIndex = 0;
+	uint64_t Profiler::s_LastFrameStart = 0;
+	uint64_t Profiler::s_LastFrameEnd = 0;
+	larray<ProfileZone> Profiler::s_LastFrameZones;
+
+	uint64_t Profiler::Now()
+	{
+#if LUFT_PROFILE_RDTSC
+		return __rdtsc();
+#else
+		return NowNanoseconds();
+#endif
+	}
+
+	double Profiler::TicksToMicroseconds(uint64_t ticks)
+	{
+		return (double)ticks / GetTicksPerMicrosecond();
+	}
+
+	uint64_t Profiler::MicrosecondsToTicks(double us)
+	{
+		return (uint64_t)(us * GetTicksPerMicrosecond());
+	}
+
+	void Profiler::SetThreadName(const char* name)
+	{
+		ThreadState* ts = GetThreadState();
+		snprintf(ts->name, sizeof(ts->name), "%s", name);
+	}
+
+	larray<ProfileThreadInfo> Profiler::GetThreads()
+	{
+		larray<ProfileThreadInfo> ret;
+		for (ThreadState* ts = s_Threads.load(std::memory_order_acquire); ts; ts = ts->next)
+		{
+			ProfileThreadInfo info;
+			info.Id = ts->id.load(std::memory_order_relaxed);
+			info.Name = ts->name;
+			ret.push_back(info);
+		}
+		return ret;
+	}
+
+	uint32_t Profiler::PushDepth()
+	{
+		return GetThreadState()->depth++;
+	}
+
+	void Profiler::PopDepth()
+	{
+		GetThreadState()->depth--;
+	}
+
+	void Profiler::Record(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		Push(GetThreadState(), name, start, end, depth);
+	}
+
+	uint32_t Profiler::CreateLane(const char* name)
+	{
+		ThreadState* ts = CreateThreadState();
+		snprintf(ts->name, sizeof(ts->name), "%s", name);
+		return ts->id.load(std::memory_order_relaxed);
+	}
+
+	void Profiler::RecordLane(uint32_t lane, const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		ThreadState* ts = FindThreadState(lane);
+		if (ts)
+			Push(ts, name, start, end, depth);
+	}
+
+	uint64_t Profiler::GetDroppedZoneCount()
+	{
+		uint64_t ret = 0;
+		for (ThreadState* ts = s_Threads.load(std::memory_order_acquire); ts; ts = ts->next)
+			ret += ts->dropped.load(std::memory_order_relaxed);
+		return ret;
+	}
+
+	void Profiler::BeginFrame()
+	{
+		const uint64_t now = Now();
+		Calibrate();
+
+		s_LastFrameZones.clear();
+		s_LastFrameStart = s_LastFrameEnd;
+		s_LastFrameEnd = now;
+		if (s_LastFrameStart == 0)
+			s_LastFrameStart = s_BaseTicks;
+
+		for (ThreadState* ts = s_Threads.load(std::memory_order_acquire); ts; ts = ts->next)
+		{
+			const uint32_t tail = ts->tail.load(std::memory_order_relaxed);
+			const uint32_t head = ts->head.load(std::memory_order_acquire);
+			for (uint32_t i = tail; i != head; i++)
+			{
+				const ProfileZone& zone = ts->ring[i & RingMask];
+				s_LastFrameZones.push_back(zone);
+				if (s_CaptureFile)
+					WriteCaptureZone(zone);
+			}
+			ts->tail.store(head, std::memory_order_release);
+		}
+
+		if (s_CaptureFile && s_CaptureStopRequested)
+			CloseCapture();
+
+		s_FrameIndex++;
+	}
+
+	bool Profiler::BeginCapture(const lstr& path)
+	{
+		if (s_CaptureFile)
+			return false;
+
+		s_CaptureFile = fopen(path.c_str(), "wb");
+		if (!s_CaptureFile)
+		{
+			CORE_LOG_ERROR("Profiler: can't open capture file {0}", path.c_str());
+			return false;
+		}
+
+		// large buffer, events are written in bursts once per frame
+		setvbuf(s_CaptureFile, NULL, _IOFBF, 1 << 20);
+		s_CaptureBaseTicks = Now();
+		s_CaptureFirstEvent = true;
+		s_CaptureStopRequested = false;
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", s_CaptureFile);
+		CORE_LOG_INFO("Profiler capture started: {0}", path.c_str());
+		return true;
+	}
+
+	void Profiler::EndCapture()
+	{
+		// finished at the next BeginFrame, so the current frame's zones make it into the file
+		if (s_CaptureFile)
+			s_CaptureStopRequested = true;
+	}
+
+	bool Profiler::IsCapturing()
+	{
+		return s_CaptureFile != nullptr;
+	}
+
+}
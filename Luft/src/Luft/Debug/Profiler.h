@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdint.h>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+
+// LUFT_PROFILE is set by the LUFT_ENABLE_PROFILING cmake option. When it's 0 every
+// LUFT_PROFILE_* macro expands to nothing, including its arguments.
+#ifndef LUFT_PROFILE
+#define LUFT_PROFILE 0
+#endif
+
+namespace Luft {
+
+	struct ProfileZone
+	{
+		// must point at a string with static lifetime, e.g. a literal or __FUNCTION__
+		const char* Name;
+		uint64_t Start;
+		uint64_t End;
+		uint32_t ThreadId;
+		uint32_t Depth;
+	};
+
+	struct ProfileThreadInfo
+	{
+		uint32_t Id;
+		lstr Name;
+	};
+
+	// Instrumenting profiler. Each thread records finished zones into its own single-producer ring,
+	// the main thread drains all rings once per frame in BeginFrame(). Timestamps are raw ticks
+	// (RDTSC where available) and only converted to time when they're consumed.
+	class LUFT_API Profiler
+	{
+	public:
+		static uint64_t Now();
+		static double TicksToMicroseconds(uint64_t ticks);
+		static double TicksToMilliseconds(uint64_t ticks) { return TicksToMicroseconds(ticks) / 1000.0; }
+		static uint64_t MicrosecondsToTicks(double us);
+
+		// names the calling thread in captures and the profiler panel
+		static void SetThreadName(const char* name);
+		static larray<ProfileThreadInfo> GetThreads();
+		// a lane is a timeline that isn't an OS thread, e.g. GPU queue timings. Only one thread
+		// at a time may record into a lane. Lanes live until shutdown
+		static uint32_t CreateLane(const char* name);
+		static void RecordLane(uint32_t lane, const char* name, uint64_t start, uint64_t end, uint32_t depth);
+
+		// main thread only: closes the previous frame by draining every thread's ring
+		static void BeginFrame();
+		static uint64_t GetFrameIndex() { return s_FrameIndex; }
+		// zones drained at the start of the current frame, i.e. everything the last frame recorded
+		static const larray<ProfileZone>& GetLastFrameZones() { return s_LastFrameZones; }
+		static uint64_t GetLastFrameStart() { return s_LastFrameStart; }
+		static uint64_t GetLastFrameEnd() { return s_LastFrameEnd; }
+		// zones lost because a ring was full when its thread tried to record
+		static uint64_t GetDroppedZoneCount();
+
+		// Chrome about:tracing / Perfetto JSON. Zones are streamed out as they're drained
+		static bool BeginCapture(const lstr& path);
+		static void EndCapture();
+		static bool IsCapturing();
+
+		// used by ProfileScope, records a finished zone on the calling thread
+		static void Record(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+		static uint32_t PushDepth();
+		static void PopDepth();
+
+	private:
+		static uint64_t s_FrameIndex;
+		static uint64_t s_LastFrameStart;
+		static uint64_t s_LastFrameEnd;
+		static larray<ProfileZone> s_LastFrameZones;
+	};
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(const char* name)
+			: m_Name(name), m_Depth(Profiler::PushDepth()), m_Start(Profiler::Now())
+		{
+		}
+
+		~ProfileScope()
+		{
+			uint64_t end = Profiler::Now();
+			Profiler::PopDepth();
+			Profiler::Record(m_Name, m_Start, end, m_Depth);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* m_Name;
+		uint32_t m_Depth;
+		uint64_t m_Start;
+	};
+
+}
+
+#if LUFT_PROFILE
+#define LUFT_PROFILE_CONCAT2(a, b) a##b
+#define LUFT_PROFILE_CONCAT(a, b) LUFT_PROFILE_CONCAT2(a, b)
+#define LUFT_PROFILE_SCOPE(name) ::Luft::ProfileScope LUFT_PROFILE_CONCAT(luftProfileScope, __LINE__)(name)
+#define LUFT_PROFILE_FUNCTION() LUFT_PROFILE_SCOPE(__FUNCTION__)
+#define LUFT_PROFILE_THREAD(name) ::Luft::Profiler::SetThreadName(name)
+#define LUFT_PROFILE_BEGIN_FRAME() ::Luft::Profiler::BeginFrame()
+#else
+#define LUFT_PROFILE_SCOPE(name)
+#define LUFT_PROFILE_FUNCTION()
+#define LUFT_PROFILE_THREAD(name)
+#define LUFT_PROFILE_BEGIN_FRAME()
+#endif
@@ -0,0 +1,741 @@
+#include "GlyphCache.h"
+
+#include <string.h>
+#include <math.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_ADVANCES_H
+#include <misc/freetype/imgui_freetype.h>
+
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	namespace
+	{
+		// the placeholder's U is CodepointBase + codepoint / CodepointScale, outside any texture so
+		// it can't be mistaken for a real glyph. Exact in a float for every codepoint
+		constexpr float CodepointBase = 2.0f;
+		constexpr float CodepointScale = 2097152.0f;
+
+		// the height glyphs are rendered at, and how far the distance field reaches out of and into
+		// them, in pixels. Sizes a few times either side of it still draw clean edges
+		constexpr float FieldSize = 24.0f;
+		constexpr uint32_t FieldSpread = 4;
+
+		// of the cache entries' layout, part of their key
+		constexpr uint32_t CacheVersion = 3;
+		constexpr uint32_t AtlasWidth = 1024;
+
+		// followed by the glyphs at the field size, placeholders included, and the atlas' pixels
+		struct CacheHeader
+		{
+			uint32_t Width;
+			uint32_t Height;
+			uint32_t GlyphCount;
+			uint32_t RegionX;
+			uint32_t RegionY;
+			uint32_t Rows;
+			uint32_t Pinned;
+			ImVec2 WhitePixel;
+		};
+
+		// Update stops rendering after this long, a page of new text fills in over a few frames
+		constexpr uint64_t RasterizeBudgetUs = 4000;
+
+		// Latin-1, and the two glyphs ImGui measures when it builds a font's lookup table
+		const ImWchar s_BakedRanges[] =
+		{
+			0x0020, 0x00FF,
+			0x2026, 0x2026, // ellipsis
+			0xFFFD, 0xFFFD, // fallback
+			0,
+		};
+		// all ImGui's own build rasterizes, for the white pixel and the layout of the atlas
+		const ImWchar s_SpaceRange[] = { 0x0020, 0x0020, 0 };
+
+		bool IsBaked(uint32_t codepoint)
+		{
+			for (const ImWchar* range = s_BakedRanges; range[0]; range += 2)
+				if (codepoint >= range[0] && codepoint <= range[1])
+					return true;
+			return false;
+		}
+
+		constexpr float Far = 1e20f;
+
+		// squared distance transform of one row or column in place, Felzenszwalb and Huttenlocher's
+		// lower envelope of parabolas. f, v and z hold length, length and length + 1 entries
+		void DistanceTransform1D(float* grid, size_t offset, size_t stride, uint32_t length, float* f, uint32_t* v, float* z)
+		{
+			v[0] = 0;
+			z[0] = -Far;
+			z[1] = Far;
+			f[0] = grid[offset];
+			for (uint32_t q = 1, k = 0; q < length; q++)
+			{
+				f[q] = grid[offset + q * stride];
+				// drop the parabolas q's hides, z[0] is below any intersection so one always stays
+				float s;
+				for (;;)
+				{
+					const uint32_t r = v[k];
+					s = (f[q] - f[r] + (float)(q * q) - (float)(r * r)) / (float)(q - r) / 2.0f;
+					if (s > z[k])
+						break;
+					k--;
+				}
+				k++;
+				v[k] = q;
+				z[k] = s;
+				z[k + 1] = Far;
+			}
+			for (uint32_t q = 0, k = 0; q < length; q++)
+			{
+				while (z[k + 1] < (float)q)
+					k++;
+				const float d = (float)q - (float)v[k];
+				grid[offset + q * stride] = f[v[k]] + d * d;
+			}
+		}
+
+		void DistanceTransform(float* grid, uint32_t width, uint32_t height, float* f, uint32_t* v, float* z)
+		{
+			for (uint32_t x = 0; x < width; x++)
+				DistanceTransform1D(grid, x, width, height, f, v, z);
+			for (uint32_t y = 0; y < height; y++)
+				DistanceTransform1D(grid, (size_t)y * width, 1, width, f, v, z);
+		}
+
+		void ScaleGlyph(const ImFontGlyph& src, ImFontGlyph& dst, float scale)
+		{
+			// UVs stay, placeholders keep their codepoint
+			dst = src;
+			dst.AdvanceX *= scale;
+			dst.X0 *= scale;
+			dst.Y0 *= scale;
+			dst.X1 *= scale;
+			dst.Y1 *= scale;
+		}
+	}
+
+	bool GlyphCache::Build(const lstr& fontPath, const float* sizes, uint32_t sizeCount, uint32_t cellCount, bool useCache)
+	{
+		VirtualFile font;
+		if (!VirtualFileSystem::Open(fontPath, font))
+		{
+			Shutdown();
+			CORE_LOG_ERROR("Can't open font {0}", fontPath.c_str());
+			return false;
+		}
+		return Prepare(std::move(font), fontPath, cellCount, useCache) && Finish(sizes, sizeCount);
+	}
+
+	bool GlyphCache::Prepare(VirtualFile&& font, const lstr& fontPath, uint32_t cellCount, bool useCache)
+	{
+		LUFT_PROFILE_FUNCTION();
+		Shutdown();
+		const uint64_t start = Profiler::Now();
+
+		m_FontPath = fontPath;
+		m_FontFile = std::move(font);
+		if (m_FontFile.Size() == 0)
+		{
+			CORE_LOG_ERROR("Font {0} is empty", fontPath.c_str());
+			Shutdown();
+			return false;
+		}
+		if (FT_Init_FreeType(&m_Library) != 0
+			|| FT_New_Memory_Face(m_Library, m_FontFile.Data(), (FT_Long)m_FontFile.Size(), 0, &m_Face) != 0
+			|| FT_Select_Charmap(m_Face, FT_ENCODING_UNICODE) != 0
+			|| !FT_IS_SCALABLE(m_Face) || m_Face->ascender <= m_Face->descender)
+		{
+			CORE_LOG_ERROR("{0} is not an outline font FreeType can read", fontPath.c_str());
+			Shutdown();
+			return false;
+		}
+		// the height imgui_freetype would request for a font of the field size
+		FT_Size_RequestRec request = {};
+		request.type = FT_SIZE_REQUEST_TYPE_REAL_DIM;
+		request.height = (FT_Long)(FieldSize * 64.0f);
+		FT_Request_Size(m_Face, &request);
+		// unrounded, so every size scales from the same baseline
+		m_Ascent = FieldSize * m_Face->ascender / (float)(m_Face->ascender - m_Face->descender);
+		m_Descent = m_Ascent - FieldSize;
+
+		// a cell holds a field the height of the font, its spread on each side and a pixel of
+		// padding around that
+		m_CellSize = (uint32_t)FieldSize + 2 * FieldSpread + 2;
+		// plain fields, set here since the cache key covers them
+		m_Atlas.FontBuilderIO = ImGuiFreeType::GetBuilderForFreeType();
+		m_Atlas.TexDesiredWidth = AtlasWidth;
+		// ImGui draws no software cursor here, and a cached atlas has no custom rects to find it in.
+		// Lines baked as coverage would be thresholded by the distance field shader, they're
+		// drawn as geometry instead. The cells decide the height, rounding it up would be wasted
+		m_Atlas.Flags |= ImFontAtlasFlags_NoMouseCursors | ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoPowerOfTwoHeight;
+		m_Columns = (AtlasWidth - m_Atlas.TexGlyphPadding) / m_CellSize;
+		// a cell for each Latin-1 glyph of the face, then the requested ones
+		uint32_t baked = 0;
+		for (const ImWchar* range = s_BakedRanges; range[0]; range += 2)
+			for (uint32_t c = range[0]; c <= range[1]; c++)
+				baked += FT_Get_Char_Index(m_Face, c) != 0;
+		m_Rows = baked + cellCount > 0 ? (baked + cellCount + m_Columns - 1) / m_Columns : 1;
+
+		m_UseCache = useCache;
+		if (useCache)
+			m_CacheKey = GetCacheKey();
+		m_Cached = useCache && LoadCache();
+		if (!m_Cached && !Bake())
+		{
+			CORE_LOG_ERROR("Can't build the font atlas for {0}", fontPath.c_str());
+			Shutdown();
+			return false;
+		}
+		m_Prepared = true;
+		m_BuildTicks = Profiler::Now() - start;
+		return true;
+	}
+
+	bool GlyphCache::Finish(const float* sizes, uint32_t sizeCount)
+	{
+		LUFT_PROFILE_FUNCTION();
+		const uint64_t start = Profiler::Now();
+		if (!m_Prepared)
+			return false;
+		m_Prepared = false;
+		if (sizeCount == 0)
+		{
+			CORE_LOG_ERROR("No font sizes to build {0} at", m_FontPath.c_str());
+			Shutdown();
+			return false;
+		}
+
+		// what AddFont leaves behind, ImGui's build only runs for an atlas that isn't cached
+		ImFontConfig config;
+		// the mapping outlives the atlas
+		config.FontDataOwnedByAtlas = false;
+		config.FontData = (void*)m_FontFile.Data();
+		config.FontDataSize = (int)m_FontFile.Size();
+		config.SizePixels = FieldSize;
+		config.GlyphRanges = s_SpaceRange;
+		if (m_Cached)
+		{
+			ImFont* font = IM_NEW(ImFont);
+			config.DstFont = font;
+			m_Atlas.ConfigData.push_back(config);
+			m_Atlas.Fonts.push_back(font);
+			m_Atlas.TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(m_Staged.size());
+			memcpy(m_Atlas.TexPixelsAlpha8, m_Staged.data(), m_Staged.size());
+			m_Atlas.TexReady = true;
+		}
+		else
+		{
+			if (!m_Atlas.AddFont(&config) || !PackAtlas())
+			{
+				CORE_LOG_ERROR("Can't build the font atlas for {0}", m_FontPath.c_str());
+				Shutdown();
+				return false;
+			}
+			if (m_UseCache)
+				SaveCache();
+		}
+		larray<uint8_t>().swap(m_Staged);
+		m_PinnedGlyphs.clear();
+
+		CreateFonts(sizes, sizeCount);
+		m_RegionUV0 = ImVec2((float)m_RegionX / m_Atlas.TexWidth, (float)m_RegionY / m_Atlas.TexHeight);
+		m_RegionUV1 = ImVec2((float)(m_RegionX + m_Columns * m_CellSize) / m_Atlas.TexWidth, (float)(m_RegionY + m_Rows * m_CellSize) / m_Atlas.TexHeight);
+
+		// the pinned cells stay out of the least recently used list
+		m_Cells.resize(m_Rows * m_Columns);
+		const int32_t first = (int32_t)m_Pinned;
+		for (int32_t i = first; i < (int32_t)m_Cells.size(); i++)
+		{
+			m_Cells[i].Prev = i > first ? i - 1 : None;
+			m_Cells[i].Next = i + 1 < (int32_t)m_Cells.size() ? i + 1 : None;
+		}
+		m_Head = first < (int32_t)m_Cells.size() ? first : None;
+		m_Tail = m_Head != None ? (int32_t)m_Cells.size() - 1 : None;
+
+		m_Dirty.clear();
+		m_Dirty.push_back({ 0, 0, (uint32_t)m_Atlas.TexWidth, (uint32_t)m_Atlas.TexHeight });
+		m_BuildTicks += Profiler::Now() - start;
+		CORE_LOG_INFO("Font {0}: {1} glyphs at {2} sizes, {3} of {4} {5}px cells pinned in a {6}x{7} distance field atlas, {8} in {9:.1f} ms",
+			m_FontPath.c_str(), m_Glyphs.size(), m_Fonts.size(), m_Pinned, m_Cells.size(), m_CellSize, m_Atlas.TexWidth, m_Atlas.TexHeight,
+			m_Cached ? "read from the cache" : "built", Profiler::TicksToMilliseconds(m_BuildTicks));
+		return true;
+	}
+
+	bool GlyphCache::Bake()
+	{
+		// a placeholder for every codepoint of the face, advances straight from the metrics tables
+		// without loading any outline
+		larray<FT_Fixed> advances;
+		advances.resize((size_t)m_Face->num_glyphs);
+		if (m_Face->num_glyphs > 0)
+			FT_Get_Advances(m_Face, 0, (FT_UInt)m_Face->num_glyphs, FT_LOAD_NO_HINTING, advances.data());
+		FT_UInt index = 0;
+		for (FT_ULong c = FT_Get_First_Char(m_Face, &index); index != 0; c = FT_Get_Next_Char(m_Face, c, &index))
+		{
+			if (c == 0 || c > IM_UNICODE_CODEPOINT_MAX)
+				continue;
+			if (m_Glyphs.size() >= 0xFFFE)
+			{
+				CORE_LOG_WRAN("The font has more glyphs than an ImGui font can index, the rest fall back");
+				break;
+			}
+			ImFontGlyph glyph = {};
+			glyph.Codepoint = (unsigned int)c;
+			glyph.AdvanceX = advances[index] / 65536.0f;
+			SetPlaceholder(glyph);
+			m_Glyphs.push_back(glyph);
+		}
+
+		// Latin-1 now, into the cells it keeps of a region the size of the reserved one. Where that
+		// lands in the atlas is up to ImGui's packing, Finish copies it there
+		const uint32_t stride = m_Columns * m_CellSize;
+		m_Staged.resize((size_t)stride * m_Rows * m_CellSize);
+		m_Pinned = 0;
+		for (uint32_t i = 0; i < (uint32_t)m_Glyphs.size(); i++)
+		{
+			ImFontGlyph& glyph = m_Glyphs[i];
+			if (!IsBaked(glyph.Codepoint))
+				continue;
+			if (!RenderField(glyph.Codepoint))
+			{
+				glyph.Visible = 0;
+				glyph.U0 = glyph.U1 = 0.0f;
+				continue;
+			}
+			CopyField(m_Staged.data(), stride, (m_Pinned % m_Columns) * m_CellSize, (m_Pinned / m_Columns) * m_CellSize, glyph);
+			m_PinnedGlyphs.push_back(i);
+			m_Pinned++;
+		}
+		return true;
+	}
+
+	bool GlyphCache::PackAtlas()
+	{
+		const int region = m_Atlas.AddCustomRectRegular((int)(m_Columns * m_CellSize), (int)(m_Rows * m_CellSize));
+		unsigned char* pixels = nullptr;
+		int width = 0, height = 0;
+		m_Atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+		if (!pixels)
+			return false;
+
+		const ImFontAtlasCustomRect* rect = m_Atlas.GetCustomRectByIndex(region);
+		m_RegionX = rect->X;
+		m_RegionY = rect->Y;
+		const uint32_t stride = m_Columns * m_CellSize;
+		for (uint32_t y = 0; y < m_Rows * m_CellSize; y++)
+			memcpy(pixels + (size_t)(m_RegionY + y) * width + m_RegionX, m_Staged.data() + (size_t)y * stride, stride);
+		for (uint32_t cell = 0; cell < m_Pinned; cell++)
+			SetCellUV((int32_t)cell, m_Glyphs[m_PinnedGlyphs[cell]]);
+		return true;
+	}
+
+	DerivedDataKey GlyphCache::GetCacheKey() const
+	{
+		DerivedDataKey key("GlyphCache", CacheVersion);
+		key.Add(m_FontFile.Data(), m_FontFile.Size());
+
+		// everything else that decides the atlas' pixels and glyphs
+		const uint32_t params[] =
+		{
+			m_Rows, m_CellSize, FieldSpread, AtlasWidth, (uint32_t)m_Atlas.Flags, (uint32_t)m_Atlas.TexGlyphPadding,
+			IMGUI_VERSION_NUM, (uint32_t)sizeof(ImFontGlyph), FREETYPE_MAJOR, FREETYPE_MINOR, FREETYPE_PATCH,
+		};
+		key.Add(params, sizeof(params));
+		key.AddValue(FieldSize);
+		key.Add(s_BakedRanges, sizeof(s_BakedRanges));
+		return key;
+	}
+
+	bool GlyphCache::LoadCache()
+	{
+		DerivedData entry;
+		if (!DerivedDataCache::Get(m_CacheKey, entry))
+			return false;
+		CacheHeader header;
+		if (entry.Size() < sizeof(header))
+			return false;
+		memcpy(&header, entry.Data(), sizeof(header));
+		const size_t glyphBytes = (size_t)header.GlyphCount * sizeof(ImFontGlyph);
+		const size_t pixelBytes = (size_t)header.Width * header.Height;
+		if (header.GlyphCount == 0 || header.Rows != m_Rows || header.Pinned > m_Rows * m_Columns || entry.Size() != sizeof(header) + glyphBytes + pixelBytes)
+		{
+			CORE_LOG_WRAN("The cached font atlas {0} doesn't fit, rebuilding it", m_CacheKey.ToString().c_str());
+			return false;
+		}
+
+		m_Glyphs.resize(header.GlyphCount);
+		memcpy(m_Glyphs.data(), entry.Data() + sizeof(header), glyphBytes);
+		// Finish hands the pixels to the atlas, through ImGui's allocator
+		m_Staged.resize(pixelBytes);
+		memcpy(m_Staged.data(), entry.Data() + sizeof(header) + glyphBytes, pixelBytes);
+
+		m_Atlas.TexWidth = (int)header.Width;
+		m_Atlas.TexHeight = (int)header.Height;
+		m_Atlas.TexUvScale = ImVec2(1.0f / header.Width, 1.0f / header.Height);
+		m_Atlas.TexUvWhitePixel = header.WhitePixel;
+		m_RegionX = header.RegionX;
+		m_RegionY = header.RegionY;
+		m_Pinned = header.Pinned;
+		return true;
+	}
+
+	void GlyphCache::SaveCache() const
+	{
+		CacheHeader header = {};
+		header.Width = (uint32_t)m_Atlas.TexWidth;
+		header.Height = (uint32_t)m_Atlas.TexHeight;
+		header.GlyphCount = (uint32_t)m_Glyphs.size();
+		header.RegionX = m_RegionX;
+		header.RegionY = m_RegionY;
+		header.Rows = m_Rows;
+		header.Pinned = m_Pinned;
+		header.WhitePixel = m_Atlas.TexUvWhitePixel;
+
+		larray<uint8_t> bytes;
+		bytes.append((const uint8_t*)&header, sizeof(header));
+		bytes.append((const uint8_t*)m_Glyphs.data(), m_Glyphs.size() * sizeof(ImFontGlyph));
+		bytes.append(m_Atlas.TexPixelsAlpha8, (size_t)m_Atlas.TexWidth * m_Atlas.TexHeight);
+		DerivedDataCache::Put(m_CacheKey, bytes.data(), bytes.size());
+	}
+
+	void GlyphCache::CreateFonts(const float* sizes, uint32_t sizeCount)
+	{
+		// the atlas' one font is the first size, the others share its config. ImGui's build skips
+		// setting up a font it found no glyphs for, a face without a space leaves it bare
+		m_Sizes.clear();
+		m_Sizes.append(sizes, sizeCount);
+		for (uint32_t i = (uint32_t)m_Atlas.Fonts.Size; i < sizeCount; i++)
+			m_Atlas.Fonts.push_back(IM_NEW(ImFont));
+		m_Fonts.clear();
+		m_Fonts.append(m_Atlas.Fonts.Data, sizeCount);
+		for (ImFont* font : m_Fonts)
+		{
+			font->ContainerAtlas = &m_Atlas;
+			font->ConfigData = &m_Atlas.ConfigData[0];
+			font->ConfigDataCount = 1;
+		}
+		SetScale(m_Scale);
+	}
+
+	void GlyphCache::SetScale(float scale)
+	{
+		LUFT_PROFILE_FUNCTION();
+		m_Scale = scale;
+		for (size_t i = 0; i < m_Fonts.size(); i++)
+		{
+			ImFont* font = m_Fonts[i];
+			const float size = m_Sizes[i] * scale;
+			const float factor = size / FieldSize;
+			font->FontSize = size;
+			font->Ascent = m_Ascent * factor;
+			font->Descent = m_Descent * factor;
+			font->Glyphs.resize((int)m_Glyphs.size());
+			for (int g = 0; g < (int)m_Glyphs.size(); g++)
+				ScaleGlyph(m_Glyphs[g], font->Glyphs[g], factor);
+			// found again, it may be the three dots whose width changed
+			font->EllipsisChar = (ImWchar)-1;
+			font->BuildLookupTable();
+		}
+	}
+
+	void GlyphCache::SyncGlyph(uint32_t glyph)
+	{
+		for (size_t i = 0; i < m_Fonts.size(); i++)
+			ScaleGlyph(m_Glyphs[glyph], m_Fonts[i]->Glyphs[glyph], m_Fonts[i]->FontSize / FieldSize);
+	}
+
+	void GlyphCache::Shutdown()
+	{
+		m_Atlas.Clear();
+		m_Fonts.clear();
+		m_Sizes.clear();
+		m_Glyphs.clear();
+		m_Prepared = false;
+		m_Cached = false;
+		larray<uint8_t>().swap(m_Staged);
+		m_PinnedGlyphs.clear();
+		if (m_Face)
+			FT_Done_Face(m_Face);
+		m_Face = nullptr;
+		if (m_Library)
+			FT_Done_FreeType(m_Library);
+		m_Library = nullptr;
+		m_FontFile.Close();
+
+		m_Cells.clear();
+		m_Pinned = 0;
+		m_Head = m_Tail = None;
+		m_Resident = 0;
+		m_ReportedFull = false;
+		m_Requests.clear();
+		m_Dirty.clear();
+	}
+
+	void GlyphCache::SetPlaceholder(ImFontGlyph& glyph)
+	{
+		// no area, so nothing is drawn, but tall enough to survive ImGui's clipping
+		glyph.X0 = glyph.X1 = 0.0f;
+		glyph.Y0 = 0.0f;
+		glyph.Y1 = FieldSize;
+		glyph.U0 = glyph.U1 = CodepointBase + glyph.Codepoint / CodepointScale;
+		glyph.V0 = glyph.V1 = 0.0f;
+		glyph.Visible = 1;
+	}
+
+	void GlyphCache::Update()
+	{
+		LUFT_PROFILE_FUNCTION();
+		if (m_Fonts.empty() || m_Cells.empty())
+			return;
+		m_Frame++;
+
+		// every cell drawn from this frame is marked before any is reused. All sizes share the cells,
+		// a request from any of them renders the glyph for every one
+		m_Requests.clear();
+		for (ImGuiViewport* viewport : ImGui::GetPlatformIO().Viewports)
+		{
+			const ImDrawData* drawData = viewport->DrawData;
+			if (!drawData)
+				continue;
+			for (const ImDrawList* list : drawData->CmdLists)
+				ScanDrawList(list);
+		}
+
+		const uint64_t start = Profiler::Now();
+		const uint64_t budget = Profiler::MicrosecondsToTicks(RasterizeBudgetUs);
+		for (uint32_t codepoint : m_Requests)
+		{
+			const ImFontGlyph* glyph = m_Fonts[0]->FindGlyphNoFallback((ImWchar)codepoint);
+			// requested by more than one quad
+			if (!glyph || glyph->U0 < CodepointBase)
+				continue;
+			if (!Rasterize(codepoint) || Profiler::Now() - start > budget)
+				break;
+		}
+	}
+
+	void GlyphCache::ScanDrawList(const ImDrawList* list)
+	{
+		const ImTextureID texture = m_Atlas.TexID;
+		const auto visit = [this](const ImDrawVert& v)
+		{
+			if (v.uv.x >= CodepointBase)
+			{
+				m_Requests.push_back((uint32_t)((v.uv.x - CodepointBase) * CodepointScale + 0.5f));
+			}
+			else if (v.uv.x >= m_RegionUV0.x && v.uv.x < m_RegionUV1.x && v.uv.y >= m_RegionUV0.y && v.uv.y < m_RegionUV1.y)
+			{
+				// a glyph stays a pixel inside its cell, so every corner lands in the same one
+				const uint32_t x = (uint32_t)(v.uv.x * m_Atlas.TexWidth) - m_RegionX;
+				const uint32_t y = (uint32_t)(v.uv.y * m_Atlas.TexHeight) - m_RegionY;
+				Touch((int32_t)((y / m_CellSize) * m_Columns + x / m_CellSize));
+			}
+		};
+
+		bool allAtlas = true;
+		for (const ImDrawCmd& cmd : list->CmdBuffer)
+			allAtlas &= cmd.UserCallback != nullptr || cmd.TextureId == texture;
+		if (allAtlas)
+		{
+			for (const ImDrawVert& v : list->VtxBuffer)
+				visit(v);
+			return;
+		}
+
+		// images may use any UVs, only look at what's drawn with the atlas
+		for (const ImDrawCmd& cmd : list->CmdBuffer)
+		{
+			if (cmd.UserCallback != nullptr || cmd.TextureId != texture)
+				continue;
+			for (unsigned int i = 0; i < cmd.ElemCount; i++)
+				visit(list->VtxBuffer[cmd.VtxOffset + list->IdxBuffer[cmd.IdxOffset + i]]);
+		}
+	}
+
+	void GlyphCache::Touch(int32_t cell)
+	{
+		if (cell < (int32_t)m_Pinned || cell >= (int32_t)m_Cells.size() || m_Cells[cell].LastUsed == m_Frame)
+			return;
+		m_Cells[cell].LastUsed = m_Frame;
+		Unlink(cell);
+		PushFront(cell);
+	}
+
+	void GlyphCache::Unlink(int32_t cell)
+	{
+		Cell& c = m_Cells[cell];
+		if (c.Prev != None)
+			m_Cells[c.Prev].Next = c.Next;
+		else
+			m_Head = c.Next;
+		if (c.Next != None)
+			m_Cells[c.Next].Prev = c.Prev;
+		else
+			m_Tail = c.Prev;
+		c.Prev = c.Next = None;
+	}
+
+	void GlyphCache::PushFront(int32_t cell)
+	{
+		Cell& c = m_Cells[cell];
+		c.Next = m_Head;
+		if (m_Head != None)
+			m_Cells[m_Head].Prev = cell;
+		m_Head = cell;
+		if (m_Tail == None)
+			m_Tail = cell;
+	}
+
+	bool GlyphCache::Rasterize(uint32_t codepoint)
+	{
+		// the fonts' glyphs are in the same order as m_Glyphs
+		const uint32_t index = (uint32_t)(m_Fonts[0]->FindGlyphNoFallback((ImWchar)codepoint) - m_Fonts[0]->Glyphs.Data);
+		ImFontGlyph& glyph = m_Glyphs[index];
+		if (!RenderField(codepoint))
+		{
+			// drawn as nothing from now on rather than asked for every frame. Blank glyphs, e.g. the
+			// ideographic space, need no cell either
+			glyph.Visible = 0;
+			glyph.U0 = glyph.U1 = 0.0f;
+			SyncGlyph(index);
+			return true;
+		}
+
+		// the least recently drawn cell, if this frame didn't draw from it
+		const int32_t cell = m_Tail;
+		if (cell == None)
+			return false;
+		Cell& c = m_Cells[cell];
+		if (c.LastUsed == m_Frame)
+		{
+			if (!m_ReportedFull)
+				CORE_LOG_WRAN("Glyph cache: all {0} cells are drawn from in one frame, some text stays blank", m_Cells.size() - m_Pinned);
+			m_ReportedFull = true;
+			return false;
+		}
+		if (c.Codepoint != 0)
+		{
+			SetPlaceholder(m_Glyphs[c.Glyph]);
+			SyncGlyph((uint32_t)c.Glyph);
+			m_Evictions++;
+		}
+		else
+			m_Resident++;
+		c.Codepoint = codepoint;
+		c.Glyph = (int32_t)index;
+		c.LastUsed = m_Frame;
+		Unlink(cell);
+		PushFront(cell);
+
+		StoreField(cell, glyph);
+		SyncGlyph(index);
+		return true;
+	}
+
+	bool GlyphCache::RenderField(uint32_t codepoint)
+	{
+		// unhinted, the field is scaled to every size
+		const FT_UInt index = FT_Get_Char_Index(m_Face, codepoint);
+		if (index == 0 || FT_Load_Glyph(m_Face, index, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING) != 0
+			|| FT_Render_Glyph(m_Face->glyph, FT_RENDER_MODE_NORMAL) != 0)
+			return false;
+		const FT_Bitmap& bitmap = m_Face->glyph->bitmap;
+		if (bitmap.width == 0 || bitmap.rows == 0 || bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+			return false;
+
+		// the distance field of the coverage, the way TinySDF makes it: squared distances to the
+		// nearest pixel outside and inside, partly covered pixels a fraction of a pixel from the
+		// edge, transformed in two passes. FreeType's own SDF renderers take a hundred times longer
+		const uint32_t width = bitmap.width + 2 * FieldSpread;
+		const uint32_t height = bitmap.rows + 2 * FieldSpread;
+		const size_t count = (size_t)width * height;
+		m_Outside.resize(count);
+		m_Inside.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			m_Outside[i] = Far;
+			m_Inside[i] = 0.0f;
+		}
+		for (uint32_t y = 0; y < bitmap.rows; y++)
+		{
+			const uint8_t* row = bitmap.buffer + (ptrdiff_t)y * bitmap.pitch;
+			for (uint32_t x = 0; x < bitmap.width; x++)
+			{
+				const float a = row[x] / 255.0f;
+				if (a == 0.0f)
+					continue;
+				const size_t i = (size_t)(y + FieldSpread) * width + x + FieldSpread;
+				const float outside = 0.5f - a > 0.0f ? 0.5f - a : 0.0f;
+				const float inside = a - 0.5f > 0.0f ? a - 0.5f : 0.0f;
+				m_Outside[i] = a == 1.0f ? 0.0f : outside * outside;
+				m_Inside[i] = a == 1.0f ? Far : inside * inside;
+			}
+		}
+		const uint32_t longest = width > height ? width : height;
+		m_EnvelopeF.resize(longest);
+		m_EnvelopeV.resize(longest);
+		m_EnvelopeZ.resize(longest + 1);
+		DistanceTransform(m_Outside.data(), width, height, m_EnvelopeF.data(), m_EnvelopeV.data(), m_EnvelopeZ.data());
+		DistanceTransform(m_Inside.data(), width, height, m_EnvelopeF.data(), m_EnvelopeV.data(), m_EnvelopeZ.data());
+
+		// the edge at 128, FieldSpread pixels out at 0
+		m_Field.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const float d = sqrtf(m_Outside[i]) - sqrtf(m_Inside[i]);
+			const float value = 128.0f - d * (128.0f / FieldSpread);
+			m_Field[i] = (uint8_t)(value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value + 0.5f);
+		}
+		m_FieldWidth = width;
+		m_FieldHeight = height;
+		m_FieldLeft = m_Face->glyph->bitmap_left - (int32_t)FieldSpread;
+		m_FieldTop = m_Face->glyph->bitmap_top + (int32_t)FieldSpread;
+		return true;
+	}
+
+	void GlyphCache::CopyField(uint8_t* pixels, uint32_t stride, uint32_t x, uint32_t y, ImFontGlyph& glyph)
+	{
+		// clipped to the cell, past the font's height only for unusual glyphs
+		const uint32_t width = m_FieldWidth < m_CellSize - 2 ? m_FieldWidth : m_CellSize - 2;
+		const uint32_t height = m_FieldHeight < m_CellSize - 2 ? m_FieldHeight : m_CellSize - 2;
+		for (uint32_t row = 0; row < m_CellSize; row++)
+			memset(pixels + (size_t)(y + row) * stride + x, 0, m_CellSize);
+		for (uint32_t row = 0; row < height; row++)
+			memcpy(pixels + (size_t)(y + 1 + row) * stride + x + 1, m_Field.data() + (size_t)row * m_FieldWidth, width);
+
+		// the field reaches the spread past the outline, and so does the quad
+		glyph.X0 = (float)m_FieldLeft;
+		glyph.Y0 = m_Ascent - (float)m_FieldTop;
+		glyph.X1 = glyph.X0 + width;
+		glyph.Y1 = glyph.Y0 + height;
+		glyph.Visible = 1;
+	}
+
+	void GlyphCache::SetCellUV(int32_t cell, ImFontGlyph& glyph) const
+	{
+		const uint32_t cellX = m_RegionX + (cell % m_Columns) * m_CellSize;
+		const uint32_t cellY = m_RegionY + (cell / m_Columns) * m_CellSize;
+		const float texWidth = (float)m_Atlas.TexWidth;
+		const float texHeight = (float)m_Atlas.TexHeight;
+		glyph.U0 = (cellX + 1) / texWidth;
+		glyph.V0 = (cellY + 1) / texHeight;
+		glyph.U1 = (cellX + 1 + (glyph.X1 - glyph.X0)) / texWidth;
+		glyph.V1 = (cellY + 1 + (glyph.Y1 - glyph.Y0)) / texHeight;
+	}
+
+	void GlyphCache::StoreField(int32_t cell, ImFontGlyph& glyph)
+	{
+		const uint32_t cellX = m_RegionX + (cell % m_Columns) * m_CellSize;
+		const uint32_t cellY = m_RegionY + (cell / m_Columns) * m_CellSize;
+		CopyField(m_Atlas.TexPixelsAlpha8, (uint32_t)m_Atlas.TexWidth, cellX, cellY, glyph);
+		SetCellUV(cell, glyph);
+		m_Dirty.push_back({ cellX, cellY, m_CellSize, m_CellSize });
+	}
+
+}
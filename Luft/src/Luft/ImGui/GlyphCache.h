@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stdint.h>
+#include <imgui.h>
+#include "Luft/Core/Base.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Core/DerivedDataCache.h"
+#include "Luft/Core/VirtualFileSystem.h"
+
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_* FT_Face;
+
+namespace Luft {
+
+	// part of the atlas changed since the renderer last uploaded it, in pixels
+	struct GlyphCacheRect
+	{
+		uint32_t X;
+		uint32_t Y;
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	// ImGui's font atlas holding signed distance fields of the glyphs, rendered once by FreeType at a
+	// fixed field size and drawn at any size by the renderer's distance field shader, so every font
+	// size and display scale shares one atlas. Each size is an ImFont whose metrics are the field's
+	// scaled, and changing the scale touches no pixels.
+	// Latin-1 is rendered by Build into cells kept for good. Every other codepoint the face has gets a
+	// placeholder glyph with its real advance, so layout is final from the first frame, drawn as an
+	// empty quad whose U coordinate carries the codepoint. Update() finds those quads in the frame's
+	// draw data, renders them into fixed-size cells of a region reserved in the atlas and points the
+	// glyphs there, in every font at once. When the region is full, the cell drawn from longest ago
+	// is reused and its glyph is a placeholder again. A glyph shows from the frame after it was first
+	// drawn.
+	// The built atlas and the glyphs' field metrics can be kept in the DerivedDataCache, keyed by the
+	// font file and the build parameters, which turns startup into one read of an entry.
+	// Every ImGui allocation is recorded in the current context, so building is split for other
+	// threads: Prepare reads the face and renders the fields without touching ImGui, Finish makes
+	// the atlas and fonts from them where the context lives.
+	class LUFT_API GlyphCache
+	{
+	public:
+		GlyphCache() = default;
+		~GlyphCache() { Shutdown(); }
+
+		GlyphCache(const GlyphCache&) = delete;
+		GlyphCache& operator=(const GlyphCache&) = delete;
+
+		// builds the atlas with room for at least cellCount glyphs beside the Latin-1 ones, and a font
+		// for each of the sizes in pixels, the font opened through the VirtualFileSystem. With useCache
+		// the atlas and glyph metrics come from the DerivedDataCache when it has them for the same
+		// font file and parameters, and are put there otherwise. The sizes aren't part of that, any
+		// set of them reads the same entry
+		bool Build(const lstr& fontPath, const float* sizes, uint32_t sizeCount, uint32_t cellCount, bool useCache = false);
+		// Build's first half with the font file already read, e.g. by the AssetStreamer. The path
+		// only names it in the log. Safe on any thread for a cache that wasn't finished before, it
+		// makes no ImGui allocation
+		bool Prepare(VirtualFile&& font, const lstr& fontPath, uint32_t cellCount, bool useCache = false);
+		// the second half, on the thread of the ImGui context, after Prepare succeeded
+		bool Finish(const float* sizes, uint32_t sizeCount);
+		void Shutdown();
+
+		// to be io.Fonts, so it's owned here
+		ImFontAtlas* GetAtlas() { return &m_Atlas; }
+		// in the order of Build's sizes
+		ImFont* GetFont(uint32_t index = 0) const { return index < m_Fonts.size() ? m_Fonts[index] : nullptr; }
+
+		// every font becomes its size times scale, e.g. on a display scale change. Not between
+		// ImGui::NewFrame and ImGui::Render, the atlas is locked then
+		void SetScale(float scale);
+		float GetScale() const { return m_Scale; }
+
+		// after ImGui::Render, with every viewport's draw data final. Rasterizes the requested
+		// glyphs for a few milliseconds at most, the rest are requested again next frame
+		void Update();
+
+		// the distance field, one byte per pixel with the outline at 128
+		const uint8_t* GetPixels() const { return m_Atlas.TexPixelsAlpha8; }
+		uint32_t GetWidth() const { return (uint32_t)m_Atlas.TexWidth; }
+		uint32_t GetHeight() const { return (uint32_t)m_Atlas.TexHeight; }
+		// everything on the first call after Build, then the cells Update wrote
+		const larray<GlyphCacheRect>& GetDirtyRects() const { return m_Dirty; }
+		void ClearDirtyRects() { m_Dirty.clear(); }
+
+		uint32_t GetCellCount() const { return (uint32_t)m_Cells.size(); }
+		uint32_t GetResidentCount() const { return m_Resident; }
+		uint64_t GetEvictionCount() const { return m_Evictions; }
+
+	private:
+		static constexpr int32_t None = -1;
+
+		struct Cell
+		{
+			// 0 while free
+			uint32_t Codepoint = 0;
+			int32_t Glyph = None;
+			uint64_t LastUsed = 0;
+			// least recently used list, m_Head is the most recent
+			int32_t Prev = None;
+			int32_t Next = None;
+		};
+
+		bool Bake();
+		bool PackAtlas();
+		DerivedDataKey GetCacheKey() const;
+		bool LoadCache();
+		void SaveCache() const;
+		void CreateFonts(const float* sizes, uint32_t sizeCount);
+		void SyncGlyph(uint32_t glyph);
+		void ScanDrawList(const ImDrawList* list);
+		void Touch(int32_t cell);
+		void Unlink(int32_t cell);
+		void PushFront(int32_t cell);
+		bool Rasterize(uint32_t codepoint);
+		bool RenderField(uint32_t codepoint);
+		void CopyField(uint8_t* pixels, uint32_t stride, uint32_t x, uint32_t y, ImFontGlyph& glyph);
+		void SetCellUV(int32_t cell, ImFontGlyph& glyph) const;
+		void StoreField(int32_t cell, ImFontGlyph& glyph);
+		void SetPlaceholder(ImFontGlyph& glyph);
+
+		ImFontAtlas m_Atlas;
+		VirtualFile m_FontFile;
+		lstr m_FontPath;
+		FT_Library m_Library = nullptr;
+		FT_Face m_Face = nullptr;
+
+		// what Prepare leaves for Finish: the atlas' pixels when they came from the cache, only the
+		// reserved region's otherwise, with the glyphs of the pinned cells in cell order
+		bool m_Prepared = false;
+		bool m_Cached = false;
+		bool m_UseCache = false;
+		DerivedDataKey m_CacheKey{ "GlyphCache", 0 };
+		larray<uint8_t> m_Staged;
+		larray<uint32_t> m_PinnedGlyphs;
+		uint64_t m_BuildTicks = 0;
+
+		// every glyph at the field size, the fonts' are these scaled and in the same order
+		larray<ImFontGlyph> m_Glyphs;
+		float m_Ascent = 0.0f;
+		float m_Descent = 0.0f;
+		larray<ImFont*> m_Fonts;
+		larray<float> m_Sizes;
+		float m_Scale = 1.0f;
+
+		// the reserved region, in pixels and in UVs
+		uint32_t m_RegionX = 0;
+		uint32_t m_RegionY = 0;
+		uint32_t m_CellSize = 0;
+		uint32_t m_Columns = 0;
+		uint32_t m_Rows = 0;
+		ImVec2 m_RegionUV0;
+		ImVec2 m_RegionUV1;
+
+		// the first m_Pinned cells hold Latin-1 and are never reused
+		larray<Cell> m_Cells;
+		uint32_t m_Pinned = 0;
+		int32_t m_Head = None;
+		int32_t m_Tail = None;
+		uint32_t m_Resident = 0;
+		uint64_t m_Evictions = 0;
+		uint64_t m_Frame = 0;
+		bool m_ReportedFull = false;
+
+		// RenderField's output and scratch
+		larray<uint8_t> m_Field;
+		uint32_t m_FieldWidth = 0;
+		uint32_t m_FieldHeight = 0;
+		int32_t m_FieldLeft = 0;
+		int32_t m_FieldTop = 0;
+		larray<float> m_Outside;
+		larray<float> m_Inside;
+		larray<float> m_EnvelopeF;
+		larray<uint32_t> m_EnvelopeV;
+		larray<float> m_EnvelopeZ;
+
+		larray<uint32_t> m_Requests;
+		larray<GlyphCacheRect> m_Dirty;
+	};
+
+}
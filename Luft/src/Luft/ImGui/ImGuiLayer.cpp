@@ -1,5 +1,8 @@
 #include "ImGuiLayer.h"
 
+#include <string.h>
+#include <chrono>
+#include <algorithm>
 #include <imgui.h>
 #include <imgui_internal.h>
 
@@ -10,7 +13,10 @@
 
 #include "Luft/Core/Application.h"
 #include "Luft/Core/Log.h"
+#include "Luft/Core/Memory.h"
 #include "Luft/Core/SystemService.h"
+#include "Luft/Debug/Profiler.h"
+#include "Luft/Debug/FrameStats.h"
 #include <SDL_vulkan.h>
 
 
@@ -21,11 +27,102 @@ namespace Luft {
 	{
 	}
 
+	static void* ImGuiMemAlloc(size_t size, void* userData)
+	{
+		return Memory::Allocate(size, MemoryTag::ImGui);
+	}
+
+	static void ImGuiMemFree(void* ptr, void* userData)
+	{
+		Memory::Free(ptr);
+	}
+
+	// four independent lanes keep the multiplies overlapped, the editor's whole draw data is hashed
+	// every frame
+	static uint64_t HashBytes(uint64_t seed, const void* data, size_t bytes)
+	{
+		constexpr uint64_t K = 0x9E3779B97F4A7C15ull;
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		uint64_t lanes[4] = { seed ^ bytes, seed + K, seed ^ (K >> 17), seed - K };
+		for (; bytes >= 32; p += 32, bytes -= 32)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				uint64_t word;
+				memcpy(&word, p + i * 8, 8);
+				lanes[i] = (lanes[i] ^ word) * K;
+				lanes[i] ^= lanes[i] >> 29;
+			}
+		}
+		uint64_t hash = lanes[0];
+		for (int i = 1; i < 4; i++)
+		{
+			hash = (hash ^ lanes[i]) * K;
+			hash ^= hash >> 29;
+		}
+		for (; bytes > 0; p++, bytes--)
+			hash = (hash ^ *p) * 1099511628211ull;
+		return hash;
+	}
+
+	// of everything every viewport would draw: geometry, textures, clip rects and sizes. Equal
+	// hashes mean the same pixels
+	static uint64_t HashDrawData()
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		uint64_t hash = 0;
+		const ImGuiPlatformIO& platformIO = ImGui::GetPlatformIO();
+		for (const ImGuiViewport* viewport : platformIO.Viewports)
+		{
+			const ImDrawData* drawData = viewport->DrawData;
+			if (!drawData || !drawData->Valid)
+				continue;
+			const float frame[] = { drawData->DisplayPos.x, drawData->DisplayPos.y, drawData->DisplaySize.x, drawData->DisplaySize.y,
+				drawData->FramebufferScale.x, drawData->FramebufferScale.y };
+			hash = HashBytes(hash ^ viewport->ID, frame, sizeof(frame));
+			for (const ImDrawList* list : drawData->CmdLists)
+			{
+				hash = HashBytes(hash, list->VtxBuffer.Data, list->VtxBuffer.size_in_bytes());
+				hash = HashBytes(hash, list->IdxBuffer.Data, list->IdxBuffer.size_in_bytes());
+				// field by field, ImDrawCmd has padding
+				for (const ImDrawCmd& cmd : list->CmdBuffer)
+				{
+					const uint64_t fields[] = { (uint64_t)(uintptr_t)cmd.TextureId, (uint64_t)(uintptr_t)cmd.UserCallback,
+						((uint64_t)cmd.VtxOffset << 32) | cmd.IdxOffset, cmd.ElemCount };
+					hash = HashBytes(hash, &cmd.ClipRect, sizeof(cmd.ClipRect));
+					hash = HashBytes(hash, fields, sizeof(fields));
+				}
+			}
+		}
+		return hash;
+	}
+
+	static bool CheckVkResult(VkResult err, const char* what)
+	{
+		if (err == VK_SUCCESS)
+			return true;
+		CORE_LOG_ERROR("[vulkan] {0} failed: VkResult = {1}", what, (int)err);
+		return false;
+	}
+
 	void ImGuiLayer::OnAttach()
 	{
 		// === Setup Dear ImGui context ===
 		IMGUI_CHECKVERSION();
-		ImGui::CreateContext();
+		// must be set before the context exists, every ImGui allocation is charged to MemoryTag::ImGui
+		ImGui::SetAllocatorFunctions(ImGuiMemAlloc, ImGuiMemFree);
+		// frames start with ImGui's default font. The glyph cache, one distance field atlas for every
+		// UIFont size, is prepared on a decode thread, finished here and becomes io.Fonts once it's there
+		ImGui::CreateContext(&m_PlaceholderAtlas);
+		m_RenderOnChange = Application::Get().GetSpecification().RenderOnChange;
+		LoadFont(AssetPriority::Immediate);
+		VirtualFileLocation fontLocation;
+		if (FileWatcher::IsRunning() && VirtualFileSystem::Locate(GetResVal(ResKey::font_path_puhui3), fontLocation))
+		{
+			m_FontWatch = FileWatcher::Watch(fontLocation.FilePath, nullptr,
+				[this](const larray<lstr>&, const Ref<void>&) { LoadFont(AssetPriority::High); });
+		}
 		ImGuiIO& io = ImGui::GetIO(); (void)io;
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
 		//io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
@@ -33,11 +130,10 @@ namespace Luft {
 		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
 		//io.ConfigFlags |= ImGuiConfigFlags_ViewportsNoTaskBarIcons;
 		//io.ConfigFlags |= ImGuiConfigFlags_ViewportsNoMerge;
-
-		float fontSize = GetIntVal(IntKey::font_size_normal).value();
-		auto font = GetResVal(ResKey::font_path_puhui3);
-		io.Fonts->AddFontFromFileTTF(font.value(), fontSize);
-		io.FontDefault = io.Fonts->AddFontFromFileTTF(font.value(), fontSize);
+		// there's no platform backend to spawn viewport windows
+		Window& window = Application::Get().GetWindow();
+		if (window.IsHeadless())
+			io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
 
 		// === Setup Dear ImGui style ===
 		// TODO:Add Window Shadow Support
@@ -53,25 +149,192 @@ namespace Luft {
 			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
 		}
 
+		if (window.IsHeadless())
+			HeadlessInit(static_cast<HeadlessWindow*>(&window));
 #ifdef LUFT_RENDERER_BACKEND_VULKAN
-		SDL2Init4Vulkan();
+		else
+			SDL2Init4Vulkan();
 #endif // LUFT_RENDERER_BACKEND_VULKAN
 
+		// shown from the Debug menu
+		m_SceneViewport.Open() = false;
+		AddViewport(&m_SceneViewport);
 	}
 
 	void ImGuiLayer::OnDetach()
 	{
+		FileWatcher::Unwatch(m_FontWatch);
+		m_FontWatch = FileWatchHandle();
+		AssetStreamer::Release(m_FontAsset);
+		m_FontAsset = AssetHandle();
 #ifdef LUFT_RENDERER_BACKEND_VULKAN
-		ImGui_ImplVulkan_Shutdown();
+		if (m_RenderPath != RenderPath::Null)
+		{
+			// frames still in flight sample the glyph atlas
+			Window& window = Application::Get().GetWindow();
+			vkDeviceWaitIdle(m_RenderPath == RenderPath::Swapchain ? static_cast<WindowsWindow*>(&window)->GetDevice() : static_cast<HeadlessWindow*>(&window)->GetDevice());
+			for (ViewportPanel* panel : m_Viewports)
+				panel->Shutdown();
+			m_Viewports.clear();
+			m_GlyphTexture.Shutdown();
+			ImGui_ImplVulkan_Shutdown();
+		}
 #endif
-		ImGui_ImplSDL2_Shutdown();
+		if (m_RenderPath == RenderPath::Swapchain)
+			ImGui_ImplSDL2_Shutdown();
 		ImGui::DestroyContext();
+		m_GlyphCache.reset();
+
+#ifdef LUFT_RENDERER_BACKEND_VULKAN
+		// the swapchain goes with the window
+		if (m_RenderPath == RenderPath::Offscreen)
+			CleanupOffscreenVulkan();
+		m_GpuTimer.Shutdown();
+#endif
+	}
+
+	void ImGuiLayer::LoadFont(AssetPriority priority)
+	{
+		// a reload still being built is superseded
+		AssetStreamer::Release(m_FontAsset);
+		const lstr fontPath = GetResVal(ResKey::font_path_puhui3);
+		const float fontSizes[] =
+		{
+			(float)GetIntVal(IntKey::font_size_normal),
+			(float)GetIntVal(IntKey::font_size_title),
+			(float)GetIntVal(IntKey::font_size_max),
+		};
+		m_FontAsset = AssetStreamer::Load(fontPath, priority,
+			[fontPath](larray<uint8_t>& bytes, Ref<void>& asset)
+			{
+				VirtualFile font;
+				font.Adopt(bytes);
+				Ref<GlyphCache> cache = CreateRef<GlyphCache>();
+				if (!cache->Prepare(std::move(font), fontPath, GlyphCacheCells, true))
+					return false;
+				asset = cache;
+				return true;
+			},
+			[this, fontSizes](AssetHandle, const Ref<void>& asset)
+			{
+				// the atlas and fonts are ImGui allocations, made here on the main thread
+				Ref<GlyphCache> cache = std::static_pointer_cast<GlyphCache>(asset);
+				if (cache->Finish(fontSizes, (uint32_t)UIFont::Count))
+					OnFontLoaded(cache);
+			});
+	}
+
+	void ImGuiLayer::OnFontLoaded(const Ref<GlyphCache>& cache)
+	{
+#ifdef LUFT_RENDERER_BACKEND_VULKAN
+		if (m_GlyphCache && m_RenderPath != RenderPath::Null)
+		{
+			// a reload: frames in flight still sample the old atlas. Should the new texture fail,
+			// the default font comes back rather than the old atlas without one
+			Window& window = Application::Get().GetWindow();
+			vkDeviceWaitIdle(m_RenderPath == RenderPath::Swapchain ? static_cast<WindowsWindow*>(&window)->GetDevice() : static_cast<HeadlessWindow*>(&window)->GetDevice());
+			m_GlyphTexture.Shutdown();
+			m_GlyphCache.reset();
+			ImGuiIO& io = ImGui::GetIO();
+			io.Fonts = &m_PlaceholderAtlas;
+			io.FontDefault = nullptr;
+		}
+		// the distance field texture has to exist before the atlas is drawn, or its glyphs would
+		// have no texture at all. Without one the default font stays
+		if (m_RenderPath == RenderPath::Swapchain)
+		{
+			auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
+			if (!m_GlyphTexture.Init(mw->GetPhysicalDevice(), mw->GetDevice(), cache->GetWidth(), cache->GetHeight(), mw->GetSwapchain().GetFramesInFlight(), mw->GetAllocator()))
+				return;
+		}
+		else if (m_RenderPath == RenderPath::Offscreen)
+		{
+			auto hw = static_cast<HeadlessWindow*>(&Application::Get().GetWindow());
+			if (!m_GlyphTexture.Init(hw->GetPhysicalDevice(), hw->GetDevice(), cache->GetWidth(), cache->GetHeight(), 1, hw->GetAllocator()))
+				return;
+		}
+		if (m_RenderPath != RenderPath::Null)
+			ImGui_ImplVulkan_SetDistanceFieldTexture(m_GlyphTexture.GetDescriptorSet());
+#endif
+		m_GlyphCache = cache;
+		ImGuiIO& io = ImGui::GetIO();
+		io.Fonts = cache->GetAtlas();
+		io.FontDefault = cache->GetFont();
+	}
 
+	bool ImGuiLayer::AddViewport(ViewportPanel* panel)
+	{
 #ifdef LUFT_RENDERER_BACKEND_VULKAN
-		CleanupVulkanWindow();
+		bool ok = false;
+		if (m_RenderPath == RenderPath::Swapchain)
+		{
+			auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
+			ok = panel->Init(mw->GetPhysicalDevice(), mw->GetDevice(), mw->GetSwapchain().GetFramesInFlight(), mw->GetAllocator());
+		}
+		else if (m_RenderPath == RenderPath::Offscreen)
+		{
+			auto hw = static_cast<HeadlessWindow*>(&Application::Get().GetWindow());
+			ok = panel->Init(hw->GetPhysicalDevice(), hw->GetDevice(), 1, hw->GetAllocator());
+		}
+		else
+			return false;
+		if (!ok)
+		{
+			panel->Shutdown();
+			return false;
+		}
+		m_Viewports.push_back(panel);
+		return true;
+#else
+		return false;
 #endif
 	}
 
+	void ImGuiLayer::RemoveViewport(ViewportPanel* panel)
+	{
+#ifdef LUFT_RENDERER_BACKEND_VULKAN
+		if (!m_Viewports.contains(panel))
+			return;
+		Window& window = Application::Get().GetWindow();
+		vkDeviceWaitIdle(m_RenderPath == RenderPath::Swapchain ? static_cast<WindowsWindow*>(&window)->GetDevice() : static_cast<HeadlessWindow*>(&window)->GetDevice());
+		panel->Shutdown();
+		m_Viewports.removeOne(panel);
+#endif
+	}
+
+	uint64_t ImGuiLayer::GetFrameNumber() const
+	{
+		if (m_RenderPath == RenderPath::Swapchain)
+			return static_cast<WindowsWindow*>(&Application::Get().GetWindow())->GetSwapchain().GetFrameNumber();
+		return m_Offscreen.FrameNumber;
+	}
+
+	void ImGuiLayer::RenderViewports(VkCommandBuffer cmd)
+	{
+		if (m_Viewports.empty())
+			return;
+		const int zone = m_GpuTimer.BeginZone(cmd, "Viewports");
+		for (ViewportPanel* panel : m_Viewports)
+			panel->Render(cmd);
+		m_GpuTimer.EndZone(cmd, zone);
+	}
+
+	void ImGuiLayer::EndViewportFrame(bool submitted)
+	{
+		for (ViewportPanel* panel : m_Viewports)
+			panel->EndFrame(submitted);
+	}
+
+	bool ImGuiLayer::HasPendingViewportRender() const
+	{
+		for (const ViewportPanel* panel : m_Viewports)
+		{
+			if (panel->HasPendingRender())
+				return true;
+		}
+		return false;
+	}
+
 	void ImGuiLayer::OnEvent(Event& e)
 	{
 		if (m_BlockEvents)
@@ -82,19 +345,103 @@ namespace Luft {
 		}
 	}
 
+	void ImGuiLayer::OnImGuiRender()
+	{
+		if (ImGui::BeginMainMenuBar())
+		{
+			if (ImGui::BeginMenu("Debug"))
+			{
+				ImGui::MenuItem("Memory", NULL, &m_ShowMemoryPanel);
+				ImGui::MenuItem("Frame Stats", NULL, &m_ShowFrameStats);
+				ImGui::MenuItem("Console", NULL, &m_ShowLogConsole);
+				if (m_Viewports.contains(&m_SceneViewport))
+					ImGui::MenuItem("Scene Viewport", NULL, &m_SceneViewport.Open());
+				if (m_RenderPath == RenderPath::Swapchain)
+					ImGui::MenuItem("Render On Change", NULL, &m_RenderOnChange);
+				if (m_RenderPath == RenderPath::Swapchain && ImGui::BeginMenu("Present Mode"))
+				{
+					auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
+					VulkanSwapchain& swapchain = mw->GetSwapchain();
+					const char* names[] = { "FIFO (VSync)", "Mailbox", "Immediate" };
+					for (int i = 0; i < (int)PresentMode::Count; i++)
+					{
+						if (ImGui::MenuItem(names[i], NULL, swapchain.GetPresentMode() == (PresentMode)i, swapchain.IsPresentModeSupported((PresentMode)i)))
+							swapchain.SetPresentMode((PresentMode)i);
+					}
+					ImGui::EndMenu();
+				}
+#if LUFT_PROFILE
+				ImGui::MenuItem("Profiler", NULL, &m_ShowProfilerPanel);
+				ImGui::Separator();
+				if (!Profiler::IsCapturing())
+				{
+					if (ImGui::MenuItem("Start Trace Capture"))
+						Profiler::BeginCapture("luft_trace.json");
+				}
+				else if (ImGui::MenuItem("Stop Trace Capture"))
+				{
+					Profiler::EndCapture();
+				}
+#endif
+				ImGui::EndMenu();
+			}
+			if (ImGui::BeginMenu("Language"))
+			{
+				for (const lstr& language : Localization::GetLanguages())
+				{
+					if (ImGui::MenuItem(language.c_str(), NULL, language == Localization::GetLanguage()))
+						Localization::SetLanguage(language);
+				}
+				ImGui::EndMenu();
+			}
+			ImGui::EndMainMenuBar();
+		}
+
+		if (m_ShowMemoryPanel)
+			m_MemoryPanel.OnImGuiRender(&m_ShowMemoryPanel);
+		if (m_ShowProfilerPanel)
+			m_ProfilerPanel.OnImGuiRender(&m_ShowProfilerPanel);
+		if (m_ShowFrameStats)
+			m_FrameStatsOverlay.OnImGuiRender(&m_ShowFrameStats);
+
+		m_LogConsolePanel.Update();
+		if (m_ShowLogConsole)
+			m_LogConsolePanel.OnImGuiRender(&m_ShowLogConsole);
+
+		const uint64_t frame = GetFrameNumber();
+		for (ViewportPanel* panel : m_Viewports)
+			panel->OnImGuiRender(frame);
+	}
+
 	bool show_demo_window = true;
 	bool show_another_window = false;
 
 	void ImGuiLayer::Begin()
 	{
-		ProcessSDLWindowEvents();
+		LUFT_PROFILE_FUNCTION();
+
+		if (m_RenderPath == RenderPath::Swapchain)
+			ProcessSDLWindowEvents();
 
 		// Start the Dear ImGui frame
 #ifdef LUFT_RENDERER_BACKEND_VULKAN
-		ImGui_ImplVulkan_NewFrame();
+		if (m_RenderPath != RenderPath::Null)
+		{
+			ImGui_ImplVulkan_NewFrame();
+			// the backend points io.Fonts at the RGBA copy it uploads once, the glyph cache's own
+			// texture is the one kept up to date
+			if (m_GlyphTexture.GetDescriptorSet() != VK_NULL_HANDLE)
+				ImGui::GetIO().Fonts->SetTexID((ImTextureID)m_GlyphTexture.GetDescriptorSet());
+		}
 #endif
-		ImGui_ImplSDL2_NewFrame();
-		ImGui::NewFrame();
+		if (m_RenderPath == RenderPath::Swapchain)
+			ImGui_ImplSDL2_NewFrame();
+		else
+			HeadlessNewFrame();
+		{
+			LUFT_PROFILE_SCOPE("ImGui::NewFrame");
+			ImGui::NewFrame();
+		}
 		//ImGuizmo::BeginFrame();
 
 		//============ Imgui Demo Test =================
@@ -135,26 +482,81 @@ namespace Luft {
 
 	void ImGuiLayer::End()
 	{
+		LUFT_PROFILE_FUNCTION();
+
 		ImGuiIO& io = ImGui::GetIO();
 
 		// Rendering
-		ImGui::Render();
+		{
+			LUFT_PROFILE_SCOPE("ImGui::Render");
+			ImGui::Render();
+		}
 		ImDrawData* main_draw_data = ImGui::GetDrawData();
+		if (m_RenderPath != RenderPath::Swapchain)
+		{
+			if (m_RenderPath == RenderPath::Offscreen)
+				OffscreenFrameRender(main_draw_data);
+			else if (m_GlyphCache)
+			{
+				m_GlyphCache->Update();
+				m_GlyphCache->ClearDirtyRects();
+			}
+			m_GpuTimer.EndFrame();
+			return;
+		}
+		auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
+		const bool viewports = (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) != 0;
+		// platform windows are created, moved and destroyed whether or not anything is drawn
+		if (viewports)
+			ImGui::UpdatePlatformWindows();
+		// glyphs first drawn this frame are rasterized either way. Their upload comes with the next
+		// frame that's recorded, before anything draws them
+		if (m_GlyphCache)
+			m_GlyphCache->Update();
+
+		// the same pixels as what's on screen: nothing to render or present, and nothing to do
+		// until there's input or a timer is due
+		const uint64_t drawHash = HashDrawData();
+		if (m_RenderOnChange && drawHash == m_LastDrawHash && !mw->GetSwapchain().NeedsRebuild()
+			&& !(m_GlyphCache && !m_GlyphCache->GetDirtyRects().empty()) && !HasPendingViewportRender())
+		{
+			FrameStats::ReportSkipped();
+			m_GpuTimer.EndFrame();
+			const uint64_t idleStart = Profiler::Now();
+			{
+				LUFT_PROFILE_SCOPE("WaitForInput");
+				SDL_WaitEventTimeout(nullptr, IdleWaitMs);
+			}
+			FrameStats::ReportWait(Profiler::TicksToMilliseconds(Profiler::Now() - idleStart));
+			return;
+		}
+
 		const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
-		if (!main_is_minimized)
-			FrameRender(main_draw_data);
+		const bool main_is_rendered = !main_is_minimized && FrameRender(main_draw_data);
+		// a frame that couldn't be rendered is tried again
+		m_LastDrawHash = main_is_minimized || main_is_rendered ? drawHash : 0;
+		EndViewportFrame(main_is_rendered);
 
-		// Update and Render additional Platform Windows
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		// Render additional Platform Windows
+		if (viewports)
 		{
-			ImGui::UpdatePlatformWindows();
+			LUFT_PROFILE_SCOPE("RenderPlatformWindows");
+			// the backend records and submits the viewports itself, so they're bracketed by
+			// timestamps in separate submissions
+			const int platformZone = m_GpuTimer.SubmitBeginZone(mw->GetQueue(), "Platform Windows");
 			ImGui::RenderPlatformWindowsDefault();
+			m_GpuTimer.SubmitEndZone(mw->GetQueue(), platformZone);
 		}
 
 		
 		// Present Main Platform Window
-		if (!main_is_minimized)
+		if (main_is_rendered)
+		{
+			const uint64_t presentStart = Profiler::Now();
 			FramePresent();
+			FrameStats::ReportPresent(Profiler::TicksToMilliseconds(Profiler::Now() - presentStart));
+		}
+		m_GpuTimer.EndFrame();
 
 	}
 
@@ -207,59 +609,24 @@ namespace Luft {
 			if (event.type == SDL_QUIT)
 			{
 				CORE_LOG_INFO("SDL_QUIT");
-				Application::Get().PushEvent(WindowCloseEvent());
+				WindowCloseEvent close;
+				Application::Get().PushEvent(close);
 			}
 			if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(window))
 			{
-				Application::Get().PushEvent(WindowCloseEvent());
+				WindowCloseEvent close;
+				Application::Get().PushEvent(close);
 				CORE_LOG_INFO("WINDOWEVENT_CLOSE");
 			}
 		}
 	}
 
-	void ImGuiLayer::SetupVulkanWindow(const WindowsWindow* ww, int width, int height)
-	{
-		auto surf = ww->GetSurface();
-		auto pd = ww->GetPhysicalDevice();
-		auto d = ww->GetDevice();
-		auto qf = ww->GetQueueFamily();
-		auto allocator = ww->GetAllocator();
-
-		m_MainWindowData.Surface = surf;
-		// Check for WSI support
-		VkBool32 res;
-		vkGetPhysicalDeviceSurfaceSupportKHR(pd, qf, surf, &res);
-		if (res != VK_TRUE)
-		{
-			fprintf(stderr, "Error no WSI support on physical device 0\n");
-			exit(-1);
-		}
-
-		// Select Surface Format
-		const VkFormat requestSurfaceImageFormat[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8_UNORM };
-		const VkColorSpaceKHR requestSurfaceColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
-		m_MainWindowData.SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(pd, surf, requestSurfaceImageFormat, (size_t)IM_ARRAYSIZE(requestSurfaceImageFormat), requestSurfaceColorSpace);
-
-		// Select Present Mode
-#ifdef Luft_UNLIMITED_FRAME_RATE
-		VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
-#else
-		VkPresentModeKHR present_modes[] = { VK_PRESENT_MODE_FIFO_KHR };
-#endif
-		m_MainWindowData.PresentMode = ImGui_ImplVulkanH_SelectPresentMode(pd, surf, &present_modes[0], IM_ARRAYSIZE(present_modes));
-		//printf("[vulkan] Selected PresentMode = %d\n", wd->PresentMode);
-
-		// Create SwapChain, RenderPass, Framebuffer, etc.
-		assert(m_MinVkImageCount >= 2);
-		ImGui_ImplVulkanH_CreateOrResizeWindow(ww->GetInstance(), pd, d, &m_MainWindowData, qf, allocator, width, height, m_MinVkImageCount);
-	}
-
 	void ImGuiLayer::SDL2Init4Vulkan()
 	{
 		auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
 		auto window = static_cast<SDL_Window*>(mw->GetNativeWindow());
 
-		SetupVulkanWindow(mw, mw->GetWidth(), mw->GetHeight());
+		VulkanSwapchain& swapchain = mw->GetSwapchain();
 
 		// Setup Platform/Renderer backends
 		ImGui_ImplSDL2_InitForVulkan(window);
@@ -271,100 +638,381 @@ namespace Luft {
 		init_info.Queue = mw->GetQueue();
 		init_info.PipelineCache = mw->GetPipelineCache();
 		init_info.DescriptorPool = mw->GetDescriptorPool();
-		init_info.RenderPass = m_MainWindowData.RenderPass;
+		init_info.RenderPass = swapchain.GetRenderPass();
 		init_info.Subpass = 0;
-		init_info.MinImageCount = m_MinVkImageCount;
-		init_info.ImageCount = m_MainWindowData.ImageCount;
+		// the backend keeps vertex buffers per ImageCount frames, a frame in flight needs its own.
+		// MinImageCount is for the platform windows' swapchains
+		init_info.MinImageCount = 2;
+		init_info.ImageCount = std::max(swapchain.GetFramesInFlight(), 2u);
 		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-		init_info.Allocator = mw->GetAllocator();
+		// secondary viewport surfaces are created by SDL without allocation callbacks but destroyed
+		// with the backend's allocator, so the backend must not use the tracking allocator
+		init_info.Allocator = nullptr;
+		const uint64_t start = Profiler::Now();
 		ImGui_ImplVulkan_Init(&init_info);
+		mw->GetPersistentPipelineCache().ReportCreation("ImGui's pipelines", Profiler::TicksToMilliseconds(Profiler::Now() - start));
+
+		m_GpuTimer.Init(mw->GetPhysicalDevice(), mw->GetDevice(), mw->GetQueueFamily(), swapchain.GetFramesInFlight(), mw->GetAllocator());
 	}
 	
-	void ImGuiLayer::CleanupVulkanWindow()
+	bool ImGuiLayer::FrameRender(ImDrawData* drawData)
 	{
+		LUFT_PROFILE_FUNCTION();
+
 		auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
-		ImGui_ImplVulkanH_DestroyWindow(mw->GetInstance(), mw->GetDevice(), &m_MainWindowData, mw->GetAllocator());
+		VulkanSwapchain& swapchain = mw->GetSwapchain();
+		// the fence wait and acquiring, and a rebuild when resized, are where the CPU blocks on the
+		// GPU and the swapchain
+		const uint64_t waitStart = Profiler::Now();
+		const bool acquired = swapchain.BeginFrame((uint32_t)(drawData->DisplaySize.x * drawData->FramebufferScale.x),
+			(uint32_t)(drawData->DisplaySize.y * drawData->FramebufferScale.y));
+		FrameStats::ReportWait(Profiler::TicksToMilliseconds(Profiler::Now() - waitStart));
+		if (!acquired)
+			return false;
+
+		VkCommandBuffer cmd = swapchain.GetCommandBuffer();
+		const uint32_t frame = swapchain.GetFrameSlot();
+		m_GpuTimer.BeginFrame(cmd, frame);
+		// only once the frame is sure to be recorded, so new glyphs are never drawn before their upload
+		if (m_GlyphCache)
+			m_GlyphTexture.Upload(cmd, frame, *m_GlyphCache);
+		RenderViewports(cmd);
+		const int passZone = m_GpuTimer.BeginZone(cmd, "ImGui RenderPass");
+		{
+			VkClearValue clear = {};
+			VkRenderPassBeginInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			info.renderPass = swapchain.GetRenderPass();
+			info.framebuffer = swapchain.GetFramebuffer();
+			info.renderArea.extent = swapchain.GetExtent();
+			info.clearValueCount = 1;
+			info.pClearValues = &clear;
+			vkCmdBeginRenderPass(cmd, &info, VK_SUBPASS_CONTENTS_INLINE);
+		}
+
+		// Record dear imgui primitives into command buffer
+		ImGui_ImplVulkan_RenderDrawData(drawData, cmd);
+
+		// Submit command buffer
+		vkCmdEndRenderPass(cmd);
+		m_GpuTimer.EndZone(cmd, passZone);
+		if (!swapchain.Submit(mw->GetQueue()))
+		{
+			m_GpuTimer.AbandonFrame();
+			return false;
+		}
+		return true;
 	}
-	
-	void ImGuiLayer::FrameRender(ImDrawData* drawData)
+
+	void ImGuiLayer::FramePresent()
 	{
-		VkResult err;
+		LUFT_PROFILE_FUNCTION();
+
 		auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
-		VkSemaphore image_acquired_semaphore = m_MainWindowData.FrameSemaphores[m_MainWindowData.SemaphoreIndex].ImageAcquiredSemaphore;
-		VkSemaphore render_complete_semaphore = m_MainWindowData.FrameSemaphores[m_MainWindowData.SemaphoreIndex].RenderCompleteSemaphore;
-		err = vkAcquireNextImageKHR(mw->GetDevice(), m_MainWindowData.Swapchain, UINT64_MAX, image_acquired_semaphore, VK_NULL_HANDLE, &m_MainWindowData.FrameIndex);
-		if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+		mw->GetSwapchain().Present(mw->GetQueue());
+	}
+
+	void ImGuiLayer::HeadlessInit(HeadlessWindow* hw)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		io.BackendPlatformName = "luft_headless";
+		io.DisplaySize = ImVec2((float)hw->GetWidth(), (float)hw->GetHeight());
+
+#ifdef LUFT_RENDERER_BACKEND_VULKAN
+		if (hw->HasVulkanDevice() && !SetupOffscreenVulkan(hw))
 		{
-			m_SwapChainRebuild = true;
+			CleanupOffscreenVulkan();
+		}
+		else if (hw->HasVulkanDevice())
+		{
+			m_RenderPath = RenderPath::Offscreen;
+
+			ImGui_ImplVulkan_InitInfo init_info = {};
+			init_info.Instance = hw->GetInstance();
+			init_info.PhysicalDevice = hw->GetPhysicalDevice();
+			init_info.Device = hw->GetDevice();
+			init_info.QueueFamily = hw->GetQueueFamily();
+			init_info.Queue = hw->GetQueue();
+			init_info.PipelineCache = hw->GetPipelineCache();
+			init_info.DescriptorPool = hw->GetDescriptorPool();
+			init_info.RenderPass = m_Offscreen.RenderPass;
+			init_info.Subpass = 0;
+			// the backend wants at least two, one frame is ever in flight here
+			init_info.MinImageCount = 2;
+			init_info.ImageCount = 2;
+			init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
+			init_info.Allocator = hw->GetAllocator();
+			const uint64_t start = Profiler::Now();
+			ImGui_ImplVulkan_Init(&init_info);
+			hw->GetPersistentPipelineCache().ReportCreation("ImGui's pipelines", Profiler::TicksToMilliseconds(Profiler::Now() - start));
+
+			m_GpuTimer.Init(hw->GetPhysicalDevice(), hw->GetDevice(), hw->GetQueueFamily(), 1, hw->GetAllocator());
+			CORE_LOG_INFO("ImGui renders offscreen ({0}x{1})", m_Offscreen.Width, m_Offscreen.Height);
 			return;
 		}
+#endif
 
-		ImGui_ImplVulkanH_Frame* fd = &m_MainWindowData.Frames[m_MainWindowData.FrameIndex];
+		m_RenderPath = RenderPath::Null;
+		// no renderer backend uploads the atlas, build it on the CPU so NewFrame has its glyphs.
+		// The glyph cache's comes built
+		unsigned char* pixels = nullptr;
+		int width = 0, height = 0;
+		io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+		CORE_LOG_INFO("ImGui uses the null renderer, frames are built but not drawn");
+	}
+
+	void ImGuiLayer::HeadlessNewFrame()
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		Window& window = Application::Get().GetWindow();
+		io.DisplaySize = ImVec2((float)window.GetWidth(), (float)window.GetHeight());
+
+		const double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		io.DeltaTime = m_HeadlessTime > 0.0 ? (float)std::max(now - m_HeadlessTime, 1e-6) : 1.0f / 60.0f;
+		m_HeadlessTime = now;
+	}
+
+	bool ImGuiLayer::SetupOffscreenVulkan(const HeadlessWindow* hw)
+	{
+		VkDevice device = hw->GetDevice();
+		const VkAllocationCallbacks* allocator = hw->GetAllocator();
+		OffscreenTarget& target = m_Offscreen;
+		target.Width = hw->GetWidth();
+		target.Height = hw->GetHeight();
+		const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+		// Color image
 		{
-			err = vkWaitForFences(mw->GetDevice(), 1, &fd->Fence, VK_TRUE, UINT64_MAX);    // wait indefinitely instead of periodically checking
+			VkImageCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			info.imageType = VK_IMAGE_TYPE_2D;
+			info.format = format;
+			info.extent = { target.Width, target.Height, 1 };
+			info.mipLevels = 1;
+			info.arrayLayers = 1;
+			info.samples = VK_SAMPLE_COUNT_1_BIT;
+			info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			if (!CheckVkResult(vkCreateImage(device, &info, allocator, &target.Image), "vkCreateImage"))
+				return false;
+
+			VkMemoryRequirements req;
+			vkGetImageMemoryRequirements(device, target.Image, &req);
+			VkPhysicalDeviceMemoryProperties props;
+			vkGetPhysicalDeviceMemoryProperties(hw->GetPhysicalDevice(), &props);
+			// device local if there is such a type, CPU implementations may expose only host memory
+			uint32_t type = (uint32_t)-1;
+			for (uint32_t i = 0; i < props.memoryTypeCount; i++)
+			{
+				if (!(req.memoryTypeBits & (1u << i)))
+					continue;
+				if (type == (uint32_t)-1 || (props.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+					type = i;
+				if (props.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+					break;
+			}
+
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = req.size;
+			alloc_info.memoryTypeIndex = type;
+			if (type == (uint32_t)-1 || !CheckVkResult(vkAllocateMemory(device, &alloc_info, allocator, &target.Memory), "vkAllocateMemory"))
+				return false;
+			vkBindImageMemory(device, target.Image, target.Memory, 0);
+
+			VkImageViewCreateInfo view_info = {};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = target.Image;
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = format;
+			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			view_info.subresourceRange.levelCount = 1;
+			view_info.subresourceRange.layerCount = 1;
+			if (!CheckVkResult(vkCreateImageView(device, &view_info, allocator, &target.View), "vkCreateImageView"))
+				return false;
+		}
+
+		// Render pass, cleared every frame and left as an attachment since nobody reads it
+		{
+			VkAttachmentDescription attachment = {};
+			attachment.format = format;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			VkAttachmentReference color_attachment = {};
+			color_attachment.attachment = 0;
+			color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &color_attachment;
+			VkSubpassDependency dependency = {};
+			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependency.dstSubpass = 0;
+			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			VkRenderPassCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			info.attachmentCount = 1;
+			info.pAttachments = &attachment;
+			info.subpassCount = 1;
+			info.pSubpasses = &subpass;
+			info.dependencyCount = 1;
+			info.pDependencies = &dependency;
+			if (!CheckVkResult(vkCreateRenderPass(device, &info, allocator, &target.RenderPass), "vkCreateRenderPass"))
+				return false;
+		}
+
+		// Framebuffer
+		{
+			VkFramebufferCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			info.renderPass = target.RenderPass;
+			info.attachmentCount = 1;
+			info.pAttachments = &target.View;
+			info.width = target.Width;
+			info.height = target.Height;
+			info.layers = 1;
+			if (!CheckVkResult(vkCreateFramebuffer(device, &info, allocator, &target.Framebuffer), "vkCreateFramebuffer"))
+				return false;
+		}
+
+		// Command buffer and its fence, created signaled so the first frame doesn't wait
+		{
+			VkCommandPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			pool_info.queueFamilyIndex = hw->GetQueueFamily();
+			if (!CheckVkResult(vkCreateCommandPool(device, &pool_info, allocator, &target.CommandPool), "vkCreateCommandPool"))
+				return false;
+
+			VkCommandBufferAllocateInfo cmd_info = {};
+			cmd_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			cmd_info.commandPool = target.CommandPool;
+			cmd_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			cmd_info.commandBufferCount = 1;
+			if (!CheckVkResult(vkAllocateCommandBuffers(device, &cmd_info, &target.CommandBuffer), "vkAllocateCommandBuffers"))
+				return false;
+
+			VkFenceCreateInfo fence_info = {};
+			fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			if (!CheckVkResult(vkCreateFence(device, &fence_info, allocator, &target.Fence), "vkCreateFence"))
+				return false;
+		}
+		return true;
+	}
 
-			err = vkResetFences(mw->GetDevice(), 1, &fd->Fence);
+	void ImGuiLayer::CleanupOffscreenVulkan()
+	{
+		auto hw = static_cast<HeadlessWindow*>(&Application::Get().GetWindow());
+		VkDevice device = hw->GetDevice();
+		const VkAllocationCallbacks* allocator = hw->GetAllocator();
+		if (device == VK_NULL_HANDLE)
+			return;
+
+		vkDeviceWaitIdle(device);
+		OffscreenTarget& target = m_Offscreen;
+		if (target.Fence != VK_NULL_HANDLE)
+			vkDestroyFence(device, target.Fence, allocator);
+		if (target.CommandPool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(device, target.CommandPool, allocator);
+		if (target.Framebuffer != VK_NULL_HANDLE)
+			vkDestroyFramebuffer(device, target.Framebuffer, allocator);
+		if (target.RenderPass != VK_NULL_HANDLE)
+			vkDestroyRenderPass(device, target.RenderPass, allocator);
+		if (target.View != VK_NULL_HANDLE)
+			vkDestroyImageView(device, target.View, allocator);
+		if (target.Image != VK_NULL_HANDLE)
+			vkDestroyImage(device, target.Image, allocator);
+		if (target.Memory != VK_NULL_HANDLE)
+			vkFreeMemory(device, target.Memory, allocator);
+		target = OffscreenTarget();
+	}
+
+	void ImGuiLayer::OffscreenFrameRender(ImDrawData* drawData)
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		auto hw = static_cast<HeadlessWindow*>(&Application::Get().GetWindow());
+		VkDevice device = hw->GetDevice();
+		OffscreenTarget& target = m_Offscreen;
+
+		// the previous frame must be done before its command buffer is reused
+		const uint64_t waitStart = Profiler::Now();
+		{
+			LUFT_PROFILE_SCOPE("WaitForFrameFence");
+			if (target.Fence != VK_NULL_HANDLE)
+				vkWaitForFences(device, 1, &target.Fence, VK_TRUE, UINT64_MAX);
 		}
+		FrameStats::ReportWait(Profiler::TicksToMilliseconds(Profiler::Now() - waitStart));
+
 		{
-			err = vkResetCommandPool(mw->GetDevice(), fd->CommandPool, 0);
+			vkResetCommandPool(device, target.CommandPool, 0);
 			VkCommandBufferBeginInfo info = {};
 			info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 			info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-			err = vkBeginCommandBuffer(fd->CommandBuffer, &info);
+			vkBeginCommandBuffer(target.CommandBuffer, &info);
 		}
+		m_GpuTimer.BeginFrame(target.CommandBuffer, 0);
+		if (m_GlyphCache)
 		{
+			m_GlyphCache->Update();
+			m_GlyphTexture.Upload(target.CommandBuffer, 0, *m_GlyphCache);
+		}
+		RenderViewports(target.CommandBuffer);
+		const int passZone = m_GpuTimer.BeginZone(target.CommandBuffer, "ImGui RenderPass");
+		{
+			VkClearValue clear = {};
+			clear.color = { { 0.1f, 0.105f, 0.11f, 1.0f } };
 			VkRenderPassBeginInfo info = {};
 			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			info.renderPass = m_MainWindowData.RenderPass;
-			info.framebuffer = fd->Framebuffer;
-			info.renderArea.extent.width = m_MainWindowData.Width;
-			info.renderArea.extent.height = m_MainWindowData.Height;
+			info.renderPass = target.RenderPass;
+			info.framebuffer = target.Framebuffer;
+			info.renderArea.extent.width = target.Width;
+			info.renderArea.extent.height = target.Height;
 			info.clearValueCount = 1;
-			info.pClearValues = &m_MainWindowData.ClearValue;
-			vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+			info.pClearValues = &clear;
+			vkCmdBeginRenderPass(target.CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
 		}
 
-		// Record dear imgui primitives into command buffer
-		ImGui_ImplVulkan_RenderDrawData(drawData, fd->CommandBuffer);
+		ImGui_ImplVulkan_RenderDrawData(drawData, target.CommandBuffer);
 
-		// Submit command buffer
-		vkCmdEndRenderPass(fd->CommandBuffer);
+		vkCmdEndRenderPass(target.CommandBuffer);
+		m_GpuTimer.EndZone(target.CommandBuffer, passZone);
 		{
-			VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 			VkSubmitInfo info = {};
 			info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			info.waitSemaphoreCount = 1;
-			info.pWaitSemaphores = &image_acquired_semaphore;
-			info.pWaitDstStageMask = &wait_stage;
 			info.commandBufferCount = 1;
-			info.pCommandBuffers = &fd->CommandBuffer;
-			info.signalSemaphoreCount = 1;
-			info.pSignalSemaphores = &render_complete_semaphore;
-
-			err = vkEndCommandBuffer(fd->CommandBuffer);
-			err = vkQueueSubmit(mw->GetQueue(), 1, &info, fd->Fence);
-		}
-	}
-
-	void ImGuiLayer::FramePresent()
-	{
-		if (m_SwapChainRebuild)
-			return;
-		auto mw = static_cast<WindowsWindow*>(&Application::Get().GetWindow());
-		VkSemaphore render_complete_semaphore = m_MainWindowData.FrameSemaphores[m_MainWindowData.SemaphoreIndex].RenderCompleteSemaphore;
-		VkPresentInfoKHR info = {};
-		info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		info.waitSemaphoreCount = 1;
-		info.pWaitSemaphores = &render_complete_semaphore;
-		info.swapchainCount = 1;
-		info.pSwapchains = &m_MainWindowData.Swapchain;
-		info.pImageIndices = &m_MainWindowData.FrameIndex;
-		VkResult err = vkQueuePresentKHR(mw->GetQueue(), &info);
-		if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
-		{
-			m_SwapChainRebuild = true;
-			return;
+			info.pCommandBuffers = &target.CommandBuffer;
+			// the fence is reset only for a submission that happens, or the next frame waits forever
+			const bool ended = CheckVkResult(vkEndCommandBuffer(target.CommandBuffer), "vkEndCommandBuffer");
+			vkResetFences(device, 1, &target.Fence);
+			const bool submitted = ended && CheckVkResult(vkQueueSubmit(hw->GetQueue(), 1, &info, target.Fence), "vkQueueSubmit");
+			EndViewportFrame(submitted);
+			if (!submitted)
+			{
+				m_GpuTimer.AbandonFrame();
+				// an empty batch still signals the fence. Failing that, wait for the GPU and signal a new one
+				if (vkQueueSubmit(hw->GetQueue(), 0, nullptr, target.Fence) != VK_SUCCESS)
+				{
+					vkDeviceWaitIdle(device);
+					vkDestroyFence(device, target.Fence, hw->GetAllocator());
+					VkFenceCreateInfo fenceInfo = {};
+					fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+					fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+					target.Fence = VK_NULL_HANDLE;
+					CheckVkResult(vkCreateFence(device, &fenceInfo, hw->GetAllocator(), &target.Fence), "vkCreateFence");
+				}
+			}
 		}
-		m_MainWindowData.SemaphoreIndex = (m_MainWindowData.SemaphoreIndex + 1) % m_MainWindowData.SemaphoreCount; // Now we can use the next set of semaphores
+		target.FrameNumber++;
 	}
 }
@@ -1,14 +1,32 @@
 #pragma once
 
 #include "Luft/Core/Layer.h"
+#include "Luft/Core/AssetStreamer.h"
+#include "Luft/Core/FileWatcher.h"
+#include "Luft/ImGui/Panels/MemoryPanel.h"
+#include "Luft/ImGui/Panels/ProfilerPanel.h"
+#include "Luft/ImGui/Panels/FrameStatsOverlay.h"
+#include "Luft/ImGui/Panels/LogConsolePanel.h"
+#include "Luft/ImGui/Panels/ViewportPanel.h"
+#include "Luft/ImGui/GlyphCache.h"
 #include <backends/imgui_impl_vulkan.h>
-#ifdef LUFT_PLATFORM_WINDOWS
+#include "Platform/Vulkan/VulkanGpuTimer.h"
+#include "Platform/Vulkan/VulkanGlyphTexture.h"
 #include "Platform/Windows/WindowsWindow.h"
-#endif
+#include "Platform/Headless/HeadlessWindow.h"
 
 
 namespace Luft {
 
+	// sizes of the UI font, from the font_size_* int keys
+	enum class UIFont
+	{
+		Normal,
+		Title,
+		Max,
+		Count
+	};
+
 	class ImGuiLayer : public Layer
 	{
 	public:
@@ -18,6 +36,7 @@ namespace Luft {
 		virtual void OnAttach() override;
 		virtual void OnDetach() override;
 		virtual void OnEvent(Event& e) override;
+		virtual void OnImGuiRender() override;
 
 		void Begin();
 		void End();
@@ -27,19 +46,98 @@ namespace Luft {
 		void SetDarkThemeColors();
 
 		uint32_t GetActiveWidgetID() const;
+		const VulkanGpuTimer& GetGpuTimer() const { return m_GpuTimer; }
+		// for ImGui::PushFont, null until the font is loaded or if it couldn't be
+		ImFont* GetFont(UIFont font) const { return m_GlyphCache ? m_GlyphCache->GetFont((uint32_t)font) : nullptr; }
+
+		// the panel stays the caller's. It's drawn with the engine panels and its scene rendered
+		// before the UI until removed. False without a Vulkan render path
+		bool AddViewport(ViewportPanel* panel);
+		// waits for the frames in flight that draw it
+		void RemoveViewport(ViewportPanel* panel);
 	private:
+		// where End() sends the frame. Headless windows get Offscreen when they have a Vulkan
+		// device and Null otherwise; both still build the full ImGui frame
+		enum class RenderPath
+		{
+			Swapchain,
+			Offscreen,
+			Null
+		};
+
+		// a single color target rendered to and waited on every frame, nothing is presented
+		struct OffscreenTarget
+		{
+			uint32_t Width = 0;
+			uint32_t Height = 0;
+			VkImage Image = VK_NULL_HANDLE;
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkRenderPass RenderPass = VK_NULL_HANDLE;
+			VkFramebuffer Framebuffer = VK_NULL_HANDLE;
+			VkCommandPool CommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkFence Fence = VK_NULL_HANDLE;
+			// frames submitted, what viewport buffers are free is told by
+			uint64_t FrameNumber = 0;
+		};
+
 		void ProcessSDLWindowEvents();
-		void SetupVulkanWindow(const WindowsWindow* ww, int width, int height);
 		void SDL2Init4Vulkan();
-		void CleanupVulkanWindow();
-		void FrameRender(ImDrawData* drawData);
+		// false when the swapchain had no image to render into, nothing is presented then
+		bool FrameRender(ImDrawData* drawData);
 		void FramePresent();
+		void HeadlessInit(HeadlessWindow* hw);
+		void HeadlessNewFrame();
+		bool SetupOffscreenVulkan(const HeadlessWindow* hw);
+		void CleanupOffscreenVulkan();
+		void OffscreenFrameRender(ImDrawData* drawData);
+		// the number the frame being built is submitted as
+		uint64_t GetFrameNumber() const;
+		// into the frame's command buffer, before the UI that draws them
+		void RenderViewports(VkCommandBuffer cmd);
+		// once the frame's submission succeeded or failed, before platform windows are rendered
+		void EndViewportFrame(bool submitted);
+		bool HasPendingViewportRender() const;
+		// builds the glyph cache on a decode thread, OnFontLoaded swaps it in
+		void LoadFont(AssetPriority priority);
+		// between frames, from AssetStreamer::Update
+		void OnFontLoaded(const Ref<GlyphCache>& cache);
 
-		ImGui_ImplVulkanH_Window m_MainWindowData;
-		
-		const uint32_t m_MinVkImageCount = 2;
-		
-		bool m_SwapChainRebuild = false;
+		// glyphs kept rasterized beside the baked Latin ones, a few screens of CJK text
+		static constexpr uint32_t GlyphCacheCells = 2048;
+		// longest a frame that drew nothing waits for input, how often time driven UI (tooltips,
+		// the text cursor) and assets arriving between frames get a look while idle
+		static constexpr int IdleWaitMs = 50;
+
+		RenderPath m_RenderPath = RenderPath::Swapchain;
+		OffscreenTarget m_Offscreen;
+		double m_HeadlessTime = 0.0;
+		VulkanGpuTimer m_GpuTimer;
+		// io.Fonts until the glyph cache is loaded, ImGui's default font
+		ImFontAtlas m_PlaceholderAtlas;
+		AssetHandle m_FontAsset;
+		// the font file, or the pack it's in. A change loads the font again
+		FileWatchHandle m_FontWatch;
+		Ref<GlyphCache> m_GlyphCache;
+		VulkanGlyphTexture m_GlyphTexture;
+
+		// engine debug panels, toggled from the Debug menu
+		MemoryPanel m_MemoryPanel;
+		bool m_ShowMemoryPanel = false;
+		ProfilerPanel m_ProfilerPanel;
+		bool m_ShowProfilerPanel = false;
+		FrameStatsOverlay m_FrameStatsOverlay;
+		bool m_ShowFrameStats = false;
+		LogConsolePanel m_LogConsolePanel;
+		bool m_ShowLogConsole = false;
+		// the engine's own viewport, a clear color until there's a scene to render into it
+		ViewportPanel m_SceneViewport{ "Scene" };
+		larray<ViewportPanel*> m_Viewports;
+
+		// skip rendering and presenting frames that would look the same as the one on screen
+		bool m_RenderOnChange = true;
+		uint64_t m_LastDrawHash = 0;
 		bool m_BlockEvents = true;
 	};
 
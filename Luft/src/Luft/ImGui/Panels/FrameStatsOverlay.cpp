@@ -0,0 +1,159 @@
+#include "FrameStatsOverlay.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <imgui.h>
+
+namespace Luft {
+
+	static void MetricRow(const char* name, float last, const FrameMetricStats& stats)
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(name);
+		ImGui::TableNextColumn();
+		if (last >= 0.0f)
+			ImGui::Text("%.2f", last);
+		else
+			ImGui::TextDisabled("-");
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", stats.P50);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", stats.P95);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", stats.P99);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.2f", stats.Max);
+	}
+
+	static float FrameMsGetter(void*, int idx)
+	{
+		return FrameStats::GetSample((uint32_t)idx).FrameMs;
+	}
+
+	void FrameStatsOverlay::OnImGuiRender(bool* open)
+	{
+		const ImGuiViewport* viewport = ImGui::GetMainViewport();
+		const float pad = 10.0f;
+		const ImVec2 workPos = viewport->WorkPos;
+		const ImVec2 workSize = viewport->WorkSize;
+		ImVec2 pos(m_Corner & 1 ? workPos.x + workSize.x - pad : workPos.x + pad, m_Corner & 2 ? workPos.y + workSize.y - pad : workPos.y + pad);
+		ImVec2 pivot(m_Corner & 1 ? 1.0f : 0.0f, m_Corner & 2 ? 1.0f : 0.0f);
+		ImGui::SetNextWindowPos(pos, ImGuiCond_Always, pivot);
+		ImGui::SetNextWindowViewport(viewport->ID);
+		ImGui::SetNextWindowBgAlpha(0.75f);
+
+		const ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+			ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+		if (!ImGui::Begin("Frame Stats", open, flags))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const FrameStatsSummary& summary = FrameStats::GetSummary();
+		const FrameSample* last = FrameStats::GetLastSample();
+
+		ImGui::Text("%u frames, %llu hitches > %.1f ms, %llu skipped", summary.SampleCount, (unsigned long long)summary.HitchCount,
+			FrameStats::GetHitchThreshold(), (unsigned long long)summary.SkippedCount);
+		if (FrameStats::IsCsvCapturing())
+		{
+			ImGui::SameLine();
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "REC");
+		}
+
+		if (ImGui::BeginTable("##FrameStats", 6, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg))
+		{
+			ImGui::TableSetupColumn("ms");
+			ImGui::TableSetupColumn("last");
+			ImGui::TableSetupColumn("p50");
+			ImGui::TableSetupColumn("p95");
+			ImGui::TableSetupColumn("p99");
+			ImGui::TableSetupColumn("max");
+			ImGui::TableHeadersRow();
+			MetricRow("Frame", last ? last->FrameMs : -1.0f, summary.Frame);
+			MetricRow("CPU", last ? last->CpuMs : -1.0f, summary.Cpu);
+			MetricRow("GPU", last ? last->GpuMs : -1.0f, summary.Gpu);
+			MetricRow("Present", last ? last->PresentMs : -1.0f, summary.Present);
+			ImGui::EndTable();
+		}
+
+		if (summary.SampleCount > 1)
+		{
+			const float scaleMax = std::max(summary.Frame.Max, FrameStats::GetHitchThreshold()) * 1.1f;
+			ImGui::PlotLines("##FrameTimes", FrameMsGetter, NULL, (int)summary.SampleCount, 0, NULL, 0.0f, scaleMax, ImVec2(320.0f, 50.0f));
+		}
+
+		DrawHitches();
+
+		if (ImGui::BeginPopupContextWindow())
+		{
+			float threshold = FrameStats::GetHitchThreshold();
+			if (ImGui::DragFloat("Hitch ms", &threshold, 0.1f, 1.0f, 1000.0f, "%.1f"))
+				FrameStats::SetHitchThreshold(threshold);
+			if (ImGui::MenuItem("Clear Hitches"))
+				FrameStats::ClearHitches();
+			ImGui::Separator();
+			if (ImGui::MenuItem("Export CSV"))
+				FrameStats::ExportCsv("luft_frame_stats.csv");
+			if (!FrameStats::IsCsvCapturing())
+			{
+				if (ImGui::MenuItem("Start CSV Capture"))
+					FrameStats::BeginCsvCapture("luft_frame_stats_capture.csv");
+			}
+			else if (ImGui::MenuItem("Stop CSV Capture"))
+			{
+				FrameStats::EndCsvCapture();
+			}
+			ImGui::Separator();
+			if (ImGui::MenuItem("Top-left", NULL, m_Corner == 0)) m_Corner = 0;
+			if (ImGui::MenuItem("Top-right", NULL, m_Corner == 1)) m_Corner = 1;
+			if (ImGui::MenuItem("Bottom-left", NULL, m_Corner == 2)) m_Corner = 2;
+			if (ImGui::MenuItem("Bottom-right", NULL, m_Corner == 3)) m_Corner = 3;
+			if (open && ImGui::MenuItem("Close"))
+				*open = false;
+			ImGui::EndPopup();
+		}
+
+		ImGui::End();
+	}
+
+	void FrameStatsOverlay::DrawHitches()
+	{
+		const larray<FrameHitch>& hitches = FrameStats::GetHitches();
+		if (hitches.empty() || !ImGui::TreeNode("##Hitches", "Recent hitches (%u)", (uint32_t)hitches.size()))
+			return;
+
+		// newest first, each showing its most expensive zones
+		const size_t MaxZones = 8;
+		larray<const ProfileZone*> top;
+		for (size_t h = hitches.size(); h > 0; h--)
+		{
+			const FrameHitch& hitch = hitches[h - 1];
+			char label[96];
+			if (hitch.Sample.GpuMs >= 0.0f)
+				snprintf(label, sizeof(label), "#%llu  %.2f ms (cpu %.2f, gpu %.2f)", (unsigned long long)hitch.Sample.Index, hitch.Sample.FrameMs, hitch.Sample.CpuMs, hitch.Sample.GpuMs);
+			else
+				snprintf(label, sizeof(label), "#%llu  %.2f ms (cpu %.2f)", (unsigned long long)hitch.Sample.Index, hitch.Sample.FrameMs, hitch.Sample.CpuMs);
+
+			if (!ImGui::TreeNode((void*)(uintptr_t)hitch.Sample.Index, "%s", label))
+				continue;
+
+			top.clear();
+			for (const ProfileZone& zone : hitch.Zones)
+				top.push_back(&zone);
+			const size_t count = std::min(top.size(), MaxZones);
+			std::partial_sort(top.begin(), top.begin() + count, top.end(),
+				[](const ProfileZone* a, const ProfileZone* b) { return a->End - a->Start > b->End - b->Start; });
+
+			if (count == 0)
+				ImGui::TextDisabled("no profiler zones recorded");
+			for (size_t i = 0; i < count; i++)
+				ImGui::Text("%8.3f ms  %s", Profiler::TicksToMilliseconds(top[i]->End - top[i]->Start), top[i]->Name);
+
+			ImGui::TreePop();
+		}
+		ImGui::TreePop();
+	}
+
+}
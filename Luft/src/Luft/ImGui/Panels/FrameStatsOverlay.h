@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Luft/Debug/FrameStats.h"
+
+namespace Luft {
+
+	// corner overlay for FrameStats: rolling percentiles, a frame time plot and the recent hitches.
+	// Right click for the threshold and CSV export
+	class FrameStatsOverlay
+	{
+	public:
+		FrameStatsOverlay() = default;
+
+		void OnImGuiRender(bool* open);
+
+	private:
+		void DrawHitches();
+
+		int m_Corner = 1;
+	};
+
+}
@@ -0,0 +1,337 @@
+#include "LogConsolePanel.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <imgui.h>
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	namespace
+	{
+		const char* s_LevelNames[] = { "Trace", "Debug", "Info", "Warn", "Error", "Fatal" };
+
+		const ImVec4 s_LevelColors[] = {
+			ImVec4(0.55f, 0.55f, 0.55f, 1.0f),
+			ImVec4(0.55f, 0.70f, 0.80f, 1.0f),
+			ImVec4(0.85f, 0.85f, 0.85f, 1.0f),
+			ImVec4(1.00f, 0.80f, 0.30f, 1.0f),
+			ImVec4(1.00f, 0.40f, 0.35f, 1.0f),
+			ImVec4(1.00f, 0.20f, 0.60f, 1.0f)
+		};
+
+		inline char ToLower(char c)
+		{
+			return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+		}
+
+		// needle is already lower case
+		bool ContainsNoCase(const char* text, size_t length, const char* needle, size_t needleLength)
+		{
+			if (needleLength == 0)
+				return true;
+			if (needleLength > length)
+				return false;
+
+			const char first = needle[0];
+			const size_t last = length - needleLength;
+			for (size_t i = 0; i <= last; i++)
+			{
+				if (ToLower(text[i]) != first)
+					continue;
+				size_t j = 1;
+				while (j < needleLength && ToLower(text[i + j]) == needle[j])
+					j++;
+				if (j == needleLength)
+					return true;
+			}
+			return false;
+		}
+
+		// drops the entries below count from a sorted index and rebases the rest
+		void RebaseIndex(larray<uint32_t>& index, uint32_t count)
+		{
+			const uint32_t* cut = std::lower_bound(index.begin(), index.end(), count);
+			const size_t removed = cut - index.begin();
+			if (removed > 0)
+				index.erase(0, removed);
+			for (uint32_t& i : index)
+				i -= count;
+		}
+	}
+
+	bool LogConsolePanel::Filter::IsNarrowerThan(const Filter& o) const
+	{
+		return (LevelMask & ~o.LevelMask) == 0 && (LoggerMask & ~o.LoggerMask) == 0 && Text.contains(o.Text);
+	}
+
+	LogConsolePanel::LogConsolePanel()
+	{
+		m_ReadBuffer.resize(256);
+	}
+
+	uint8_t LogConsolePanel::FindLogger(const char* name)
+	{
+		for (size_t i = 0; i < m_Loggers.size(); i++)
+		{
+			if (m_Loggers[i] == name)
+				return (uint8_t)i;
+		}
+		// the last id collects whatever doesn't get its own
+		if (m_Loggers.size() == MaxLoggers)
+			return MaxLoggers - 1;
+		m_Loggers.push_back(lstr(name));
+		return (uint8_t)(m_Loggers.size() - 1);
+	}
+
+	bool LogConsolePanel::Matches(const Line& line, const Filter& filter) const
+	{
+		if (!(filter.LevelMask & (1u << line.Level)) || !(filter.LoggerMask & (1u << line.Logger)))
+			return false;
+		return ContainsNoCase(m_Text.data() + line.TextOffset, line.TextLength, filter.Text.c_str(), filter.Text.size());
+	}
+
+	void LogConsolePanel::Update()
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		const std::shared_ptr<LogRingSink>& sink = Log::GetConsoleSink();
+		if (!sink)
+			return;
+
+		uint32_t count;
+		while ((count = sink->Read(m_ReadBuffer.data(), (uint32_t)m_ReadBuffer.size())) > 0)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const LogRecord& record = m_ReadBuffer[i];
+				Line line;
+				line.Time = record.Time;
+				line.TextOffset = (uint32_t)m_Text.size();
+				line.TextLength = record.TextLength;
+				line.Level = record.Level < LevelCount ? record.Level : LevelCount - 1;
+				line.Logger = FindLogger(record.Logger);
+
+				m_Text.resize(m_Text.size() + record.TextLength);
+				memcpy(m_Text.data() + line.TextOffset, record.Text, record.TextLength);
+				m_Lines.push_back(line);
+				m_LevelCounts[line.Level]++;
+			}
+
+			if (m_Lines.size() > MaxLines || m_Text.size() > MaxTextBytes)
+				Trim();
+		}
+	}
+
+	void LogConsolePanel::Trim()
+	{
+		const uint32_t drop = (uint32_t)(m_Lines.size() / 4);
+		if (drop == 0)
+			return;
+
+		for (uint32_t i = 0; i < drop; i++)
+			m_LevelCounts[m_Lines[i].Level]--;
+
+		const uint32_t textDrop = m_Lines[drop].TextOffset;
+		m_Lines.erase(0, drop);
+		m_Text.erase(0, textDrop);
+		for (Line& line : m_Lines)
+			line.TextOffset -= textDrop;
+
+		// source entries before the cursor are consumed already
+		if (m_SourceCursor > 0)
+			m_Source.erase(0, m_SourceCursor);
+		m_SourceCursor = 0;
+		RebaseIndex(m_Source, drop);
+		RebaseIndex(m_Filtered, drop);
+		m_IndexedCount = m_IndexedCount > drop ? m_IndexedCount - drop : 0;
+	}
+
+	void LogConsolePanel::Clear()
+	{
+		m_Lines.clear();
+		m_Text.clear();
+		m_Filtered.clear();
+		m_Source.clear();
+		m_SourceCursor = 0;
+		m_IndexedCount = 0;
+		memset(m_LevelCounts, 0, sizeof(m_LevelCounts));
+	}
+
+	void LogConsolePanel::ApplyFilter()
+	{
+		if (m_Edit == m_Active)
+			return;
+
+		const bool caughtUp = m_SourceCursor == m_Source.size();
+		if (caughtUp && m_Edit.IsNarrowerThan(m_Active))
+		{
+			// only what passed the wider filter can pass this one
+			m_Source.swap(m_Filtered);
+		}
+		else
+		{
+			m_Source.clear();
+			m_IndexedCount = 0;
+		}
+		m_Filtered.clear();
+		m_SourceCursor = 0;
+		m_Active = m_Edit;
+	}
+
+	void LogConsolePanel::AdvanceIndex()
+	{
+		const uint64_t start = Profiler::Now();
+		const uint64_t budget = Profiler::MicrosecondsToTicks(IndexBudgetMs * 1000.0);
+		uint32_t sinceCheck = 0;
+		// a line costs a few nanoseconds unless the text search is long, so the clock is read
+		// only every so often
+		auto overBudget = [&]() {
+			if (++sinceCheck < 1024)
+				return false;
+			sinceCheck = 0;
+			return Profiler::Now() - start > budget;
+		};
+
+		while (m_SourceCursor < m_Source.size())
+		{
+			const uint32_t i = m_Source[m_SourceCursor++];
+			if (Matches(m_Lines[i], m_Active))
+				m_Filtered.push_back(i);
+			if (overBudget())
+				break;
+		}
+		if (m_SourceCursor == m_Source.size())
+		{
+			m_Source.clear();
+			m_SourceCursor = 0;
+			const uint32_t lineCount = (uint32_t)m_Lines.size();
+			while (m_IndexedCount < lineCount)
+			{
+				const uint32_t i = m_IndexedCount++;
+				if (Matches(m_Lines[i], m_Active))
+					m_Filtered.push_back(i);
+				if (overBudget())
+					break;
+			}
+		}
+
+		m_IndexMs = Profiler::TicksToMilliseconds(Profiler::Now() - start);
+	}
+
+	void LogConsolePanel::OnImGuiRender(bool* open)
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		if (!ImGui::Begin("Console", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		DrawToolbar();
+		ApplyFilter();
+		AdvanceIndex();
+		DrawLines();
+
+		ImGui::End();
+	}
+
+	void LogConsolePanel::DrawToolbar()
+	{
+		for (uint32_t level = 0; level < LevelCount; level++)
+		{
+			char label[48];
+			snprintf(label, sizeof(label), "%s (%llu)##Level%u", s_LevelNames[level], (unsigned long long)m_LevelCounts[level], level);
+			bool enabled = (m_Edit.LevelMask & (1u << level)) != 0;
+			ImGui::PushStyleColor(ImGuiCol_Text, s_LevelColors[level]);
+			if (ImGui::Checkbox(label, &enabled))
+				m_Edit.LevelMask ^= 1u << level;
+			ImGui::PopStyleColor();
+			ImGui::SameLine();
+		}
+		ImGui::NewLine();
+
+		for (size_t logger = 0; logger < m_Loggers.size(); logger++)
+		{
+			bool enabled = (m_Edit.LoggerMask & (1u << logger)) != 0;
+			if (ImGui::Checkbox(m_Loggers[logger].c_str(), &enabled))
+				m_Edit.LoggerMask ^= 1u << logger;
+			ImGui::SameLine();
+		}
+
+		ImGui::SetNextItemWidth(240.0f);
+		if (ImGui::InputTextWithHint("##Search", "search", m_SearchBuffer, sizeof(m_SearchBuffer)))
+		{
+			m_Edit.Text.clear();
+			for (const char* c = m_SearchBuffer; *c; c++)
+				m_Edit.Text.push_back(ToLower(*c));
+		}
+		ImGui::SameLine();
+		ImGui::Checkbox("Auto-scroll", &m_AutoScroll);
+		ImGui::SameLine();
+		if (ImGui::Button("Clear"))
+			Clear();
+
+		const std::shared_ptr<LogRingSink>& sink = Log::GetConsoleSink();
+		const uint64_t lost = sink ? sink->GetLostCount() : 0;
+		const uint32_t pending = (uint32_t)(m_Source.size() - m_SourceCursor) + (uint32_t)m_Lines.size() - m_IndexedCount;
+		if (pending > 0)
+			ImGui::TextDisabled("%u lines, %u shown, indexing %u more (%.2f ms/frame)  lost %llu", (uint32_t)m_Lines.size(),
+				(uint32_t)m_Filtered.size(), pending, m_IndexMs, (unsigned long long)lost);
+		else
+			ImGui::TextDisabled("%u lines, %u shown  lost %llu", (uint32_t)m_Lines.size(), (uint32_t)m_Filtered.size(), (unsigned long long)lost);
+	}
+
+	void LogConsolePanel::DrawLines()
+	{
+		const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable |
+			ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingFixedFit;
+		if (!ImGui::BeginTable("##ConsoleLines", 4, flags))
+			return;
+
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Time");
+		ImGui::TableSetupColumn("Level");
+		ImGui::TableSetupColumn("Logger");
+		ImGui::TableSetupColumn("Message", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableHeadersRow();
+
+		// only the rows in view are submitted, however many lines pass the filter
+		const bool atBottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+		ImGuiListClipper clipper;
+		clipper.Begin((int)m_Filtered.size());
+		while (clipper.Step())
+		{
+			for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+			{
+				const Line& line = m_Lines[m_Filtered[row]];
+				ImGui::TableNextRow();
+
+				ImGui::TableNextColumn();
+				const time_t seconds = (time_t)(line.Time / 1000000000);
+				char stamp[16];
+				strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&seconds));
+				ImGui::Text("%s.%03d", stamp, (int)(line.Time / 1000000 % 1000));
+
+				ImGui::TableNextColumn();
+				ImGui::TextColored(s_LevelColors[line.Level], "%s", s_LevelNames[line.Level]);
+
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(m_Loggers[line.Logger].c_str());
+
+				ImGui::TableNextColumn();
+				const char* text = m_Text.data() + line.TextOffset;
+				ImGui::TextUnformatted(text, text + line.TextLength);
+			}
+		}
+
+		if (m_AutoScroll && atBottom)
+			ImGui::SetScrollHereY(1.0f);
+		ImGui::EndTable();
+	}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Core/LogRingSink.h"
+
+namespace Luft {
+
+	// Console over the messages Log's ring sink collects. Lines are copied into the panel's own
+	// store, so far more are retained than the sink holds, and only the visible rows are drawn.
+	// The filtered view is an index of line numbers that is extended as lines arrive and rebuilt
+	// within a per-frame time budget when the filter changes; narrowing a filter only re-checks
+	// the lines that passed the previous one.
+	class LogConsolePanel
+	{
+	public:
+		// past either limit the oldest quarter of the lines is dropped
+		static constexpr uint32_t MaxLines = 1u << 22;
+		static constexpr uint32_t MaxTextBytes = 256u << 20;
+		// time a frame may spend rebuilding the filtered index
+		static constexpr double IndexBudgetMs = 2.0;
+
+		LogConsolePanel();
+
+		// drains the sink. Called every frame, open or not, so nothing is lost while it's hidden
+		void Update();
+		void OnImGuiRender(bool* open);
+		void Clear();
+
+	private:
+		static constexpr uint32_t LevelCount = 6;
+		static constexpr uint32_t MaxLoggers = 32;
+
+		struct Line
+		{
+			// nanoseconds since the epoch
+			int64_t Time;
+			uint32_t TextOffset;
+			uint16_t TextLength;
+			uint8_t Level;
+			uint8_t Logger;
+		};
+
+		struct Filter
+		{
+			// bit per spdlog level and per logger id
+			uint32_t LevelMask = ~0u;
+			uint32_t LoggerMask = ~0u;
+			// lower case, matched case-insensitively
+			lstr Text;
+
+			bool operator==(const Filter& o) const { return LevelMask == o.LevelMask && LoggerMask == o.LoggerMask && Text == o.Text; }
+			bool operator!=(const Filter& o) const { return !(*this == o); }
+			// everything this filter passes, o passes too
+			bool IsNarrowerThan(const Filter& o) const;
+		};
+
+		uint8_t FindLogger(const char* name);
+		bool Matches(const Line& line, const Filter& filter) const;
+		void ApplyFilter();
+		void AdvanceIndex();
+		void Trim();
+
+		void DrawToolbar();
+		void DrawLines();
+
+		larray<Line> m_Lines;
+		larray<char> m_Text;
+		larray<lstr> m_Loggers;
+		uint64_t m_LevelCounts[LevelCount] = {};
+		larray<LogRecord> m_ReadBuffer;
+
+		// m_Filtered holds the lines passing m_Active found so far. The index is built from
+		// m_Source first, the previous filter's result when narrowing, then from the lines at
+		// m_IndexedCount onwards
+		Filter m_Active;
+		Filter m_Edit;
+		larray<uint32_t> m_Filtered;
+		larray<uint32_t> m_Source;
+		uint32_t m_SourceCursor = 0;
+		uint32_t m_IndexedCount = 0;
+
+		char m_SearchBuffer[256] = {};
+		bool m_AutoScroll = true;
+		double m_IndexMs = 0.0;
+	};
+
+}
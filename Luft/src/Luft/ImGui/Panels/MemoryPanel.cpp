@@ -0,0 +1,138 @@
+#include "MemoryPanel.h"
+
+#include <stdio.h>
+#include <imgui.h>
+
+namespace Luft {
+
+	static void FormatBytes(char* buf, size_t bufSize, double bytes, bool sign)
+	{
+		const char* units[] = { "B", "KB", "MB", "GB" };
+		double v = bytes < 0 ? -bytes : bytes;
+		int unit = 0;
+		while (v >= 1024.0 && unit < 3)
+		{
+			v /= 1024.0;
+			unit++;
+		}
+		const char* prefix = bytes < 0 ? "-" : (sign && bytes > 0 ? "+" : "");
+		if (unit == 0)
+			snprintf(buf, bufSize, "%s%.0f %s", prefix, v, units[unit]);
+		else
+			snprintf(buf, bufSize, "%s%.2f %s", prefix, v, units[unit]);
+	}
+
+	static void BytesCell(double bytes, bool sign = false)
+	{
+		char buf[32];
+		FormatBytes(buf, sizeof(buf), bytes, sign);
+		ImGui::TableNextColumn();
+		if (sign && bytes > 0)
+			ImGui::TextColored(ImVec4(1.0f, 0.55f, 0.45f, 1.0f), "%s", buf);
+		else
+			ImGui::TextUnformatted(buf);
+	}
+
+	void MemoryPanel::OnImGuiRender(bool* open)
+	{
+		if (!ImGui::Begin("Memory", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const MemorySnapshot& current = Memory::GetFrameSnapshot();
+		const MemorySnapshot frameDiff = current.Diff(Memory::GetPreviousFrameSnapshot());
+
+		if (ImGui::Button("Capture Snapshot"))
+		{
+			m_Snapshot = current;
+			m_HasSnapshot = true;
+		}
+		if (m_HasSnapshot)
+		{
+			ImGui::SameLine();
+			if (ImGui::Button("Clear Snapshot"))
+				m_HasSnapshot = false;
+			ImGui::SameLine();
+			ImGui::Text("captured %.1f s ago", current.Time - m_Snapshot.Time);
+		}
+
+		const MemorySnapshot snapDiff = current.Diff(m_Snapshot);
+		const int columns = m_HasSnapshot ? 8 : 6;
+		const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingStretchProp;
+		if (ImGui::BeginTable("##MemoryTags", columns, flags))
+		{
+			ImGui::TableSetupColumn("Tag");
+			ImGui::TableSetupColumn("Live");
+			ImGui::TableSetupColumn("Peak");
+			ImGui::TableSetupColumn("Allocs");
+			ImGui::TableSetupColumn("Rate/s");
+			ImGui::TableSetupColumn("Frame");
+			if (m_HasSnapshot)
+			{
+				ImGui::TableSetupColumn("Since Snapshot");
+				ImGui::TableSetupColumn("Allocs Since");
+			}
+			ImGui::TableHeadersRow();
+
+			MemoryTagStats total;
+			int64_t totalPeak = 0;
+			double totalRate = 0.0;
+			MemoryTagStats totalFrame;
+			MemoryTagStats totalSnap;
+
+			for (size_t i = 0; i < (size_t)MemoryTag::Count; i++)
+			{
+				const MemoryTag tag = (MemoryTag)i;
+				const MemoryTagStats& s = current.Tags[i];
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(Memory::GetTagName(tag));
+				BytesCell((double)s.LiveBytes);
+				BytesCell((double)Memory::GetPeakBytes(tag));
+				ImGui::TableNextColumn();
+				ImGui::Text("%lld", (long long)s.LiveCount);
+				BytesCell(Memory::GetAllocRate(tag));
+				BytesCell((double)frameDiff.Tags[i].LiveBytes, true);
+				if (m_HasSnapshot)
+				{
+					BytesCell((double)snapDiff.Tags[i].LiveBytes, true);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)snapDiff.Tags[i].TotalAllocCount);
+				}
+
+				total.LiveBytes += s.LiveBytes;
+				total.LiveCount += s.LiveCount;
+				totalPeak += Memory::GetPeakBytes(tag);
+				totalRate += Memory::GetAllocRate(tag);
+				totalFrame.LiveBytes += frameDiff.Tags[i].LiveBytes;
+				totalSnap.LiveBytes += snapDiff.Tags[i].LiveBytes;
+				totalSnap.TotalAllocCount += snapDiff.Tags[i].TotalAllocCount;
+			}
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted("Total");
+			BytesCell((double)total.LiveBytes);
+			// sum of per-tag peaks, an upper bound of the real combined peak
+			BytesCell((double)totalPeak);
+			ImGui::TableNextColumn();
+			ImGui::Text("%lld", (long long)total.LiveCount);
+			BytesCell(totalRate);
+			BytesCell((double)totalFrame.LiveBytes, true);
+			if (m_HasSnapshot)
+			{
+				BytesCell((double)totalSnap.LiveBytes, true);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)totalSnap.TotalAllocCount);
+			}
+
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Luft/Core/Memory.h"
+
+namespace Luft {
+
+	// per-tag view of the tracking heap, with a captured snapshot to diff growth against
+	class MemoryPanel
+	{
+	public:
+		MemoryPanel() = default;
+
+		void OnImGuiRender(bool* open);
+
+	private:
+		MemorySnapshot m_Snapshot;
+		bool m_HasSnapshot = false;
+	};
+
+}
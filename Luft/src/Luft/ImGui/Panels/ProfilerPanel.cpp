@@ -0,0 +1,705 @@
+#include "ProfilerPanel.h"
+
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include <imgui.h>
+#include <imgui_internal.h>
+#include "ImSequencer.h"
+#include "ImCurveEdit.h"
+
+namespace Luft {
+
+	namespace
+	{
+		// merging keeps a run per nesting level up to this one, deeper zones share the last level
+		constexpr uint32_t MaxMergeDepth = 64;
+		// name table size, must be a power of two. Stops accepting new names at half load
+		constexpr uint32_t StatsTableSize = 4096;
+		// at LOD scale 1, zones shorter than 1/2048th of the frame are merged: below a pixel even
+		// on a 4K wide flame graph
+		constexpr uint64_t BaseMergeDivisor = 2048;
+
+		constexpr float LaneHeaderHeight = 18.0f;
+		constexpr float RowHeight = 18.0f;
+		// zones narrower than this are folded into per-row pixel runs while drawing
+		constexpr float MinZonePixels = 2.0f;
+
+		inline uint32_t HashName(const char* name)
+		{
+			uint64_t h = (uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ull;
+			return (uint32_t)(h >> 32);
+		}
+
+		inline ImU32 ZoneColor(const char* name, bool merged)
+		{
+			if (merged || name == NULL)
+				return IM_COL32(110, 110, 120, 255);
+			const float hue = (float)(HashName(name) & 0xffff) / 65535.0f;
+			return (ImU32)ImColor::HSV(hue, 0.45f, 0.75f);
+		}
+
+		inline uint16_t AddCount(uint16_t a, uint32_t b)
+		{
+			uint32_t sum = (uint32_t)a + b;
+			return sum > 0xffff ? 0xffff : (uint16_t)sum;
+		}
+
+		inline uint32_t ZoneCount(const ProfileZone&) { return 1; }
+		template <typename ZoneT>
+		inline uint32_t ZoneCount(const ZoneT& zone) { return zone.Count; }
+	}
+
+	// === ImCurveEdit adapter: frame times over the history, one point per frame ===
+
+	struct ProfilerPanel::FrameTimeCurve : public ImCurveEdit::Delegate
+	{
+		larray<ImVec2> Points;
+		ImVec2 Min = ImVec2(0.0f, 0.0f);
+		ImVec2 Max = ImVec2((float)HistorySize - 1.0f, 33.3f);
+
+		size_t GetCurveCount() override { return 1; }
+		ImCurveEdit::CurveType GetCurveType(size_t) const override { return ImCurveEdit::CurveLinear; }
+		ImVec2& GetMin() override { return Min; }
+		ImVec2& GetMax() override { return Max; }
+		size_t GetPointCount(size_t) override { return Points.size(); }
+		uint32_t GetCurveColor(size_t) override { return 0xFF40C0FF; }
+		ImVec2* GetPoints(size_t) override { return Points.data(); }
+		// read-only, points are only selectable
+		int EditPoint(size_t, int pointIndex, ImVec2) override { return pointIndex; }
+		void AddPoint(size_t, ImVec2) override {}
+		unsigned int GetBackgroundColor() override { return 0xFF1E1E1E; }
+	};
+
+	// === ImSequencer adapter: one lane per thread spanning the frame history ===
+
+	struct ProfilerPanel::ThreadTimeline : public ImSequencer::SequenceInterface
+	{
+		ProfilerPanel* Panel;
+		int Start = 0;
+		int End = 0;
+
+		ThreadTimeline(ProfilerPanel* panel) : Panel(panel)
+		{
+			End = panel->GetStoredFrameCount() > 0 ? (int)panel->GetStoredFrameCount() - 1 : 0;
+		}
+
+		int GetFrameMin() const override { return 0; }
+		int GetFrameMax() const override { return End; }
+		int GetItemCount() const override { return (int)Panel->m_Threads.size(); }
+		const char* GetItemLabel(int index) const override { return Panel->m_Threads[index].Name.c_str(); }
+
+		void Get(int, int** start, int** end, int* type, unsigned int* color) override
+		{
+			// lanes always cover the whole history and can't be edited
+			if (start)
+				*start = &Start;
+			if (end)
+				*end = &End;
+			if (type)
+				*type = 0;
+			if (color)
+				*color = 0xFF303030;
+		}
+
+		// per-frame busy time of the lane's thread, as a bar relative to the frame's length
+		void CustomDrawCompact(int index, ImDrawList* drawList, const ImRect& rc, const ImRect& clippingRect) override
+		{
+			const uint32_t frameCount = Panel->GetStoredFrameCount();
+			if (frameCount == 0)
+				return;
+
+			const uint32_t threadId = Panel->m_Threads[index].Id;
+			const float framePixels = rc.GetWidth() / (float)(End + 2);
+			const float left = rc.Min.x - 0.5f * framePixels;
+
+			uint32_t first = 0;
+			if (clippingRect.Min.x > left)
+				first = (uint32_t)((clippingRect.Min.x - left) / framePixels);
+			uint32_t last = (uint32_t)((clippingRect.Max.x - left) / framePixels) + 1;
+			if (last > frameCount)
+				last = frameCount;
+
+			drawList->PushClipRect(clippingRect.Min, clippingRect.Max, true);
+			for (uint32_t f = first; f < last; f++)
+			{
+				StoredFrame& frame = Panel->GetStoredFrame(f);
+				if (threadId >= frame.ThreadBusyMs.size() || frame.End <= frame.Start)
+					continue;
+
+				const float frameMs = (float)Profiler::TicksToMilliseconds(frame.End - frame.Start);
+				float ratio = frame.ThreadBusyMs[threadId] / frameMs;
+				ratio = ImClamp(ratio, 0.0f, 1.0f);
+				if (ratio <= 0.0f)
+					continue;
+
+				const float x0 = left + f * framePixels;
+				const float x1 = x0 + ImMax(framePixels - 1.0f, 1.0f);
+				const float y1 = rc.Max.y - 2.0f;
+				const float y0 = y1 - ratio * (rc.GetHeight() - 4.0f);
+				const ImU32 col = ImColor(ImLerp(ImVec4(0.3f, 0.8f, 0.4f, 1.0f), ImVec4(0.95f, 0.35f, 0.3f, 1.0f), ratio));
+				drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), col);
+			}
+			drawList->PopClipRect();
+		}
+	};
+
+	ProfilerPanel::ProfilerPanel()
+	{
+		m_StatsTable.resize(StatsTableSize);
+	}
+
+	ProfilerPanel::~ProfilerPanel()
+	{
+		for (ZoneStats* stats : m_Stats)
+			delete stats;
+	}
+
+	ProfilerPanel::ZoneStats* ProfilerPanel::FindStats(const char* name)
+	{
+		uint32_t idx = HashName(name) & (StatsTableSize - 1);
+		while (m_StatsTable[idx] != NULL)
+		{
+			if (m_StatsTable[idx]->Name == name)
+				return m_StatsTable[idx];
+			idx = (idx + 1) & (StatsTableSize - 1);
+		}
+
+		if (m_Stats.size() >= StatsTableSize / 2)
+			return NULL;
+
+		ZoneStats* stats = new ZoneStats();
+		stats->Name = name;
+		m_StatsTable[idx] = stats;
+		m_Stats.push_back(stats);
+		return stats;
+	}
+
+	template <typename ZoneT>
+	void ProfilerPanel::MergeZones(const ZoneT* zones, size_t count, uint64_t minTicks, larray<StoredZone>& out)
+	{
+		// zones come out of the rings grouped by thread, and on one thread zones at the same depth
+		// are recorded in time order, so a pending run per depth is all the state merging needs
+		StoredZone pending[MaxMergeDepth];
+		bool hasPending[MaxMergeDepth] = {};
+		uint32_t pendingTop = 0;
+		uint32_t thread = ~0u;
+
+		auto flushFrom = [&](uint32_t depth) {
+			for (uint32_t d = depth; d < pendingTop; d++)
+			{
+				if (hasPending[d])
+				{
+					out.push_back(pending[d]);
+					hasPending[d] = false;
+				}
+			}
+			if (depth < pendingTop)
+				pendingTop = depth;
+		};
+
+		out.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			const ZoneT& zone = zones[i];
+			if (zone.ThreadId != thread)
+			{
+				flushFrom(0);
+				thread = zone.ThreadId;
+			}
+
+			StoredZone stored;
+			stored.Name = zone.Name;
+			stored.Start = zone.Start;
+			stored.End = zone.End;
+			stored.ThreadId = zone.ThreadId;
+			stored.Depth = (uint16_t)(zone.Depth < 0xffff ? zone.Depth : 0xffff);
+			stored.Count = AddCount(0, ZoneCount(zone));
+
+			const uint32_t depth = zone.Depth < MaxMergeDepth ? zone.Depth : MaxMergeDepth - 1;
+			if (zone.End - zone.Start < minTicks)
+			{
+				// a short zone below the last level folds into the run there, drawn at that level.
+				// Those come in mixed depths so out of time order, a parent after its children
+				stored.Depth = (uint16_t)depth;
+				StoredZone& run = pending[depth];
+				if (hasPending[depth] && zone.Start <= run.End + minTicks)
+				{
+					if (zone.Start < run.Start)
+						run.Start = zone.Start;
+					if (zone.End > run.End)
+						run.End = zone.End;
+					if (run.Name != zone.Name)
+						run.Name = NULL;
+					run.Count = AddCount(run.Count, ZoneCount(zone));
+				}
+				else
+				{
+					if (hasPending[depth])
+						out.push_back(run);
+					run = stored;
+					hasPending[depth] = true;
+					if (depth + 1 > pendingTop)
+						pendingTop = depth + 1;
+				}
+			}
+			else
+			{
+				// a visible zone closes any run nested inside it, those can't continue past it
+				flushFrom(depth);
+				out.push_back(stored);
+			}
+		}
+		flushFrom(0);
+	}
+
+	void ProfilerPanel::Ingest()
+	{
+		const uint64_t frameIndex = Profiler::GetFrameIndex();
+		if (m_Paused || frameIndex == m_LastIngestedFrame)
+			return;
+		m_LastIngestedFrame = frameIndex;
+
+		const larray<ProfileZone>& zones = Profiler::GetLastFrameZones();
+		const uint32_t slot = m_FrameHead;
+		StoredFrame& frame = m_Frames[slot];
+		frame.Index = frameIndex - 1;
+		frame.Start = Profiler::GetLastFrameStart();
+		frame.End = Profiler::GetLastFrameEnd();
+		frame.RecordedZones = (uint32_t)zones.size();
+
+		// statistics are taken from the full resolution zones before merging
+		for (ZoneStats* stats : m_Stats)
+		{
+			stats->FrameMs[slot] = 0.0f;
+			stats->FrameCalls[slot] = 0;
+		}
+		frame.ThreadBusyMs.clear();
+		// zones with the same name tend to come in runs, skip the table for repeats
+		const char* lastName = NULL;
+		ZoneStats* stats = NULL;
+		const double msPerTick = Profiler::TicksToMilliseconds(1000000) / 1000000.0;
+		for (const ProfileZone& zone : zones)
+		{
+			const float ms = (float)((double)(zone.End - zone.Start) * msPerTick);
+			if (zone.Name != lastName)
+			{
+				stats = FindStats(zone.Name);
+				lastName = zone.Name;
+			}
+			if (stats)
+			{
+				stats->FrameMs[slot] += ms;
+				stats->FrameCalls[slot]++;
+			}
+			if (zone.Depth == 0)
+			{
+				if (zone.ThreadId >= frame.ThreadBusyMs.size())
+					frame.ThreadBusyMs.resize(zone.ThreadId + 1);
+				frame.ThreadBusyMs[zone.ThreadId] += ms;
+			}
+		}
+
+		const uint64_t frameTicks = frame.End > frame.Start ? frame.End - frame.Start : 1;
+		uint64_t minTicks = (uint64_t)((double)(frameTicks / BaseMergeDivisor) * m_LodScale);
+		if (minTicks == 0)
+			minTicks = 1;
+		MergeZones(zones.data(), zones.size(), minTicks, frame.Zones);
+
+		// still over the storage budget: coarsen until the frame fits. Once zones as long as the
+		// frame merge, each thread is down to a run per level and more passes won't help, the
+		// rest is cut off
+		larray<StoredZone> coarse;
+		while (frame.Zones.size() > MaxStoredZones && minTicks <= frameTicks)
+		{
+			minTicks *= 4;
+			MergeZones(frame.Zones.data(), frame.Zones.size(), minTicks, coarse);
+			frame.Zones.swap(coarse);
+		}
+		if (frame.Zones.size() > MaxStoredZones)
+			frame.Zones.resize(MaxStoredZones);
+
+		m_FrameHead = (m_FrameHead + 1) % HistorySize;
+		if (m_FrameCount < HistorySize)
+			m_FrameCount++;
+	}
+
+	void ProfilerPanel::RefreshStats()
+	{
+		m_Threads = Profiler::GetThreads();
+		std::sort(m_Threads.begin(), m_Threads.end(), [](const ProfileThreadInfo& a, const ProfileThreadInfo& b) { return a.Id < b.Id; });
+
+		m_StatsRows.clear();
+		if (m_FrameCount == 0)
+			return;
+
+		float samples[HistorySize];
+		for (const ZoneStats* stats : m_Stats)
+		{
+			ZoneStatsRow row;
+			row.Name = stats->Name;
+			row.MinMs = FLT_MAX;
+			row.MaxMs = 0.0f;
+			double sum = 0.0;
+			uint64_t calls = 0;
+			for (uint32_t pos = 0; pos < m_FrameCount; pos++)
+			{
+				const uint32_t slot = GetSlot(pos);
+				const float ms = stats->FrameMs[slot];
+				samples[pos] = ms;
+				sum += ms;
+				calls += stats->FrameCalls[slot];
+				row.MinMs = ImMin(row.MinMs, ms);
+				row.MaxMs = ImMax(row.MaxMs, ms);
+			}
+			if (calls == 0)
+				continue;
+
+			row.AvgMs = (float)(sum / m_FrameCount);
+			row.CallsPerFrame = (float)calls / (float)m_FrameCount;
+			const uint32_t p99 = (uint32_t)ceil(0.99 * m_FrameCount) - 1;
+			std::nth_element(samples, samples + p99, samples + m_FrameCount);
+			row.P99Ms = samples[p99];
+			m_StatsRows.push_back(row);
+		}
+
+		std::sort(m_StatsRows.begin(), m_StatsRows.end(), [](const ZoneStatsRow& a, const ZoneStatsRow& b) { return a.AvgMs > b.AvgMs; });
+	}
+
+	void ProfilerPanel::OnImGuiRender(bool* open)
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		// keep recording while collapsed, so history is there when the window is opened again
+		const uint64_t ingestStart = Profiler::Now();
+		Ingest();
+		const uint64_t ingestEnd = Profiler::Now();
+
+		const double now = ImGui::GetTime();
+		if (now - m_LastStatsRefresh > 0.25 || m_Threads.empty())
+		{
+			RefreshStats();
+			m_LastStatsRefresh = now;
+		}
+
+		if (m_SelectedFrame < 0 || !m_Paused)
+			m_SelectedFrame = (int)m_FrameCount - 1;
+		if (m_SelectedFrame >= (int)m_FrameCount)
+			m_SelectedFrame = (int)m_FrameCount - 1;
+
+		if (ImGui::Begin("Profiler", open))
+		{
+			DrawToolbar();
+			DrawFrameGraph();
+			DrawTimeline();
+			DrawFlameGraph();
+			DrawStatsTable();
+		}
+		ImGui::End();
+
+		// smoothed self cost. Over budget the panel merges more aggressively, well under it the
+		// detail comes back
+		const double ingestMs = Profiler::TicksToMilliseconds(ingestEnd - ingestStart);
+		const double drawMs = Profiler::TicksToMilliseconds(Profiler::Now() - ingestEnd);
+		m_IngestMs = m_IngestMs * 0.9 + ingestMs * 0.1;
+		m_DrawMs = m_DrawMs * 0.9 + drawMs * 0.1;
+		if (m_IngestMs + m_DrawMs > BudgetMs && m_LodScale < 1024.0)
+			m_LodScale *= 2.0;
+		else if (m_IngestMs + m_DrawMs < BudgetMs * 0.25 && m_LodScale > 1.0)
+			m_LodScale *= 0.5;
+	}
+
+	void ProfilerPanel::DrawToolbar()
+	{
+		if (ImGui::Button(m_Paused ? "Resume" : "Pause"))
+			m_Paused = !m_Paused;
+		ImGui::SameLine();
+
+		if (m_FrameCount > 0)
+		{
+			ImGui::SetNextItemWidth(200.0f);
+			if (ImGui::SliderInt("##Frame", &m_SelectedFrame, 0, (int)m_FrameCount - 1, "frame %d"))
+				m_Paused = true;
+			ImGui::SameLine();
+
+			const StoredFrame& frame = GetStoredFrame((uint32_t)m_SelectedFrame);
+			ImGui::Text("#%llu  %.3f ms  %u zones (%u stored)", (unsigned long long)frame.Index,
+				Profiler::TicksToMilliseconds(frame.End - frame.Start), frame.RecordedZones, (uint32_t)frame.Zones.size());
+		}
+
+		ImGui::TextDisabled("panel %.3f ms (budget %.1f ms)  LOD x%.0f  dropped zones %llu", m_IngestMs + m_DrawMs, BudgetMs, m_LodScale,
+			(unsigned long long)Profiler::GetDroppedZoneCount());
+	}
+
+	void ProfilerPanel::DrawFrameGraph()
+	{
+		if (m_FrameCount == 0)
+			return;
+
+		FrameTimeCurve curve;
+		curve.Points.resize(m_FrameCount);
+		float maxMs = 16.7f;
+		const float offset = (float)(HistorySize - m_FrameCount);
+		for (uint32_t pos = 0; pos < m_FrameCount; pos++)
+		{
+			const StoredFrame& frame = GetStoredFrame(pos);
+			const float ms = (float)Profiler::TicksToMilliseconds(frame.End - frame.Start);
+			curve.Points[pos] = ImVec2(offset + pos, ms);
+			maxMs = ImMax(maxMs, ms);
+		}
+		curve.Max.y = maxMs * 1.1f;
+
+		// clicking a point selects that frame
+		ImVector<ImCurveEdit::EditPoint> selection;
+		ImCurveEdit::Edit(curve, ImVec2(ImGui::GetContentRegionAvail().x, 80.0f), ImGui::GetID("##FrameTimes"), NULL, &selection);
+		const int selected = selection.empty() ? -1 : selection[0].pointIndex;
+		if (selected != m_GraphSelection)
+		{
+			m_GraphSelection = selected;
+			if (selected >= 0 && selected < (int)m_FrameCount)
+			{
+				m_SelectedFrame = selected;
+				m_Paused = true;
+			}
+		}
+	}
+
+	void ProfilerPanel::DrawTimeline()
+	{
+		if (m_FrameCount == 0 || m_Threads.empty())
+			return;
+
+		ThreadTimeline timeline(this);
+		const float height = 20.0f * (m_Threads.size() + 1) + 40.0f;
+		if (ImGui::BeginChild("##ProfilerTimeline", ImVec2(0.0f, height)))
+		{
+			int current = m_SelectedFrame;
+			ImSequencer::Sequencer(&timeline, &current, &m_TimelineExpanded, NULL, &m_TimelineFirstFrame, ImSequencer::SEQUENCER_CHANGE_FRAME);
+			if (current != m_SelectedFrame)
+			{
+				m_SelectedFrame = ImClamp(current, 0, (int)m_FrameCount - 1);
+				m_Paused = true;
+			}
+		}
+		ImGui::EndChild();
+	}
+
+	void ProfilerPanel::DrawFlameGraph()
+	{
+		if (m_FrameCount == 0 || m_SelectedFrame < 0)
+			return;
+
+		const StoredFrame& frame = GetStoredFrame((uint32_t)m_SelectedFrame);
+		if (frame.End <= frame.Start)
+			return;
+
+		// lane layout: one lane per thread, as deep as its deepest zone
+		uint32_t maxThread = 0;
+		for (const StoredZone& zone : frame.Zones)
+			maxThread = ImMax(maxThread, zone.ThreadId);
+		larray<uint32_t> laneDepth;
+		laneDepth.resize(maxThread + 1);
+		larray<bool> laneUsed;
+		laneUsed.resize(maxThread + 1);
+		for (const StoredZone& zone : frame.Zones)
+		{
+			laneUsed[zone.ThreadId] = true;
+			laneDepth[zone.ThreadId] = ImMax(laneDepth[zone.ThreadId], (uint32_t)zone.Depth + 1);
+		}
+
+		larray<float> laneY;
+		laneY.resize(maxThread + 1);
+		larray<uint32_t> rowBase;
+		rowBase.resize(maxThread + 1);
+		float height = 0.0f;
+		uint32_t rows = 0;
+		for (uint32_t t = 0; t <= maxThread; t++)
+		{
+			if (!laneUsed[t])
+				continue;
+			laneY[t] = height;
+			rowBase[t] = rows;
+			height += LaneHeaderHeight + laneDepth[t] * RowHeight;
+			rows += laneDepth[t];
+		}
+		if (rows == 0)
+			return;
+
+		const ImVec2 canvasPos = ImGui::GetCursorScreenPos();
+		const float width = ImMax(ImGui::GetContentRegionAvail().x, 64.0f);
+		ImGui::InvisibleButton("##FlameGraph", ImVec2(width, height));
+		const bool hovered = ImGui::IsItemHovered();
+		ImGuiIO& io = ImGui::GetIO();
+
+		// wheel zooms around the cursor, dragging pans, double click resets
+		double span = m_ViewEnd - m_ViewBegin;
+		if (hovered && io.MouseWheel != 0.0f)
+		{
+			const double pivot = m_ViewBegin + span * ImClamp((io.MousePos.x - canvasPos.x) / width, 0.0f, 1.0f);
+			const double scale = io.MouseWheel > 0.0f ? 0.8 : 1.25;
+			m_ViewBegin = pivot - (pivot - m_ViewBegin) * scale;
+			m_ViewEnd = pivot + (m_ViewEnd - pivot) * scale;
+		}
+		if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0.0f))
+		{
+			const double delta = -io.MouseDelta.x / width * span;
+			m_ViewBegin += delta;
+			m_ViewEnd += delta;
+		}
+		if (hovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+		{
+			m_ViewBegin = 0.0;
+			m_ViewEnd = 1.0;
+		}
+		span = ImMax(m_ViewEnd - m_ViewBegin, 1e-6);
+
+		const double frameTicks = (double)(frame.End - frame.Start);
+		const double viewStart = (double)frame.Start + m_ViewBegin * frameTicks;
+		const double pixelsPerTick = width / (span * frameTicks);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->PushClipRect(canvasPos, ImVec2(canvasPos.x + width, canvasPos.y + height), true);
+		drawList->AddRectFilled(canvasPos, ImVec2(canvasPos.x + width, canvasPos.y + height), IM_COL32(30, 30, 30, 255));
+
+		for (const ProfileThreadInfo& thread : m_Threads)
+		{
+			if (thread.Id > maxThread || !laneUsed[thread.Id])
+				continue;
+			const float y = canvasPos.y + laneY[thread.Id];
+			drawList->AddRectFilled(ImVec2(canvasPos.x, y), ImVec2(canvasPos.x + width, y + LaneHeaderHeight), IM_COL32(45, 45, 50, 255));
+			drawList->AddText(ImVec2(canvasPos.x + 4.0f, y + 2.0f), IM_COL32(200, 200, 200, 255), thread.Name.c_str());
+		}
+
+		// zones too narrow to see are folded into one run per row and pixel span, so the number of
+		// rectangles is bounded by rows * width whatever the zone count
+		struct PixelRun
+		{
+			float X0, X1;
+			uint32_t Count;
+		};
+		larray<PixelRun> runs;
+		runs.resize(rows);
+
+		const StoredZone* hoveredZone = NULL;
+		uint32_t hoveredRunCount = 0;
+		auto flushRun = [&](uint32_t row, float y) {
+			PixelRun& run = runs[row];
+			if (run.Count == 0)
+				return;
+			const ImVec2 p0(canvasPos.x + run.X0, y);
+			const ImVec2 p1(canvasPos.x + ImMax(run.X1, run.X0 + 1.0f), y + RowHeight - 1.0f);
+			drawList->AddRectFilled(p0, p1, IM_COL32(90, 90, 100, 255));
+			if (hovered && ImRect(p0, p1).Contains(io.MousePos))
+				hoveredRunCount = run.Count;
+			run.Count = 0;
+		};
+
+		for (const StoredZone& zone : frame.Zones)
+		{
+			const float x0 = (float)(((double)zone.Start - viewStart) * pixelsPerTick);
+			const float x1 = (float)(((double)zone.End - viewStart) * pixelsPerTick);
+			if (x1 < 0.0f || x0 > width)
+				continue;
+
+			const uint32_t row = rowBase[zone.ThreadId] + zone.Depth;
+			const float y = canvasPos.y + laneY[zone.ThreadId] + LaneHeaderHeight + zone.Depth * RowHeight;
+
+			if (x1 - x0 < MinZonePixels)
+			{
+				PixelRun& run = runs[row];
+				if (run.Count > 0 && x0 <= run.X1 + 1.0f)
+				{
+					run.X1 = ImMax(run.X1, x1);
+					run.Count += zone.Count;
+				}
+				else
+				{
+					flushRun(row, y);
+					run.X0 = ImMax(x0, 0.0f);
+					run.X1 = x1;
+					run.Count = zone.Count;
+				}
+				continue;
+			}
+
+			flushRun(row, y);
+			const bool merged = zone.Count > 1;
+			const ImVec2 p0(canvasPos.x + ImMax(x0, 0.0f), y);
+			const ImVec2 p1(canvasPos.x + ImMin(x1, width), y + RowHeight - 1.0f);
+			drawList->AddRectFilled(p0, p1, ZoneColor(zone.Name, merged));
+			if (p1.x - p0.x > 24.0f)
+			{
+				const char* label = zone.Name ? zone.Name : "[merged]";
+				ImGui::RenderTextClipped(ImVec2(p0.x + 3.0f, p0.y), p1, label, NULL, NULL, ImVec2(0.0f, 0.5f));
+			}
+			if (hovered && ImRect(p0, p1).Contains(io.MousePos))
+				hoveredZone = &zone;
+		}
+		for (uint32_t t = 0; t <= maxThread; t++)
+		{
+			if (!laneUsed[t])
+				continue;
+			for (uint32_t d = 0; d < laneDepth[t]; d++)
+				flushRun(rowBase[t] + d, canvasPos.y + laneY[t] + LaneHeaderHeight + d * RowHeight);
+		}
+		drawList->PopClipRect();
+
+		if (hoveredZone)
+		{
+			ImGui::BeginTooltip();
+			ImGui::TextUnformatted(hoveredZone->Name ? hoveredZone->Name : "[merged zones]");
+			ImGui::Text("%.3f ms", Profiler::TicksToMilliseconds(hoveredZone->End - hoveredZone->Start));
+			if (hoveredZone->Count > 1)
+				ImGui::Text("%u zones merged", (uint32_t)hoveredZone->Count);
+			ImGui::EndTooltip();
+		}
+		else if (hoveredRunCount > 0)
+		{
+			ImGui::SetTooltip("%u zones below display resolution", hoveredRunCount);
+		}
+	}
+
+	void ProfilerPanel::DrawStatsTable()
+	{
+		const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable |
+			ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_ScrollY;
+		if (!ImGui::BeginTable("##ProfilerZones", 6, flags, ImVec2(0.0f, ImMax(ImGui::GetContentRegionAvail().y, 120.0f))))
+			return;
+
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Zone");
+		ImGui::TableSetupColumn("Calls/frame");
+		ImGui::TableSetupColumn("Min ms");
+		ImGui::TableSetupColumn("Avg ms");
+		ImGui::TableSetupColumn("Max ms");
+		ImGui::TableSetupColumn("P99 ms");
+		ImGui::TableHeadersRow();
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)m_StatsRows.size());
+		while (clipper.Step())
+		{
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				const ZoneStatsRow& row = m_StatsRows[i];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(row.Name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", row.CallsPerFrame);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", row.MinMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", row.AvgMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", row.MaxMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", row.P99Ms);
+			}
+		}
+
+		ImGui::EndTable();
+	}
+
+}
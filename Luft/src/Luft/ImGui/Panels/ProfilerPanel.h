@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include "Luft/Core/larray.h"
+#include "Luft/Core/lstr.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	// Live view of the instrumenting profiler: frame time graph, per-thread timeline over the frame
+	// history, a flame graph of the selected frame and per-zone statistics.
+	// Frames are level-of-detail reduced as they're stored, so the panel's own cost stays bounded
+	// however many zones a frame records.
+	class ProfilerPanel
+	{
+	public:
+		// frames kept for scrubbing and statistics
+		static constexpr uint32_t HistorySize = 256;
+		// zones stored per frame after merging, the merge threshold grows until a frame fits
+		static constexpr uint32_t MaxStoredZones = 4096;
+		// time the panel may spend per frame on ingesting and drawing before it coarsens its LOD
+		static constexpr double BudgetMs = 2.0;
+
+		ProfilerPanel();
+		~ProfilerPanel();
+
+		void OnImGuiRender(bool* open);
+
+	private:
+		struct StoredZone
+		{
+			// NULL for a run of merged zones with different names
+			const char* Name;
+			uint64_t Start;
+			uint64_t End;
+			uint32_t ThreadId;
+			uint16_t Depth;
+			// number of recorded zones folded into this one, saturates
+			uint16_t Count;
+		};
+
+		struct StoredFrame
+		{
+			uint64_t Index = 0;
+			uint64_t Start = 0;
+			uint64_t End = 0;
+			uint32_t RecordedZones = 0;
+			larray<StoredZone> Zones;
+			// summed depth 0 zone time per thread id, drives the timeline lanes
+			larray<float> ThreadBusyMs;
+		};
+
+		struct ZoneStats
+		{
+			const char* Name = NULL;
+			// inclusive time and call count per history slot
+			float FrameMs[HistorySize] = {};
+			uint32_t FrameCalls[HistorySize] = {};
+		};
+
+		struct ZoneStatsRow
+		{
+			const char* Name;
+			float MinMs, AvgMs, MaxMs, P99Ms;
+			float CallsPerFrame;
+		};
+
+		// adapters handing the panel's data to ImCurveEdit and ImSequencer
+		struct FrameTimeCurve;
+		struct ThreadTimeline;
+
+		void Ingest();
+		// folds runs of zones shorter than minTicks on the same thread and depth into one zone.
+		// Works on ProfileZone or StoredZone input in drain order
+		template <typename ZoneT>
+		static void MergeZones(const ZoneT* zones, size_t count, uint64_t minTicks, larray<StoredZone>& out);
+		ZoneStats* FindStats(const char* name);
+		void RefreshStats();
+
+		void DrawToolbar();
+		void DrawFrameGraph();
+		void DrawTimeline();
+		void DrawFlameGraph();
+		void DrawStatsTable();
+
+		// history position 0 is the oldest stored frame
+		uint32_t GetStoredFrameCount() const { return m_FrameCount; }
+		StoredFrame& GetStoredFrame(uint32_t pos) { return m_Frames[(m_FrameHead + HistorySize - m_FrameCount + pos) % HistorySize]; }
+		uint32_t GetSlot(uint32_t pos) const { return (m_FrameHead + HistorySize - m_FrameCount + pos) % HistorySize; }
+
+		StoredFrame m_Frames[HistorySize];
+		uint32_t m_FrameHead = 0;
+		uint32_t m_FrameCount = 0;
+		uint64_t m_LastIngestedFrame = 0;
+
+		// open addressed by name pointer, zone names are static strings
+		larray<ZoneStats*> m_StatsTable;
+		larray<ZoneStats*> m_Stats;
+		larray<ZoneStatsRow> m_StatsRows;
+		double m_LastStatsRefresh = 0.0;
+
+		larray<ProfileThreadInfo> m_Threads;
+
+		// scale applied on top of the base merge threshold, raised when over budget
+		double m_LodScale = 1.0;
+		double m_IngestMs = 0.0;
+		double m_DrawMs = 0.0;
+
+		bool m_Paused = false;
+		int m_SelectedFrame = -1;
+		int m_TimelineFirstFrame = 0;
+		int m_GraphSelection = -1;
+		bool m_TimelineExpanded = true;
+
+		// flame graph view as a fraction of the selected frame, [0, 1] shows all of it
+		double m_ViewBegin = 0.0;
+		double m_ViewEnd = 1.0;
+	};
+
+}
@@ -0,0 +1,117 @@
+#include "ViewportPanel.h"
+
+#include <imgui.h>
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft {
+
+	bool ViewportPanel::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight, const VkAllocationCallbacks* allocator)
+	{
+		m_Dirty = true;
+		return m_Target.Init(physicalDevice, device, framesInFlight, allocator);
+	}
+
+	void ViewportPanel::Shutdown()
+	{
+		m_Target.Shutdown();
+		m_Shown = false;
+	}
+
+	void ViewportPanel::OnImGuiRender(uint64_t frame)
+	{
+		m_Shown = false;
+		m_Hovered = false;
+		m_Focused = false;
+		if (!m_Open)
+			return;
+
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+		const bool visible = ImGui::Begin(m_Name.c_str(), &m_Open);
+		ImGui::PopStyleVar();
+		if (!visible)
+		{
+			ImGui::End();
+			return;
+		}
+
+		const ImVec2 avail = ImGui::GetContentRegionAvail();
+		const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+		const uint32_t width = avail.x > 0.0f ? (uint32_t)(avail.x * scale.x + 0.5f) : 0;
+		const uint32_t height = avail.y > 0.0f ? (uint32_t)(avail.y * scale.y + 0.5f) : 0;
+		const double now = ImGui::GetTime();
+		if (width != m_PanelWidth || height != m_PanelHeight)
+		{
+			m_PanelWidth = width;
+			m_PanelHeight = height;
+			m_SizeSince = now;
+		}
+		// the first size is taken right away, there's nothing to stretch yet
+		const bool empty = m_Target.GetTexture() == VK_NULL_HANDLE;
+		if ((width != m_Target.GetWidth() || height != m_Target.GetHeight()) && width > 0 && height > 0
+			&& (empty || now - m_SizeSince >= SettleSeconds))
+		{
+			m_Target.Resize(width, height);
+			m_Dirty = true;
+		}
+
+		VkDescriptorSet texture = (m_Dirty || m_Realtime) ? m_Target.Acquire(frame) : m_Target.GetTexture();
+		if (m_Target.HasPendingRender())
+			m_Dirty = false;
+		if (texture != VK_NULL_HANDLE && width > 0 && height > 0)
+		{
+			ImGui::Image((ImTextureID)texture, avail);
+			m_Shown = true;
+			m_Texture = texture;
+			m_Frame = frame;
+		}
+		m_Hovered = ImGui::IsWindowHovered();
+		m_Focused = ImGui::IsWindowFocused();
+		ImGui::End();
+	}
+
+	void ViewportPanel::Render(VkCommandBuffer cmd)
+	{
+		if (!m_Shown)
+			return;
+		LUFT_PROFILE_FUNCTION();
+		if (m_Target.BeginRender(cmd, m_Clear))
+		{
+			if (m_Render)
+				m_Render(cmd, m_Target.GetWidth(), m_Target.GetHeight());
+			m_Target.EndRender(cmd);
+		}
+	}
+
+	void ViewportPanel::EndFrame(bool submitted)
+	{
+		if (!m_Shown)
+			return;
+		m_Target.EndFrame(submitted);
+		const VkDescriptorSet texture = m_Target.GetTexture();
+		if (texture != m_Texture)
+		{
+			// the acquired buffer wasn't rendered, or was in a command buffer that never ran.
+			// Nothing is drawn before there's an image
+			for (ImGuiViewport* viewport : ImGui::GetPlatformIO().Viewports)
+			{
+				if (viewport->DrawData == nullptr)
+					continue;
+				for (ImDrawList* list : viewport->DrawData->CmdLists)
+				{
+					for (ImDrawCmd& drawCmd : list->CmdBuffer)
+					{
+						if (drawCmd.UserCallback != nullptr || drawCmd.TextureId != (ImTextureID)m_Texture)
+							continue;
+						drawCmd.TextureId = (ImTextureID)texture;
+						if (texture == VK_NULL_HANDLE)
+							drawCmd.ElemCount = 0;
+					}
+				}
+			}
+			m_Texture = texture;
+		}
+		// platform windows draw it even when the frame isn't submitted, that's before the next one
+		m_Target.MarkUsed(m_Frame);
+	}
+
+}
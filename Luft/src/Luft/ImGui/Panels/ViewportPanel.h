@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include "Luft/Core/lstr.h"
+#include "Platform/Vulkan/VulkanRenderTarget.h"
+
+namespace Luft {
+
+	// a scene rendered at the panel's own pixel size into a VulkanRenderTarget. The target follows
+	// the panel once its size has held for SettleSeconds, until then the last image is stretched,
+	// so dragging a splitter doesn't reallocate every frame. Redrawn every frame it's visible when
+	// realtime, otherwise only on RequestRedraw and resizes
+	class ViewportPanel
+	{
+	public:
+		// recorded inside the target's render pass, after the clear, with the viewport set to its size
+		using RenderFn = std::function<void(VkCommandBuffer cmd, uint32_t width, uint32_t height)>;
+
+		static constexpr double SettleSeconds = 0.15;
+
+		explicit ViewportPanel(const lstr& name) : m_Name(name) {}
+
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight, const VkAllocationCallbacks* allocator);
+		void Shutdown();
+
+		const lstr& GetName() const { return m_Name; }
+		VkRenderPass GetRenderPass() const { return m_Target.GetRenderPass(); }
+		void SetRenderCallback(const RenderFn& fn) { m_Render = fn; RequestRedraw(); }
+		void SetClearColor(float r, float g, float b) { m_Clear = { { r, g, b, 1.0f } }; RequestRedraw(); }
+		void SetRealtime(bool realtime) { m_Realtime = realtime; }
+		bool IsRealtime() const { return m_Realtime; }
+		void RequestRedraw() { m_Dirty = true; }
+
+		bool& Open() { return m_Open; }
+		bool IsHovered() const { return m_Hovered; }
+		bool IsFocused() const { return m_Focused; }
+		uint32_t GetWidth() const { return m_Target.GetWidth(); }
+		uint32_t GetHeight() const { return m_Target.GetHeight(); }
+
+		// frame: the number the frame being built is submitted as
+		void OnImGuiRender(uint64_t frame);
+		// the frame has to be rendered even when the UI didn't change
+		bool HasPendingRender() const { return m_Shown && m_Target.HasPendingRender(); }
+		// in the frame's command buffer before ImGui's pass, after the slot's fence was waited on
+		void Render(VkCommandBuffer cmd);
+		// after ImGui::Render, once it's known whether the frame was submitted and before platform
+		// windows are. Those that would draw an image the frame didn't render draw the last one
+		void EndFrame(bool submitted);
+
+	private:
+		lstr m_Name;
+		VulkanRenderTarget m_Target;
+		RenderFn m_Render;
+		VkClearColorValue m_Clear = { { 0.1f, 0.1f, 0.12f, 1.0f } };
+
+		bool m_Open = true;
+		bool m_Realtime = false;
+		bool m_Dirty = true;
+		// drew the target's texture in the frame being built, numbered m_Frame
+		bool m_Shown = false;
+		VkDescriptorSet m_Texture = VK_NULL_HANDLE;
+		uint64_t m_Frame = 0;
+		bool m_Hovered = false;
+		bool m_Focused = false;
+
+		// the size the panel has had since m_SizeSince
+		uint32_t m_PanelWidth = 0;
+		uint32_t m_PanelHeight = 0;
+		double m_SizeSince = 0.0;
+	};
+
+}
@@ -0,0 +1,166 @@
+#include "HeadlessWindow.h"
+#include "Luft/Core/Log.h"
+#include "Platform/Vulkan/VulkanRenderTarget.h"
+#include "Luft/Core/larray.h"
+#include "Version.h"
+
+namespace Luft
+{
+	HeadlessWindow::HeadlessWindow(const WindowProps& props)
+		: m_Width(props.Width), m_Height(props.Height)
+	{
+		CORE_LOG_INFO("Headless window {0}x{1}", m_Width, m_Height);
+		if (props.OffscreenVulkan && !VulkanSetup())
+		{
+			CORE_LOG_WRAN("Offscreen Vulkan unavailable, falling back to the null renderer");
+			Shutdown();
+		}
+	}
+
+	HeadlessWindow::~HeadlessWindow()
+	{
+		Shutdown();
+	}
+
+	bool HeadlessWindow::VulkanSetup()
+	{
+		VkResult err;
+
+		// Create Vulkan Instance, no surface extensions needed
+		{
+			VkApplicationInfo app_info = {};
+			app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+			app_info.pApplicationName = PRODUCT_NAME;
+			app_info.pEngineName = PRODUCT_NAME;
+			app_info.apiVersion = VK_API_VERSION_1_1;
+
+			VkInstanceCreateInfo create_info = {};
+			create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+			create_info.pApplicationInfo = &app_info;
+			err = vkCreateInstance(&create_info, m_VkAllocator, &m_VkInstance);
+			if (err != VK_SUCCESS)
+			{
+				CORE_LOG_ERROR("[vulkan] vkCreateInstance failed: VkResult = {0}", (int)err);
+				m_VkInstance = VK_NULL_HANDLE;
+				return false;
+			}
+		}
+
+		// Select Physical Device, a CPU implementation first so a run is reproducible across machines
+		{
+			uint32_t gpu_count = 0;
+			vkEnumeratePhysicalDevices(m_VkInstance, &gpu_count, NULL);
+			if (gpu_count == 0)
+			{
+				CORE_LOG_ERROR("[vulkan] no physical device, is lavapipe (mesa-vulkan-drivers) installed?");
+				return false;
+			}
+
+			larray<VkPhysicalDevice> gpus;
+			gpus.resize(gpu_count);
+			vkEnumeratePhysicalDevices(m_VkInstance, &gpu_count, gpus.data());
+
+			m_VkPhysicalDevice = gpus[0];
+			for (VkPhysicalDevice& device : gpus)
+			{
+				VkPhysicalDeviceProperties properties;
+				vkGetPhysicalDeviceProperties(device, &properties);
+				if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU)
+				{
+					m_VkPhysicalDevice = device;
+					break;
+				}
+			}
+
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(m_VkPhysicalDevice, &properties);
+			CORE_LOG_INFO("[vulkan] offscreen device: {0}", properties.deviceName);
+		}
+
+		// Select graphics queue family
+		{
+			uint32_t count = 0;
+			larray<VkQueueFamilyProperties> queues;
+			vkGetPhysicalDeviceQueueFamilyProperties(m_VkPhysicalDevice, &count, NULL);
+			queues.resize(count);
+			vkGetPhysicalDeviceQueueFamilyProperties(m_VkPhysicalDevice, &count, queues.data());
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (queues[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+				{
+					m_VkQueueFamily = i;
+					break;
+				}
+			}
+			if (m_VkQueueFamily == (uint32_t)-1)
+			{
+				CORE_LOG_ERROR("[vulkan] no graphics queue");
+				return false;
+			}
+		}
+
+		// Create Logical Device (with 1 queue)
+		{
+			const float queue_priority[] = { 1.0f };
+			VkDeviceQueueCreateInfo queue_info[1] = {};
+			queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queue_info[0].queueFamilyIndex = m_VkQueueFamily;
+			queue_info[0].queueCount = 1;
+			queue_info[0].pQueuePriorities = queue_priority;
+			VkDeviceCreateInfo create_info = {};
+			create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+			create_info.queueCreateInfoCount = sizeof(queue_info) / sizeof(queue_info[0]);
+			create_info.pQueueCreateInfos = queue_info;
+			err = vkCreateDevice(m_VkPhysicalDevice, &create_info, m_VkAllocator, &m_VkDevice);
+			if (err != VK_SUCCESS)
+			{
+				CORE_LOG_ERROR("[vulkan] vkCreateDevice failed: VkResult = {0}", (int)err);
+				m_VkDevice = VK_NULL_HANDLE;
+				return false;
+			}
+			vkGetDeviceQueue(m_VkDevice, m_VkQueueFamily, 0, &m_VkQueue);
+		}
+
+		// Load the pipelines compiled by earlier runs, lavapipe's too
+		m_PipelineCache.Init(m_VkPhysicalDevice, m_VkDevice, "cache", m_VkAllocator);
+
+		// Create Descriptor Pool, same as the windowed path: the font image, the glyph atlas and the
+		// viewport panels' render targets
+		{
+			VkDescriptorPoolSize pool_sizes[] =
+			{
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 + VulkanRenderTarget::PoolTextures },
+			};
+			VkDescriptorPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+			pool_info.maxSets = 2 + VulkanRenderTarget::PoolTextures;
+			pool_info.poolSizeCount = (uint32_t)ARRAYSIZE(pool_sizes);
+			pool_info.pPoolSizes = pool_sizes;
+			err = vkCreateDescriptorPool(m_VkDevice, &pool_info, m_VkAllocator, &m_VkDescriptorPool);
+			if (err != VK_SUCCESS)
+			{
+				CORE_LOG_ERROR("[vulkan] vkCreateDescriptorPool failed: VkResult = {0}", (int)err);
+				m_VkDescriptorPool = VK_NULL_HANDLE;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void HeadlessWindow::Shutdown()
+	{
+		if (m_VkDescriptorPool != VK_NULL_HANDLE)
+			vkDestroyDescriptorPool(m_VkDevice, m_VkDescriptorPool, m_VkAllocator);
+		m_PipelineCache.Shutdown();
+		if (m_VkDevice != VK_NULL_HANDLE)
+			vkDestroyDevice(m_VkDevice, m_VkAllocator);
+		if (m_VkInstance != VK_NULL_HANDLE)
+			vkDestroyInstance(m_VkInstance, m_VkAllocator);
+		m_VkDescriptorPool = VK_NULL_HANDLE;
+		m_VkDevice = VK_NULL_HANDLE;
+		m_VkQueue = VK_NULL_HANDLE;
+		m_VkPhysicalDevice = VK_NULL_HANDLE;
+		m_VkInstance = VK_NULL_HANDLE;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vulkan/vulkan_core.h>
+#include "Luft/Core/Window.h"
+#include "Platform/Vulkan/VulkanPipelineCache.h"
+
+namespace Luft
+{
+	// Window without a display, for CI and benchmark runs. It never produces input and reports a
+	// fixed size. With props.OffscreenVulkan it also owns a Vulkan device without any surface or
+	// swapchain extension, preferring a CPU implementation (lavapipe) so it works on machines
+	// without a GPU; the ImGui layer then renders into an offscreen image instead of presenting.
+	class HeadlessWindow : public Window
+	{
+	public:
+		HeadlessWindow(const WindowProps& props);
+		virtual ~HeadlessWindow();
+
+		void OnUpdate() override { m_PipelineCache.Update(); }
+
+		uint32_t GetWidth() const override { return m_Width; }
+		uint32_t GetHeight() const override { return m_Height; }
+
+		void SetEventCallback(const EventCallbackFn& callback) override { m_EventCallback = callback; }
+		void SetVSync(bool enabled) override { m_VSync = enabled; }
+		bool IsVSync() const override { return m_VSync; }
+
+		void* GetNativeWindow() const override { return nullptr; }
+		bool IsHeadless() const override { return true; }
+
+		// false when offscreen Vulkan wasn't requested or no device could be created
+		bool HasVulkanDevice() const { return m_VkDevice != VK_NULL_HANDLE; }
+		VkInstance GetInstance() const { return m_VkInstance; }
+		VkPhysicalDevice GetPhysicalDevice() const { return m_VkPhysicalDevice; }
+		VkDevice GetDevice() const { return m_VkDevice; }
+		uint32_t GetQueueFamily() const { return m_VkQueueFamily; }
+		VkQueue GetQueue() const { return m_VkQueue; }
+		VkPipelineCache GetPipelineCache() const { return m_PipelineCache.GetHandle(); }
+		VulkanPipelineCache& GetPersistentPipelineCache() { return m_PipelineCache; }
+		VkDescriptorPool GetDescriptorPool() const { return m_VkDescriptorPool; }
+		VkAllocationCallbacks* GetAllocator() const { return m_VkAllocator; }
+
+	private:
+		bool VulkanSetup();
+		void Shutdown();
+
+	private:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		bool m_VSync = false;
+		EventCallbackFn m_EventCallback;
+
+		VkAllocationCallbacks* m_VkAllocator = nullptr;
+		VkInstance m_VkInstance = VK_NULL_HANDLE;
+		VkPhysicalDevice m_VkPhysicalDevice = VK_NULL_HANDLE;
+		uint32_t m_VkQueueFamily = (uint32_t)-1;
+		VkDevice m_VkDevice = VK_NULL_HANDLE;
+		VkQueue m_VkQueue = VK_NULL_HANDLE;
+		VulkanPipelineCache m_PipelineCache;
+		VkDescriptorPool m_VkDescriptorPool = VK_NULL_HANDLE;
+	};
+}
@@ -0,0 +1,247 @@
+#include "VulkanGlyphTexture.h"
+
+#include <string.h>
+#include <backends/imgui_impl_vulkan.h>
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft
+{
+	bool VulkanGlyphTexture::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t width, uint32_t height, uint32_t frameCount, const VkAllocationCallbacks* allocator)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		m_Width = width;
+		m_Height = height;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R8_UNORM;
+		imageInfo.extent = { width, height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (vkCreateImage(device, &imageInfo, allocator, &m_Image) != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] glyph texture: failed to create the image");
+			Shutdown();
+			return false;
+		}
+
+		VkMemoryRequirements req;
+		vkGetImageMemoryRequirements(device, m_Image, &req);
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = req.size;
+		allocInfo.memoryTypeIndex = FindMemoryType(req.memoryTypeBits, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (allocInfo.memoryTypeIndex == (uint32_t)-1 || vkAllocateMemory(device, &allocInfo, allocator, &m_Memory) != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] glyph texture: failed to allocate image memory");
+			Shutdown();
+			return false;
+		}
+		vkBindImageMemory(device, m_Image, m_Memory, 0);
+
+		// the backend's shader multiplies the vertex color by the texel, so coverage goes to alpha
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = m_Image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R8_UNORM;
+		viewInfo.components = { VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_R };
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(device, &viewInfo, allocator, &m_View) != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] glyph texture: failed to create the image view");
+			Shutdown();
+			return false;
+		}
+
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = -1000;
+		samplerInfo.maxLod = 1000;
+		samplerInfo.maxAnisotropy = 1.0f;
+		if (vkCreateSampler(device, &samplerInfo, allocator, &m_Sampler) != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] glyph texture: failed to create the sampler");
+			Shutdown();
+			return false;
+		}
+
+		m_DescriptorSet = ImGui_ImplVulkan_AddTexture(m_Sampler, m_View, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		if (m_DescriptorSet == VK_NULL_HANDLE)
+		{
+			CORE_LOG_ERROR("[vulkan] glyph texture: no descriptor set left in the pool");
+			Shutdown();
+			return false;
+		}
+		m_Staging.resize(frameCount);
+		m_Initialized = false;
+		return true;
+	}
+
+	void VulkanGlyphTexture::Shutdown()
+	{
+		for (Staging& staging : m_Staging)
+			Release(staging);
+		m_Staging.clear();
+
+		if (m_DescriptorSet != VK_NULL_HANDLE)
+			ImGui_ImplVulkan_RemoveTexture(m_DescriptorSet);
+		m_DescriptorSet = VK_NULL_HANDLE;
+		if (m_Sampler != VK_NULL_HANDLE)
+			vkDestroySampler(m_Device, m_Sampler, m_Allocator);
+		m_Sampler = VK_NULL_HANDLE;
+		if (m_View != VK_NULL_HANDLE)
+			vkDestroyImageView(m_Device, m_View, m_Allocator);
+		m_View = VK_NULL_HANDLE;
+		if (m_Image != VK_NULL_HANDLE)
+			vkDestroyImage(m_Device, m_Image, m_Allocator);
+		m_Image = VK_NULL_HANDLE;
+		if (m_Memory != VK_NULL_HANDLE)
+			vkFreeMemory(m_Device, m_Memory, m_Allocator);
+		m_Memory = VK_NULL_HANDLE;
+		m_Initialized = false;
+	}
+
+	uint32_t VulkanGlyphTexture::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+	{
+		uint32_t found = (uint32_t)-1;
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			const VkMemoryPropertyFlags flags = m_MemoryProperties.memoryTypes[i].propertyFlags;
+			if (!(typeBits & (1u << i)) || (flags & required) != required)
+				continue;
+			if ((flags & preferred) == preferred)
+				return i;
+			if (found == (uint32_t)-1)
+				found = i;
+		}
+		return found;
+	}
+
+	bool VulkanGlyphTexture::Reserve(Staging& staging, VkDeviceSize size)
+	{
+		if (staging.Size >= size)
+			return true;
+		// the slot's previous upload has completed, its buffer can go
+		Release(staging);
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (vkCreateBuffer(m_Device, &bufferInfo, m_Allocator, &staging.Buffer) != VK_SUCCESS)
+			return false;
+
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(m_Device, staging.Buffer, &req);
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = req.size;
+		allocInfo.memoryTypeIndex = FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+		if (allocInfo.memoryTypeIndex == (uint32_t)-1 || vkAllocateMemory(m_Device, &allocInfo, m_Allocator, &staging.Memory) != VK_SUCCESS)
+		{
+			Release(staging);
+			return false;
+		}
+		vkBindBufferMemory(m_Device, staging.Buffer, staging.Memory, 0);
+		if (vkMapMemory(m_Device, staging.Memory, 0, size, 0, (void**)&staging.Mapped) != VK_SUCCESS)
+		{
+			Release(staging);
+			return false;
+		}
+		staging.Size = size;
+		return true;
+	}
+
+	void VulkanGlyphTexture::Release(Staging& staging)
+	{
+		if (staging.Buffer != VK_NULL_HANDLE)
+			vkDestroyBuffer(m_Device, staging.Buffer, m_Allocator);
+		if (staging.Memory != VK_NULL_HANDLE)
+			vkFreeMemory(m_Device, staging.Memory, m_Allocator);
+		staging = Staging();
+	}
+
+	void VulkanGlyphTexture::Upload(VkCommandBuffer cmd, uint32_t frame, GlyphCache& cache)
+	{
+		const larray<GlyphCacheRect>& rects = cache.GetDirtyRects();
+		if (rects.empty() || m_Image == VK_NULL_HANDLE || frame >= m_Staging.size())
+			return;
+		LUFT_PROFILE_FUNCTION();
+
+		VkDeviceSize bytes = 0;
+		for (const GlyphCacheRect& rect : rects)
+			bytes += ((VkDeviceSize)rect.Width * rect.Height + 3) & ~(VkDeviceSize)3;
+		Staging& staging = m_Staging[frame];
+		if (!Reserve(staging, bytes))
+		{
+			// the rects stay dirty and are tried again next frame
+			CORE_LOG_ERROR("[vulkan] glyph texture: failed to allocate {0} bytes of staging memory", bytes);
+			return;
+		}
+
+		const uint8_t* pixels = cache.GetPixels();
+		const uint32_t stride = cache.GetWidth();
+		m_Regions.clear();
+		VkDeviceSize offset = 0;
+		for (const GlyphCacheRect& rect : rects)
+		{
+			for (uint32_t y = 0; y < rect.Height; y++)
+				memcpy(staging.Mapped + offset + (VkDeviceSize)y * rect.Width, pixels + (size_t)(rect.Y + y) * stride + rect.X, rect.Width);
+
+			VkBufferImageCopy region = {};
+			region.bufferOffset = offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { (int32_t)rect.X, (int32_t)rect.Y, 0 };
+			region.imageExtent = { rect.Width, rect.Height, 1 };
+			m_Regions.push_back(region);
+			offset += ((VkDeviceSize)rect.Width * rect.Height + 3) & ~(VkDeviceSize)3;
+		}
+
+		// earlier frames may still be sampling the cells being replaced; they were submitted first,
+		// so waiting for their fragment shaders covers them
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = m_Initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_Image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(cmd, m_Initialized ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+		vkCmdCopyBufferToImage(cmd, staging.Buffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)m_Regions.size(), m_Regions.data());
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+		m_Initialized = true;
+		cache.ClearDirtyRects();
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+#include "Luft/Core/larray.h"
+#include "Luft/ImGui/GlyphCache.h"
+
+namespace Luft
+{
+	// The GPU copy of a GlyphCache atlas: a one channel image sampled as white with the distance
+	// field as alpha, registered with the ImGui Vulkan backend, whose distance field pipeline draws
+	// it. Only the rectangles the cache dirtied are copied, through a staging buffer per frame in
+	// flight that grows to the largest upload.
+	class VulkanGlyphTexture
+	{
+	public:
+		// after ImGui_ImplVulkan_Init, the descriptor set comes from the backend's pool
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t width, uint32_t height, uint32_t frameCount, const VkAllocationCallbacks* allocator);
+		// before ImGui_ImplVulkan_Shutdown, with the device idle
+		void Shutdown();
+
+		// the ImTextureID of the atlas
+		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
+
+		// call once the slot's fence has been waited on, with its command buffer begun and outside
+		// a render pass. Records copies of the cache's dirty rects and clears them
+		void Upload(VkCommandBuffer cmd, uint32_t frame, GlyphCache& cache);
+
+	private:
+		struct Staging
+		{
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			uint8_t* Mapped = nullptr;
+			VkDeviceSize Size = 0;
+		};
+
+		uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const;
+		bool Reserve(Staging& staging, VkDeviceSize size);
+		void Release(Staging& staging);
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_Allocator = nullptr;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties = {};
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+
+		VkImage m_Image = VK_NULL_HANDLE;
+		VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+		VkImageView m_View = VK_NULL_HANDLE;
+		VkSampler m_Sampler = VK_NULL_HANDLE;
+		VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+		// until the first upload, which also moves it out of the undefined layout
+		bool m_Initialized = false;
+
+		larray<Staging> m_Staging;
+		larray<VkBufferImageCopy> m_Regions;
+	};
+}
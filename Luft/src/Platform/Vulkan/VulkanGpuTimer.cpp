@@ -0,0 +1,277 @@
+#include "VulkanGpuTimer.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+#include "Luft/Debug/FrameStats.h"
+
+namespace Luft
+{
+	bool VulkanGpuTimer::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t frameCount, const VkAllocationCallbacks* allocator)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(physicalDevice, &props);
+
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, NULL);
+		larray<VkQueueFamilyProperties> families;
+		families.resize(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+		const uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+		if (validBits == 0 || props.limits.timestampPeriod <= 0.0f)
+		{
+			CORE_LOG_WRAN("[vulkan] queue family {0} has no timestamp support, GPU timings are disabled", queueFamily);
+			return false;
+		}
+		m_TimestampPeriod = props.limits.timestampPeriod;
+		m_TimestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+		if (vkCreateCommandPool(device, &poolInfo, allocator, &m_CommandPool) != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] GPU timer: failed to create command pool");
+			return false;
+		}
+
+		m_Slots.resize(frameCount);
+		for (FrameSlot& slot : m_Slots)
+		{
+			VkQueryPoolCreateInfo queryInfo = {};
+			queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryInfo.queryCount = MaxZonesPerFrame * 2;
+			if (vkCreateQueryPool(device, &queryInfo, allocator, &slot.Pool) != VK_SUCCESS)
+			{
+				CORE_LOG_ERROR("[vulkan] GPU timer: failed to create query pool");
+				Shutdown();
+				return false;
+			}
+
+			VkCommandBuffer cmds[MaxSubmitZonesPerFrame * 2];
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_CommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = MaxSubmitZonesPerFrame * 2;
+			if (vkAllocateCommandBuffers(device, &allocInfo, cmds) != VK_SUCCESS)
+			{
+				CORE_LOG_ERROR("[vulkan] GPU timer: failed to allocate command buffers");
+				Shutdown();
+				return false;
+			}
+
+			for (uint32_t i = 0; i < MaxSubmitZonesPerFrame; i++)
+			{
+				SubmitZone& sz = slot.Submits[i];
+				sz.Begin = cmds[i * 2];
+				sz.End = cmds[i * 2 + 1];
+				VkFenceCreateInfo fenceInfo = {};
+				fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+				fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+				if (vkCreateFence(device, &fenceInfo, allocator, &sz.Fence) != VK_SUCCESS)
+				{
+					CORE_LOG_ERROR("[vulkan] GPU timer: failed to create fence");
+					Shutdown();
+					return false;
+				}
+			}
+		}
+
+#if LUFT_PROFILE
+		if (m_Lane == ~0u)
+			m_Lane = Profiler::CreateLane("GPU");
+#endif
+		m_Supported = true;
+		return true;
+	}
+
+	void VulkanGpuTimer::Shutdown()
+	{
+		// the caller has made sure the device is idle
+		for (FrameSlot& slot : m_Slots)
+		{
+			if (slot.Pool != VK_NULL_HANDLE)
+				vkDestroyQueryPool(m_Device, slot.Pool, m_Allocator);
+			for (SubmitZone& sz : slot.Submits)
+			{
+				if (sz.Fence != VK_NULL_HANDLE)
+					vkDestroyFence(m_Device, sz.Fence, m_Allocator);
+			}
+		}
+		m_Slots.clear();
+
+		if (m_CommandPool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(m_Device, m_CommandPool, m_Allocator);
+		m_CommandPool = VK_NULL_HANDLE;
+
+		m_Current = nullptr;
+		m_Supported = false;
+	}
+
+	void VulkanGpuTimer::BeginFrame(VkCommandBuffer cmd, uint32_t frame)
+	{
+		m_Current = nullptr;
+		if (!m_Supported || frame >= m_Slots.size())
+			return;
+
+		FrameSlot& slot = m_Slots[frame];
+
+		// the slot's own command buffer is done, but the separate zone submissions may still be in
+		// flight. Rather than wait, this frame simply goes untimed
+		for (uint32_t i = 0; i < slot.SubmitCount; i++)
+		{
+			if (vkGetFenceStatus(m_Device, slot.Submits[i].Fence) != VK_SUCCESS)
+				return;
+		}
+
+		Resolve(slot);
+
+		vkCmdResetQueryPool(cmd, slot.Pool, 0, MaxZonesPerFrame * 2);
+		slot.ZoneCount = 0;
+		slot.SubmitCount = 0;
+		slot.CpuTicks = Profiler::Now();
+		slot.FrameIndex = FrameStats::GetFrameIndex();
+		m_Current = &slot;
+		m_Depth = 0;
+	}
+
+	void VulkanGpuTimer::AbandonFrame()
+	{
+		if (m_Current == nullptr)
+			return;
+		m_Current->ZoneCount = 0;
+		m_Current->SubmitCount = 0;
+		m_Current = nullptr;
+	}
+
+	int VulkanGpuTimer::BeginZone(VkCommandBuffer cmd, const char* name)
+	{
+		if (m_Current == nullptr || m_Current->ZoneCount >= MaxZonesPerFrame)
+			return -1;
+
+		const uint32_t zone = m_Current->ZoneCount++;
+		m_Current->Zones[zone].Name = name;
+		m_Current->Zones[zone].Depth = m_Depth++;
+		vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_Current->Pool, zone * 2);
+		return (int)zone;
+	}
+
+	void VulkanGpuTimer::EndZone(VkCommandBuffer cmd, int zone)
+	{
+		if (m_Current == nullptr || zone < 0)
+			return;
+
+		m_Depth--;
+		vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_Current->Pool, zone * 2 + 1);
+	}
+
+	bool VulkanGpuTimer::SubmitTimestamp(VkQueue queue, VkCommandBuffer cmd, VkPipelineStageFlagBits stage, uint32_t query, VkFence fence)
+	{
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
+			return false;
+		vkCmdWriteTimestamp(cmd, stage, m_Current->Pool, query);
+		if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+			return false;
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cmd;
+		return vkQueueSubmit(queue, 1, &submitInfo, fence) == VK_SUCCESS;
+	}
+
+	int VulkanGpuTimer::SubmitBeginZone(VkQueue queue, const char* name)
+	{
+		if (m_Current == nullptr || m_Current->ZoneCount >= MaxZonesPerFrame || m_Current->SubmitCount >= MaxSubmitZonesPerFrame)
+			return -1;
+
+		const uint32_t zone = m_Current->ZoneCount;
+		SubmitZone& sz = m_Current->Submits[m_Current->SubmitCount];
+		if (!SubmitTimestamp(queue, sz.Begin, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, zone * 2, VK_NULL_HANDLE))
+			return -1;
+
+		m_Current->Zones[zone].Name = name;
+		m_Current->Zones[zone].Depth = 0;
+		m_Current->ZoneCount++;
+		return (int)zone;
+	}
+
+	void VulkanGpuTimer::SubmitEndZone(VkQueue queue, int zone)
+	{
+		if (m_Current == nullptr || zone < 0)
+			return;
+
+		SubmitZone& sz = m_Current->Submits[m_Current->SubmitCount];
+		vkResetFences(m_Device, 1, &sz.Fence);
+		// counted even on failure: the begin submission is in flight either way, and an unsignalled
+		// fence just keeps the slot untimed
+		m_Current->SubmitCount++;
+		// bottom of pipe waits for everything submitted before it on the queue
+		SubmitTimestamp(queue, sz.End, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, zone * 2 + 1, sz.Fence);
+	}
+
+	void VulkanGpuTimer::Resolve(FrameSlot& slot)
+	{
+		if (slot.ZoneCount == 0)
+			return;
+
+		// value and availability per query, never waits
+		uint64_t results[MaxZonesPerFrame * 2][2];
+		const VkResult err = vkGetQueryPoolResults(m_Device, slot.Pool, 0, slot.ZoneCount * 2, sizeof(results), results,
+			sizeof(results[0]), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (err != VK_SUCCESS && err != VK_NOT_READY)
+			return;
+
+		const double ticksPerNs = (double)Profiler::MicrosecondsToTicks(1000000.0) / 1000000000.0;
+		uint64_t first = ~0ull;
+		uint64_t last = 0;
+		for (uint32_t i = 0; i < slot.ZoneCount; i++)
+		{
+			if (results[i * 2][1] == 0 || results[i * 2 + 1][1] == 0)
+				continue;
+
+			const uint64_t begin = results[i * 2][0] & m_TimestampMask;
+			const uint64_t end = results[i * 2 + 1][0] & m_TimestampMask;
+			if (end < begin)
+				continue;
+			first = begin < first ? begin : first;
+			last = end > last ? end : last;
+		}
+		if (first > last)
+			return;
+
+		const double firstNs = (double)first * m_TimestampPeriod;
+		const double candidate = (double)slot.CpuTicks - firstNs * ticksPerNs;
+		if (!m_HasOffset || candidate > m_GpuToCpuOffset)
+			m_GpuToCpuOffset = candidate;
+		m_HasOffset = true;
+
+		m_LastFrameMs = (double)(last - first) * m_TimestampPeriod / 1000000.0;
+		m_LastFrameIndex = slot.FrameIndex;
+		FrameStats::ReportGpu(slot.FrameIndex, m_LastFrameMs);
+
+#if LUFT_PROFILE
+		for (uint32_t i = 0; i < slot.ZoneCount; i++)
+		{
+			if (results[i * 2][1] == 0 || results[i * 2 + 1][1] == 0)
+				continue;
+
+			const double beginNs = (double)(results[i * 2][0] & m_TimestampMask) * m_TimestampPeriod;
+			const double endNs = (double)(results[i * 2 + 1][0] & m_TimestampMask) * m_TimestampPeriod;
+			if (endNs < beginNs)
+				continue;
+			const uint64_t start = (uint64_t)(beginNs * ticksPerNs + m_GpuToCpuOffset);
+			const uint64_t end = (uint64_t)(endNs * ticksPerNs + m_GpuToCpuOffset);
+			Profiler::RecordLane(m_Lane, slot.Zones[i].Name, start, end, slot.Zones[i].Depth);
+		}
+#endif
+	}
+}
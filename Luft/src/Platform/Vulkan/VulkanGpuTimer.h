@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+#include "Luft/Core/larray.h"
+
+namespace Luft
+{
+	// GPU timestamps, one query pool per frame in flight. A frame's results are read when its slot
+	// comes around again, after its fence was waited on anyway, so reading never stalls. Zones are
+	// mapped onto the CPU timeline and recorded into a "GPU" profiler lane.
+	class VulkanGpuTimer
+	{
+	public:
+		static constexpr uint32_t MaxZonesPerFrame = 16;
+		// zones bracketing work recorded by someone else, each costs two tiny submissions
+		static constexpr uint32_t MaxSubmitZonesPerFrame = 4;
+
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t frameCount, const VkAllocationCallbacks* allocator);
+		void Shutdown();
+		bool IsSupported() const { return m_Supported; }
+
+		// call once the slot's fence has been waited on, with its command buffer begun and outside
+		// a render pass. Collects the slot's previous results and resets its queries
+		void BeginFrame(VkCommandBuffer cmd, uint32_t frame);
+		// stops accepting zones until the next BeginFrame
+		void EndFrame() { m_Current = nullptr; }
+		// instead of EndFrame when the frame's command buffer is never submitted: its query reset
+		// didn't happen, so nothing more is written into the slot's queries or read back from them
+		void AbandonFrame();
+
+		// both return -1 and record nothing when timing isn't possible this frame
+		int BeginZone(VkCommandBuffer cmd, const char* name);
+		void EndZone(VkCommandBuffer cmd, int zone);
+		// timestamps in their own submissions on the same queue, for work we can't record into,
+		// e.g. ImGui's platform windows
+		int SubmitBeginZone(VkQueue queue, const char* name);
+		void SubmitEndZone(VkQueue queue, int zone);
+
+		// GPU time of the most recently resolved frame, first to last timestamp, and the FrameStats
+		// frame it was recorded in. Also reported to FrameStats as it resolves
+		double GetLastFrameMs() const { return m_LastFrameMs; }
+		uint64_t GetLastFrameIndex() const { return m_LastFrameIndex; }
+
+	private:
+		struct Zone
+		{
+			const char* Name;
+			uint32_t Depth;
+		};
+
+		struct SubmitZone
+		{
+			VkCommandBuffer Begin;
+			VkCommandBuffer End;
+			// signalled by the end submission, the command buffers are free once it is
+			VkFence Fence;
+		};
+
+		struct FrameSlot
+		{
+			VkQueryPool Pool = VK_NULL_HANDLE;
+			Zone Zones[MaxZonesPerFrame];
+			uint32_t ZoneCount = 0;
+			SubmitZone Submits[MaxSubmitZonesPerFrame];
+			uint32_t SubmitCount = 0;
+			uint64_t CpuTicks = 0;
+			uint64_t FrameIndex = 0;
+		};
+
+		bool SubmitTimestamp(VkQueue queue, VkCommandBuffer cmd, VkPipelineStageFlagBits stage, uint32_t query, VkFence fence);
+		void Resolve(FrameSlot& slot);
+
+		bool m_Supported = false;
+		VkDevice m_Device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_Allocator = nullptr;
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		larray<FrameSlot> m_Slots;
+		FrameSlot* m_Current = nullptr;
+		uint32_t m_Depth = 0;
+
+		double m_TimestampPeriod = 1.0;
+		uint64_t m_TimestampMask = ~0ull;
+		// GPU nanoseconds to CPU ticks: cpu = gpu * ticksPerNs + offset. The offset only ever grows
+		// toward the true one, since the GPU can't start a frame before the CPU began recording it
+		double m_GpuToCpuOffset = 0.0;
+		bool m_HasOffset = false;
+		uint32_t m_Lane = ~0u;
+
+		double m_LastFrameMs = 0.0;
+		uint64_t m_LastFrameIndex = 0;
+	};
+}
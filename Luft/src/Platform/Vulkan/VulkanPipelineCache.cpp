@@ -0,0 +1,210 @@
+#include "VulkanPipelineCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <system_error>
+#include "Luft/Core/KeyValueFile.h"
+#include "Luft/Core/larray.h"
+#include "Luft/Core/Log.h"
+#include "Luft/Core/MappedFile.h"
+
+namespace Luft
+{
+	namespace
+	{
+		constexpr char FileMagic[8] = { 'L', 'V', 'K', 'P', 'C', '1', 0, 0 };
+
+		// followed by the driver's cache data. What the driver's own header says is checked too,
+		// this one also catches a file that didn't arrive whole
+		struct FileHeader
+		{
+			char Magic[8];
+			uint32_t VendorID;
+			uint32_t DeviceID;
+			uint32_t DriverVersion;
+			uint8_t CacheUUID[VK_UUID_SIZE];
+			uint32_t DataSize;
+			uint64_t DataHash;
+			float ColdMs;
+			uint32_t Reserved;
+		};
+
+		uint64_t HashData(const uint8_t* p, size_t bytes)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (; bytes >= 8; p += 8, bytes -= 8)
+			{
+				uint64_t word;
+				memcpy(&word, p, 8);
+				hash = (hash ^ word) * 1099511628211ull;
+				hash ^= hash >> 29;
+			}
+			for (; bytes > 0; p++, bytes--)
+				hash = (hash ^ *p) * 1099511628211ull;
+			return hash;
+		}
+
+		// the cache data starts with VkPipelineCacheHeaderVersionOne, drivers are meant to reject
+		// data from another device but not all of them do
+		bool MatchesDevice(const uint8_t* data, size_t size, const VkPhysicalDeviceProperties& props)
+		{
+			VkPipelineCacheHeaderVersionOne header;
+			if (size < sizeof(header))
+				return false;
+			memcpy(&header, data, sizeof(header));
+			return header.headerSize >= sizeof(header) && header.headerSize <= size
+				&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& header.vendorID == props.vendorID && header.deviceID == props.deviceID
+				&& memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+	}
+
+	bool VulkanPipelineCache::Init(VkPhysicalDevice physicalDevice, VkDevice device, const lstr& dir, const VkAllocationCallbacks* allocator)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		vkGetPhysicalDeviceProperties(physicalDevice, &m_Properties);
+		char name[64];
+		snprintf(name, sizeof(name), "/vk_pipelines_%04x_%04x.bin", m_Properties.vendorID, m_Properties.deviceID);
+		m_Path = dir + name;
+		m_LastCheck = std::chrono::steady_clock::now();
+
+		MappedFile file;
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		if (file.Open(m_Path) && file.Size() >= sizeof(FileHeader))
+		{
+			FileHeader header;
+			memcpy(&header, file.Data(), sizeof(header));
+			data = file.Data() + sizeof(header);
+			size = file.Size() - sizeof(header);
+			if (memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0 || header.DataSize != size || HashData(data, size) != header.DataHash)
+			{
+				CORE_LOG_WRAN("[vulkan] {0} is damaged, pipelines are compiled again", m_Path.c_str());
+				size = 0;
+			}
+			else if (header.VendorID != m_Properties.vendorID || header.DeviceID != m_Properties.deviceID || header.DriverVersion != m_Properties.driverVersion
+				|| memcmp(header.CacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 || !MatchesDevice(data, size, m_Properties))
+			{
+				CORE_LOG_INFO("[vulkan] {0} is from another driver, pipelines are compiled again", m_Path.c_str());
+				size = 0;
+			}
+			else
+				m_ColdMs = header.ColdMs;
+		}
+
+		VkPipelineCacheCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		info.initialDataSize = size;
+		info.pInitialData = size > 0 ? data : nullptr;
+		VkResult err = vkCreatePipelineCache(device, &info, allocator, &m_Cache);
+		if (err != VK_SUCCESS && size > 0)
+		{
+			// the driver didn't take the data after all
+			info.initialDataSize = 0;
+			info.pInitialData = nullptr;
+			size = 0;
+			err = vkCreatePipelineCache(device, &info, allocator, &m_Cache);
+		}
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkCreatePipelineCache failed: VkResult = {0}", (int)err);
+			m_Cache = VK_NULL_HANDLE;
+			return false;
+		}
+		m_Warm = size > 0;
+		m_SavedSize = size;
+		if (m_Warm)
+			CORE_LOG_INFO("[vulkan] Pipeline cache {0} ({1} KB)", m_Path.c_str(), size / 1024);
+		return true;
+	}
+
+	void VulkanPipelineCache::Shutdown()
+	{
+		if (m_Cache == VK_NULL_HANDLE)
+			return;
+		Save();
+		vkDestroyPipelineCache(m_Device, m_Cache, m_Allocator);
+		m_Cache = VK_NULL_HANDLE;
+	}
+
+	void VulkanPipelineCache::Update()
+	{
+		if (m_Cache == VK_NULL_HANDLE)
+			return;
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - m_LastCheck < std::chrono::seconds(SaveIntervalSeconds))
+			return;
+		m_LastCheck = now;
+		Save();
+	}
+
+	bool VulkanPipelineCache::Save()
+	{
+		if (m_Cache == VK_NULL_HANDLE)
+			return false;
+		larray<uint8_t> bytes;
+		size_t size = 0;
+		VkResult err = VK_INCOMPLETE;
+		// VK_INCOMPLETE when pipelines were created on another thread since the size was asked
+		// for, it's asked again
+		for (int attempt = 0; attempt < 4 && err == VK_INCOMPLETE; attempt++)
+		{
+			err = vkGetPipelineCacheData(m_Device, m_Cache, &size, nullptr);
+			// nothing new, the cache only ever grows
+			if (err != VK_SUCCESS || size == m_SavedSize)
+				break;
+			bytes.resize(sizeof(FileHeader) + size);
+			err = vkGetPipelineCacheData(m_Device, m_Cache, &size, bytes.data() + sizeof(FileHeader));
+		}
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkGetPipelineCacheData failed: VkResult = {0}", (int)err);
+			return false;
+		}
+		if (size == m_SavedSize)
+			return true;
+		bytes.resize(sizeof(FileHeader) + size);
+
+		FileHeader header = {};
+		memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+		header.VendorID = m_Properties.vendorID;
+		header.DeviceID = m_Properties.deviceID;
+		header.DriverVersion = m_Properties.driverVersion;
+		memcpy(header.CacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.DataSize = (uint32_t)size;
+		header.DataHash = HashData(bytes.data() + sizeof(FileHeader), size);
+		header.ColdMs = m_ColdMs;
+		memcpy(bytes.data(), &header, sizeof(header));
+
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(m_Path.c_str()).parent_path(), ec);
+		if (!KeyValueFile::WriteReplacing(m_Path, bytes.data(), bytes.size()))
+		{
+			CORE_LOG_WRAN("[vulkan] Can't write the pipeline cache {0}", m_Path.c_str());
+			return false;
+		}
+		m_SavedSize = size;
+		CORE_LOG_INFO("[vulkan] Saved {0} KB of pipelines to {1}", size / 1024, m_Path.c_str());
+		return true;
+	}
+
+	void VulkanPipelineCache::ReportCreation(const char* what, double ms)
+	{
+		if (m_Reported || m_Cache == VK_NULL_HANDLE)
+			return;
+		m_Reported = true;
+		if (!m_Warm)
+		{
+			m_ColdMs = (float)ms;
+			CORE_LOG_INFO("[vulkan] {0} created in {1:.1f} ms, compiling every pipeline", what, ms);
+		}
+		else if (m_ColdMs > 0.0f)
+		{
+			CORE_LOG_INFO("[vulkan] {0} created in {1:.1f} ms from the pipeline cache, {2:.1f} ms saved against {3:.1f} ms without it",
+				what, ms, m_ColdMs - ms, m_ColdMs);
+		}
+		else
+			CORE_LOG_INFO("[vulkan] {0} created in {1:.1f} ms from the pipeline cache", what, ms);
+	}
+}
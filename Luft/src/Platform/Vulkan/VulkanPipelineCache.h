@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <vulkan/vulkan_core.h>
+#include "Luft/Core/lstr.h"
+
+namespace Luft
+{
+	// A VkPipelineCache kept on disk between runs, one file per GPU, so pipelines are compiled once
+	// rather than on every launch. A file is only handed to the driver when it was written for the
+	// same vendor, device, driver version and cache UUID and arrived whole; anything else starts an
+	// empty cache. Saved on Shutdown and, when pipelines were added, every SaveIntervalSeconds, by
+	// replacing the file so a crash mid-write leaves the old one.
+	class VulkanPipelineCache
+	{
+	public:
+		static constexpr uint32_t SaveIntervalSeconds = 60;
+
+		// after the device is created. A cache that can't be created leaves the handle null, which
+		// Vulkan takes as no cache
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, const lstr& dir, const VkAllocationCallbacks* allocator);
+		// saves, then destroys the cache. Before the device is destroyed
+		void Shutdown();
+
+		// once a frame, saves when it's time and the cache grew
+		void Update();
+		bool Save();
+
+		// how long the first pipelines took to create, logged against how long they took on the run
+		// that started without a cache
+		void ReportCreation(const char* what, double ms);
+
+		VkPipelineCache GetHandle() const { return m_Cache; }
+
+	private:
+		VkDevice m_Device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_Allocator = nullptr;
+		VkPipelineCache m_Cache = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties m_Properties = {};
+		lstr m_Path;
+
+		// started from a file rather than empty
+		bool m_Warm = false;
+		bool m_Reported = false;
+		// of the first pipelines of a run without a cache, kept in the file
+		float m_ColdMs = 0.0f;
+		size_t m_SavedSize = 0;
+		std::chrono::steady_clock::time_point m_LastCheck;
+	};
+}
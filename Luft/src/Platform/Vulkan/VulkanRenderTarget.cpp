@@ -0,0 +1,380 @@
+#include "VulkanRenderTarget.h"
+
+#include <backends/imgui_impl_vulkan.h>
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft
+{
+	bool VulkanRenderTarget::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight, const VkAllocationCallbacks* allocator)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+
+		// D16 is the only one every device renders to, the others are preferred when there
+		const VkFormat depthFormats[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM };
+		for (VkFormat format : depthFormats)
+		{
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+			if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			{
+				m_DepthFormat = format;
+				break;
+			}
+		}
+		if (m_DepthFormat == VK_FORMAT_UNDEFINED)
+		{
+			CORE_LOG_ERROR("[vulkan] render target: no depth format to render to");
+			return false;
+		}
+
+		VkAttachmentDescription attachments[2] = {};
+		attachments[0].format = ColorFormat;
+		attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		attachments[1].format = m_DepthFormat;
+		attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		VkAttachmentReference colorRef = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		VkAttachmentReference depthRef = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorRef;
+		subpass.pDepthStencilAttachment = &depthRef;
+
+		// in: after earlier frames on the queue are done sampling or depth testing the buffer. Out:
+		// before ImGui's pass samples it
+		VkSubpassDependency dependencies[2] = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		VkRenderPassCreateInfo passInfo = {};
+		passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		passInfo.attachmentCount = 2;
+		passInfo.pAttachments = attachments;
+		passInfo.subpassCount = 1;
+		passInfo.pSubpasses = &subpass;
+		passInfo.dependencyCount = 2;
+		passInfo.pDependencies = dependencies;
+		VkResult err = vkCreateRenderPass(device, &passInfo, allocator, &m_RenderPass);
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkCreateRenderPass failed: VkResult = {0}", (int)err);
+			Shutdown();
+			return false;
+		}
+
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = -1000;
+		samplerInfo.maxLod = 1000;
+		samplerInfo.maxAnisotropy = 1.0f;
+		err = vkCreateSampler(device, &samplerInfo, allocator, &m_Sampler);
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkCreateSampler failed: VkResult = {0}", (int)err);
+			Shutdown();
+			return false;
+		}
+
+		m_Buffers.resize(framesInFlight + 1);
+		return true;
+	}
+
+	void VulkanRenderTarget::Shutdown()
+	{
+		for (Buffer& buffer : m_Buffers)
+		{
+			Destroy(buffer);
+			if (buffer.DescriptorSet != VK_NULL_HANDLE)
+				ImGui_ImplVulkan_RemoveTexture(buffer.DescriptorSet);
+		}
+		m_Buffers.clear();
+		m_Current = -1;
+		m_Pending = -1;
+		m_Recorded = false;
+
+		if (m_Sampler != VK_NULL_HANDLE)
+			vkDestroySampler(m_Device, m_Sampler, m_Allocator);
+		m_Sampler = VK_NULL_HANDLE;
+		if (m_RenderPass != VK_NULL_HANDLE)
+			vkDestroyRenderPass(m_Device, m_RenderPass, m_Allocator);
+		m_RenderPass = VK_NULL_HANDLE;
+	}
+
+	void VulkanRenderTarget::Resize(uint32_t width, uint32_t height)
+	{
+		m_Width = width;
+		m_Height = height;
+	}
+
+	VkDescriptorSet VulkanRenderTarget::Acquire(uint64_t frame)
+	{
+		if (m_Width == 0 || m_Height == 0 || m_Buffers.empty())
+			return VK_NULL_HANDLE;
+		if (m_Pending < 0)
+		{
+			// the least recently drawn buffer that no frame possibly still running at render time
+			// draws. Those frames hold one each at most, which leaves one free. Never the one on
+			// screen, a frame that isn't submitted falls back to it
+			const uint64_t inFlight = m_Buffers.size();
+			for (int i = 0; i < (int)m_Buffers.size(); i++)
+			{
+				const Buffer& buffer = m_Buffers[i];
+				if (i == m_Current || (buffer.Used && buffer.LastUse + inFlight > frame))
+					continue;
+				if (m_Pending < 0 || !buffer.Used || (m_Buffers[m_Pending].Used && buffer.LastUse < m_Buffers[m_Pending].LastUse))
+					m_Pending = i;
+			}
+			if (m_Pending < 0)
+				return GetTexture();
+		}
+
+		// a buffer that was never drawn by a submitted frame is created right away, the backend
+		// only hands out descriptor sets for a view. Others are resized in BeginRender, once the
+		// frame that last drew them is known to be done
+		Buffer& buffer = m_Buffers[m_Pending];
+		if (buffer.DescriptorSet == VK_NULL_HANDLE && !Create(buffer))
+		{
+			Destroy(buffer);
+			m_Pending = -1;
+			return GetTexture();
+		}
+		return buffer.DescriptorSet;
+	}
+
+	bool VulkanRenderTarget::BeginRender(VkCommandBuffer cmd, const VkClearColorValue& clear)
+	{
+		if (m_Pending < 0)
+			return false;
+		Buffer& buffer = m_Buffers[m_Pending];
+		if ((buffer.Width != m_Width || buffer.Height != m_Height) && m_Width > 0 && m_Height > 0)
+		{
+			LUFT_PROFILE_SCOPE("VulkanRenderTarget::Resize");
+			// the new images are made first, a buffer that can't be resized keeps its old ones and
+			// is drawn stretched
+			Buffer resized;
+			resized.DescriptorSet = buffer.DescriptorSet;
+			if (Create(resized))
+			{
+				Destroy(buffer);
+				buffer = resized;
+			}
+			else
+				Destroy(resized);
+		}
+
+		VkClearValue clearValues[2] = {};
+		clearValues[0].color = clear;
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		VkRenderPassBeginInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		info.renderPass = m_RenderPass;
+		info.framebuffer = buffer.Framebuffer;
+		info.renderArea.extent = { buffer.Width, buffer.Height };
+		info.clearValueCount = 2;
+		info.pClearValues = clearValues;
+		vkCmdBeginRenderPass(cmd, &info, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport = { 0.0f, 0.0f, (float)buffer.Width, (float)buffer.Height, 0.0f, 1.0f };
+		VkRect2D scissor = { { 0, 0 }, { buffer.Width, buffer.Height } };
+		vkCmdSetViewport(cmd, 0, 1, &viewport);
+		vkCmdSetScissor(cmd, 0, 1, &scissor);
+		return true;
+	}
+
+	void VulkanRenderTarget::EndRender(VkCommandBuffer cmd)
+	{
+		vkCmdEndRenderPass(cmd);
+		m_Recorded = true;
+	}
+
+	void VulkanRenderTarget::EndFrame(bool submitted)
+	{
+		if (m_Recorded && submitted)
+		{
+			m_Current = m_Pending;
+			m_Pending = -1;
+		}
+		m_Recorded = false;
+	}
+
+	void VulkanRenderTarget::MarkUsed(uint64_t frame)
+	{
+		if (m_Current < 0)
+			return;
+		m_Buffers[m_Current].LastUse = frame;
+		m_Buffers[m_Current].Used = true;
+	}
+
+	uint32_t VulkanRenderTarget::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags preferred) const
+	{
+		uint32_t found = (uint32_t)-1;
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			if (!(typeBits & (1u << i)))
+				continue;
+			if ((m_MemoryProperties.memoryTypes[i].propertyFlags & preferred) == preferred)
+				return i;
+			if (found == (uint32_t)-1)
+				found = i;
+		}
+		return found;
+	}
+
+	bool VulkanRenderTarget::CreateImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, uint32_t width, uint32_t height,
+		VkImage& image, VkDeviceMemory& memory, VkImageView& view)
+	{
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = { width, height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = usage;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkResult err = vkCreateImage(m_Device, &imageInfo, m_Allocator, &image);
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkCreateImage failed: VkResult = {0}", (int)err);
+			return false;
+		}
+
+		VkMemoryRequirements req;
+		vkGetImageMemoryRequirements(m_Device, image, &req);
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = req.size;
+		allocInfo.memoryTypeIndex = FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (allocInfo.memoryTypeIndex == (uint32_t)-1 || vkAllocateMemory(m_Device, &allocInfo, m_Allocator, &memory) != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] render target: failed to allocate {0}x{1} image memory", width, height);
+			return false;
+		}
+		vkBindImageMemory(m_Device, image, memory, 0);
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspect;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.layerCount = 1;
+		err = vkCreateImageView(m_Device, &viewInfo, m_Allocator, &view);
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkCreateImageView failed: VkResult = {0}", (int)err);
+			return false;
+		}
+		return true;
+	}
+
+	bool VulkanRenderTarget::Create(Buffer& buffer)
+	{
+		if (!CreateImage(ColorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+				m_Width, m_Height, buffer.Color, buffer.ColorMemory, buffer.ColorView)
+			|| !CreateImage(m_DepthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT,
+				m_Width, m_Height, buffer.Depth, buffer.DepthMemory, buffer.DepthView))
+			return false;
+
+		const VkImageView views[2] = { buffer.ColorView, buffer.DepthView };
+		VkFramebufferCreateInfo fbInfo = {};
+		fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		fbInfo.renderPass = m_RenderPass;
+		fbInfo.attachmentCount = 2;
+		fbInfo.pAttachments = views;
+		fbInfo.width = m_Width;
+		fbInfo.height = m_Height;
+		fbInfo.layers = 1;
+		VkResult err = vkCreateFramebuffer(m_Device, &fbInfo, m_Allocator, &buffer.Framebuffer);
+		if (err != VK_SUCCESS)
+		{
+			CORE_LOG_ERROR("[vulkan] vkCreateFramebuffer failed: VkResult = {0}", (int)err);
+			return false;
+		}
+
+		if (buffer.DescriptorSet == VK_NULL_HANDLE)
+		{
+			buffer.DescriptorSet = ImGui_ImplVulkan_AddTexture(m_Sampler, buffer.ColorView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			if (buffer.DescriptorSet == VK_NULL_HANDLE)
+			{
+				CORE_LOG_ERROR("[vulkan] render target: no descriptor set left in the pool");
+				return false;
+			}
+		}
+		else
+		{
+			// no frame that binds it is pending and this one hasn't recorded ImGui's pass yet
+			VkDescriptorImageInfo imageInfo = {};
+			imageInfo.sampler = m_Sampler;
+			imageInfo.imageView = buffer.ColorView;
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = buffer.DescriptorSet;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.pImageInfo = &imageInfo;
+			vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+		}
+		buffer.Width = m_Width;
+		buffer.Height = m_Height;
+		return true;
+	}
+
+	void VulkanRenderTarget::Destroy(Buffer& buffer)
+	{
+		if (buffer.Framebuffer != VK_NULL_HANDLE)
+			vkDestroyFramebuffer(m_Device, buffer.Framebuffer, m_Allocator);
+		if (buffer.ColorView != VK_NULL_HANDLE)
+			vkDestroyImageView(m_Device, buffer.ColorView, m_Allocator);
+		if (buffer.Color != VK_NULL_HANDLE)
+			vkDestroyImage(m_Device, buffer.Color, m_Allocator);
+		if (buffer.ColorMemory != VK_NULL_HANDLE)
+			vkFreeMemory(m_Device, buffer.ColorMemory, m_Allocator);
+		if (buffer.DepthView != VK_NULL_HANDLE)
+			vkDestroyImageView(m_Device, buffer.DepthView, m_Allocator);
+		if (buffer.Depth != VK_NULL_HANDLE)
+			vkDestroyImage(m_Device, buffer.Depth, m_Allocator);
+		if (buffer.DepthMemory != VK_NULL_HANDLE)
+			vkFreeMemory(m_Device, buffer.DepthMemory, m_Allocator);
+		// the descriptor set is kept, it's pointed at the next view
+		const VkDescriptorSet set = buffer.DescriptorSet;
+		buffer = Buffer();
+		buffer.DescriptorSet = set;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+#include "Luft/Core/larray.h"
+
+namespace Luft
+{
+	// Color and depth a scene is rendered into and ImGui draws as a texture, e.g. in a viewport
+	// panel. A frame renders into a buffer no frame still on the GPU draws, and shows it, so the
+	// scene and the UI never wait on each other. That takes a buffer per frame in flight and one
+	// more, since the backend submits platform windows after the frame's fence and a frame's last
+	// draw is only known done once the next one's fence is. Buffers take a new size when they're
+	// next rendered, the one on screen keeps its old one until then. Frames are numbered by the
+	// renderer in submission order.
+	class VulkanRenderTarget
+	{
+	public:
+		static constexpr VkFormat ColorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		// descriptor sets the windows' pools keep for targets: eight of them with the most buffers
+		// one gets, at three frames in flight
+		static constexpr uint32_t PoolTextures = 8 * 4;
+
+		// after ImGui_ImplVulkan_Init, the textures' descriptor sets come from the backend's pool
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight, const VkAllocationCallbacks* allocator);
+		// with the device idle, before ImGui_ImplVulkan_Shutdown
+		void Shutdown();
+
+		// pipelines drawing into the target are made for this, it stays the same across resizes
+		VkRenderPass GetRenderPass() const { return m_RenderPass; }
+
+		void Resize(uint32_t width, uint32_t height);
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+
+		// while the ImGui frame is built: picks the buffer this frame renders and returns its
+		// texture to draw. A buffer picked and not yet rendered is picked again. Null without a size
+		VkDescriptorSet Acquire(uint64_t frame);
+		// the buffer a submitted frame rendered last, for frames that don't render. Null until then
+		VkDescriptorSet GetTexture() const { return m_Current >= 0 ? m_Buffers[m_Current].DescriptorSet : VK_NULL_HANDLE; }
+		bool HasPendingRender() const { return m_Pending >= 0; }
+
+		// in the frame's command buffer, outside a render pass, once the slot's fence was waited on:
+		// gives the acquired buffer the current size and begins its render pass, cleared. False
+		// when nothing was acquired
+		bool BeginRender(VkCommandBuffer cmd, const VkClearColorValue& clear);
+		void EndRender(VkCommandBuffer cmd);
+		// once it's known whether the frame's command buffer was submitted: what it rendered becomes
+		// GetTexture(), or is rendered again by the next frame
+		void EndFrame(bool submitted);
+		// GetTexture() is drawn by the frame numbered frame, or by platform windows submitted
+		// before the next one
+		void MarkUsed(uint64_t frame);
+
+	private:
+		struct Buffer
+		{
+			VkImage Color = VK_NULL_HANDLE;
+			VkDeviceMemory ColorMemory = VK_NULL_HANDLE;
+			VkImageView ColorView = VK_NULL_HANDLE;
+			VkImage Depth = VK_NULL_HANDLE;
+			VkDeviceMemory DepthMemory = VK_NULL_HANDLE;
+			VkImageView DepthView = VK_NULL_HANDLE;
+			VkFramebuffer Framebuffer = VK_NULL_HANDLE;
+			// the backend's, updated in place when the buffer is recreated
+			VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+			uint32_t Width = 0;
+			uint32_t Height = 0;
+			// the last submitted frame that drew it
+			uint64_t LastUse = 0;
+			bool Used = false;
+		};
+
+		uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags preferred) const;
+		bool CreateImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, uint32_t width, uint32_t height,
+			VkImage& image, VkDeviceMemory& memory, VkImageView& view);
+		bool Create(Buffer& buffer);
+		void Destroy(Buffer& buffer);
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_Allocator = nullptr;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties = {};
+		VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+		VkRenderPass m_RenderPass = VK_NULL_HANDLE;
+		VkSampler m_Sampler = VK_NULL_HANDLE;
+
+		larray<Buffer> m_Buffers;
+		int m_Current = -1;
+		int m_Pending = -1;
+		// the pending buffer is rendered in the frame's command buffer, not yet submitted
+		bool m_Recorded = false;
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+	};
+}
@@ -0,0 +1,500 @@
+#include "VulkanSwapchain.h"
+#include <algorithm>
+#include "Luft/Core/Log.h"
+#include "Luft/Debug/Profiler.h"
+
+namespace Luft
+{
+	namespace
+	{
+		const VkPresentModeKHR s_VkModes[(int)PresentMode::Count] =
+		{
+			VK_PRESENT_MODE_FIFO_KHR,
+			VK_PRESENT_MODE_MAILBOX_KHR,
+			VK_PRESENT_MODE_IMMEDIATE_KHR,
+		};
+
+		const char* const s_ModeNames[(int)PresentMode::Count] = { "FIFO", "Mailbox", "Immediate" };
+
+		bool CheckVkResult(VkResult err, const char* what)
+		{
+			if (err == VK_SUCCESS)
+				return true;
+			CORE_LOG_ERROR("[vulkan] {0} failed: VkResult = {1}", what, (int)err);
+			return false;
+		}
+	}
+
+	bool VulkanSwapchain::Init(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, uint32_t queueFamily,
+		uint32_t framesInFlight, PresentMode mode, uint32_t width, uint32_t height, const VkAllocationCallbacks* allocator)
+	{
+		m_PhysicalDevice = physicalDevice;
+		m_Device = device;
+		m_Surface = surface;
+		m_Allocator = allocator;
+		m_RequestedMode = mode;
+
+		VkBool32 wsi = VK_FALSE;
+		vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamily, surface, &wsi);
+		if (wsi != VK_TRUE)
+		{
+			CORE_LOG_ERROR("[vulkan] Queue family {0} can't present to the window's surface", queueFamily);
+			return false;
+		}
+
+		// the first of these the surface has, or whatever it lists first
+		{
+			uint32_t count = 0;
+			vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &count, nullptr);
+			larray<VkSurfaceFormatKHR> formats;
+			formats.resize(count);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &count, formats.data());
+			const VkFormat requested[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8_UNORM };
+			m_Format = count > 0 ? formats[0] : VkSurfaceFormatKHR{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLORSPACE_SRGB_NONLINEAR_KHR };
+			if (count == 1 && formats[0].format == VK_FORMAT_UNDEFINED)
+				m_Format = { requested[0], VK_COLORSPACE_SRGB_NONLINEAR_KHR };
+			else
+			{
+				bool found = false;
+				for (VkFormat f : requested)
+				{
+					for (const VkSurfaceFormatKHR& sf : formats)
+					{
+						if (sf.format == f && sf.colorSpace == VK_COLORSPACE_SRGB_NONLINEAR_KHR)
+						{
+							m_Format = sf;
+							found = true;
+							break;
+						}
+					}
+					if (found)
+						break;
+				}
+			}
+		}
+
+		{
+			uint32_t count = 0;
+			vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &count, nullptr);
+			larray<VkPresentModeKHR> modes;
+			modes.resize(count);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &count, modes.data());
+			for (int i = 0; i < (int)PresentMode::Count; i++)
+				m_Supported[i] = std::find(modes.begin(), modes.end(), s_VkModes[i]) != modes.end();
+			// always there
+			m_Supported[(int)PresentMode::Fifo] = true;
+			if (!m_Supported[(int)mode])
+				CORE_LOG_WRAN("[vulkan] The surface has no {0} present mode, using FIFO", s_ModeNames[(int)mode]);
+		}
+
+		// the image only ever holds this frame's ImGui draw, no need to keep what was there
+		{
+			VkAttachmentDescription attachment = {};
+			attachment.format = m_Format.format;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			VkAttachmentReference color = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = 1;
+			subpass.pColorAttachments = &color;
+			// the acquire semaphore is waited on at this stage, the layout change has to wait too
+			VkSubpassDependency dependency = {};
+			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependency.dstSubpass = 0;
+			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dependency.srcAccessMask = 0;
+			dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			VkRenderPassCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			info.attachmentCount = 1;
+			info.pAttachments = &attachment;
+			info.subpassCount = 1;
+			info.pSubpasses = &subpass;
+			info.dependencyCount = 1;
+			info.pDependencies = &dependency;
+			if (!CheckVkResult(vkCreateRenderPass(device, &info, allocator, &m_RenderPass), "vkCreateRenderPass"))
+				return false;
+		}
+
+		m_Frames.resize(std::min(std::max(framesInFlight, 1u), MaxFramesInFlight));
+		for (Frame& frame : m_Frames)
+		{
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = queueFamily;
+			if (!CheckVkResult(vkCreateCommandPool(device, &poolInfo, allocator, &frame.CommandPool), "vkCreateCommandPool"))
+				return false;
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frame.CommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			if (!CheckVkResult(vkAllocateCommandBuffers(device, &allocInfo, &frame.CommandBuffer), "vkAllocateCommandBuffers"))
+				return false;
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			if (!CheckVkResult(vkCreateFence(device, &fenceInfo, allocator, &frame.Fence), "vkCreateFence"))
+				return false;
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (!CheckVkResult(vkCreateSemaphore(device, &semaphoreInfo, allocator, &frame.ImageAcquired), "vkCreateSemaphore"))
+				return false;
+		}
+
+		if (!Rebuild(width, height))
+			return false;
+		CORE_LOG_INFO("[vulkan] Swapchain {0}x{1}, {2} images, {3} frames in flight, {4}",
+			m_Extent.width, m_Extent.height, m_Images.size(), m_Frames.size(), s_ModeNames[(int)m_Mode]);
+		return true;
+	}
+
+	void VulkanSwapchain::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+			return;
+		// presents can't be waited on any other way
+		vkDeviceWaitIdle(m_Device);
+		DestroyRetired(true);
+		DestroyImages();
+		if (m_Swapchain != VK_NULL_HANDLE)
+			vkDestroySwapchainKHR(m_Device, m_Swapchain, m_Allocator);
+		m_Swapchain = VK_NULL_HANDLE;
+		for (Frame& frame : m_Frames)
+		{
+			vkDestroySemaphore(m_Device, frame.ImageAcquired, m_Allocator);
+			vkDestroyFence(m_Device, frame.Fence, m_Allocator);
+			vkDestroyCommandPool(m_Device, frame.CommandPool, m_Allocator);
+		}
+		m_Frames.clear();
+		vkDestroyRenderPass(m_Device, m_RenderPass, m_Allocator);
+		m_RenderPass = VK_NULL_HANDLE;
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void VulkanSwapchain::SetPresentMode(PresentMode mode)
+	{
+		if (mode == m_RequestedMode)
+			return;
+		if (!m_Supported[(int)mode])
+			CORE_LOG_WRAN("[vulkan] The surface has no {0} present mode, using FIFO", s_ModeNames[(int)mode]);
+		m_RequestedMode = mode;
+		m_NeedsRebuild = true;
+	}
+
+	bool VulkanSwapchain::BeginFrame(uint32_t width, uint32_t height)
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		// minimized, a zero sized swapchain can't be created
+		if (width == 0 || height == 0)
+			return false;
+		if (m_NeedsRebuild || width != m_RequestedWidth || height != m_RequestedHeight)
+		{
+			if (!Rebuild(width, height))
+				return false;
+		}
+
+		Frame& frame = m_Frames[m_Slot];
+		{
+			LUFT_PROFILE_SCOPE("WaitForFrameFence");
+			vkWaitForFences(m_Device, 1, &frame.Fence, VK_TRUE, UINT64_MAX);
+		}
+		DestroyRetired(false);
+
+		// begun before acquiring, so a failure leaves nothing acquired. A buffer left recording is
+		// reset with the pool next time
+		vkResetCommandPool(m_Device, frame.CommandPool, 0);
+		VkCommandBufferBeginInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (!CheckVkResult(vkBeginCommandBuffer(frame.CommandBuffer, &info), "vkBeginCommandBuffer"))
+			return false;
+
+		VkResult err;
+		{
+			LUFT_PROFILE_SCOPE("AcquireNextImage");
+			err = vkAcquireNextImageKHR(m_Device, m_Swapchain, UINT64_MAX, frame.ImageAcquired, VK_NULL_HANDLE, &m_ImageIndex);
+		}
+		if (err == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// nothing was acquired and the semaphore stays unsignalled, the fence signalled
+			m_NeedsRebuild = true;
+			return false;
+		}
+		// suboptimal still acquired an image, it's rendered and presented before the rebuild
+		if (err == VK_SUBOPTIMAL_KHR)
+			m_NeedsRebuild = true;
+		else if (!CheckVkResult(err, "vkAcquireNextImageKHR"))
+			return false;
+
+		// with more slots than images, or images handed out of order, another slot's frame may
+		// still be rendering into it
+		Image& image = m_Images[m_ImageIndex];
+		if (image.Fence != VK_NULL_HANDLE && image.Fence != frame.Fence)
+		{
+			LUFT_PROFILE_SCOPE("WaitForImageFence");
+			vkWaitForFences(m_Device, 1, &image.Fence, VK_TRUE, UINT64_MAX);
+		}
+		image.Fence = frame.Fence;
+		return true;
+	}
+
+	bool VulkanSwapchain::Submit(VkQueue queue)
+	{
+		Frame& frame = m_Frames[m_Slot];
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		VkSubmitInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.waitSemaphoreCount = 1;
+		info.pWaitSemaphores = &frame.ImageAcquired;
+		info.pWaitDstStageMask = &waitStage;
+		info.commandBufferCount = 1;
+		info.pCommandBuffers = &frame.CommandBuffer;
+		info.signalSemaphoreCount = 1;
+		info.pSignalSemaphores = &m_Images[m_ImageIndex].RenderComplete;
+		if (!CheckVkResult(vkEndCommandBuffer(frame.CommandBuffer), "vkEndCommandBuffer"))
+		{
+			AbandonFrame(queue);
+			return false;
+		}
+		// only right before submitting, a fence left unsignalled would never be again
+		vkResetFences(m_Device, 1, &frame.Fence);
+		if (!CheckVkResult(vkQueueSubmit(queue, 1, &info, frame.Fence), "vkQueueSubmit"))
+		{
+			AbandonFrame(queue);
+			return false;
+		}
+		return true;
+	}
+
+	void VulkanSwapchain::AbandonFrame(VkQueue queue)
+	{
+		// an empty batch takes the frame's place: it waits on the acquire, so the semaphore is
+		// unsignalled again, and signals the fence the slot waits on next
+		Frame& frame = m_Frames[m_Slot];
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.waitSemaphoreCount = 1;
+		info.pWaitSemaphores = &frame.ImageAcquired;
+		info.pWaitDstStageMask = &waitStage;
+		vkResetFences(m_Device, 1, &frame.Fence);
+		if (!CheckVkResult(vkQueueSubmit(queue, 1, &info, frame.Fence), "vkQueueSubmit"))
+		{
+			// nothing can be submitted, the slot gets a signalled fence and a new semaphore instead
+			vkDeviceWaitIdle(m_Device);
+			for (Image& image : m_Images)
+			{
+				if (image.Fence == frame.Fence)
+					image.Fence = VK_NULL_HANDLE;
+			}
+			vkDestroyFence(m_Device, frame.Fence, m_Allocator);
+			vkDestroySemaphore(m_Device, frame.ImageAcquired, m_Allocator);
+			frame.Fence = VK_NULL_HANDLE;
+			frame.ImageAcquired = VK_NULL_HANDLE;
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			CheckVkResult(vkCreateFence(m_Device, &fenceInfo, m_Allocator, &frame.Fence), "vkCreateFence");
+			CheckVkResult(vkCreateSemaphore(m_Device, &semaphoreInfo, m_Allocator, &frame.ImageAcquired), "vkCreateSemaphore");
+		}
+		// the image stays acquired and is never presented, it goes with the swapchain the next
+		// BeginFrame replaces
+		m_NeedsRebuild = true;
+		NextSlot();
+	}
+
+	void VulkanSwapchain::NextSlot()
+	{
+		m_Slot = (m_Slot + 1) % (uint32_t)m_Frames.size();
+		m_FrameNumber++;
+	}
+
+	void VulkanSwapchain::Present(VkQueue queue)
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		VkPresentInfoKHR info = {};
+		info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		info.waitSemaphoreCount = 1;
+		info.pWaitSemaphores = &m_Images[m_ImageIndex].RenderComplete;
+		info.swapchainCount = 1;
+		info.pSwapchains = &m_Swapchain;
+		info.pImageIndices = &m_ImageIndex;
+		const VkResult err = vkQueuePresentKHR(queue, &info);
+		if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
+			m_NeedsRebuild = true;
+		else
+			CheckVkResult(err, "vkQueuePresentKHR");
+		NextSlot();
+	}
+
+	bool VulkanSwapchain::Rebuild(uint32_t width, uint32_t height)
+	{
+		LUFT_PROFILE_FUNCTION();
+
+		// the command buffers of the frames in flight use the old framebuffers. Other work on the
+		// queue, platform windows and timer submissions, goes on
+		WaitForFrames();
+
+		VkSurfaceCapabilitiesKHR caps;
+		if (!CheckVkResult(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_PhysicalDevice, m_Surface, &caps), "vkGetPhysicalDeviceSurfaceCapabilitiesKHR"))
+			return false;
+		VkExtent2D extent = caps.currentExtent;
+		if (extent.width == 0xffffffff)
+		{
+			extent.width = std::min(std::max(width, caps.minImageExtent.width), caps.maxImageExtent.width);
+			extent.height = std::min(std::max(height, caps.minImageExtent.height), caps.maxImageExtent.height);
+		}
+		// minimized between the size being read and now
+		if (extent.width == 0 || extent.height == 0)
+			return false;
+
+		const PresentMode mode = m_Supported[(int)m_RequestedMode] ? m_RequestedMode : PresentMode::Fifo;
+		// mailbox needs a third image to always have one to render into
+		uint32_t imageCount = std::max(caps.minImageCount, mode == PresentMode::Mailbox ? 3u : 2u);
+		if (caps.maxImageCount != 0)
+			imageCount = std::min(imageCount, caps.maxImageCount);
+
+		VkSwapchainCreateInfoKHR info = {};
+		info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		info.surface = m_Surface;
+		info.minImageCount = imageCount;
+		info.imageFormat = m_Format.format;
+		info.imageColorSpace = m_Format.colorSpace;
+		info.imageExtent = extent;
+		info.imageArrayLayers = 1;
+		info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		info.preTransform = (caps.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR) ? VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR : caps.currentTransform;
+		info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		info.presentMode = s_VkModes[(int)mode];
+		info.clipped = VK_TRUE;
+		// lets the driver hand over resources, and images not yet acquired are released
+		info.oldSwapchain = m_Swapchain;
+		VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+		if (!CheckVkResult(vkCreateSwapchainKHR(m_Device, &info, m_Allocator, &swapchain), "vkCreateSwapchainKHR"))
+			return false;
+
+		const bool replacing = m_Swapchain != VK_NULL_HANDLE;
+		// the old swapchain is retired either way. Its last presents may still wait on the
+		// semaphores, so those go with it once every slot has come around again
+		if (replacing)
+		{
+			Retired retired;
+			retired.Swapchain = m_Swapchain;
+			for (Image& image : m_Images)
+			{
+				retired.Semaphores.push_back(image.RenderComplete);
+				image.RenderComplete = VK_NULL_HANDLE;
+			}
+			retired.Frame = m_FrameNumber;
+			m_Retired.push_back(std::move(retired));
+		}
+		DestroyImages();
+		m_Swapchain = swapchain;
+		m_Extent = extent;
+
+		uint32_t count = 0;
+		vkGetSwapchainImagesKHR(m_Device, m_Swapchain, &count, nullptr);
+		larray<VkImage> images;
+		images.resize(count);
+		vkGetSwapchainImagesKHR(m_Device, m_Swapchain, &count, images.data());
+		m_Images.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Image& image = m_Images[i];
+			image.Handle = images[i];
+			image.Fence = VK_NULL_HANDLE;
+
+			VkImageViewCreateInfo viewInfo = {};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = image.Handle;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = m_Format.format;
+			viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			if (!CheckVkResult(vkCreateImageView(m_Device, &viewInfo, m_Allocator, &image.View), "vkCreateImageView"))
+				return false;
+
+			VkFramebufferCreateInfo fbInfo = {};
+			fbInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			fbInfo.renderPass = m_RenderPass;
+			fbInfo.attachmentCount = 1;
+			fbInfo.pAttachments = &image.View;
+			fbInfo.width = extent.width;
+			fbInfo.height = extent.height;
+			fbInfo.layers = 1;
+			if (!CheckVkResult(vkCreateFramebuffer(m_Device, &fbInfo, m_Allocator, &image.Framebuffer), "vkCreateFramebuffer"))
+				return false;
+
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			if (!CheckVkResult(vkCreateSemaphore(m_Device, &semaphoreInfo, m_Allocator, &image.RenderComplete), "vkCreateSemaphore"))
+				return false;
+		}
+
+		if (replacing && mode != m_Mode)
+			CORE_LOG_INFO("[vulkan] Presenting with {0}, {1} images", s_ModeNames[(int)mode], count);
+		m_Mode = mode;
+		m_RequestedWidth = width;
+		m_RequestedHeight = height;
+		m_NeedsRebuild = false;
+		m_RebuildCount++;
+		return true;
+	}
+
+	void VulkanSwapchain::WaitForFrames()
+	{
+		LUFT_PROFILE_FUNCTION();
+		VkFence fences[MaxFramesInFlight];
+		for (uint32_t i = 0; i < m_Frames.size(); i++)
+			fences[i] = m_Frames[i].Fence;
+		// every fence is signalled unless its frame was submitted
+		vkWaitForFences(m_Device, (uint32_t)m_Frames.size(), fences, VK_TRUE, UINT64_MAX);
+	}
+
+	void VulkanSwapchain::DestroyImages()
+	{
+		for (Image& image : m_Images)
+		{
+			if (image.RenderComplete != VK_NULL_HANDLE)
+				vkDestroySemaphore(m_Device, image.RenderComplete, m_Allocator);
+			if (image.Framebuffer != VK_NULL_HANDLE)
+				vkDestroyFramebuffer(m_Device, image.Framebuffer, m_Allocator);
+			if (image.View != VK_NULL_HANDLE)
+				vkDestroyImageView(m_Device, image.View, m_Allocator);
+		}
+		m_Images.clear();
+	}
+
+	void VulkanSwapchain::DestroyRetired(bool all)
+	{
+		// Vulkan can't say when a present finished. Once every slot's fence was waited on again
+		// the presents queued before the rebuild are long done
+		size_t i = 0;
+		while (i < m_Retired.size())
+		{
+			Retired& retired = m_Retired[i];
+			if (!all && m_FrameNumber < retired.Frame + m_Frames.size() + 1)
+			{
+				i++;
+				continue;
+			}
+			for (VkSemaphore semaphore : retired.Semaphores)
+				vkDestroySemaphore(m_Device, semaphore, m_Allocator);
+			vkDestroySwapchainKHR(m_Device, retired.Swapchain, m_Allocator);
+			m_Retired.erase(i);
+		}
+	}
+}
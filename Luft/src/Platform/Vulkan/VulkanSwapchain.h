@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan_core.h>
+#include "Luft/Core/larray.h"
+#include "Luft/Core/Window.h"
+
+namespace Luft
+{
+	// The main window's swapchain and what's recorded into it. A frame in flight is a slot with
+	// its own command buffer, fence and acquire semaphore, so how far the CPU runs ahead is set by
+	// the slot count alone and not by how many images the present mode asks for. Images have the
+	// semaphore their present waits on, since only acquiring an image again tells it was shown.
+	// An out of date or resized swapchain, or a new present mode, is rebuilt at the next
+	// BeginFrame from the old one, waiting only on the frames in flight rather than the device.
+	class VulkanSwapchain
+	{
+	public:
+		static constexpr uint32_t MaxFramesInFlight = 3;
+
+		// after the device and surface are created. Fails without WSI support on the queue family
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, uint32_t queueFamily,
+			uint32_t framesInFlight, PresentMode mode, uint32_t width, uint32_t height, const VkAllocationCallbacks* allocator);
+		// before the surface and device are destroyed
+		void Shutdown();
+
+		// takes effect with the rebuild at the next BeginFrame
+		void SetPresentMode(PresentMode mode);
+		// the mode asked for, and the one in use, which is Fifo when the surface lacks the other
+		PresentMode GetRequestedPresentMode() const { return m_RequestedMode; }
+		PresentMode GetPresentMode() const { return m_Mode; }
+		bool IsPresentModeSupported(PresentMode mode) const { return m_Supported[(int)mode]; }
+		// the next BeginFrame rebuilds, what's on screen may be stale
+		bool NeedsRebuild() const { return m_NeedsRebuild; }
+
+		// waits for the slot to come free, begins its command buffer and acquires an image at the
+		// drawable size, rebuilding first when needed. False when there's nothing to render into:
+		// minimized, or out of date and rebuilt next frame
+		bool BeginFrame(uint32_t width, uint32_t height);
+		// ends the command buffer and submits it, waiting on the acquire and signalling the image's
+		// present semaphore. When that fails the frame is dropped, not presented, and the slot
+		// moves on as if it had been
+		bool Submit(VkQueue queue);
+		void Present(VkQueue queue);
+
+		VkCommandBuffer GetCommandBuffer() const { return m_Frames[m_Slot].CommandBuffer; }
+		// 0 to GetFramesInFlight() - 1, for what's kept once per frame in flight
+		uint32_t GetFrameSlot() const { return m_Slot; }
+		uint32_t GetFramesInFlight() const { return (uint32_t)m_Frames.size(); }
+		uint32_t GetImageCount() const { return (uint32_t)m_Images.size(); }
+		VkRenderPass GetRenderPass() const { return m_RenderPass; }
+		VkFramebuffer GetFramebuffer() const { return m_Images[m_ImageIndex].Framebuffer; }
+		VkExtent2D GetExtent() const { return m_Extent; }
+		uint32_t GetRebuildCount() const { return m_RebuildCount; }
+		// frames presented so far, the one being built is submitted as this
+		uint64_t GetFrameNumber() const { return m_FrameNumber; }
+
+	private:
+		struct Frame
+		{
+			VkCommandPool CommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkFence Fence = VK_NULL_HANDLE;
+			VkSemaphore ImageAcquired = VK_NULL_HANDLE;
+		};
+
+		struct Image
+		{
+			VkImage Handle = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkFramebuffer Framebuffer = VK_NULL_HANDLE;
+			VkSemaphore RenderComplete = VK_NULL_HANDLE;
+			// of the slot that last rendered into it
+			VkFence Fence = VK_NULL_HANDLE;
+		};
+
+		// a swapchain replaced by a rebuild and the semaphores its last presents wait on
+		struct Retired
+		{
+			VkSwapchainKHR Swapchain = VK_NULL_HANDLE;
+			larray<VkSemaphore> Semaphores;
+			uint64_t Frame = 0;
+		};
+
+		void AbandonFrame(VkQueue queue);
+		void NextSlot();
+		bool Rebuild(uint32_t width, uint32_t height);
+		void WaitForFrames();
+		void DestroyImages();
+		void DestroyRetired(bool all);
+
+		VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_Allocator = nullptr;
+		VkSurfaceFormatKHR m_Format = {};
+		VkRenderPass m_RenderPass = VK_NULL_HANDLE;
+		VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
+		VkExtent2D m_Extent = {};
+		bool m_Supported[(int)PresentMode::Count] = {};
+
+		larray<Frame> m_Frames;
+		larray<Image> m_Images;
+		larray<Retired> m_Retired;
+		uint32_t m_Slot = 0;
+		uint32_t m_ImageIndex = 0;
+		uint64_t m_FrameNumber = 0;
+
+		PresentMode m_RequestedMode = PresentMode::Fifo;
+		PresentMode m_Mode = PresentMode::Fifo;
+		// the drawable size the swapchain was built for, the surface may have settled on another
+		uint32_t m_RequestedWidth = 0;
+		uint32_t m_RequestedHeight = 0;
+		bool m_NeedsRebuild = false;
+		uint32_t m_RebuildCount = 0;
+	};
+}
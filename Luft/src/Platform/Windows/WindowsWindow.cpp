@@ -1,8 +1,10 @@
 #include <SDL_vulkan.h>
 #include "WindowsWindow.h"
 #include "Luft/Core/Log.h"
+#include "Platform/Vulkan/VulkanRenderTarget.h"
 #include "Version.h"
 #include "Luft/Core/larray.h"
+#include "Luft/Core/Memory.h"
 
 
 namespace Luft
@@ -19,15 +21,20 @@ namespace Luft
 
 	void WindowsWindow::OnUpdate()
 	{
+		m_PipelineCache.Update();
 	}
 
 	void WindowsWindow::SetVSync(bool enabled)
 	{
+		if (enabled)
+			m_Swapchain.SetPresentMode(PresentMode::Fifo);
+		else
+			m_Swapchain.SetPresentMode(m_Swapchain.IsPresentModeSupported(PresentMode::Mailbox) ? PresentMode::Mailbox : PresentMode::Immediate);
 	}
 
 	bool WindowsWindow::IsVSync() const
 	{
-		return false;
+		return m_Swapchain.GetRequestedPresentMode() == PresentMode::Fifo;
 	}
 
 	int SDLEventWatcher(void* data, SDL_Event* event)
@@ -83,6 +90,22 @@ namespace Luft
 			abort();
 	}
 
+	// host allocations made by the vulkan loader/driver are routed through the tracking heap
+	static void* VKAPI_CALL vk_allocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+	{
+		return Memory::Allocate(size, MemoryTag::Vulkan, alignment);
+	}
+
+	static void* VKAPI_CALL vk_reallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+	{
+		return Memory::Reallocate(pOriginal, size, MemoryTag::Vulkan, alignment);
+	}
+
+	static void VKAPI_CALL vk_free(void* pUserData, void* pMemory)
+	{
+		Memory::Free(pMemory);
+	}
+
 	void WindowsWindow::Init(const WindowProps& props)
 	{
 		if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0)
@@ -122,6 +145,11 @@ namespace Luft
 		//SDL_AddEventWatch(SDLEventWatcher, this->m_Window);
 
 		//Vulkan Setup
+		m_VkAllocationCallbacks = {};
+		m_VkAllocationCallbacks.pfnAllocation = vk_allocation;
+		m_VkAllocationCallbacks.pfnReallocation = vk_reallocation;
+		m_VkAllocationCallbacks.pfnFree = vk_free;
+		m_VkAllocator = &m_VkAllocationCallbacks;
 		VulkanSetup();
 
 		// Create Window Surface
@@ -130,6 +158,14 @@ namespace Luft
 			CORE_LOG_ERROR("Failed to create Vulkan surface.");
 			return;
 		}
+
+		// the swapchain is sized to the drawable, which differs from the window size with high DPI
+		int width, height;
+		SDL_GetWindowSize(m_Window, &width, &height);
+		m_WindowData.Width = width;
+		m_WindowData.Height = height;
+		SDL_Vulkan_GetDrawableSize(m_Window, &width, &height);
+		m_Swapchain.Init(m_VkPhysicalDevice, m_VkDevice, m_VkSurface, m_VkQueueFamily, props.FramesInFlight, props.Present, width, height, m_VkAllocator);
 	}
 
 #ifdef LUFT_USE_VULKAN_DEBUG_REPORT
@@ -296,18 +332,22 @@ namespace Luft
 			vkGetDeviceQueue(m_VkDevice, m_VkQueueFamily, 0, &m_VkQueue);
 		}
 
+		// Load the pipelines compiled by earlier runs
+		m_PipelineCache.Init(m_VkPhysicalDevice, m_VkDevice, "cache", m_VkAllocator);
+
 		// Create Descriptor Pool
-		// The example only requires a single combined image sampler descriptor for the font image and only uses one descriptor set (for that)
+		// One combined image sampler for the backend's font image, one for the glyph cache's atlas
+		// and one per buffer of each viewport panel's render target.
 		// If you wish to load e.g. additional textures you may need to alter pools sizes.
 		{
 			VkDescriptorPoolSize pool_sizes[] =
 			{
-				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 + VulkanRenderTarget::PoolTextures },
 			};
 			VkDescriptorPoolCreateInfo pool_info = {};
 			pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 			pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-			pool_info.maxSets = 1;
+			pool_info.maxSets = 2 + VulkanRenderTarget::PoolTextures;
 			pool_info.poolSizeCount = (uint32_t)ARRAYSIZE(pool_sizes);
 			pool_info.pPoolSizes = pool_sizes;
 			err = vkCreateDescriptorPool(m_VkDevice, &pool_info, m_VkAllocator, &m_VkDescriptorPool);
@@ -317,7 +357,12 @@ namespace Luft
 
 	void WindowsWindow::Shutdown()
 	{
+		m_Swapchain.Shutdown();
+		// SDL_Vulkan_CreateSurface made it without allocation callbacks, so it has to be destroyed
+		// without them too
+		vkDestroySurfaceKHR(m_VkInstance, m_VkSurface, nullptr);
 		vkDestroyDescriptorPool(m_VkDevice, m_VkDescriptorPool, m_VkAllocator);
+		m_PipelineCache.Shutdown();
 
 #ifdef LUFT_USE_VULKAN_DEBUG_REPORT
 		// Remove the debug report callback
@@ -2,6 +2,8 @@
 #include <SDL.h>
 #include <vulkan/vulkan_core.h>
 #include "Luft/Core/Window.h"
+#include "Platform/Vulkan/VulkanPipelineCache.h"
+#include "Platform/Vulkan/VulkanSwapchain.h"
 
 namespace Luft
 {
@@ -18,9 +20,11 @@ namespace Luft
 		VkDevice GetDevice() const { return m_VkDevice; }
 		uint32_t GetQueueFamily() const { return m_VkQueueFamily; }
 		VkQueue GetQueue() const { return m_VkQueue; }
-		VkPipelineCache GetPipelineCache() const { return m_VkPipelineCache; }
+		VkPipelineCache GetPipelineCache() const { return m_PipelineCache.GetHandle(); }
+		VulkanPipelineCache& GetPersistentPipelineCache() { return m_PipelineCache; }
 		VkDescriptorPool GetDescriptorPool() const { return m_VkDescriptorPool; }
 		VkAllocationCallbacks* GetAllocator() const { return m_VkAllocator; }
+		VulkanSwapchain& GetSwapchain() { return m_Swapchain; }
 
 		void OnUpdate() override;
 
@@ -29,8 +33,10 @@ namespace Luft
 
 		// Window attributes
 		void SetEventCallback(const EventCallbackFn& callback) override { m_WindowData.EventCallback = callback; }
+		// Fifo when enabled, otherwise Mailbox or, without it, Immediate. From the next frame
 		void SetVSync(bool enabled) override;
 		bool IsVSync() const override;
+		void SetPresentMode(PresentMode mode) { m_Swapchain.SetPresentMode(mode); }
 
 		void* NativeWindow() const { return m_Window; }
 
@@ -44,8 +50,7 @@ namespace Luft
 		struct WindowData
 		{
 			lstr Title;
-			unsigned int Width, Height;
-			bool VSync;
+			unsigned int Width = 0, Height = 0;
 
 			EventCallbackFn EventCallback;
 
@@ -54,6 +59,7 @@ namespace Luft
 		WindowData m_WindowData;
 
 		SDL_Window* m_Window;
+		VkAllocationCallbacks  m_VkAllocationCallbacks = {};
 		VkAllocationCallbacks* m_VkAllocator = nullptr;
 		VkInstance             m_VkInstance = VK_NULL_HANDLE;
 		VkSurfaceKHR           m_VkSurface = VK_NULL_HANDLE;
@@ -62,7 +68,8 @@ namespace Luft
 		uint32_t m_VkQueueFamily = (uint32_t)-1;
 		VkDevice m_VkDevice = VK_NULL_HANDLE;
 		VkQueue m_VkQueue = VK_NULL_HANDLE;
-		VkPipelineCache          m_VkPipelineCache = VK_NULL_HANDLE;
+		VulkanPipelineCache      m_PipelineCache;
 		VkDescriptorPool         m_VkDescriptorPool = VK_NULL_HANDLE;
+		VulkanSwapchain          m_Swapchain;
 	};
 }
\ No newline at end of file